@@ -10,10 +10,19 @@
 #include "RunAction.hh"
 #include "EventAction.hh"
 #include "SteppingAction.hh"
+#include "StackingAction.hh"
+#include "RegionOfInterest.hh"
+#include "Checkpoint.hh"
 #include "SteppingVerbose.hh"
+#include "ShowerLibraryBuilder.hh"
+#include "FrozenShowerMessenger.hh"
+#include "SimProfiler.hh"
+#include "StartupCache.hh"
 #include "G4VisExecutive.hh"
 #include "G4UIExecutive.hh"
 
+#include <sstream>
+
 void printHelp() {
   std::cout << "===========================================================================" << std::endl
             << "PFCalEE - a standalone simulation of HGCal-type of detectors" << std::endl
@@ -30,6 +39,16 @@ void printHelp() {
             << "\t--dropLayers - csv list of layers to drop" << std::endl
             << "\t--fineGranularity - use fine granularity cells" << std::endl
             << "\t--ultraFineGranularity - use ultra fine granularity cells" << std::endl
+            << "\t--frozenShowers - shower library file: replace low energy e/gamma in the EE absorbers by frozen showers" << std::endl
+            << "\t--makeShowerLibrary - output file: record a frozen shower library from full simulation" << std::endl
+            << "\t--profile - output prefix: write per event CPU profile to <prefix>.root and <prefix>.json" << std::endl
+            << "\t--envelopes - 1: place each layer in an envelope, 2: also each subdetector (default 0: flat)" << std::endl
+            << "\t--smartless - world,envelope: smartless values for the navigation voxels (default: Geant4's)" << std::endl
+            << "\t--roi - dEta[,dPhi]: kill secondaries outside the (eta,phi) cones around the primaries (default: off)" << std::endl
+            << "\t--cache - directory: warm start from cached geometry and physics tables, written by the first job" << std::endl
+            << "\t--refreshCache - rewrite the cache even if it is up to date" << std::endl
+            << "\t--checkpoint - N: save the output and the random state every N events and at the end of the run (default: off)" << std::endl
+            << "\t--resume - continue from the last checkpoint of PFcal.root, if any" << std::endl
             << "\t--ui - do not run in batch mode" << std::endl
             << "===========================================================================" << std::endl << std::endl;
 }
@@ -59,6 +78,16 @@ int main(int argc,char** argv)
   std::string absThickW="";//1.75,1.75,1.75,1.75,1.75,2.8,2.8,2.8,2.8,2.8,4.2,4.2,4.2,4.2,4.2";
   std::string absThickPb="";//1,1,1,1,1,2.1,2.1,2.1,2.1,2.1,4.4,4.4,4.4,4.4";
   std::string dropLayers="";
+  std::string frozenShowers="";
+  std::string makeShowerLibrary="";
+  std::string profile="";
+  int envelopes(0);
+  double smartlessWorld(0), smartlessEnvelope(0);
+  std::string cacheDir="";
+  bool refreshCache(false);
+  double roiDeltaEta(0), roiDeltaPhi(0);
+  int checkpointEvery(0);
+  bool resume(false);
   bool batchMode(true);
 
   if (argc<2){
@@ -78,6 +107,16 @@ int main(int argc,char** argv)
     else if(arg.find("--absThickW")!=std::string::npos)          { absThickW=argv[i+1]; i++;}
     else if(arg.find("--absThickPb")!=std::string::npos)         { absThickPb=argv[i+1]; i++;}
     else if(arg.find("--dropLayers")!=std::string::npos)         { dropLayers=argv[i+1]; i++;}
+    else if(arg.find("--frozenShowers")!=std::string::npos)      { frozenShowers=argv[i+1]; i++;}
+    else if(arg.find("--makeShowerLibrary")!=std::string::npos)  { makeShowerLibrary=argv[i+1]; i++;}
+    else if(arg.find("--profile")!=std::string::npos)            { profile=argv[i+1]; i++;}
+    else if(arg.find("--envelopes")!=std::string::npos)          { sscanf(argv[i+1],"%d",&envelopes); i++;}
+    else if(arg.find("--smartless")!=std::string::npos)          { sscanf(argv[i+1],"%lf,%lf",&smartlessWorld,&smartlessEnvelope); i++;}
+    else if(arg.find("--roi")!=std::string::npos)                { if (sscanf(argv[i+1],"%lf,%lf",&roiDeltaEta,&roiDeltaPhi)<2) roiDeltaPhi=roiDeltaEta; i++;}
+    else if(arg.find("--checkpoint")!=std::string::npos)         { sscanf(argv[i+1],"%d",&checkpointEvery); i++;}
+    else if(arg.find("--resume")!=std::string::npos)             { resume=true;}
+    else if(arg.find("--refreshCache")!=std::string::npos)       { refreshCache=true;}
+    else if(arg.find("--cache")!=std::string::npos)              { cacheDir=argv[i+1]; i++;}
     else if(arg.find("--fineGranularity")!=std::string::npos)    { coarseGranularity=0;} 
     else if(arg.find("--ultraFineGranularity")!=std::string::npos)    { coarseGranularity=-1;} 
     else if(arg.find("--ui")!=std::string::npos)                 { batchMode=false;} 
@@ -86,16 +125,91 @@ int main(int argc,char** argv)
   std::cout << "-- Running version=" << version << " model=" << model << " shape=" << shape << std::endl
             << "\teta=" << eta << " coarse granularity=" << coarseGranularity << std::endl
             << "\tabsThickW=" << absThickW << " absThickPb=" << absThickPb << " dropLayers=" << dropLayers << std::endl
+            << "\tenvelopes=" << envelopes << " smartless=" << smartlessWorld << "," << smartlessEnvelope << std::endl
             << "\tbatchMode=" << batchMode << std::endl;
 
-  runManager->SetUserInitialization(new DetectorConstruction(version,model,shape,absThickW,absThickPb,dropLayers,coarseGranularity));
-  runManager->SetUserInitialization(new PhysicsList);
+  if (frozenShowers.size()>0 && makeShowerLibrary.size()>0){
+    std::cout << " -- ERROR! --frozenShowers and --makeShowerLibrary cannot be used together." << std::endl;
+    return -1;
+  }
+  if (frozenShowers.size()>0) std::cout << "\tfrozen showers from " << frozenShowers << std::endl;
+  if (makeShowerLibrary.size()>0) std::cout << "\tshower library written to " << makeShowerLibrary << std::endl;
+
+  DetectorConstruction *detector = new DetectorConstruction(version,model,shape,absThickW,absThickPb,dropLayers,coarseGranularity);
+  if (frozenShowers.size()>0) detector->SetFrozenShowers(DetectorConstruction::fs_REPLAY,frozenShowers);
+  else if (makeShowerLibrary.size()>0) detector->SetFrozenShowers(DetectorConstruction::fs_GENERATE);
+  detector->SetEnvelopes(envelopes,smartlessWorld,smartlessEnvelope);
+  runManager->SetUserInitialization(detector);
+  PhysicsList *physicsList = new PhysicsList(frozenShowers.size()>0);
+  runManager->SetUserInitialization(physicsList);
+
+  StartupCache *cache = 0;
+  if (cacheDir.size()>0){
+    //everything that changes the geometry or the physics tables
+    std::ostringstream cacheKey;
+    cacheKey << "version=" << version << " model=" << model << " shape=" << shape << " granularity=" << coarseGranularity
+	     << " absThickW=" << absThickW << " absThickPb=" << absThickPb << " dropLayers=" << dropLayers
+	     << " envelopes=" << envelopes << " frozenShowers=" << (frozenShowers.size()>0 ? 2 : (makeShowerLibrary.size()>0 ? 1 : 0))
+	     << " geometry=" << DetectorConstruction::geometryRevision
+	     << " " << physicsList->cacheKey();
+    cache = new StartupCache(cacheDir,cacheKey.str(),physicsList);
+    if (cache->check(*detector,refreshCache)) {
+      detector->SetStartupCache(cache);
+      physicsList->SetPhysicsTableRetrieved(cache->physicsDir());
+    }
+  }
+
+  Checkpoint *checkpoint = 0;
+  if (checkpointEvery>0 || resume){
+    if (resume && checkpointEvery<=0) checkpointEvery = 100;
+    std::cout << "\tcheckpoint every " << checkpointEvery << " events" << (resume ? ", resumed if possible" : "") << std::endl;
+    checkpoint = new Checkpoint(checkpointEvery,resume);
+  }
 
   // Set user action classes
   runManager->SetUserAction(new PrimaryGeneratorAction(model,eta));
-  runManager->SetUserAction(new RunAction);
-  runManager->SetUserAction(new EventAction);
-  runManager->SetUserAction(new SteppingAction);
+  RunAction *runAction = new RunAction;
+  runManager->SetUserAction(runAction);
+  EventAction *eventAction = new EventAction(checkpoint);
+  runManager->SetUserAction(eventAction);
+  StackingAction *stacking = new StackingAction;
+  runManager->SetUserAction(stacking);
+  SteppingAction *stepping = new SteppingAction;
+  runManager->SetUserAction(stepping);
+
+  ShowerLibraryBuilder *showerBuilder = 0;
+  FrozenShowerMessenger *showerBuilderMessenger = 0;
+  if (makeShowerLibrary.size()>0){
+    showerBuilder = new ShowerLibraryBuilder(makeShowerLibrary);
+    showerBuilderMessenger = new FrozenShowerMessenger(0,showerBuilder);
+    stepping->setShowerLibraryBuilder(showerBuilder);
+  }
+
+  SimProfiler *profiler = 0;
+  if (profile.size()>0){
+    std::cout << "\tCPU profile written to " << profile << ".root/.json" << std::endl;
+    profiler = new SimProfiler(profile);
+    runAction->setProfiler(profiler);
+    eventAction->setProfiler(profiler);
+    stepping->setProfiler(profiler);
+  }
+  if (cache) runAction->setStartupCache(cache);
+
+  RegionOfInterest *roi = 0;
+  if (roiDeltaEta>0 && roiDeltaPhi>0){
+    std::cout << "\tregion of interest: deltaEta=" << roiDeltaEta << " deltaPhi=" << roiDeltaPhi << std::endl;
+    roi = new RegionOfInterest(roiDeltaEta,roiDeltaPhi);
+    eventAction->setRegionOfInterest(roi);
+    stepping->setRegionOfInterest(roi);
+  }
+
+  if (checkpoint){
+    runAction->setCheckpoint(checkpoint);
+    if (checkpoint->resuming()){
+      stacking->restoreCounters(*checkpoint->resumedInfo());
+      if (roi) roi->restoreCounters(*checkpoint->resumedInfo());
+    }
+  }
 
   // Initialize G4 kernel
   runManager->Initialize();
@@ -134,6 +248,13 @@ int main(int argc,char** argv)
     }
 
   delete runManager;
+  //writes the library
+  delete showerBuilderMessenger;
+  delete showerBuilder;
+  delete profiler;
+  delete cache;
+  delete roi;
+  delete checkpoint;
 
   return 0;
 }
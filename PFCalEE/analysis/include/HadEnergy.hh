@@ -76,7 +76,8 @@ public:
 
   bool fillEnergies();
  
-  double calcGlobalC(const double LimMIP, const double EmipMean, TH1F* spectrum); 
+  //counts: per-event spectrum with p_spectrum binning, including under/overflow
+  double calcGlobalC(const double LimMIP, const double EmipMean, const double * counts); 
   
   inline double getGlobalC(const unsigned iLim) { 
       if(iLim < Cglobal_.size()) return Cglobal_[iLim];
@@ -85,6 +86,19 @@ public:
 
 private:
 
+  //compact per-event summary kept for the tail-spectra pass
+  struct EventSummary{
+    unsigned ievt;
+    double Etotal;
+    double truthTanx;
+    double truthTany;
+    ROOT::Math::XYZPoint truthPos;
+  };
+
+  bool isFHspectrumHit(const HGCSSRecoHit & lHit,
+		       const EventSummary & evt,
+		       const std::vector<double> & absW);
+
   std::string outputName_;
   TFile *outputFile_;
   TTree *outtree_;
@@ -117,6 +131,9 @@ private:
   TH1F *p_spectrum_lowtail;
   TH2F *p_spectrumByLayer;
 
+  static const unsigned nSpectrumBins_ = 1000;
+  double spectrumCounts_[nSpectrumBins_+2];
+
   bool isCalibed_;
   double FHtoEslope_; 
   double FHtoEoffset_;
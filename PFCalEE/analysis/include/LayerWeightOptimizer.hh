@@ -0,0 +1,175 @@
+#ifndef LayerWeightOptimizer_hh
+#define LayerWeightOptimizer_hh
+
+#include <string>
+#include <vector>
+#include <iostream>
+#include <memory>
+
+#include "HGCSSDetectorDescription.hh"
+
+//Sums and cross-products of the per-layer energies needed for a linear
+//least-square fit of trueE = sum_i w_i E_i (+ constant).
+//The symmetric matrix is stored as a packed lower triangle.
+class LayerWeightAccumulator {
+
+public:
+  LayerWeightAccumulator():nFit_(0),n_(0),tt_(0){};
+  LayerWeightAccumulator(const unsigned nFit){
+    reset(nFit);
+  };
+  ~LayerWeightAccumulator(){};
+
+  void reset(const unsigned nFit);
+
+  //aE has nFit elements, constant term included
+  inline void add(const std::vector<double> & aE, const double trueE){
+    unsigned idx = 0;
+    for (unsigned i(0); i<nFit_; ++i){
+      const double ei = aE[i];
+      sumE_[i] += ei;
+      et_[i] += ei*trueE;
+      for (unsigned j(0); j<=i; ++j){
+	ee_[idx++] += ei*aE[j];
+      }
+    }
+    tt_ += trueE*trueE;
+    n_++;
+  };
+
+  void merge(const LayerWeightAccumulator & other);
+
+  inline unsigned nFit() const{
+    return nFit_;
+  };
+  inline unsigned long long n() const{
+    return n_;
+  };
+  //element (i,j) of sum E E^T
+  inline double ee(const unsigned i, const unsigned j) const{
+    return i>=j ? ee_[i*(i+1)/2+j] : ee_[j*(j+1)/2+i];
+  };
+  inline double et(const unsigned i) const{
+    return et_[i];
+  };
+  inline double sumE(const unsigned i) const{
+    return sumE_[i];
+  };
+  inline double tt() const{
+    return tt_;
+  };
+
+  //sum of (w.E)^2 and sum of w.E, from the stored moments
+  double sumWE2(const std::vector<double> & w) const;
+  double sumWE(const std::vector<double> & w) const;
+
+private:
+  unsigned nFit_;
+  unsigned long long n_;
+  std::vector<double> ee_;
+  std::vector<double> et_;
+  std::vector<double> sumE_;
+  double tt_;
+
+};
+
+//Compiled replacement of macros/eMinimisation.C.
+//Per-layer energies (HGCSSSamplingSection measuredE, converted to MIPs
+//with the detector mipWeight) of all energy points are read in a single
+//pass, in chunks of entries processed on nThreads threads. Partial
+//accumulators are merged in chunk order, so the result does not depend
+//on the number of threads. As in the macro, each energy point enters
+//the fit normalised to its number of events, the first trainFraction of
+//the entries are used for the fit and the rest for the evaluation,
+//computed from the stored moments without re-reading the trees.
+class LayerWeightOptimizer {
+
+public:
+  LayerWeightOptimizer(const unsigned versionNumber,
+		       const unsigned model=2,
+		       const bool addConstant=false);
+  ~LayerWeightOptimizer(){};
+
+  //trueE in GeV, maxEvents=0: all entries
+  void addEnergyPoint(const std::string & filePath,
+		      const double trueE,
+		      const unsigned maxEvents=0);
+
+  inline void setTrainFraction(const double frac){
+    trainFraction_ = frac;
+  };
+
+  //single pass over all energy points
+  bool accumulate(const unsigned nThreads=0, const unsigned chunkSize=1000);
+
+  //Cholesky solution of the normal equations, false if not positive-definite
+  bool solve();
+
+  inline unsigned nLayers() const{
+    return nLayers_;
+  };
+  inline unsigned nFit() const{
+    return nFit_;
+  };
+
+  //GeV per MIP for each layer
+  inline const std::vector<double> & weights() const{
+    return weights_;
+  };
+  inline double constant() const{
+    return addConstant_ ? constant_ : 0;
+  };
+
+  //weights in the HGCSSDetector convention: E(GeV) = sum_L E_L(MIP)*absWeight_L*gevWeight - gevOffset,
+  //with absWeight normalised to the mean of the first section
+  std::vector<double> absWeights() const;
+  double gevWeight() const;
+  inline double gevOffset() const{
+    return -constant();
+  };
+
+  //fit and test linearity/resolution per energy point
+  void print(std::ostream & aOs) const;
+
+  //per-layer table and per-section lines as set in HGCSSDetector::buildDetector
+  bool writeWeights(const std::string & outFile) const;
+
+private:
+
+  struct EnergyPoint {
+    std::string filePath;
+    double trueE;
+    unsigned maxEvents;
+    unsigned nEntries;
+    unsigned nTrain;
+    LayerWeightAccumulator train;
+    LayerWeightAccumulator test;
+  };
+
+  struct Chunk {
+    unsigned point;
+    unsigned first;
+    unsigned last;
+  };
+
+  void processChunks(const std::vector<Chunk> & chunks,
+		     const unsigned firstChunk,
+		     const unsigned step,
+		     std::vector<LayerWeightAccumulator> & trainRes,
+		     std::vector<LayerWeightAccumulator> & testRes,
+		     std::vector<unsigned long long> & nSkipped) const;
+
+  std::shared_ptr<const HGCSSDetectorDescription> detector_;
+  unsigned nLayers_;
+  unsigned nFit_;
+  bool addConstant_;
+  double trainFraction_;
+  std::vector<EnergyPoint> points_;
+
+  std::vector<double> weights_;
+  double constant_;
+  bool solved_;
+
+};
+
+#endif
@@ -0,0 +1,130 @@
+#ifndef LogWeightScan_hh
+#define LogWeightScan_hh
+
+#include <string>
+#include <vector>
+#include <map>
+#include <iostream>
+
+#include "TFile.h"
+#include "TTree.h"
+#include "TH2Poly.h"
+
+#include "HGCSSGeometryConversion.hh"
+
+//One-pass scan of the log-weighting parameter w0 of the per-layer
+//position (as PositionFit::getRecoPosition with doLogWeight_), on the
+//EcellsSR2 trees saved by PositionFit. Per event and layer, the cell
+//neighbourhood around the maximum is projected on x and y and the
+//log(E_i/Etot) computed once; the positions for all w0 values are then
+//evaluated together in the inner loop. Residuals to the truth position
+//within its cell (from the HGCSSGeometryConversion map if set, else a
+//square grid of cellSize) are accumulated per input point (eta/pT
+//sample), layer and w0, replacing the one-w0-per-read macros
+//logWeightingScan.C and logWeightingScanAll.C.
+class LogWeightScan {
+
+public:
+
+  //residual moments, all entries and |residual|<truncation
+  struct Stats {
+    Stats():n(0),sum(0),sum2(0),nIn(0),sumIn(0),sum2In(0){};
+    unsigned long long n;
+    double sum;
+    double sum2;
+    unsigned long long nIn;
+    double sumIn;
+    double sum2In;
+    double rms() const;
+    double rmsIn() const;
+    double rmsInError() const;
+  };
+
+  LogWeightScan(const unsigned nLayers,
+		const std::vector<double> & w0);
+  ~LogWeightScan(){};
+
+  //nStored x nStored cells in the tree (3 for the current PositionFit
+  //output, 5 for older files); only the central nUsed x nUsed are used
+  void setNeighbourhood(const unsigned nStored, const unsigned nUsed);
+
+  //nUsed per layer, e.g. 3 up to layer 22 and 5 above for older files
+  void setNeighbourhood(const unsigned nStored, const std::vector<unsigned> & nUsed);
+
+  //cells of the given shape (1 hexagon, 2 diamond, 3 triangle, 4 square),
+  //the map must have been initialised in geomConv
+  void setCellMap(HGCSSGeometryConversion & geomConv, const unsigned shape);
+
+  inline void setCellSize(const double cellSize){
+    cellSize_ = cellSize;
+  };
+
+  inline void setTruncation(const double truncation){
+    truncation_ = truncation;
+  };
+
+  //evenly spaced w0 values in [w0min,w0max]
+  static std::vector<double> w0Range(const double w0min, const double w0max, const unsigned nW);
+
+  //treePath: path of the EcellsSR2 tree in the file, maxEvents=0: all
+  bool addPoint(const std::string & label,
+		const std::string & filePath,
+		const std::string & treePath="EcellsSR2",
+		const unsigned maxEvents=0);
+
+  //positions for all w0 of one layer, from the n x n energies
+  //(row-major, y then x); false if the layer is empty
+  bool positions(const double *Exy,
+		 const unsigned n,
+		 std::vector<double> & xpos,
+		 std::vector<double> & ypos) const;
+
+  inline unsigned nPoints() const{
+    return labels_.size();
+  };
+  inline const std::vector<double> & w0() const{
+    return w0_;
+  };
+  inline const Stats & statsX(const unsigned iP, const unsigned iL, const unsigned iW) const{
+    return statsX_[index(iP,iL,iW)];
+  };
+  inline const Stats & statsY(const unsigned iP, const unsigned iL, const unsigned iW) const{
+    return statsY_[index(iP,iL,iW)];
+  };
+
+  //w0 with the smallest truncated RMS of (x+y)/2
+  unsigned bestW0(const unsigned iP, const unsigned iL) const;
+
+  //sigma vs w0 graphs per point and layer, and best w0 vs layer
+  void write(TFile *outputFile) const;
+
+  void print(std::ostream & aOs) const;
+
+private:
+
+  inline unsigned index(const unsigned iP, const unsigned iL, const unsigned iW) const{
+    return (iP*nLayers_+iL)*nW_+iW;
+  };
+
+  //residual to the centre of the cell containing the truth position
+  void foldToCell(const double x, const double y,
+		  double & xt, double & yt) const;
+
+  unsigned nLayers_;
+  unsigned nW_;
+  std::vector<double> w0_;
+  unsigned nStored_;
+  //per layer
+  std::vector<unsigned> nUsed_;
+  double cellSize_;
+  TH2Poly *cellMap_;
+  const std::map<int,std::pair<double,double> > *cellCentres_;
+  double truncation_;
+
+  std::vector<std::string> labels_;
+  std::vector<Stats> statsX_;
+  std::vector<Stats> statsY_;
+
+};
+
+#endif
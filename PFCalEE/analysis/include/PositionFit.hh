@@ -21,6 +21,7 @@
 #include "HGCSSCluster.hh"
 #include "HGCSSGenParticle.hh"
 #include "HGCSSPUenergy.hh"
+#include "HGCSSPUeventDensity.hh"
 #include "HGCSSGeometryConversion.hh"
 #include "HGCSSCalibration.hh"
 
@@ -108,6 +109,18 @@ public:
 		  const HGCSSGeometryConversion & geomConv, 
 		  const HGCSSPUenergy & puDensity);
 
+  //per-event PU from HGCSSPUeventDensity (cone of coneDR around the
+  //shower excluded) instead of the random cones, and subtracted
+  //instead of the mean parametrisation. Cell areas as in SignalRegion
+  //(HGCSSGeometryConversion::cellAreaInCm2).
+  inline void setEventPuDensity(const bool useEventPU, const double coneDR=0.3,
+				const bool doHexa=true){
+    useEventPU_ = useEventPU;
+    useMeanPU_ = !useEventPU;
+    puConeDR_ = coneDR;
+    doHexa_ = doHexa;
+  };
+
   inline void setMatrixFolder(const std::string outFolder){
     matrixFolder_ = outFolder;
   };
@@ -275,6 +288,9 @@ private:
   double cellSize_;
   unsigned debug_;
   bool useMeanPU_;
+  bool useEventPU_;
+  double puConeDR_;
+  bool doHexa_;
   bool fixForPuMixBug_;
   bool doMatrix_;
   bool saveEtree_;
@@ -285,6 +301,7 @@ private:
   HGCSSGeometryConversion geomConv_;
   HGCSSCalibration calib_;
   HGCSSPUenergy puDensity_;
+  HGCSSPUeventDensity puEventDensity_;
 
   std::vector<double> avgZ_;
 
@@ -0,0 +1,101 @@
+#ifndef RadialProfile_hh
+#define RadialProfile_hh
+
+#include <vector>
+
+#include "TH1F.h"
+#include "TH2F.h"
+
+//Energy vs distance dR to the shower axis, per layer and summed over
+//layers, filled in one pass over the hits in fine dR bins. Containment
+//radii come from the cumulative sums of the bins: the radius is the
+//largest hit dR with the energy up to it below the fraction, as when
+//sorting the hits, but hits in the bin where the fraction is crossed
+//are not resolved. With setExact(true) the hits are kept and only
+//those of the crossing bin are selected and sorted.
+//Bins of binWidth up to dRfine (as the SignalRegion histograms), then
+//with relative width tailStep up to dRmax, the last bin takes the rest.
+class RadialProfile {
+
+public:
+
+  RadialProfile(const unsigned nLayers=0,
+		const double binWidth=0.1,
+		const double dRfine=200,
+		const double tailStep=0.005,
+		const double dRmax=5000);
+  ~RadialProfile(){};
+
+  inline void setExact(const bool exact){
+    exact_ = exact;
+  };
+
+  inline bool exact() const{
+    return exact_;
+  };
+
+  //to be called before the hits of each event
+  void reset();
+
+  void add(const unsigned layer, const double dR, const double E);
+
+  inline double energy(const unsigned layer) const{
+    return layer<nLayers_ ? Esum_[layer] : 0;
+  };
+
+  inline double totalEnergy() const{
+    return Esum_[nLayers_];
+  };
+
+  //largest dR with the energy up to it below fraction of the layer
+  //energy, Econtained set to that energy; 0 if none.
+  double radius(const unsigned layer,
+		const double fraction,
+		double & Econtained);
+
+  double totalRadius(const double fraction);
+
+  //one fill per non-empty bin: p_dR weighted by the bin energy,
+  //p_Esumfrac with the cumulative fraction weighted by the hit count.
+  void fillHistograms(const unsigned layer,
+		      TH1F *p_dR,
+		      TH2F *p_Esumfrac);
+
+private:
+
+  struct Hit {
+    double dR;
+    double E;
+  };
+
+  unsigned bin(const double dR) const;
+
+  //row nLayers_ is the sum of the layers
+  double containment(const unsigned row,
+		     const double fraction,
+		     double & Econtained);
+
+  //bins filled in each row, in increasing dR
+  void sortBins();
+
+  unsigned nLayers_;
+  double binWidth_;
+  double dRfine_;
+  double logStep_;
+  unsigned nFine_;
+  unsigned nBins_;
+  bool exact_;
+  bool sorted_;
+
+  //nBins_ per row
+  std::vector<double> E_;
+  std::vector<double> maxdR_;
+  std::vector<unsigned> nHits_;
+  std::vector<double> Esum_;
+  std::vector<std::vector<unsigned> > filled_;
+  //per layer, exact mode only
+  std::vector<std::vector<Hit> > hits_;
+
+};
+
+#endif
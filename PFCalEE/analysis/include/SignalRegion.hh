@@ -15,9 +15,11 @@
 #include "HGCSSSimHit.hh"
 #include "HGCSSSamplingSection.hh"
 #include "HGCSSPUenergy.hh"
+#include "HGCSSPUeventDensity.hh"
 #include "HGCSSGeometryConversion.hh"
 #include "HGCSSCalibration.hh"
 #include "PositionFit.hh"
+#include "RadialProfile.hh"
 
 #include "Math/Vector3D.h"
 #include "Math/Vector3Dfwd.h"
@@ -26,20 +28,6 @@
 #include "Math/Point3D.h"
 #include "Math/Point3Dfwd.h"
 
-struct MyRecoHit{
-  double dR;
-  double E;
-};
-
-struct {
-  bool operator()(const MyRecoHit & a,
-		  const MyRecoHit & b) const
-  {   
-    return a.dR < b.dR;
-  }   
-} customdRsort;
-
-
 class SignalRegion{
 
 public:
@@ -135,6 +123,19 @@ public:
     else {return energySR_[layer][iSR];}
   };
 
+  //subtract the PU density measured in each event (HGCSSPUeventDensity),
+  //excluding a cone of coneDR around the shower, instead of the mean one
+  inline void setEventPuDensity(const bool useEventPU, const double coneDR=0.3){
+    useEventPU_ = useEventPU;
+    puConeDR_ = coneDR;
+  };
+
+  //containment radii resolved with the hits of the crossing dR bin
+  //instead of the bin content (RadialProfile)
+  inline void setExactContainment(const bool exact){
+    profile_.setExact(exact);
+  };
+
   inline double absweight(const unsigned layer) const{
     if(layer >= nLayers_) return 0;
     return absweight_[layer];
@@ -192,6 +193,10 @@ private:
   
   HGCSSGeometryConversion geomConv_;
   HGCSSPUenergy puDensity_;
+  HGCSSPUeventDensity puEventDensity_;
+  bool useEventPU_;
+  double puConeDR_;
+  RadialProfile profile_;
   //HGCSSCalibration *mycalib_;
   
   bool fixForPuMixBug_;
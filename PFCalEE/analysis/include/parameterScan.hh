@@ -5,61 +5,147 @@
 #include <vector>
 #include <map>
 
-#include "TCanvas.h"
-#include "TGraph.h"
-
+#include "TTree.h"
+
+//Scan of the W/Pb absorber thicknesses per layer pair, in steps of
+//stepSizeW/stepSizePb. Consecutive layer pairs are grouped in blocks
+//sharing the same step. Partial configurations are pruned as soon as
+//the thickness/X0/lambda bounds or the block ordering rules cannot be
+//met anymore, subtrees run on nThreads threads, and accepted models
+//are written in a fixed order to the output tree. At most 2*nThreads
+//tasks are ahead of the one being written, so that the accepted models
+//waiting for it stay bounded.
 class parameterScan {
 
 public:
 
-  parameterScan(){};
+  parameterScan():
+    nLayers(0),
+    maxThick(0),
+    minX0(0),
+    maxLambda(0),
+    stepSizeW(0),
+    stepSizePb(0),
+    nSteps(0),
+    length(0),
+    X0tot(0),
+    L0tot(0),
+    validModels(0),
+    totModels(0),
+    visitedModels(0),
+    nC(4),
+    nThreads(0),
+    x0w(0),
+    x0pb(0),
+    l0w(0),
+    l0pb(0)
+  {};
   ~parameterScan(){};
 
+  //accepted model category: block steps 1<2<3<4<5, 1>2>3<4<5, 1<2<3>4>5 or others
+  enum Category {
+    cat_Ordered=0,
+    cat_DownUp=1,
+    cat_UpDown=2,
+    cat_Others=3
+  };
+
   unsigned nLayers;
   double maxThick;
   double minX0;
   double maxLambda;
-  
+
   double stepSizeW;
   double stepSizePb;
-  
+
   unsigned nSteps;
-  
+
   double length;
   double X0tot;
   double L0tot;
 
-  std::vector<unsigned> iS ;
-  unsigned validModels;
-  unsigned totModels;
+  //number of layer pairs per block, setDefaultBlocks() if empty
+  std::vector<unsigned> blocks;
 
+  unsigned long long validModels;
+  //size of the full configuration space, and configurations actually tested
+  unsigned long long totModels;
+  unsigned long long visitedModels;
 
   std::map<double,unsigned> modelMap;
-  std::pair<std::map<double,unsigned>::iterator,bool> isInserted;
 
   unsigned nC;
-  std::vector<TCanvas *> myc;
-  std::vector<bool> first;
   std::vector<unsigned> counter;
 
+  //0: run in the calling thread
+  unsigned nThreads;
+
   double x0w;
   double x0pb;
   double l0w;
   double l0pb;
 
+  //same grouping as the former process30layers...process20layers:
+  //four blocks of 3 pairs (2 pairs below 12 pairs), rest in a fifth block
+  void setDefaultBlocks();
 
-  void process30layers();
-  void process28layers();
-  void process26layers();
-  void process24layers();
-  void process22layers();
-  void process20layers();
+  //enumerate all configurations; accepted models are filled
+  //in outTree if not null, see initialiseTree
+  void process(TTree *outTree=0);
 
-  bool processModel(const unsigned nBlocks,
-		    const std::vector<unsigned> & idx);
+  //branches: category, X0, length, lambda, nBlocks, steps[nBlocks]
+  void initialiseTree(TTree *outTree);
 
   void print();
 
+private:
+
+  //steps in Result::steps
+  struct Model {
+    unsigned category;
+    double X0;
+    double length;
+    double lambda;
+  };
+
+  //per-thread results
+  struct Result {
+    Result():validModels(0),visitedModels(0){};
+    unsigned long long validModels;
+    unsigned long long visitedModels;
+    std::map<double,unsigned> modelMap;
+    std::vector<unsigned> counter;
+    std::vector<Model> models;
+    //nBlocks per model, flat
+    std::vector<unsigned> steps;
+  };
+
+  //blocks of the ordering rules: first four blocks and last block
+  unsigned ruleBlock(const unsigned i) const;
+
+  void processTask(const unsigned task, Result & res) const;
+
+  void enumerate(const unsigned iB, std::vector<unsigned> & steps,
+		 const double thick, const double x0, const double l0,
+		 Result & res) const;
+
+  //final selection on a full configuration, as the leaf of the former loops
+  void processModel(const std::vector<unsigned> & steps, Result & res) const;
+
+  std::vector<unsigned> firstPair_;
+  std::vector<double> dThick_;
+  std::vector<double> dX0_;
+  std::vector<double> dL0_;
+  std::vector<double> maxRemainingX0_;
+
+  //output tree buffers
+  unsigned outCategory_;
+  double outX0_;
+  double outLength_;
+  double outLambda_;
+  unsigned outNBlocks_;
+  std::vector<unsigned> outSteps_;
+
 };//class
 
 
@@ -15,6 +15,10 @@
 #include <unordered_set>
 
 #include "TFile.h"
+#include "TChain.h"
+
+#include "HGCSSInfo.hh"
+#include "HGCSSFileCatalogue.hh"
 
 typedef KDTreeLinkerAlgo<unsigned,3> KDTree;
 typedef KDTreeNodeInfoT<unsigned,3> KDNode;
@@ -76,6 +80,43 @@ bool testInputFile(std::string input, TFile* & file){
   return true;
 };
 
+//add the input to the chain with its entries from the catalogue,
+//or open the file to test it if it is not catalogued
+bool addInputFile(TChain *chain, const std::string & input, TFile* & file,
+		  const HGCSSFileCatalogue * catalogue=0){
+  if (catalogue && catalogue->addFile(*chain,input)) return true;
+  if (!testInputFile(input,file)) return false;
+  chain->AddFile(input.c_str());
+  return true;
+};
+
+//Info of the input from the catalogue, or from the file: catalogued
+//inputs without Info were not opened by addInputFile, they are here
+HGCSSInfo * getInputInfo(const std::string & input, TFile* & file,
+			 const HGCSSFileCatalogue * catalogue=0){
+  if (catalogue) {
+    HGCSSInfo *info = new HGCSSInfo();
+    if (catalogue->fillInfo(input,*info)) return info;
+    delete info;
+  }
+  if (!file || input!=file->GetName()) {
+    if (!testInputFile(input,file)) return 0;
+  }
+  return (HGCSSInfo*)file->Get("Info");
+};
+
+//index files given as a csv list
+bool readCatalogues(const std::string & fileNames, HGCSSFileCatalogue & catalogue){
+  std::vector<std::string> lFiles;
+  boost::split(lFiles,fileNames,boost::is_any_of(","));
+  for (unsigned iF(0); iF<lFiles.size(); ++iF){
+    if (lFiles[iF].size()==0) continue;
+    if (!catalogue.read(lFiles[iF])) return false;
+    std::cout << " -- Catalogue " << lFiles[iF] << " read, " << catalogue.records().size() << " files." << std::endl;
+  }
+  return true;
+};
+
 double zPos(const int l){
   if (l<=0) return 3173.9;
   if (l==1) return 3183.65;
@@ -76,14 +76,29 @@ void HadEnergy::bookHist(TFile *outputFile){
 
 }
 
+bool HadEnergy::isFHspectrumHit(const HGCSSRecoHit & lHit,
+				const EventSummary & evt,
+				const std::vector<double> & absW){
+  double posz = lHit.get_z();
+  double truthposx = evt.truthTanx*(posz-evt.truthPos.z())+evt.truthPos.x();
+  double truthposy = evt.truthTany*(posz-evt.truthPos.z())+evt.truthPos.y();
+  if (fabs(lHit.get_x()-truthposx) > 500 ||
+      fabs(lHit.get_y()-truthposy) > 500) return false;
+  unsigned layer = lHit.layer();
+  if (layer >= nLayers_ || absW[layer]==0) return false;
+  return myDetector_.detType(myDetector_.getSection(layer)) == DetectorEnum::FHCAL;
+}
+
 bool HadEnergy::fillEnergies(){
 
   p_spectrum->Reset();
-  std::vector<TH1F*> spectrumCollection;
-  std::vector<double> Etotal;
+  //one compact summary per processed event: the per-event spectra are
+  //not kept, tails are rebuilt from a second pass over the rechits.
+  std::vector<EventSummary> summaries;
   TH1F* p_Etotal = new TH1F("p_Etotal","p_Etotal",1000,0,100000);
   unsigned nSec = nSections_;
   double recSum[nSec];
+  const TAxis * spectrumAxis = p_spectrum->GetXaxis();
 
   HGCSSEvent * event = 0;
   std::vector<HGCSSSamplingSection> * ssvec = 0;
@@ -102,7 +117,7 @@ bool HadEnergy::fillEnergies(){
      
   std::cout << "- Processing = " << nEvts  << " events out of " << lRecTree_->GetEntries() << std::endl;
   
-  spectrumCollection.resize(nEvts,0);
+  summaries.reserve(nEvts);
   std::vector<double> absW;
   bool firstEvent = true;
   for (unsigned ievt(0); ievt<nEvts; ++ievt){// loop on entries
@@ -113,18 +128,20 @@ bool HadEnergy::fillEnergies(){
 
     //get truth info
     bool found = false;
-    double truthTanx = 0;
-    double truthTany = 0;
+    EventSummary lEvt;
+    lEvt.ievt = ievt;
+    lEvt.Etotal = 0;
+    lEvt.truthTanx = 0;
+    lEvt.truthTany = 0;
     //double truthE = 0;
-    ROOT::Math::XYZPoint truthPos;
     for (unsigned iP(0); iP<(*genvec).size(); ++iP){//loop on gen particles    
       if (debug_>1 && (*genvec).size()!= 1) (*genvec)[iP].Print(std::cout);
       if ((*genvec)[iP].trackID()==1){
 	found = true;
 	//set direction
-	truthPos = ROOT::Math::XYZPoint((*genvec)[iP].x(),(*genvec)[iP].y(),(*genvec)[iP].z());
-	truthTanx = (*genvec)[iP].px()/(*genvec)[iP].pz();
-	truthTany = (*genvec)[iP].py()/(*genvec)[iP].pz();
+	lEvt.truthPos = ROOT::Math::XYZPoint((*genvec)[iP].x(),(*genvec)[iP].y(),(*genvec)[iP].z());
+	lEvt.truthTanx = (*genvec)[iP].px()/(*genvec)[iP].pz();
+	lEvt.truthTany = (*genvec)[iP].py()/(*genvec)[iP].pz();
 	//in GeV
 	//truthE = (*genvec)[iP].E()/1000.;
 	
@@ -170,7 +187,9 @@ bool HadEnergy::fillEnergies(){
 
     EmipMeanFH_ = 0;
     nhitsFH_ = 0;
-    spectrumCollection[ievt] = new TH1F("","",1000,0,250);
+    for (unsigned iB(0); iB<nSpectrumBins_+2; ++iB){
+      spectrumCounts_[iB] = 0;
+    }
     energy_.clear();
     wgttotalE_ = 0;
     for(unsigned iS(0); iS < nSec; iS++){
@@ -179,12 +198,12 @@ bool HadEnergy::fillEnergies(){
 
 
     for (unsigned iH(0); iH<(*rechitvec).size(); ++iH){//loop over rechits
-      const HGCSSRecoHit lHit = (*rechitvec)[iH];
+      const HGCSSRecoHit & lHit = (*rechitvec)[iH];
       double posx = lHit.get_x();
       double posy = lHit.get_y();
       double posz = lHit.get_z();
-      double truthposx = truthTanx*(posz-truthPos.z())+truthPos.x();
-      double truthposy = truthTany*(posz-truthPos.z())+truthPos.y();
+      double truthposx = lEvt.truthTanx*(posz-lEvt.truthPos.z())+lEvt.truthPos.x();
+      double truthposy = lEvt.truthTany*(posz-lEvt.truthPos.z())+lEvt.truthPos.y();
       //consider 1*1 m^2 section
       if (fabs(posx-truthposx) <= 500 && 
 	  fabs(posy-truthposy) <= 500){
@@ -208,7 +227,8 @@ bool HadEnergy::fillEnergies(){
 	
 	DetectorEnum type = myDetector_.detType(sec);
 	if(type == DetectorEnum::FHCAL && absW[layer]!= 0){
-	  spectrumCollection[ievt]->Fill(energy);
+	  spectrumCounts_[spectrumAxis->FindFixBin(energy)] += 1;
+	  p_spectrum->Fill(energy);
 	  EmipMeanFH_ += energy;
 	  nhitsFH_ += 1;
 	}
@@ -234,7 +254,8 @@ bool HadEnergy::fillEnergies(){
     }
 
     wgttotalE_ = (EE_-ECALoffset_)/ECALslope_ + ((EFHCAL_-FHtoEoffset_)/FHtoEslope_ + (EBHCAL_-BHtoEoffset_)/(BHtoEslope_*FHtoBHslope_))/EEtoHslope_;
-    Etotal.push_back(wgttotalE_);
+    lEvt.Etotal = wgttotalE_;
+    summaries.push_back(lEvt);
     p_Etotal->Fill(wgttotalE_);
     if(nhitsFH_!=0)EmipMeanFH_ = EmipMeanFH_/nhitsFH_; 
 
@@ -243,7 +264,7 @@ bool HadEnergy::fillEnergies(){
   //else if(EFHCAL > 1.1*GenE/1.25)p_spectrum_hightail->Add(p_spectrum);
 
     for(unsigned iLim(0); iLim < LimMIP_.size(); iLim++){
-      Cglobal_[iLim] = calcGlobalC(LimMIP_[iLim], EmipMeanFH_, spectrumCollection[ievt]);
+      Cglobal_[iLim] = calcGlobalC(LimMIP_[iLim], EmipMeanFH_, spectrumCounts_);
       correctedtotalE_[iLim] = (EE_-ECALoffset_)/ECALslope_ + ((EFHCAL_-FHtoEoffset_)/FHtoEslope_*Cglobal_[iLim] + (EBHCAL_-BHtoEoffset_)/(BHtoEslope_*FHtoBHslope_))/(EEtoHslopePar0_/wgttotalE_+EEtoHslopePar1_);//wgttotalE_*Cglobal_[iLim];
     }
 
@@ -254,14 +275,21 @@ bool HadEnergy::fillEnergies(){
   TF1 *fit = (TF1*)p_Etotal->GetFunction("gaus");
   double EMean = fit?fit->GetParameter(1):p_Etotal->GetMean();
   double ERMS = fit?fit->GetParameter(2):p_Etotal->GetRMS();
-  for (unsigned ievt(0); ievt<nEvts; ++ievt){
-    if (!spectrumCollection[ievt]) continue;
-    p_spectrum->Add(spectrumCollection[ievt]);
-    if(Etotal[ievt] < EMean-ERMS)p_spectrum_lowtail->Add(spectrumCollection[ievt]);
-    else if(Etotal[ievt] > EMean+ERMS)p_spectrum_hightail->Add(spectrumCollection[ievt]);
+
+  //second pass, reading only the rechits of events in the tails
+  for (unsigned iE(0); iE<summaries.size(); ++iE){
+    const EventSummary & lEvt = summaries[iE];
+    TH1F *tail = 0;
+    if(lEvt.Etotal < EMean-ERMS) tail = p_spectrum_lowtail;
+    else if(lEvt.Etotal > EMean+ERMS) tail = p_spectrum_hightail;
+    if (!tail) continue;
+    lRecTree_->GetEntry(lEvt.ievt);
+    for (unsigned iH(0); iH<(*rechitvec).size(); ++iH){//loop over rechits
+      const HGCSSRecoHit & lHit = (*rechitvec)[iH];
+      if (isFHspectrumHit(lHit,lEvt,absW)) tail->Fill(lHit.energy());
+    }
   }
  
-  spectrumCollection.clear();
   outtree_->Write();
   p_spectrumByLayer->Write(); 
   p_spectrum->Write(); 
@@ -271,20 +299,20 @@ bool HadEnergy::fillEnergies(){
   return true;
 }
 
-double HadEnergy::calcGlobalC(const double LimMIP, const double EmipMean, TH1F* spectrum){
-  Int_t binLim = spectrum->GetXaxis()->FindBin(LimMIP);
-  Int_t binAve = spectrum->GetXaxis()->FindBin(EmipMean);
+double HadEnergy::calcGlobalC(const double LimMIP, const double EmipMean, const double * counts){
+  const TAxis * axis = p_spectrum->GetXaxis();
+  Int_t binLim = axis->FindFixBin(LimMIP);
+  Int_t binAve = axis->FindFixBin(EmipMean);
   float countLim(0);
   for(int iB(0); iB < binLim; iB++){
-     countLim += spectrum->GetBinContent(iB);
+     countLim += counts[iB];
   }
   float countAve(0);
   for(int iB(0); iB < binAve; iB++){
-     countAve += spectrum->GetBinContent(iB);
+     countAve += counts[iB];
   }
   double globalC(0);
   if(countAve!=0)globalC = countLim/countAve;
  
   return globalC;
 }
-
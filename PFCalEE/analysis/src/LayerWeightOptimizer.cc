@@ -0,0 +1,352 @@
+#include "LayerWeightOptimizer.hh"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <thread>
+
+#include "TFile.h"
+#include "TTree.h"
+#include "TROOT.h"
+
+#include "HGCSSSamplingSection.hh"
+
+void LayerWeightAccumulator::reset(const unsigned nFit){
+  nFit_ = nFit;
+  n_ = 0;
+  ee_.assign(nFit*(nFit+1)/2,0);
+  et_.assign(nFit,0);
+  sumE_.assign(nFit,0);
+  tt_ = 0;
+}
+
+void LayerWeightAccumulator::merge(const LayerWeightAccumulator & other){
+  if (other.n_==0) return;
+  if (nFit_ != other.nFit_){
+    std::cout << " -- Error, cannot merge accumulators of size " << nFit_ << " and " << other.nFit_ << std::endl;
+    return;
+  }
+  for (unsigned i(0); i<ee_.size(); ++i) ee_[i] += other.ee_[i];
+  for (unsigned i(0); i<nFit_; ++i){
+    et_[i] += other.et_[i];
+    sumE_[i] += other.sumE_[i];
+  }
+  tt_ += other.tt_;
+  n_ += other.n_;
+}
+
+double LayerWeightAccumulator::sumWE2(const std::vector<double> & w) const{
+  double sum = 0;
+  unsigned idx = 0;
+  for (unsigned i(0); i<nFit_; ++i){
+    for (unsigned j(0); j<i; ++j){
+      sum += 2*w[i]*w[j]*ee_[idx++];
+    }
+    sum += w[i]*w[i]*ee_[idx++];
+  }
+  return sum;
+}
+
+double LayerWeightAccumulator::sumWE(const std::vector<double> & w) const{
+  double sum = 0;
+  for (unsigned i(0); i<nFit_; ++i) sum += w[i]*sumE_[i];
+  return sum;
+}
+
+LayerWeightOptimizer::LayerWeightOptimizer(const unsigned versionNumber,
+					   const unsigned model,
+					   const bool addConstant):
+  addConstant_(addConstant),
+  trainFraction_(0.5),
+  constant_(0),
+  solved_(false)
+{
+  detector_ = HGCSSDetectorDescription::get(versionNumber,model);
+  nLayers_ = detector_->nLayers();
+  nFit_ = addConstant_ ? nLayers_+1 : nLayers_;
+}
+
+void LayerWeightOptimizer::addEnergyPoint(const std::string & filePath,
+					  const double trueE,
+					  const unsigned maxEvents){
+  EnergyPoint lPoint;
+  lPoint.filePath = filePath;
+  lPoint.trueE = trueE;
+  lPoint.maxEvents = maxEvents;
+  lPoint.nEntries = 0;
+  lPoint.nTrain = 0;
+  points_.push_back(lPoint);
+}
+
+void LayerWeightOptimizer::processChunks(const std::vector<Chunk> & chunks,
+					 const unsigned firstChunk,
+					 const unsigned step,
+					 std::vector<LayerWeightAccumulator> & trainRes,
+					 std::vector<LayerWeightAccumulator> & testRes,
+					 std::vector<unsigned long long> & nSkipped) const{
+
+  //one open file per energy point and per worker
+  std::vector<TFile*> files(points_.size(),0);
+  std::vector<TTree*> trees(points_.size(),0);
+  std::vector<std::vector<HGCSSSamplingSection>*> ssvecs(points_.size(),0);
+  std::vector<double> lE(nFit_,1.);
+
+  for (unsigned iC(firstChunk); iC<chunks.size(); iC+=step){
+    const Chunk & lChunk = chunks[iC];
+    const EnergyPoint & lPoint = points_[lChunk.point];
+    trainRes[iC].reset(nFit_);
+    testRes[iC].reset(nFit_);
+
+    if (!trees[lChunk.point]){
+      files[lChunk.point] = TFile::Open(lPoint.filePath.c_str());
+      if (!files[lChunk.point]) continue;
+      trees[lChunk.point] = (TTree*)files[lChunk.point]->Get("HGCSSTree");
+      if (!trees[lChunk.point]) continue;
+      //only the sampling sections are needed
+      trees[lChunk.point]->SetBranchStatus("*",0);
+      trees[lChunk.point]->SetBranchStatus("HGCSSSamplingSectionVec*",1);
+      trees[lChunk.point]->SetBranchAddress("HGCSSSamplingSectionVec",&ssvecs[lChunk.point]);
+    }
+    TTree *lTree = trees[lChunk.point];
+
+    for (unsigned ievt(lChunk.first); ievt<lChunk.last; ++ievt){
+      lTree->GetEntry(ievt);
+      const std::vector<HGCSSSamplingSection> & ssvec = *ssvecs[lChunk.point];
+      if (ssvec.size() != nLayers_){
+	nSkipped[iC]++;
+	continue;
+      }
+      for (unsigned iL(0); iL<nLayers_; ++iL){
+	lE[iL] = ssvec[iL].measuredE()*detector_->mipWeight(iL);
+      }
+      if (ievt<lPoint.nTrain) trainRes[iC].add(lE,lPoint.trueE);
+      else testRes[iC].add(lE,lPoint.trueE);
+    }
+  }
+
+  for (unsigned iP(0); iP<files.size(); ++iP){
+    if (files[iP]) files[iP]->Close();
+    delete ssvecs[iP];
+  }
+}
+
+bool LayerWeightOptimizer::accumulate(const unsigned nThreads, const unsigned chunkSize){
+
+  if (points_.size()==0){
+    std::cout << " -- Error, no energy point to process." << std::endl;
+    return false;
+  }
+
+  std::vector<Chunk> chunks;
+  for (unsigned iP(0); iP<points_.size(); ++iP){
+    EnergyPoint & lPoint = points_[iP];
+    TFile *lFile = TFile::Open(lPoint.filePath.c_str());
+    if (!lFile) {
+      std::cout << " -- Error, input file " << lPoint.filePath << " cannot be opened. Exiting..." << std::endl;
+      return false;
+    }
+    TTree *lTree = (TTree*)lFile->Get("HGCSSTree");
+    if (!lTree){
+      std::cout << " -- Error, tree HGCSSTree cannot be opened in " << lPoint.filePath << ". Exiting..." << std::endl;
+      lFile->Close();
+      return false;
+    }
+    const unsigned nEntries = lTree->GetEntries();
+    lPoint.nEntries = (lPoint.maxEvents > nEntries || lPoint.maxEvents==0) ? nEntries : lPoint.maxEvents;
+    lPoint.nTrain = static_cast<unsigned>(trainFraction_*lPoint.nEntries);
+    lPoint.train.reset(nFit_);
+    lPoint.test.reset(nFit_);
+    lFile->Close();
+
+    std::cout << " -- E = " << lPoint.trueE << " GeV: " << lPoint.nEntries << " entries, "
+	      << lPoint.nTrain << " for the fit, from " << lPoint.filePath << std::endl;
+
+    for (unsigned first(0); first<lPoint.nEntries; first+=chunkSize){
+      Chunk lChunk;
+      lChunk.point = iP;
+      lChunk.first = first;
+      lChunk.last = std::min(first+chunkSize,lPoint.nEntries);
+      chunks.push_back(lChunk);
+    }
+  }
+
+  std::vector<LayerWeightAccumulator> trainRes(chunks.size());
+  std::vector<LayerWeightAccumulator> testRes(chunks.size());
+  std::vector<unsigned long long> nSkipped(chunks.size(),0);
+
+  const unsigned nWorkers = std::min<unsigned>(nThreads,chunks.size());
+  if (nWorkers<2){
+    processChunks(chunks,0,1,trainRes,testRes,nSkipped);
+  }
+  else {
+    ROOT::EnableThreadSafety();
+    std::vector<std::thread> workers;
+    for (unsigned iT(0); iT<nWorkers; ++iT){
+      workers.push_back(std::thread(&LayerWeightOptimizer::processChunks,this,
+				    std::cref(chunks),iT,nWorkers,
+				    std::ref(trainRes),std::ref(testRes),std::ref(nSkipped)));
+    }
+    for (unsigned iT(0); iT<nWorkers; ++iT) workers[iT].join();
+  }
+
+  //merge in chunk order
+  unsigned long long totSkipped = 0;
+  for (unsigned iC(0); iC<chunks.size(); ++iC){
+    points_[chunks[iC].point].train.merge(trainRes[iC]);
+    points_[chunks[iC].point].test.merge(testRes[iC]);
+    totSkipped += nSkipped[iC];
+  }
+  if (totSkipped>0) std::cout << " -- Warning, " << totSkipped << " events skipped with a number of layers different from " << nLayers_ << std::endl;
+
+  for (unsigned iP(0); iP<points_.size(); ++iP){
+    if (points_[iP].train.n()==0){
+      std::cout << " -- Error, no event for the fit at E = " << points_[iP].trueE << " GeV." << std::endl;
+      return false;
+    }
+  }
+  solved_ = false;
+  return true;
+}
+
+bool LayerWeightOptimizer::solve(){
+
+  solved_ = false;
+  //normal equations, each energy point normalised to its number of events
+  std::vector<double> lA(nFit_*(nFit_+1)/2,0);
+  std::vector<double> lB(nFit_,0);
+  for (unsigned iP(0); iP<points_.size(); ++iP){
+    const LayerWeightAccumulator & acc = points_[iP].train;
+    if (acc.n()==0) continue;
+    const double norm = 1./acc.n();
+    unsigned idx = 0;
+    for (unsigned i(0); i<nFit_; ++i){
+      lB[i] += acc.et(i)*norm;
+      for (unsigned j(0); j<=i; ++j){
+	lA[idx++] += acc.ee(i,j)*norm;
+      }
+    }
+  }
+
+  //Cholesky A = L L^T, in place in the packed lower triangle
+  for (unsigned j(0); j<nFit_; ++j){
+    double diag = lA[j*(j+1)/2+j];
+    for (unsigned k(0); k<j; ++k) diag -= lA[j*(j+1)/2+k]*lA[j*(j+1)/2+k];
+    if (diag<=0){
+      std::cout << " -- Error, matrix is not positive-definite at row " << j
+		<< " (empty or fully correlated layers?)." << std::endl;
+      return false;
+    }
+    const double ljj = sqrt(diag);
+    lA[j*(j+1)/2+j] = ljj;
+    for (unsigned i(j+1); i<nFit_; ++i){
+      double val = lA[i*(i+1)/2+j];
+      for (unsigned k(0); k<j; ++k) val -= lA[i*(i+1)/2+k]*lA[j*(j+1)/2+k];
+      lA[i*(i+1)/2+j] = val/ljj;
+    }
+  }
+
+  //forward then backward substitution
+  std::vector<double> lY(nFit_,0);
+  for (unsigned i(0); i<nFit_; ++i){
+    double val = lB[i];
+    for (unsigned k(0); k<i; ++k) val -= lA[i*(i+1)/2+k]*lY[k];
+    lY[i] = val/lA[i*(i+1)/2+i];
+  }
+  std::vector<double> lX(nFit_,0);
+  for (unsigned i(nFit_); i-->0;){
+    double val = lY[i];
+    for (unsigned k(i+1); k<nFit_; ++k) val -= lA[k*(k+1)/2+i]*lX[k];
+    lX[i] = val/lA[i*(i+1)/2+i];
+  }
+
+  weights_.assign(lX.begin(),lX.begin()+nLayers_);
+  constant_ = addConstant_ ? lX[nLayers_] : 0;
+  solved_ = true;
+  return true;
+}
+
+double LayerWeightOptimizer::gevWeight() const{
+  double sum = 0;
+  unsigned n = 0;
+  for (unsigned iL(0); iL<nLayers_ && iL<weights_.size(); ++iL){
+    if (detector_->section(iL)!=0) continue;
+    sum += weights_[iL];
+    n++;
+  }
+  return n>0 ? sum/n : 1.;
+}
+
+std::vector<double> LayerWeightOptimizer::absWeights() const{
+  std::vector<double> lAbs(weights_.size(),0);
+  const double ref = gevWeight();
+  if (ref==0) return lAbs;
+  for (unsigned iL(0); iL<weights_.size(); ++iL) lAbs[iL] = weights_[iL]/ref;
+  return lAbs;
+}
+
+void LayerWeightOptimizer::print(std::ostream & aOs) const{
+  if (!solved_) {
+    aOs << " -- LayerWeightOptimizer: no solution." << std::endl;
+    return;
+  }
+  std::vector<double> lW(weights_);
+  if (addConstant_) lW.push_back(constant_);
+
+  aOs << " -- LayerWeightOptimizer: version " << detector_->version() << " model " << detector_->model()
+      << ", " << nLayers_ << " layers" << (addConstant_ ? " + constant" : "") << std::endl
+      << std::setw(10) << "E(GeV)" << std::setw(8) << "sample" << std::setw(10) << "nEvts"
+      << std::setw(12) << "<E>/Etrue" << std::setw(12) << "sigma/E" << std::endl;
+  for (unsigned iP(0); iP<points_.size(); ++iP){
+    const EnergyPoint & lPoint = points_[iP];
+    for (unsigned iS(0); iS<2; ++iS){
+      const LayerWeightAccumulator & acc = iS==0 ? lPoint.train : lPoint.test;
+      if (acc.n()==0) continue;
+      const double mean = acc.sumWE(lW)/acc.n();
+      const double var = acc.sumWE2(lW)/acc.n()-mean*mean;
+      aOs << std::setw(10) << lPoint.trueE << std::setw(8) << (iS==0?"fit":"test")
+	  << std::setw(10) << acc.n()
+	  << std::setw(12) << std::setprecision(4) << mean/lPoint.trueE
+	  << std::setw(12) << (mean>0 && var>0 ? sqrt(var)/mean : 0)
+	  << std::endl;
+    }
+  }
+}
+
+bool LayerWeightOptimizer::writeWeights(const std::string & outFile) const{
+  if (!solved_) return false;
+  std::ofstream lOut(outFile.c_str());
+  if (!lOut.is_open()){
+    std::cout << " -- Error, cannot write weights to " << outFile << std::endl;
+    return false;
+  }
+  const std::vector<double> lAbs = absWeights();
+  const double gev = gevWeight();
+
+  lOut << "# LayerWeightOptimizer, version " << detector_->version() << " model " << detector_->model() << std::endl
+       << "# E(GeV) = sum_L E_L(MIP)*absWeight_L*gevWeight - gevOffset" << std::endl
+       << "# gevWeight " << std::setprecision(8) << gev << std::endl
+       << "# gevOffset " << gevOffset() << std::endl
+       << "# layer absWeight weight(GeV/MIP)" << std::endl;
+  for (unsigned iL(0); iL<nLayers_; ++iL){
+    lOut << iL << " " << lAbs[iL] << " " << weights_[iL] << std::endl;
+  }
+
+  //section average, to be pasted in HGCSSDetector::buildDetector
+  lOut << "#" << std::endl;
+  for (unsigned iS(0); iS<detector_->nSections(); ++iS){
+    double sum = 0;
+    unsigned n = 0;
+    for (unsigned iL(0); iL<nLayers_; ++iL){
+      if (detector_->section(iL)!=iS) continue;
+      sum += lAbs[iL];
+      n++;
+    }
+    if (n==0) continue;
+    lOut << "# " << detector_->subDetectorBySection(iS).name << ".absWeight = " << sum/n << ";" << std::endl;
+  }
+  lOut.close();
+  std::cout << " -- Weights written to " << outFile << std::endl;
+  return true;
+}
@@ -0,0 +1,328 @@
+#include "LogWeightScan.hh"
+
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <limits>
+#include <sstream>
+
+#include "TGraph.h"
+#include "TGraphErrors.h"
+
+double LogWeightScan::Stats::rms() const{
+  if (n==0) return 0;
+  const double mean = sum/n;
+  const double var = sum2/n-mean*mean;
+  return var>0 ? sqrt(var) : 0;
+}
+
+double LogWeightScan::Stats::rmsIn() const{
+  if (nIn==0) return 0;
+  const double mean = sumIn/nIn;
+  const double var = sum2In/nIn-mean*mean;
+  return var>0 ? sqrt(var) : 0;
+}
+
+double LogWeightScan::Stats::rmsInError() const{
+  return nIn>0 ? rmsIn()/sqrt(2.*nIn) : 0;
+}
+
+LogWeightScan::LogWeightScan(const unsigned nLayers,
+			     const std::vector<double> & w0):
+  nLayers_(nLayers),
+  nW_(w0.size()),
+  w0_(w0),
+  nStored_(3),
+  nUsed_(nLayers,3),
+  cellSize_(10.),
+  cellMap_(0),
+  cellCentres_(0),
+  truncation_(5.)
+{}
+
+void LogWeightScan::setNeighbourhood(const unsigned nStored, const unsigned nUsed){
+  setNeighbourhood(nStored,std::vector<unsigned>(nLayers_,nUsed));
+}
+
+void LogWeightScan::setNeighbourhood(const unsigned nStored, const std::vector<unsigned> & nUsed){
+  nStored_ = nStored;
+  nUsed_.assign(nLayers_,nStored);
+  for (unsigned iL(0); iL<nLayers_ && iL<nUsed.size(); ++iL){
+    if (nUsed[iL]>nStored_ || (nStored_-nUsed[iL])%2!=0){
+      std::cout << " -- Warning, layer " << iL << ": cannot use " << nUsed[iL] << "x" << nUsed[iL]
+		<< " cells out of " << nStored << "x" << nStored << ", using all of them." << std::endl;
+      continue;
+    }
+    nUsed_[iL] = nUsed[iL];
+  }
+}
+
+void LogWeightScan::setCellMap(HGCSSGeometryConversion & geomConv, const unsigned shape){
+  if (shape==2) {
+    cellMap_ = geomConv.diamondMap();
+    cellCentres_ = &geomConv.diamGeom;
+  }
+  else if (shape==3) {
+    cellMap_ = geomConv.triangleMap();
+    cellCentres_ = &geomConv.triangleGeom;
+  }
+  else if (shape==4) {
+    cellMap_ = geomConv.squareMap();
+    cellCentres_ = &geomConv.squareGeom;
+  }
+  else {
+    cellMap_ = geomConv.hexagonMap();
+    cellCentres_ = &geomConv.hexaGeom;
+  }
+}
+
+std::vector<double> LogWeightScan::w0Range(const double w0min, const double w0max, const unsigned nW){
+  std::vector<double> lW0;
+  if (nW==0) return lW0;
+  const double step = nW>1 ? (w0max-w0min)/(nW-1) : 0;
+  for (unsigned iW(0); iW<nW; ++iW) lW0.push_back(w0min+iW*step);
+  return lW0;
+}
+
+void LogWeightScan::foldToCell(const double x, const double y,
+			       double & xt, double & yt) const{
+  if (cellMap_) {
+    std::map<int,std::pair<double,double> >::const_iterator lCell = cellCentres_->find(cellMap_->FindBin(x,y));
+    if (lCell != cellCentres_->end()) {
+      xt = x-lCell->second.first;
+      yt = y-lCell->second.second;
+      return;
+    }
+  }
+  xt = x-cellSize_*floor(x/cellSize_+0.5);
+  yt = y-cellSize_*floor(y/cellSize_+0.5);
+}
+
+bool LogWeightScan::positions(const double *Exy,
+			      const unsigned n,
+			      std::vector<double> & xpos,
+			      std::vector<double> & ypos) const{
+  double Etot = 0;
+  std::vector<double> Ex(n,0);
+  std::vector<double> Ey(n,0);
+  for (unsigned iy(0); iy<n; ++iy){
+    for (unsigned ix(0); ix<n; ++ix){
+      const double E = Exy[n*iy+ix];
+      Etot += E;
+      Ex[ix] += E;
+      Ey[iy] += E;
+    }
+  }
+  if (Etot<=0) return false;
+
+  //log(E_i/Etot) and cell offsets, once per layer
+  const double lowLog = -std::numeric_limits<double>::max();
+  std::vector<double> lx(n,lowLog);
+  std::vector<double> ly(n,lowLog);
+  std::vector<double> offset(n,0);
+  for (unsigned i(0); i<n; ++i){
+    if (Ex[i]>0) lx[i] = log(Ex[i]/Etot);
+    if (Ey[i]>0) ly[i] = log(Ey[i]/Etot);
+    offset[i] = cellSize_*(i-(n-1)/2.);
+  }
+
+  //all w0 in the inner loop
+  std::vector<double> sumWx(nW_,0);
+  std::vector<double> sumWy(nW_,0);
+  std::vector<double> sumPx(nW_,0);
+  std::vector<double> sumPy(nW_,0);
+  const double *w0 = &w0_[0];
+  for (unsigned i(0); i<n; ++i){
+    const double lxi = lx[i];
+    const double lyi = ly[i];
+    const double off = offset[i];
+    for (unsigned iW(0); iW<nW_; ++iW){
+      const double wx = std::max(0.,lxi+w0[iW]);
+      const double wy = std::max(0.,lyi+w0[iW]);
+      sumWx[iW] += wx;
+      sumWy[iW] += wy;
+      sumPx[iW] += wx*off;
+      sumPy[iW] += wy*off;
+    }
+  }
+
+  //NaN if no cell passes: the layer is discarded for this w0, as in PositionFit
+  const double undefined = std::numeric_limits<double>::quiet_NaN();
+  xpos.resize(nW_);
+  ypos.resize(nW_);
+  for (unsigned iW(0); iW<nW_; ++iW){
+    xpos[iW] = sumWx[iW]>0 ? sumPx[iW]/sumWx[iW] : undefined;
+    ypos[iW] = sumWy[iW]>0 ? sumPy[iW]/sumWy[iW] : undefined;
+  }
+  return true;
+}
+
+bool LogWeightScan::addPoint(const std::string & label,
+			     const std::string & filePath,
+			     const std::string & treePath,
+			     const unsigned maxEvents){
+
+  TFile *lFile = TFile::Open(filePath.c_str());
+  if (!lFile) {
+    std::cout << " -- Error, input file " << filePath << " cannot be opened. Skipping..." << std::endl;
+    return false;
+  }
+  TTree *lTree = (TTree*)lFile->Get(treePath.c_str());
+  if (!lTree) {
+    std::cout << " -- Error, tree " << treePath << " not found in " << filePath << ". Skipping..." << std::endl;
+    lFile->Close();
+    return false;
+  }
+
+  const unsigned nCells = nStored_*nStored_;
+  std::vector<double> Exy(nLayers_*nCells,0);
+  std::vector<double> truthPosX(nLayers_,0);
+  std::vector<double> truthPosY(nLayers_,0);
+
+  //the timing branches are not needed
+  lTree->SetBranchStatus("*",0);
+  for (unsigned iL(0); iL<nLayers_; ++iL){
+    std::ostringstream lName;
+    lName << "TruthPosX_" << iL;
+    lTree->SetBranchStatus(lName.str().c_str(),1);
+    lTree->SetBranchAddress(lName.str().c_str(),&truthPosX[iL]);
+    lName.str("");
+    lName << "TruthPosY_" << iL;
+    lTree->SetBranchStatus(lName.str().c_str(),1);
+    lTree->SetBranchAddress(lName.str().c_str(),&truthPosY[iL]);
+    for (unsigned idx(0); idx<nCells; ++idx){
+      lName.str("");
+      lName << "E_" << iL << "_" << idx;
+      lTree->SetBranchStatus(lName.str().c_str(),1);
+      lTree->SetBranchAddress(lName.str().c_str(),&Exy[iL*nCells+idx]);
+    }
+  }
+
+  const unsigned iP = labels_.size();
+  labels_.push_back(label);
+  statsX_.resize(labels_.size()*nLayers_*nW_);
+  statsY_.resize(labels_.size()*nLayers_*nW_);
+
+  const unsigned nEntries = lTree->GetEntries();
+  const unsigned nEvts = (maxEvents > nEntries || maxEvents==0) ? nEntries : maxEvents;
+  std::cout << " -- " << label << ": processing " << nEvts << " entries out of " << nEntries
+	    << ", " << nW_ << " w0 values" << std::endl;
+
+  std::vector<double> lUsed(nCells,0);
+  std::vector<double> xpos;
+  std::vector<double> ypos;
+  for (unsigned ievt(0); ievt<nEvts; ++ievt){//loop on entries
+    if (ievt%1000 == 0) std::cout << "... Processing entry: " << ievt << std::endl;
+    lTree->GetEntry(ievt);
+
+    for (unsigned iL(0); iL<nLayers_; ++iL){//loop on layers
+      const double *lCells = &Exy[iL*nCells];
+      const unsigned n = nUsed_[iL];
+      const unsigned first = (nStored_-n)/2;
+      for (unsigned iy(0); iy<n; ++iy){
+	for (unsigned ix(0); ix<n; ++ix){
+	  lUsed[n*iy+ix] = lCells[nStored_*(iy+first)+ix+first];
+	}
+      }
+      if (!positions(&lUsed[0],n,xpos,ypos)) continue;
+
+      double xt = 0;
+      double yt = 0;
+      foldToCell(truthPosX[iL],truthPosY[iL],xt,yt);
+      for (unsigned iW(0); iW<nW_; ++iW){
+	const unsigned idx = index(iP,iL,iW);
+	if (!std::isnan(xpos[iW])){
+	  const double dx = xpos[iW]-xt;
+	  Stats & sx = statsX_[idx];
+	  sx.n++;
+	  sx.sum += dx;
+	  sx.sum2 += dx*dx;
+	  if (fabs(dx)<truncation_){
+	    sx.nIn++;
+	    sx.sumIn += dx;
+	    sx.sum2In += dx*dx;
+	  }
+	}
+	if (!std::isnan(ypos[iW])){
+	  const double dy = ypos[iW]-yt;
+	  Stats & sy = statsY_[idx];
+	  sy.n++;
+	  sy.sum += dy;
+	  sy.sum2 += dy*dy;
+	  if (fabs(dy)<truncation_){
+	    sy.nIn++;
+	    sy.sumIn += dy;
+	    sy.sum2In += dy*dy;
+	  }
+	}
+      }
+    }//loop on layers
+  }//loop on entries
+
+  lFile->Close();
+  return true;
+}
+
+unsigned LogWeightScan::bestW0(const unsigned iP, const unsigned iL) const{
+  unsigned best = 0;
+  double minRes = -1;
+  for (unsigned iW(0); iW<nW_; ++iW){
+    const Stats & sx = statsX(iP,iL,iW);
+    const Stats & sy = statsY(iP,iL,iW);
+    if (sx.nIn==0 || sy.nIn==0) continue;
+    const double res = (sx.rmsIn()+sy.rmsIn())/2.;
+    if (minRes<0 || res<minRes){
+      minRes = res;
+      best = iW;
+    }
+  }
+  return best;
+}
+
+void LogWeightScan::write(TFile *outputFile) const{
+  for (unsigned iP(0); iP<nPoints(); ++iP){
+    outputFile->mkdir(labels_[iP].c_str());
+    outputFile->cd(labels_[iP].c_str());
+    TGraph *grW0 = new TGraph();
+    grW0->SetName("grW0min");
+    grW0->SetTitle(";layer;W0");
+    for (unsigned iL(0); iL<nLayers_; ++iL){
+      TGraphErrors *grX = new TGraphErrors();
+      TGraphErrors *grY = new TGraphErrors();
+      std::ostringstream lName;
+      lName << "grX_" << iL;
+      grX->SetName(lName.str().c_str());
+      grX->SetTitle(";W0; #sigma(x-xt) (mm)");
+      lName.str("");
+      lName << "grY_" << iL;
+      grY->SetName(lName.str().c_str());
+      grY->SetTitle(";W0; #sigma(y-yt) (mm)");
+      for (unsigned iW(0); iW<nW_; ++iW){
+	const Stats & sx = statsX(iP,iL,iW);
+	const Stats & sy = statsY(iP,iL,iW);
+	grX->SetPoint(iW,w0_[iW],sx.rmsIn());
+	grX->SetPointError(iW,0,sx.rmsInError());
+	grY->SetPoint(iW,w0_[iW],sy.rmsIn());
+	grY->SetPointError(iW,0,sy.rmsInError());
+      }
+      grX->Write();
+      grY->Write();
+      grW0->SetPoint(iL,iL,w0_[bestW0(iP,iL)]);
+    }
+    grW0->Write();
+  }
+}
+
+void LogWeightScan::print(std::ostream & aOs) const{
+  for (unsigned iP(0); iP<nPoints(); ++iP){
+    aOs << " -- " << labels_[iP] << ": best w0 per layer" << std::endl
+	<< std::setw(6) << "layer" << std::setw(8) << "w0"
+	<< std::setw(12) << "sigmaX(mm)" << std::setw(12) << "sigmaY(mm)" << std::endl;
+    for (unsigned iL(0); iL<nLayers_; ++iL){
+      const unsigned iW = bestW0(iP,iL);
+      aOs << std::setw(6) << iL << std::setw(8) << std::setprecision(3) << w0_[iW]
+	  << std::setw(12) << std::setprecision(4) << statsX(iP,iL,iW).rmsIn()
+	  << std::setw(12) << statsY(iP,iL,iW).rmsIn() << std::endl;
+    }
+  }
+}
@@ -87,6 +87,10 @@ PositionFit::PositionFit(const unsigned nSR,
   nSiLayers_ = nSiLayers;
   debug_ = debug;
   useMeanPU_ = true;
+  useEventPU_ = false;
+  puConeDR_ = 0.3;
+  doHexa_ = true;
+  puEventDensity_ = HGCSSPUeventDensity(nLayers_);
   fixForPuMixBug_ = applyPuMixFix;
   doMatrix_ = doMatrix;
   saveEtree_ = true;
@@ -1015,7 +1019,18 @@ bool PositionFit::getInitialPosition(const unsigned ievt,
   //take average per layer: not all 9 cells of 3*3 area have hits...
   std::vector<double> puE;
   puE.resize(nLayers_,0);
-  if (nPuVtx>0){
+  if (nPuVtx>0 && useEventPU_){
+    //one pass on the rechits, density of the eta ring of the shower
+    puEventDensity_.clearSignalCones();
+    puEventDensity_.addSignalCone(pcaEta_,pcaPhi_,puConeDR_);
+    puEventDensity_.fill(*rechitvec,fixForPuMixBug_);
+    for (unsigned iL(0);iL<nLayers_;++iL){//loop on layers
+      const double lArea = geomConv_.cellAreaInCm2(iL,sqrt(pow(xmax[iL],2)+pow(ymax[iL],2)),doHexa_);
+      puE[iL] = puEventDensity_.getDensity(pcaEta_,iL,lArea);
+      if (debug_) std::cout << "layer " << iL << " Epu=" << puE[iL] << std::endl;
+    }
+  }
+  else if (nPuVtx>0){
     unsigned nRandomCones = 50;
     double phistep = TMath::Pi()/nRandomCones;
     if (debug_) std::cout << "--- etamax = " << pcaEta_ << " phimax=" << pcaPhi_ << " phistep = " << phistep << std::endl;
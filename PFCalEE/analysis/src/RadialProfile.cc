@@ -0,0 +1,151 @@
+#include "RadialProfile.hh"
+
+#include <algorithm>
+#include <cmath>
+
+RadialProfile::RadialProfile(const unsigned nLayers,
+			     const double binWidth,
+			     const double dRfine,
+			     const double tailStep,
+			     const double dRmax){
+  nLayers_ = nLayers;
+  binWidth_ = binWidth;
+  dRfine_ = dRfine;
+  logStep_ = log(1+tailStep);
+  nFine_ = static_cast<unsigned>(dRfine/binWidth+0.5);
+  nBins_ = nFine_+1;
+  if (dRmax>dRfine) nBins_ += static_cast<unsigned>(ceil(log(dRmax/dRfine)/logStep_));
+  exact_ = false;
+  sorted_ = true;
+
+  E_.resize((nLayers_+1)*nBins_,0);
+  maxdR_.resize((nLayers_+1)*nBins_,0);
+  nHits_.resize((nLayers_+1)*nBins_,0);
+  Esum_.resize(nLayers_+1,0);
+  filled_.resize(nLayers_+1);
+  hits_.resize(nLayers_);
+}
+
+unsigned RadialProfile::bin(const double dR) const{
+  if (dR<dRfine_) return static_cast<unsigned>(dR/binWidth_);
+  const unsigned iB = nFine_+static_cast<unsigned>(log(dR/dRfine_)/logStep_);
+  return std::min(iB,nBins_-1);
+}
+
+void RadialProfile::reset(){
+  //only the bins filled in the previous event
+  for (unsigned iR(0); iR<=nLayers_; ++iR){
+    for (unsigned iF(0); iF<filled_[iR].size(); ++iF){
+      const unsigned idx = iR*nBins_+filled_[iR][iF];
+      E_[idx] = 0;
+      maxdR_[idx] = 0;
+      nHits_[idx] = 0;
+    }
+    filled_[iR].clear();
+    Esum_[iR] = 0;
+  }
+  for (unsigned iL(0); iL<nLayers_; ++iL){
+    hits_[iL].clear();
+  }
+  sorted_ = true;
+}
+
+void RadialProfile::add(const unsigned layer, const double dR, const double E){
+  if (layer>=nLayers_) return;
+  const unsigned iB = bin(dR);
+  const unsigned rows[2] = {layer,nLayers_};
+  for (unsigned iR(0); iR<2; ++iR){
+    const unsigned idx = rows[iR]*nBins_+iB;
+    if (nHits_[idx]==0) {
+      filled_[rows[iR]].push_back(iB);
+      sorted_ = false;
+    }
+    nHits_[idx]++;
+    E_[idx] += E;
+    if (dR>maxdR_[idx]) maxdR_[idx] = dR;
+    Esum_[rows[iR]] += E;
+  }
+  if (exact_) {
+    Hit lHit;
+    lHit.dR = dR;
+    lHit.E = E;
+    hits_[layer].push_back(lHit);
+  }
+}
+
+void RadialProfile::sortBins(){
+  if (sorted_) return;
+  for (unsigned iR(0); iR<=nLayers_; ++iR){
+    std::sort(filled_[iR].begin(),filled_[iR].end());
+  }
+  sorted_ = true;
+}
+
+double RadialProfile::containment(const unsigned row,
+				  const double fraction,
+				  double & Econtained){
+  sortBins();
+  const double Ecut = fraction*Esum_[row];
+  const std::vector<unsigned> & lBins = filled_[row];
+  double Esum = 0;
+  double dR = 0;
+  Econtained = 0;
+  for (unsigned iF(0); iF<lBins.size(); ++iF){
+    const unsigned iB = lBins[iF];
+    const unsigned idx = row*nBins_+iB;
+    if (Esum+E_[idx]<Ecut) {
+      Esum += E_[idx];
+      dR = maxdR_[idx];
+      Econtained = Esum;
+      continue;
+    }
+    if (!exact_) break;
+    //select the hits of the crossing bin, only those are sorted
+    std::vector<Hit> lHits;
+    const unsigned first = row<nLayers_ ? row : 0;
+    const unsigned last = row<nLayers_ ? row+1 : nLayers_;
+    for (unsigned iL(first); iL<last; ++iL){
+      for (unsigned iH(0); iH<hits_[iL].size(); ++iH){
+	if (bin(hits_[iL][iH].dR)==iB) lHits.push_back(hits_[iL][iH]);
+      }
+    }
+    std::sort(lHits.begin(),lHits.end(),[](const Hit & a, const Hit & b){return a.dR < b.dR;});
+    for (unsigned iH(0); iH<lHits.size(); ++iH){
+      Esum += lHits[iH].E;
+      if (Esum>=Ecut) break;
+      dR = lHits[iH].dR;
+      Econtained = Esum;
+    }
+    break;
+  }
+  return dR;
+}
+
+double RadialProfile::radius(const unsigned layer,
+			     const double fraction,
+			     double & Econtained){
+  Econtained = 0;
+  if (layer>=nLayers_) return 0;
+  return containment(layer,fraction,Econtained);
+}
+
+double RadialProfile::totalRadius(const double fraction){
+  double Econtained = 0;
+  return containment(nLayers_,fraction,Econtained);
+}
+
+void RadialProfile::fillHistograms(const unsigned layer,
+				   TH1F *p_dR,
+				   TH2F *p_Esumfrac){
+  if (layer>=nLayers_) return;
+  sortBins();
+  const std::vector<unsigned> & lBins = filled_[layer];
+  double Esum = 0;
+  for (unsigned iF(0); iF<lBins.size(); ++iF){
+    const unsigned idx = layer*nBins_+lBins[iF];
+    Esum += E_[idx];
+    //largest dR of the bin: same histogram bin as its hits
+    if (p_dR) p_dR->Fill(maxdR_[idx],E_[idx]);
+    if (p_Esumfrac && Esum_[layer]>0) p_Esumfrac->Fill(maxdR_[idx],Esum/Esum_[layer],nHits_[idx]);
+  }
+}
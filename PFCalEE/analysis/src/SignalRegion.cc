@@ -44,6 +44,10 @@ SignalRegion::SignalRegion(const std::string inputFolder,
 
   zPos_ = zpos;
   puDensity_ = HGCSSPUenergy();
+  puEventDensity_ = HGCSSPUeventDensity(nLayers_);
+  profile_ = RadialProfile(nLayers_);
+  useEventPU_ = false;
+  puConeDR_ = 0.3;
   fixForPuMixBug_ =  false;
 
 }
@@ -57,10 +61,10 @@ SignalRegion::SignalRegion(const std::string inputFolder,
 			   const bool applyPuMixFix,
 			   const unsigned versionNumber,
 			   const bool doHexa,
-			   const unsigned g4trackID){
-
+			   const unsigned g4trackID):
+  SignalRegion(inputFolder,nLayers,zpos,nevt,geomConv,versionNumber,doHexa,g4trackID)
+{
 
-  SignalRegion(inputFolder,nLayers,zpos,nevt,geomConv,versionNumber,doHexa,g4trackID);
   puDensity_ = puDensity;
   fixForPuMixBug_ = applyPuMixFix;
 
@@ -392,8 +396,15 @@ bool SignalRegion::fillEnergies(const unsigned ievt,
   //maxH[iL] = 0;
   //}
 
-  std::vector<MyRecoHit> lhitvec[nLayers_];
-  std::vector<MyRecoHit> lhitvectotal;
+  //event-by-event PU density, signal cone around the shower axis
+  if (useEventPU_ && nPuVtx>0){
+    const ROOT::Math::XYZPoint & lRef = eventPos[nLayers_/2];
+    puEventDensity_.clearSignalCones();
+    puEventDensity_.addSignalCone(lRef.eta(),lRef.phi(),puConeDR_);
+    puEventDensity_.fill(rechitvec,fixForPuMixBug_);
+  }
+
+  profile_.reset();
 
   for (unsigned iH(0); iH<rechitvec.size(); ++iH){//loop on hits
     const HGCSSRecoHit & lHit = rechitvec[iH];
@@ -426,7 +437,10 @@ bool SignalRegion::fillEnergies(const unsigned ievt,
     
     double lradius = sqrt(pow(posx,2)+pow(posy,2));
     double puE = 0;
-    if (nPuVtx>0) puE = puDensity_.getDensity(leta,layer,geomConv_.cellSizeInCm(layer,lradius),nPuVtx);
+    if (nPuVtx>0 && useEventPU_) {
+      puE = puEventDensity_.getDensity(leta,layer,geomConv_.cellAreaInCm2(layer,lradius,doHexa_));
+    }
+    else if (nPuVtx>0) puE = puDensity_.getDensity(leta,layer,geomConv_.cellSizeInCm(layer,lradius),nPuVtx);
     double subtractedenergy = std::max(0.,energy - puE);
     //double halfCell = 0.5*geomConv_.cellSize(layer,lradius);
     //hexagons are side up....
@@ -443,11 +457,8 @@ bool SignalRegion::fillEnergies(const unsigned ievt,
     double dy = posy-refy[layer];
     double dr = sqrt(dx*dx+dy*dy);
 
-    MyRecoHit ltmpHit;
-    ltmpHit.dR = dr;
-    ltmpHit.E = energy*absweight_[layer];
-    lhitvec[layer].push_back(ltmpHit);
-    lhitvectotal.push_back(ltmpHit);
+    profile_.add(layer,dr,energy*absweight_[layer]);
+    p_EvsdR[layer]->Fill(dr,energy*absweight_[layer]);
     E100_[layer] += energy*absweight_[layer];
     
 
@@ -503,46 +514,14 @@ bool SignalRegion::fillEnergies(const unsigned ievt,
 
   //fill 68 and 90% containment radius
   for (unsigned iL(0);iL<nLayers_;++iL){
-    std::sort(lhitvec[iL].begin(), lhitvec[iL].end(), customdRsort);
-    double Esum = 0;
-    //std::cout << " -- Layer: " << iL << " nH = " << lhitvec[iL].size() << std::endl;
-    for (unsigned iH(0); iH<lhitvec[iL].size(); ++iH){
-      //std::cout << " ---- " << iH << " dR " << lhitvec[iL][iH].dR 
-      //	<< " Esum " << Esum
-      //	<< " E100 " << E100_[iL] 
-      //	<< " (68%=" << 0.68*E100_[iL] << ")"
-      //	<< " E68 " << E68_[iL]
-      //	<< " dR68 " << dR68_[iL]
-      //	<< std::endl;
-      //if (lhitvec[iL][iH].dR>0) 
-      Esum += lhitvec[iL][iH].E;
-      p_EsumfracvsdR[iL]->Fill(lhitvec[iL][iH].dR,Esum/E100_[iL]);
-      p_EvsdR[iL]->Fill(lhitvec[iL][iH].dR,lhitvec[iL][iH].E);
-      p_dR[iL]->Fill(lhitvec[iL][iH].dR,lhitvec[iL][iH].E);
-      if (Esum<0.68*E100_[iL]) {
-	dR68_[iL] = lhitvec[iL][iH].dR;
-	E68_[iL] = Esum;
-      }
-      if (Esum<0.9*E100_[iL]){
-	dR90_[iL] = lhitvec[iL][iH].dR;
-	E90_[iL] = Esum;
-      }
-    }
+    dR68_[iL] = profile_.radius(iL,0.68,E68_[iL]);
+    dR90_[iL] = profile_.radius(iL,0.9,E90_[iL]);
+    profile_.fillHistograms(iL,p_dR[iL],p_EsumfracvsdR[iL]);
   }
 
   //fill moliere radius total
-  std::sort(lhitvectotal.begin(), lhitvectotal.end(), customdRsort);
-  double Esum = 0;
-  for (unsigned iH(0); iH<lhitvectotal.size(); ++iH){
-    //std::cout << iL << " " << iH << " " << lhitvec[iL][iH].dR << std::endl;
-    Esum += lhitvectotal[iH].E;
-    if (Esum<0.68*wgttotalE_) {
-      mR68_ = lhitvectotal[iH].dR;
-    }
-    if (Esum<0.9*wgttotalE_){
-      mR90_ = lhitvectotal[iH].dR;
-    }
-  }
+  mR68_ = profile_.totalRadius(0.68);
+  mR90_ = profile_.totalRadius(0.9);
 
   /*for (unsigned iL(0);iL<nLayers_;++iL){
     const HGCSSRecoHit & lmaxHit = rechitvec[maxH[iL]];
@@ -1,328 +1,243 @@
 #include "parameterScan.hh"
-#include "TStyle.h"
-#include "TLatex.h"
-#include "TGraph.h"
 #include <cmath>
 #include <iostream>
 #include <fstream>
 #include <sstream>
 #include <iomanip>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
 
+//margin on the pruning bounds, so that rounding never prunes
+//a model the final selection would accept
+static const double scanTolerance = 1e-6;
 
-void parameterScan::process30layers(){
-  
-  const unsigned nBlocks = 5;
-  std::vector<unsigned>idx;
-  idx.resize(nBlocks,0);
-  for (unsigned iB(0); iB<nBlocks;++iB){
-    idx[iB] = 3*iB;
+void parameterScan::setDefaultBlocks(){
+  blocks.clear();
+  const unsigned nPairs = nLayers/2;
+  const unsigned size = nPairs>=12 ? 3 : 2;
+  unsigned remaining = nPairs;
+  for (unsigned iB(0); iB<4 && remaining>0; ++iB){
+    const unsigned n = remaining<size ? remaining : size;
+    blocks.push_back(n);
+    remaining -= n;
   }
-  
-  for (iS[0]=0; iS[0]<nSteps;++iS[0]){
-    std::cout << " Processing iS0 = " << iS[0] << std::endl;
-    iS[1] = iS[0];
-    iS[2] = iS[0];
-    for (iS[3]=0; iS[3]<nSteps;++iS[3]){
-      iS[4] = iS[3];
-      iS[5] = iS[3];
-      for (iS[6]=0; iS[6]<nSteps;++iS[6]){
-	iS[7] = iS[6];
-	iS[8] = iS[6];
-	for (iS[9]=0; iS[9]<nSteps;++iS[9]){
-	  iS[10] = iS[9];
-	  iS[11] = iS[9];
-	  for (iS[12]=0; iS[12]<nSteps;++iS[12]){
-	    iS[13] = iS[12];
-	    iS[14] = iS[12];
-	    
-	    processModel(nBlocks,idx);
-	    
-	  }//loop on S12
-	}//loop on S9
-      }//loop on S6
-    }//loop on S3
-  }//loop on S0
-  
-}//process30lay
+  if (remaining>0) blocks.push_back(remaining);
+}
 
-void parameterScan::process28layers(){
-  
-  const unsigned nBlocks = 5;
-  std::vector<unsigned>idx;
-  idx.resize(nBlocks,0);
-  for (unsigned iB(0); iB<nBlocks;++iB){
-    idx[iB] = 3*iB;
-  }
-  
-  for (iS[0]=0; iS[0]<nSteps;++iS[0]){
-    std::cout << " Processing iS0 = " << iS[0] << std::endl;
-    iS[1] = iS[0];
-    iS[2] = iS[0];
-    for (iS[3]=0; iS[3]<nSteps;++iS[3]){
-      iS[4] = iS[3];
-      iS[5] = iS[3];
-      for (iS[6]=0; iS[6]<nSteps;++iS[6]){
-	iS[7] = iS[6];
-	iS[8] = iS[6];
-	for (iS[9]=0; iS[9]<nSteps;++iS[9]){
-	  iS[10] = iS[9];
-	  iS[11] = iS[9];
-	  for (iS[12]=0; iS[12]<nSteps;++iS[12]){
-	    iS[13] = iS[12];
-	    
-	    processModel(nBlocks,idx);
-	    
-	  }//loop on S12
-	}//loop on S9
-      }//loop on S6
-    }//loop on S3
-  }//loop on S0
-  
-}//process28lay
+unsigned parameterScan::ruleBlock(const unsigned i) const{
+  const unsigned nB = blocks.size();
+  if (i>=4) return nB-1;
+  return i<nB ? i : nB-1;
+}
 
-void parameterScan::process26layers(){
-  
-  const unsigned nBlocks = 5;
-  std::vector<unsigned>idx;
-  idx.resize(nBlocks,0);
-  for (unsigned iB(0); iB<nBlocks;++iB){
-    idx[iB] = 3*iB;
+void parameterScan::initialiseTree(TTree *outTree){
+  if (blocks.empty()) setDefaultBlocks();
+  outSteps_.resize(blocks.size(),0);
+  outTree->Branch("category",&outCategory_,"category/i");
+  outTree->Branch("X0",&outX0_,"X0/D");
+  outTree->Branch("length",&outLength_,"length/D");
+  outTree->Branch("lambda",&outLambda_,"lambda/D");
+  outTree->Branch("nBlocks",&outNBlocks_,"nBlocks/i");
+  outTree->Branch("steps",&outSteps_[0],"steps[nBlocks]/i");
+}
+
+void parameterScan::process(TTree *outTree){
+
+  if (blocks.empty()) setDefaultBlocks();
+  const unsigned nB = blocks.size();
+
+  firstPair_.assign(nB,0);
+  dThick_.assign(nB,0);
+  dX0_.assign(nB,0);
+  dL0_.assign(nB,0);
+  maxRemainingX0_.assign(nB+1,0);
+  unsigned nPairs = 0;
+  totModels = 1;
+  for (unsigned iB(0); iB<nB; ++iB){
+    firstPair_[iB] = nPairs;
+    nPairs += blocks[iB];
+    dThick_[iB] = blocks[iB]*(stepSizeW+stepSizePb);
+    dX0_[iB] = blocks[iB]*(stepSizeW/x0w+stepSizePb/x0pb);
+    dL0_[iB] = blocks[iB]*(stepSizeW/l0w+stepSizePb/l0pb);
+    totModels *= nSteps;
+  }
+  for (unsigned iB(nB); iB>0; --iB){
+    maxRemainingX0_[iB-1] = maxRemainingX0_[iB]+dX0_[iB-1]*(nSteps>0?nSteps-1:0);
+  }
+  if (nPairs != nLayers/2) {
+    std::cout << " -- Warning! blocks cover " << nPairs << " layer pairs for " << nLayers << " layers." << std::endl;
   }
-  
-  for (iS[0]=0; iS[0]<nSteps;++iS[0]){
-    std::cout << " Processing iS0 = " << iS[0] << std::endl;
-    iS[1] = iS[0];
-    iS[2] = iS[0];
-    for (iS[3]=0; iS[3]<nSteps;++iS[3]){
-      iS[4] = iS[3];
-      iS[5] = iS[3];
-      for (iS[6]=0; iS[6]<nSteps;++iS[6]){
-	iS[7] = iS[6];
-	iS[8] = iS[6];
-	for (iS[9]=0; iS[9]<nSteps;++iS[9]){
-	  iS[10] = iS[9];
-	  iS[11] = iS[9];
-	  for (iS[12]=0; iS[12]<nSteps;++iS[12]){
-	    
-	    processModel(nBlocks,idx);
-	    
-	  }//loop on S12
-	}//loop on S9
-      }//loop on S6
-    }//loop on S3
-  }//loop on S0
-  
-}//process26lay
 
-void parameterScan::process24layers(){
-  
-  const unsigned nBlocks = 4;
-  std::vector<unsigned>idx;
-  idx.resize(nBlocks,0);
-  for (unsigned iB(0); iB<nBlocks;++iB){
-    idx[iB] = 3*iB;
+  validModels = 0;
+  visitedModels = 0;
+  modelMap.clear();
+  counter.assign(nC,0);
+  if (outTree) outNBlocks_ = nB;
+
+  //one task per value of the first two blocks
+  const unsigned nTasks = nB>1 ? nSteps*nSteps : nSteps;
+  std::vector<Result> taskResults(nTasks);
+  std::vector<bool> done(nTasks,false);
+  std::mutex lMutex;
+  std::condition_variable lCond;
+  std::atomic<unsigned> nextTask(0);
+  //tasks written so far, workers stay within window of them
+  unsigned nMerged = 0;
+  const unsigned window = 2*nThreads;
+
+  auto worker = [&](){
+    unsigned task = 0;
+    while ((task = nextTask++) < nTasks){
+      {
+	std::unique_lock<std::mutex> lock(lMutex);
+	lCond.wait(lock,[&](){ return task < nMerged+window; });
+      }
+      Result lRes;
+      lRes.counter.resize(nC,0);
+      processTask(task,lRes);
+      std::lock_guard<std::mutex> lock(lMutex);
+      taskResults[task] = std::move(lRes);
+      done[task] = true;
+      lCond.notify_all();
+    }
+  };
+
+  std::vector<std::thread> threads;
+  for (unsigned iT(0); iT<nThreads; ++iT) threads.push_back(std::thread(worker));
+
+  //merge and write in task order
+  for (unsigned iT(0); iT<nTasks; ++iT){
+    if (nB>1 && iT%nSteps==0) std::cout << " Processing iS0 = " << iT/nSteps << std::endl;
+    Result lRes;
+    if (nThreads==0) {
+      lRes.counter.resize(nC,0);
+      processTask(iT,lRes);
+    }
+    else {
+      std::unique_lock<std::mutex> lock(lMutex);
+      lCond.wait(lock,[&](){ return done[iT]; });
+      std::swap(lRes,taskResults[iT]);
+      nMerged = iT+1;
+      lCond.notify_all();
+    }
+    validModels += lRes.validModels;
+    visitedModels += lRes.visitedModels;
+    for (unsigned iC(0); iC<nC; ++iC) counter[iC] += lRes.counter[iC];
+    for (std::map<double,unsigned>::const_iterator iter=lRes.modelMap.begin(); iter!=lRes.modelMap.end(); ++iter){
+      modelMap[iter->first] += iter->second;
+    }
+    if (!outTree) continue;
+    for (unsigned iM(0); iM<lRes.models.size(); ++iM){
+      const Model & lModel = lRes.models[iM];
+      outCategory_ = lModel.category;
+      outX0_ = lModel.X0;
+      outLength_ = lModel.length;
+      outLambda_ = lModel.lambda;
+      for (unsigned iB(0); iB<nB; ++iB) outSteps_[iB] = lRes.steps[iM*nB+iB];
+      outTree->Fill();
+    }
   }
-  //to not break conditions in processModel method which expects 5 blocks...
-  idx.push_back(9);
-  
-  for (iS[0]=0; iS[0]<nSteps;++iS[0]){
-    std::cout << " Processing iS0 = " << iS[0] << std::endl;
-    iS[1] = iS[0];
-    iS[2] = iS[0];
-    for (iS[3]=0; iS[3]<nSteps;++iS[3]){
-      iS[4] = iS[3];
-      iS[5] = iS[3];
-      for (iS[6]=0; iS[6]<nSteps;++iS[6]){
-	iS[7] = iS[6];
-	iS[8] = iS[6];
-	for (iS[9]=0; iS[9]<nSteps;++iS[9]){
-	  iS[10] = iS[9];
-	  iS[11] = iS[9];
 
-	    processModel(nBlocks,idx);
-	    
-	}//loop on S9
-      }//loop on S6
-    }//loop on S3
-  }//loop on S0
-  
-  
-}//process24lay
+  for (unsigned iT(0); iT<threads.size(); ++iT) threads[iT].join();
 
-void parameterScan::process22layers(){
-  
-  const unsigned nBlocks = 5;
-  std::vector<unsigned>idx;
-  idx.resize(nBlocks,0);
-  for (unsigned iB(0); iB<nBlocks;++iB){
-    idx[iB] = 2*iB;
+}
+
+void parameterScan::processTask(const unsigned task, Result & res) const{
+  std::vector<unsigned> steps(blocks.size(),0);
+  if (blocks.size()>1) {
+    steps[0] = task/nSteps;
+    const double thick = length+steps[0]*dThick_[0];
+    const double x0 = X0tot+steps[0]*dX0_[0];
+    const double l0 = L0tot+steps[0]*dL0_[0];
+    if (thick>maxThick+scanTolerance || l0>maxLambda+scanTolerance) return;
+    if (x0+maxRemainingX0_[1]<minX0-scanTolerance) return;
+    //second block fixed by the task
+    steps[1] = task%nSteps;
+    if (blocks.size()==2 && steps[1]<steps[0]) return;
+    const double thick1 = thick+steps[1]*dThick_[1];
+    const double x01 = x0+steps[1]*dX0_[1];
+    const double l01 = l0+steps[1]*dL0_[1];
+    if (thick1>maxThick+scanTolerance || l01>maxLambda+scanTolerance) return;
+    if (x01+maxRemainingX0_[2]<minX0-scanTolerance) return;
+    enumerate(2,steps,thick1,x01,l01,res);
   }
-  
-  for (iS[0]=0; iS[0]<nSteps;++iS[0]){
-    std::cout << " Processing iS0 = " << iS[0] << std::endl;
-    iS[1] = iS[0];
-    for (iS[2]=0; iS[2]<nSteps;++iS[2]){
-      iS[3] = iS[2];
-      for (iS[4]=0; iS[4]<nSteps;++iS[4]){
-	iS[5] = iS[4];
-	for (iS[6]=0; iS[6]<nSteps;++iS[6]){
-	  iS[7] = iS[6];
-	  for (iS[8]=0; iS[8]<nSteps;++iS[8]){
-	    iS[9] = iS[8];
-	    iS[10] = iS[8];
-	    processModel(nBlocks,idx);
-	  }//loop on S8
-	}//loop on S6
-      }//loop on S4
-    }//loop on S2
-  }//loop on S0
-  
-}//process22lay
+  else {
+    steps[0] = task;
+    enumerate(1,steps,length+task*dThick_[0],X0tot+task*dX0_[0],L0tot+task*dL0_[0],res);
+  }
+}
 
-void parameterScan::process20layers(){
-  
-  const unsigned nBlocks = 5;
-  std::vector<unsigned>idx;
-  idx.resize(nBlocks,0);
-  for (unsigned iB(0); iB<nBlocks;++iB){
-    idx[iB] = 2*iB;
+void parameterScan::enumerate(const unsigned iB, std::vector<unsigned> & steps,
+			      const double thick, const double x0, const double l0,
+			      Result & res) const{
+  if (iB==blocks.size()) {
+    processModel(steps,res);
+    return;
   }
-  
-  for (iS[0]=0; iS[0]<nSteps;++iS[0]){
-    std::cout << " Processing iS0 = " << iS[0] << std::endl;
-    iS[1] = iS[0];
-    for (iS[2]=0; iS[2]<nSteps;++iS[2]){
-      iS[3] = iS[2];
-      for (iS[4]=0; iS[4]<nSteps;++iS[4]){
-	iS[5] = iS[4];
-	for (iS[6]=0; iS[6]<nSteps;++iS[6]){
-	  iS[7] = iS[6];
-	  for (iS[8]=0; iS[8]<nSteps;++iS[8]){
-	    iS[9] = iS[8];
-	    processModel(nBlocks,idx);
-	  }//loop on S8
-	}//loop on S6
-      }//loop on S4
-    }//loop on S2
-  }//loop on S0
-  
-}//process22lay
+  //the last block cannot be thinner than the first two
+  unsigned first = 0;
+  if (iB==blocks.size()-1) {
+    first = steps[ruleBlock(0)];
+    if (steps[ruleBlock(1)]>first) first = steps[ruleBlock(1)];
+  }
+  for (unsigned s(first); s<nSteps; ++s){
+    const double lThick = thick+s*dThick_[iB];
+    const double lX0 = x0+s*dX0_[iB];
+    const double lL0 = l0+s*dL0_[iB];
+    //thickness and lambda only grow with s
+    if (lThick>maxThick+scanTolerance || lL0>maxLambda+scanTolerance) break;
+    if (lX0+maxRemainingX0_[iB+1]<minX0-scanTolerance) continue;
+    steps[iB] = s;
+    enumerate(iB+1,steps,lThick,lX0,lL0,res);
+  }
+}
 
-bool parameterScan::processModel(const unsigned nBlocks,
-				 const std::vector<unsigned> & idx){
-  totModels++;
-  
-  //set thick array
+void parameterScan::processModel(const std::vector<unsigned> & steps, Result & res) const{
+  res.visitedModels++;
+
+  //same sums as per layer pair
   double totthick = length;
   double xtot=X0tot;
   double ltot=L0tot;
-  std::vector<double> wThick;
-  std::vector<double> pbThick;
-  wThick.resize(nLayers/2,0);
-  pbThick.resize(nLayers/2,0);
-  
-  for (unsigned iL(0); iL<nLayers/2;++iL){
-    wThick[iL] = iS[iL]*stepSizeW;
-    pbThick[iL] = iS[iL]*stepSizePb;
-    totthick += wThick[iL]+pbThick[iL];
-    xtot += wThick[iL]/x0w+pbThick[iL]/x0pb;
-    ltot += wThick[iL]/l0w+pbThick[iL]/l0pb;
+  for (unsigned iB(0); iB<blocks.size(); ++iB){
+    for (unsigned iP(0); iP<blocks[iB]; ++iP){
+      const double wThick = steps[iB]*stepSizeW;
+      const double pbThick = steps[iB]*stepSizePb;
+      totthick += wThick+pbThick;
+      xtot += wThick/x0w+pbThick/x0pb;
+      ltot += wThick/l0w+pbThick/l0pb;
+    }
   }
-  
+
   //filter
-  if (totthick > maxThick || xtot<minX0 || ltot>maxLambda) return false;
+  if (totthick > maxThick || xtot<minX0 || ltot>maxLambda) return;
+  const unsigned s0 = steps[ruleBlock(0)];
+  const unsigned s1 = steps[ruleBlock(1)];
+  const unsigned s2 = steps[ruleBlock(2)];
+  const unsigned s3 = steps[ruleBlock(3)];
+  const unsigned s4 = steps[ruleBlock(4)];
   //reject obvious wrong models...
-  if (iS[idx[0]]>iS[idx[1]] && iS[idx[1]]>iS[idx[2]] && iS[idx[2]]>iS[idx[3]] && iS[idx[3]]>iS[idx[4]]) return false;
-  if (iS[idx[0]]>iS[idx[4]] || iS[idx[1]]>iS[idx[4]]) return false;
-  //if (iS[idx[0]]>iS[idx[3]] || iS[idx[1]]>iS[idx[3]]) continue;
-  
-  //std::cout << " - Model kept: Total length = " << totthick << "mm, nX0 = " << xtot << ", nL0 = " << ltot << std::endl;
-  
-  //std::cout << " ---- Model Kept ! ---- " << std::endl
-  //	      << "Total length = " << totthick
-  //	      << "mm, nX0 = " << xtot
-  //	      << ", nL0 = " << ltot << std::endl;
-  //for (unsigned iL(0); iL<nLayers/2;++iL){
-  //std::cout << "Layer pair " << iL << ": " << iS[iL] << " " << wThick[iL] << " " << pbThick[iL] << std::endl;
-  //}
-  validModels++;
-  
-  float block[nBlocks];
-  float extraW[nBlocks];
-  for (unsigned iB(0); iB<nBlocks;++iB){
-    block[iB] = iB;
-    extraW[iB] = iS[idx[iB]]*stepSizeW/x0w;
-  }
-  
-  TGraph *tmp = new TGraph(nBlocks,block,extraW);
-  tmp->SetMaximum(nSteps*stepSizeW/x0w);
-  tmp->SetMinimum(0);
-  if (iS[idx[0]]<iS[idx[1]] && iS[idx[1]]<iS[idx[2]] && iS[idx[2]]<iS[idx[3]] && iS[idx[3]]<=iS[idx[4]]) {
-    tmp->SetTitle("1<2<3<4<5;block;extra thickness (X0)");
-    myc[0]->cd();
-    tmp->SetLineColor(counter[0]%9+1);
-    tmp->Draw(first[0]?"AL":"L");
-    first[0] = false;
-    counter[0]++;
-    /*std::cout << " --- " << xtot << " " << totthick << " " << ltot 
-      << " " << iS[0] << " " << iS[3] << " " << iS[6]
-      << " " << iS[9] << " " << iS[12]
-      << std::endl;*/
-  }
-  else if (iS[idx[0]]>iS[idx[1]] && iS[idx[1]]>iS[idx[2]] && iS[idx[2]]<iS[idx[3]] && iS[idx[3]]<=iS[idx[4]]) {
-    tmp->SetTitle("1>2>3<4<5;block;extra thickness (X0)");
-    myc[1]->cd();
-    tmp->SetLineColor(counter[1]%9+1);
-    tmp->Draw(first[1]?"AL":"L");
-    first[1] = false;
-    counter[1]++;
-    /*std::cout << " --- " << xtot << " " << totthick << " " << ltot 
-      << " " << iS[0] << " " << iS[3] << " " << iS[6]
-      << " " << iS[9] << " " << iS[12]
-      << std::endl;*/
-  }
-  else if (iS[idx[0]]<iS[idx[1]] && iS[idx[1]]<iS[idx[2]] && iS[idx[2]]>iS[idx[3]] && iS[idx[3]]>=iS[idx[4]]) {
-    tmp->SetTitle("1<2<3>4>5;block;extra thickness (X0)");
-    myc[2]->cd();
-    tmp->SetLineColor(counter[2]%9+1);
-    tmp->Draw(first[2]?"AL":"L");
-    first[2] = false;
-    counter[2]++;
-    /*std::cout << " --- " << xtot << " " << totthick << " " << ltot 
-      << " " << iS[0] << " " << iS[3] << " " << iS[6]
-      << " " << iS[9] << " " << iS[12]
-      << std::endl;*/
-  }
-  else {
-    tmp->SetTitle("others;block;extra thickness (X0)");
-    myc[nC-1]->cd();
-    tmp->SetLineColor(counter[nC-1]%9+1);
-    tmp->Draw(first[nC-1]?"AL":"L");
-    first[nC-1] = false;
-    counter[nC-1]++;
-  }
-  //tmp->GetXaxis()->SetTitle();
-  
-  isInserted = modelMap.insert(std::pair<double,unsigned>(static_cast<unsigned>(xtot*100000)/100000.,1));
-  if (!isInserted.second) isInserted.first->second += 1;
-  //else std::cout << " ---- element inserted: " << xtot << " " << totthick << " " << ltot 
-  //	       << " " << iS[0] << " " << iS[3] << " " << iS[6]
-  //	       << " " << iS[9] << " " << iS[12]
-  //	       << std::endl;
-  
-  /*if (validModels>500) {
-    std::cout << " Warning!!! Too many valid models ! Stopping the scan..." << std::endl;
-    std::cout << " nValid = " << validModels << "/" << totModels << std::endl;
-    std::cout << " ---- Last Model ---- " << std::endl
-    << "Total length = " << totthick
-    << "mm, nX0 = " << xtot
-    << ", nL0 = " << ltot << std::endl;
-    for (unsigned iL(0); iL<nLayers/2;++iL){
-    std::cout << "Layer pair " << iL << ": " << iS[iL] << " " << minWthick+wThick[iL] << "mm " << minPbthick+pbThick[iL] << "mm" << std::endl;
-    }
-    return 1;
-    }*/
-  return true;
+  if (s0>s1 && s1>s2 && s2>s3 && s3>s4) return;
+  if (s0>s4 || s1>s4) return;
+
+  res.validModels++;
+
+  Model lModel;
+  if (s0<s1 && s1<s2 && s2<s3 && s3<=s4) lModel.category = cat_Ordered;
+  else if (s0>s1 && s1>s2 && s2<s3 && s3<=s4) lModel.category = cat_DownUp;
+  else if (s0<s1 && s1<s2 && s2>s3 && s3>=s4) lModel.category = cat_UpDown;
+  else lModel.category = cat_Others;
+  res.counter[lModel.category]++;
+
+  res.modelMap[static_cast<unsigned>(xtot*100000)/100000.] += 1;
+
+  lModel.X0 = xtot;
+  lModel.length = totthick;
+  lModel.lambda = ltot;
+  res.models.push_back(lModel);
+  res.steps.insert(res.steps.end(),steps.begin(),steps.end());
 }
 
 void parameterScan::print(){
@@ -340,7 +255,11 @@ void parameterScan::print(){
   
   std::cout <<  "Number of steps = " << nSteps << std::endl;
   
-  std::cout << "Number of layer pair: " << iS.size()  << std::endl;
+  std::cout << "Number of layer pair: " << nLayers/2  << std::endl;
+  std::cout << "Pairs per block: ";
+  for (unsigned iB(0); iB<blocks.size(); ++iB) std::cout << blocks[iB] << " ";
+  std::cout << std::endl;
+  std::cout << "Number of threads = " << nThreads << std::endl;
 
   std::cout << " ------------------------------------- " << std::endl;
   std::cout << " ------------------------------------- " << std::endl;
@@ -35,6 +35,7 @@
 #include "HGCSSDetector.hh"
 #include "HGCSSGeometryConversion.hh"
 #include "HGCSSPUenergy.hh"
+#include "HGCSSFileCatalogue.hh"
 
 #include "PositionFit.hh"
 #include "SignalRegion.hh"
@@ -44,20 +45,11 @@
 #include "Math/Point2D.h"
 #include "Math/Point2Dfwd.h"
 
+#include "utilities.h"
+
 using boost::lexical_cast;
 namespace po=boost::program_options;
 
-bool testInputFile(std::string input, TFile* & file){
-  file = TFile::Open(input.c_str());
-  
-  if (!file) {
-    std::cout << " -- Error, input file " << input.c_str() << " cannot be opened. Skipping..." << std::endl;
-    return false;
-  }
-  else std::cout << " -- input file " << file->GetName() << " successfully opened." << std::endl;
-  return true;
-};
-
 
 int main(int argc, char** argv){//main  
 
@@ -73,6 +65,7 @@ int main(int argc, char** argv){//main
   std::string filePath;
   std::string digifilePath;
   unsigned nRuns;
+  std::string catalogueFile;//file catalogue (bin/catalogue) of the inputs
   std::string simFileName;
   std::string recoFileName;
   std::string outPath;
@@ -81,6 +74,11 @@ int main(int argc, char** argv){//main
   unsigned redoStep;
   unsigned debug;
   bool applyPuMixFix;
+  //containment radii from the sorted hits of the crossing dR bin
+  bool exactContainment;
+  //PU density measured in each event, outside a cone of puConeDR
+  bool eventPU;
+  double puConeDR;
 
   po::options_description preconfig("Configuration"); 
   preconfig.add_options()("cfg,c",po::value<std::string>(&cfg)->required());
@@ -97,6 +95,7 @@ int main(int argc, char** argv){//main
     ("filePath,i",     po::value<std::string>(&filePath)->required())
     ("digifilePath", po::value<std::string>(&digifilePath)->default_value(""))
     ("nRuns",        po::value<unsigned>(&nRuns)->default_value(0))
+    ("catalogue",    po::value<std::string>(&catalogueFile)->default_value(""))
     ("simFileName,s",  po::value<std::string>(&simFileName)->required())
     ("recoFileName,r", po::value<std::string>(&recoFileName)->required())
     ("outPath,o",      po::value<std::string>(&outPath)->required())
@@ -104,6 +103,9 @@ int main(int argc, char** argv){//main
     ("redoStep",       po::value<unsigned>(&redoStep)->default_value(0))
     ("debug,d",        po::value<unsigned>(&debug)->default_value(0))
     ("applyPuMixFix",  po::value<bool>(&applyPuMixFix)->default_value(false))
+    ("exactContainment", po::value<bool>(&exactContainment)->default_value(false))
+    ("eventPU",        po::value<bool>(&eventPU)->default_value(false))
+    ("puConeDR",       po::value<double>(&puConeDR)->default_value(0.3))
     ;
 
   // ("output_name,o",            po::value<std::string>(&outputname)->default_value("tmp.root"))
@@ -150,7 +152,11 @@ int main(int argc, char** argv){//main
 
   //std::cout << inputsim.str() << " " << inputrec.str() << std::endl;
 
-  HGCSSInfo * info;
+  HGCSSInfo * info = 0;
+
+  //catalogued inputs are added with their entries without being opened
+  HGCSSFileCatalogue catalogue;
+  if (catalogueFile.size()>0 && !catalogue.read(catalogueFile)) return 1;
 
   TChain *lSimTree = new TChain("HGCSSTree");
   TChain *lRecTree = 0;
@@ -163,31 +169,27 @@ int main(int argc, char** argv){//main
   else lRecTree = new TChain("PUTree");
 
   if (nRuns == 0){
-    if (!testInputFile(inputsim.str(),simFile)) return 1;
-    lSimTree->AddFile(inputsim.str().c_str());
-    if (!testInputFile(inputrec.str(),recFile)) return 1;
-    lRecTree->AddFile(inputrec.str().c_str());
+    if (!addInputFile(lSimTree,inputsim.str(),simFile,&catalogue)) return 1;
+    info = getInputInfo(inputsim.str(),simFile,&catalogue);
+    if (!addInputFile(lRecTree,inputrec.str(),recFile,&catalogue)) return 1;
   }
   else {
     for (unsigned i(0);i<nRuns;++i){
       std::ostringstream lstr;
       lstr << inputsim.str() << "_run" << i << ".root";
-      if (testInputFile(lstr.str(),simFile)){  
-	if (simFile) info =(HGCSSInfo*)simFile->Get("Info");
-	else {
-	  std::cout << " -- Error in getting information from simfile!" << std::endl;
-	  return 1;
-	}
-      }
-      else continue;
-      lSimTree->AddFile(lstr.str().c_str());
+      if (!addInputFile(lSimTree,lstr.str(),simFile,&catalogue)) continue;
+      if (!info) info = getInputInfo(lstr.str(),simFile,&catalogue);
       lstr.str("");
       lstr << inputrec.str() << "_run" << i << ".root";
-      if (!testInputFile(lstr.str(),recFile)) continue;
-      lRecTree->AddFile(lstr.str().c_str());
+      if (!addInputFile(lRecTree,lstr.str(),recFile,&catalogue)) continue;
     }
   }
 
+  if (!info){
+    std::cout << " -- Error, no Info found for the input files. Exiting..." << std::endl;
+    return 1;
+  }
+
   if (!lSimTree){
     std::cout << " -- Error, tree HGCSSTree cannot be opened. Exiting..." << std::endl;
     return 1;
@@ -217,6 +219,10 @@ int main(int argc, char** argv){//main
 	    << ", model = " << model
 	    << ", cellSize = " << cellSize
 	    << std::endl;
+  if (info->hasRoI()) std::cout << " -- Sim region of interest: deltaEta = " << info->roiDeltaEta()
+				 << ", deltaPhi = " << info->roiDeltaPhi()
+				 << ", killed tracks = " << info->nKilledRoI()
+				 << std::endl;
 
 
   //initialise detector
@@ -271,6 +277,7 @@ int main(int argc, char** argv){//main
 
   PositionFit lChi2Fit(nSR,residualMax,nLayers,nSiLayers,applyPuMixFix,debug);
   lChi2Fit.initialise(outputFile,"PositionFit",outFolder,geomConv,puDensity);
+  lChi2Fit.setEventPuDensity(eventPU,puConeDR);
 
 
   std::vector<double> zpos;
@@ -283,6 +290,8 @@ int main(int argc, char** argv){//main
   //perform loop over events to find positions to fit and get energies
   SignalRegion SignalEnergy(outFolder, nLayers, zpos, nEvts, geomConv, puDensity,applyPuMixFix,versionNumber);
   SignalEnergy.initialise(outputFile,"Energies");
+  SignalEnergy.setExactContainment(exactContainment);
+  SignalEnergy.setEventPuDensity(eventPU,puConeDR);
 
   //initialise
   bool dofit = redoStep>0 || !SignalEnergy.initialiseFitPositions();
@@ -55,7 +55,8 @@ void getValueFromString(std::vector<unsigned>& outputNumber, std::string& source
 };
 
 void getTotalEnergy(const std::vector<unsigned> & dropLay,
-		    TTree* & tree, double & sumEE, double & sumFH, double & sumBH, std::ostringstream& inputsim, std::ostringstream& inputrec, const unsigned nRunsEM=0){
+		    TTree* & tree, double & sumEE, double & sumFH, double & sumBH, std::ostringstream& inputsim, std::ostringstream& inputrec, const unsigned nRunsEM=0,
+		    const HGCSSFileCatalogue * catalogue=0){
 
     TFile * simFile = 0;
     TFile * recFile = 0;
@@ -63,27 +64,29 @@ void getTotalEnergy(const std::vector<unsigned> & dropLay,
     TChain  *lSimTree = new TChain("HGCSSTree");
     TChain  *lRecTree = new TChain("RecoTree");
 
+    std::string lastSim = inputsim.str();
     if (nRunsEM == 0){
-      if (!testInputFile(inputsim.str(),simFile)) return;
-      lSimTree->AddFile(inputsim.str().c_str());
-      if (!testInputFile(inputrec.str(),recFile)) return;
-      lRecTree->AddFile(inputrec.str().c_str());
+      if (!addInputFile(lSimTree,inputsim.str(),simFile,catalogue)) return;
+      if (!addInputFile(lRecTree,inputrec.str(),recFile,catalogue)) return;
     }
     else {
 
       for (unsigned i(0);i<nRunsEM;++i){
 	std::ostringstream tmpsim,tmprec;	
 	tmpsim << inputsim.str() << "_run" << i<< ".root";
-	if (!testInputFile(tmpsim.str(),simFile)) continue;
-	lSimTree->AddFile(tmpsim.str().c_str());
+	if (!addInputFile(lSimTree,tmpsim.str(),simFile,catalogue)) continue;
+	lastSim = tmpsim.str();
 	tmprec << inputrec.str() << "_run" << i<< ".root";
-	if (!testInputFile(tmprec.str(),recFile)) continue;
-	lRecTree->AddFile(tmprec.str().c_str());
+	if (!addInputFile(lRecTree,tmprec.str(),recFile,catalogue)) continue;
       }
     }
     bool hasDeDxIn = true;
 
-    HGCSSInfo * info=(HGCSSInfo*)simFile->Get("Info");
+    HGCSSInfo * info=getInputInfo(lastSim,simFile,catalogue);
+    if (!info) {
+      std::cout << " -- Error, no Info for " << lastSim << std::endl;
+      return;
+    }
     const unsigned versionNumber = info->version();
     std::cout << " -- version number = " << versionNumber << std::endl;
     //if (versionNumber==25 || versionNumber==27 || versionNumber==28) hasDeDxIn=true;
@@ -228,7 +231,8 @@ void setCalibFactor(const std::vector<unsigned> & dropLay,
 		    const std::vector<std::pair<std::string, std::string>> & fileName3, 
 		    TFile* outputFileEM,
 		    TCanvas *c1, TCanvas *c2, TCanvas *c3,
-		    TGraphErrors * slopesummaryEE,TGraphErrors * slopesummaryFH,TGraphErrors * slopesummaryBH){
+		    TGraphErrors * slopesummaryEE,TGraphErrors * slopesummaryFH,TGraphErrors * slopesummaryBH,
+		    const HGCSSFileCatalogue * catalogue=0){
 
   const unsigned nP = fileName1.size();
   if(fileName1.size() != genEn.size() || fileName1.size() != fileName2.size() || fileName1.size() != fileName3.size()){std::cout << "Got different number of EE/FH/BH files when set calibration factor" << std::endl; return;}
@@ -274,7 +278,7 @@ void setCalibFactor(const std::vector<unsigned> & dropLay,
       var << "E_BH";
       treeEE[iP]->Branch(var.str().c_str(),&sumBH);
 
-      getTotalEnergy(dropLay,treeEE[iP], sumEE, sumFH, sumBH, inputsim, inputrec,nRunsEM);
+      getTotalEnergy(dropLay,treeEE[iP], sumEE, sumFH, sumBH, inputsim, inputrec,nRunsEM,catalogue);
       //for(unsigned iE(0); iE < Etotal[0].size(); iE++)p_Energy1->Fill(Etotal[0][iE]);
       outputFileEM->cd();
       treeEE[iP]->Write();
@@ -332,7 +336,7 @@ void setCalibFactor(const std::vector<unsigned> & dropLay,
       var.str("");
       var << "E_BH";
       treeFH[iP]->Branch(var.str().c_str(),&sumBH);
-      getTotalEnergy(dropLay,treeFH[iP], sumEE, sumFH, sumBH, inputsim, inputrec,nRunsEM);
+      getTotalEnergy(dropLay,treeFH[iP], sumEE, sumFH, sumBH, inputsim, inputrec,nRunsEM,catalogue);
       //for(unsigned iE(0); iE < Etotal[1].size(); iE++)p_Energy2->Fill(Etotal[1][iE]);
       outputFileEM->cd();
       treeFH[iP]->Write();
@@ -388,7 +392,7 @@ void setCalibFactor(const std::vector<unsigned> & dropLay,
       var.str("");
       var << "E_BH";
       treeBH[iP]->Branch(var.str().c_str(),&sumBH);
-      getTotalEnergy(dropLay,treeBH[iP], sumEE, sumFH, sumBH, inputsim, inputrec,nRunsEM);
+      getTotalEnergy(dropLay,treeBH[iP], sumEE, sumFH, sumBH, inputsim, inputrec,nRunsEM,catalogue);
       outputFileEM->cd();
       treeBH[iP]->Write();
      //for(unsigned iE(0); iE < Etotal[1].size(); iE++)p_Energy3->Fill(Etotal[2][iE]);
@@ -521,6 +525,7 @@ int main(int argc, char** argv){//main
   std::string digifilePath;
   unsigned nRuns;
   unsigned nRunsEM;
+  std::string catalogueFiles;//csv list of file catalogues (bin/catalogue) of the inputs
   std::string genEnergy;
   std::string genEnergyEM;
   std::string simFileName;
@@ -555,6 +560,7 @@ int main(int argc, char** argv){//main
     ("filePath,i",     po::value<std::string>(&filePath)->required())
     ("nRuns",        po::value<unsigned>(&nRuns)->default_value(0))
     ("nRunsEM",        po::value<unsigned>(&nRunsEM)->default_value(0))
+    ("catalogue",      po::value<std::string>(&catalogueFiles)->default_value(""))
     ("genEnergy",    po::value<std::string>(&genEnergy)->required()) 
     ("genEnergyEM",    po::value<std::string>(&genEnergyEM)->required()) 
     ("simFileName,s",  po::value<std::string>(&simFileName)->required())
@@ -573,6 +579,10 @@ int main(int argc, char** argv){//main
   po::store(po::parse_config_file<char>(cfg.c_str(), config), vm);
   po::notify(vm);
 
+  //entries and Info of the inputs without opening them
+  HGCSSFileCatalogue catalogue;
+  if (!readCatalogues(catalogueFiles,catalogue)) return 1;
+
   //////////////////////////////////////////////////////////
   //// Hardcoded config ////////////////////////////////////
   //////////////////////////////////////////////////////////
@@ -661,7 +671,8 @@ int main(int argc, char** argv){//main
 		     eeFileName, fhFileName, bhFileName,
 		     outputFileEM,
 		     c1,c2,c3,
-		     slopesummaryEE,slopesummaryFH,slopesummaryBH); 
+		     slopesummaryEE,slopesummaryFH,slopesummaryBH,
+		     catalogueFiles.size()>0 ? &catalogue : 0); 
       //c1->SaveAs("EEcalibtoEM.png");
       //c2->SaveAs("FHcalibtoEM.png");
       //c3->SaveAs("BHcalibtoEM.png");
@@ -777,13 +788,12 @@ int main(int argc, char** argv){//main
      TChain  *lRecTree = new TChain("RecoTree");
    
      std::ostringstream inputsim, inputrec;
+     const HGCSSFileCatalogue * lCatalogue = catalogueFiles.size()>0 ? &catalogue : 0;
      if (nRuns == 0){
        inputsim << filePath << "/" << simHeader << genEn[iGen] << simAppend;
        inputrec << filePath << "/" << recHeader << genEn[iGen] << recAppend;;
-       if (!testInputFile(inputsim.str(),simFile)) return 1;
-       lSimTree->AddFile(inputsim.str().c_str());
-       if (!testInputFile(inputrec.str(),recFile)) return 1;
-       lRecTree->AddFile(inputrec.str().c_str());
+       if (!addInputFile(lSimTree,inputsim.str(),simFile,lCatalogue)) return 1;
+       if (!addInputFile(lRecTree,inputrec.str(),recFile,lCatalogue)) return 1;
      }
      else {
        for (unsigned i(0);i<nRuns;++i){
@@ -791,10 +801,8 @@ int main(int argc, char** argv){//main
          inputsim << filePath << "/" << simHeader << genEn[iGen] << simAppend << "_run" << i << ".root";
          inputrec.str("");
          inputrec << filePath << "/" << recHeader << genEn[iGen] << recAppend << "_run" << i << ".root";
-         if (!testInputFile(inputsim.str(),simFile)) return 1;
-         lSimTree->AddFile(inputsim.str().c_str());
-         if (!testInputFile(inputrec.str(),recFile)) return 1;
-         lRecTree->AddFile(inputrec.str().c_str());
+         if (!addInputFile(lSimTree,inputsim.str(),simFile,lCatalogue)) return 1;
+         if (!addInputFile(lRecTree,inputrec.str(),recFile,lCatalogue)) return 1;
        }
      }
 
@@ -819,7 +827,11 @@ int main(int argc, char** argv){//main
      // Info    ////////////////////
      ///////////////////////////////
    
-     HGCSSInfo * info=(HGCSSInfo*)simFile->Get("Info");
+     HGCSSInfo * info=getInputInfo(inputsim.str(),simFile,lCatalogue);
+     if (!info) {
+       std::cout << " -- Error, no Info for " << inputsim.str() << ". Exiting..." << std::endl;
+       return 1;
+     }
      const double cellSize = info->cellSize();
      const unsigned versionNumber = info->version();
      const unsigned model = info->model();
@@ -0,0 +1,156 @@
+#include<string>
+#include<vector>
+#include<iostream>
+#include<cstdlib>
+#include<cmath>
+#include <boost/algorithm/string.hpp>
+#include "boost/program_options.hpp"
+
+#include "TFile.h"
+
+#include "HGCSSGeometryConversion.hh"
+#include "HGCSSSimHit.hh"
+#include "LogWeightScan.hh"
+
+namespace po=boost::program_options;
+
+//Scan of the log-weighting w0 per layer, for several eta/pT samples,
+//in one read of the PositionFit EcellsSR2 trees.
+//./bin/logWeightScan -o <output root file> -l <label 1>,<label 2> -i <file 1>,<file 2>
+//  [-L 30] [--w0min 1] [--w0max 6] [--nW0 51] [--nStored 3] [--nUsed 3,23:5]
+//  [--shape 1] [--model 2] [--cellSize 0] [--truncation 5] [-t EcellsSR2] [-n 0]
+int main(int argc, char** argv){//main
+
+  std::string outPath;
+  std::string labels;
+  std::string inFiles;
+  unsigned nLayers;
+  double w0min;
+  double w0max;
+  unsigned nW0;
+  unsigned nStored;
+  std::string nUsed;
+  unsigned shape;
+  unsigned model;
+  double cellSize;
+  double truncation;
+  std::string treePath;
+  unsigned pNevts;
+
+  po::options_description config("Configuration");
+  config.add_options()
+    ("help,h", "print the options")
+    ("outFile,o",   po::value<std::string>(&outPath)->required())
+    //one label (eta/pT sample) per file
+    ("labels,l",    po::value<std::string>(&labels)->required())
+    ("inFiles,i",   po::value<std::string>(&inFiles)->required())
+    ("nLayers,L",   po::value<unsigned>(&nLayers)->default_value(30))
+    ("w0min",       po::value<double>(&w0min)->default_value(1))
+    ("w0max",       po::value<double>(&w0max)->default_value(6))
+    ("nW0",         po::value<unsigned>(&nW0)->default_value(51))
+    //cells per side in the tree
+    ("nStored",     po::value<unsigned>(&nStored)->default_value(3))
+    //cells per side used, n or firstLayer:n, e.g. 3,23:5
+    ("nUsed",       po::value<std::string>(&nUsed)->default_value(""))
+    //truth cell: 0 square grid of cellSize, 1 hexagon, 2 diamond, 3 triangle, 4 square
+    ("shape",       po::value<unsigned>(&shape)->default_value(1))
+    ("model",       po::value<unsigned>(&model)->default_value(2))
+    //mm, 0: the simulation cell size of the shape (square grid: 10)
+    ("cellSize",    po::value<double>(&cellSize)->default_value(0))
+    ("truncation",  po::value<double>(&truncation)->default_value(5))
+    ("treePath,t",  po::value<std::string>(&treePath)->default_value("EcellsSR2"))
+    //entries per file, 0: all
+    ("pNevts,n",    po::value<unsigned>(&pNevts)->default_value(0))
+    ;
+  po::variables_map vm;
+  po::store(po::command_line_parser(argc, argv).options(config).run(), vm);
+  if (vm.count("help")) {
+    std::cout << config << std::endl;
+    return 0;
+  }
+  po::notify(vm);
+
+  std::vector<std::string> lLabels;
+  std::vector<std::string> lFiles;
+  boost::split(lLabels,labels,boost::is_any_of(","));
+  boost::split(lFiles,inFiles,boost::is_any_of(","));
+  if (lLabels.size()!=lFiles.size()) {
+    std::cout << " -- Error! " << lFiles.size() << " files for " << lLabels.size() << " labels." << std::endl;
+    return 1;
+  }
+
+  //cell sizes of the simulation maps (EventAction, egammaResoWithTruth)
+  if (shape>4) {
+    std::cout << " -- Error! Unknown shape " << shape << "." << std::endl;
+    return 1;
+  }
+  if (shape==1) {
+    if (cellSize==0) cellSize = CELL_SIZE_X;
+    if (fabs(cellSize-CELL_SIZE_X)>0.01 && fabs(cellSize-FINE_CELL_SIZE_X)>0.01 && fabs(cellSize-ULTRAFINE_CELL_SIZE_X)>0.01) {
+      std::cout << " -- Error! Hexagon side " << cellSize << " mm is none of the simulated "
+		<< CELL_SIZE_X << ", " << FINE_CELL_SIZE_X << " or " << ULTRAFINE_CELL_SIZE_X << " mm." << std::endl;
+      return 1;
+    }
+  }
+  else if (shape==2 || shape==3) {
+    if (cellSize==0) cellSize = 10.;
+    if (fabs(cellSize-10.)>0.01) {
+      std::cout << " -- Error! The diamond and triangle maps are simulated with 10 mm cells only." << std::endl;
+      return 1;
+    }
+  }
+  else if (cellSize==0) cellSize = 10.;
+  if (cellSize<0) {
+    std::cout << " -- Error! Negative cell size " << cellSize << "." << std::endl;
+    return 1;
+  }
+
+  std::vector<unsigned> lUsed(nLayers,nStored);
+  if (!nUsed.empty()) {
+    std::vector<std::string> lRanges;
+    boost::split(lRanges,nUsed,boost::is_any_of(","));
+    for (unsigned iR(0); iR<lRanges.size(); ++iR){
+      unsigned firstLayer = 0;
+      std::string lN = lRanges[iR];
+      if (lN.find(":") != lN.npos) {
+	firstLayer = atoi(lN.substr(0,lN.find(":")).c_str());
+	lN = lN.substr(lN.find(":")+1);
+      }
+      for (unsigned iL(firstLayer); iL<nLayers; ++iL) lUsed[iL] = atoi(lN.c_str());
+    }
+  }
+
+  LogWeightScan lScan(nLayers,LogWeightScan::w0Range(w0min,w0max,nW0));
+  lScan.setNeighbourhood(nStored,lUsed);
+  lScan.setCellSize(cellSize);
+  lScan.setTruncation(truncation);
+
+  //bypassR,nSiLayers
+  HGCSSGeometryConversion geomConv(model,cellSize,false,3);
+  if (shape>0) {
+    const double xyWidth = geomConv.getXYwidth();
+    if (shape==2) geomConv.initialiseDiamondMap(xyWidth,cellSize);
+    else if (shape==3) geomConv.initialiseTriangleMap(xyWidth,cellSize*sqrt(2.));
+    else if (shape==4) geomConv.initialiseSquareMap(xyWidth,cellSize);
+    else geomConv.initialiseHoneyComb(xyWidth,cellSize);
+    lScan.setCellMap(geomConv,shape);
+  }
+
+  for (unsigned iF(0); iF<lFiles.size(); ++iF){
+    lScan.addPoint(lLabels[iF],lFiles[iF],treePath,pNevts);
+  }
+  if (lScan.nPoints()==0) return 1;
+
+  TFile *outputFile = TFile::Open(outPath.c_str(),"RECREATE");
+  if (!outputFile) {
+    std::cout << " -- Error, output file " << outPath << " cannot be opened. Exiting..." << std::endl;
+    return 1;
+  }
+  lScan.write(outputFile);
+  outputFile->Close();
+
+  lScan.print(std::cout);
+
+  return 0;
+
+}//main
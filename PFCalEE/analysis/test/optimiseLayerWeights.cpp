@@ -0,0 +1,71 @@
+#include<string>
+#include<vector>
+#include<iostream>
+#include<cstdlib>
+#include <boost/algorithm/string.hpp>
+#include "boost/program_options.hpp"
+
+#include "LayerWeightOptimizer.hh"
+
+namespace po=boost::program_options;
+
+//Layer weights minimising the energy resolution, from the per-layer
+//energies of PFCalEE output files at several gun energies.
+//./bin/optimiseLayerWeights -v <version> -m <model> -o <weights file>
+//  -i <PFcal_1.root>,<PFcal_2.root> -e <Etrue 1>,<Etrue 2> [-t 8] [-n 0] [--addCst]
+int main(int argc, char** argv){//main
+
+  unsigned version;
+  unsigned model;
+  std::string outFile;
+  std::string inFiles;
+  std::string energies;
+  unsigned nThreads;
+  unsigned pNevts;
+  bool addCst;
+
+  po::options_description config("Configuration");
+  config.add_options()
+    ("help,h", "print the options")
+    ("version,v",  po::value<unsigned>(&version)->required())
+    ("model,m",    po::value<unsigned>(&model)->required())
+    ("outFile,o",  po::value<std::string>(&outFile)->required())
+    //one gun energy (GeV) per file
+    ("inFiles,i",  po::value<std::string>(&inFiles)->required())
+    ("energies,e", po::value<std::string>(&energies)->required())
+    ("threads,t",  po::value<unsigned>(&nThreads)->default_value(8))
+    //entries per file, 0: all
+    ("pNevts,n",   po::value<unsigned>(&pNevts)->default_value(0))
+    //fit a constant term
+    ("addCst",     po::value<bool>(&addCst)->default_value(false)->implicit_value(true))
+    ;
+  po::variables_map vm;
+  po::store(po::command_line_parser(argc, argv).options(config).run(), vm);
+  if (vm.count("help")) {
+    std::cout << config << std::endl;
+    return 0;
+  }
+  po::notify(vm);
+
+  std::vector<std::string> lFiles;
+  std::vector<std::string> lEnergies;
+  boost::split(lFiles,inFiles,boost::is_any_of(","));
+  boost::split(lEnergies,energies,boost::is_any_of(","));
+  if (lFiles.size()!=lEnergies.size()) {
+    std::cout << " -- Error! " << lFiles.size() << " files for " << lEnergies.size() << " energies." << std::endl;
+    return 1;
+  }
+
+  LayerWeightOptimizer lOpt(version,model,addCst);
+  for (unsigned iF(0); iF<lFiles.size(); ++iF){
+    lOpt.addEnergyPoint(lFiles[iF],atof(lEnergies[iF].c_str()),pNevts);
+  }
+
+  if (!lOpt.accumulate(nThreads)) return 1;
+  if (!lOpt.solve()) return 1;
+  lOpt.print(std::cout);
+  if (!lOpt.writeWeights(outFile)) return 1;
+
+  return 0;
+
+}//main
@@ -9,6 +9,8 @@
 #include <boost/algorithm/string.hpp>
 
 #include "TH2F.h"
+#include "TFile.h"
+#include "TTree.h"
 #include "TCanvas.h"
 #include "TGraph.h"
 #include "TStyle.h"
@@ -157,6 +159,9 @@ int main(int argc, char** argv){//main
   if (argc < 2) {
     std::cout << " Usage: " 
 	      << argv[0] << " <nLayers>"
+	      << " <optional: nSteps (default=15)>"
+	      << " <optional: nThreads (default=0)>"
+	      << " <optional: max models drawn per category (default=1000)>"
 	      << std::endl;
     return 1;
   }
@@ -191,6 +196,7 @@ int main(int argc, char** argv){//main
 
   //TO do: add quick first check based on smaller and larger values :/
   unsigned nSteps = 15;
+  if (argc>2) nSteps = atoi(argv[2]);
   //if (nLayers == 30) nSteps = 14;
   scan.nSteps = nSteps;//8;
   
@@ -216,9 +222,9 @@ int main(int argc, char** argv){//main
   scan.X0tot = X0tot;
   scan.L0tot = L0tot;
 
-  (scan.iS).resize(nLayers/2,0);
-  scan.validModels = 0;
-  scan.totModels = 0;
+  scan.nThreads = argc>3 ? atoi(argv[3]) : 0;
+  const unsigned maxDrawn = argc>4 ? atoi(argv[4]) : 1000;
+  scan.setDefaultBlocks();
 
 
   scan.print();
@@ -271,36 +277,20 @@ int main(int argc, char** argv){//main
 
   //return 1;
 
-  const unsigned nC = 4;
-  scan.nC=nC;
-  scan.myc.resize(4,0);
-  scan.first.resize(4,0);
-  scan.counter.resize(4,0);
-  for (unsigned iC(0);iC<nC;++iC){
-    std::ostringstream label;
-    label << "myc" << iC;
-    scan.myc[iC] = new TCanvas(label.str().c_str(),
-			       label.str().c_str(),
-			       1);
-    scan.first[iC] = true;
-    scan.counter[iC] = 0;
+  //accepted models are stored in a tree and only drawn at the end
+  TFile *outputFile = TFile::Open(plotDir+"models.root","RECREATE");
+  if (!outputFile) {
+    std::cout << " -- Error, output file " << plotDir << "models.root cannot be opened. Exiting..." << std::endl;
+    return 1;
   }
+  outputFile->cd();
+  TTree *modelTree = new TTree("ModelTree","Accepted absorber configurations");
+  scan.initialiseTree(modelTree);
 
-  if (nLayers==30)
-    scan.process30layers();
-  else if (nLayers==28)
-    scan.process28layers();
-  else if (nLayers==26)
-    scan.process26layers();
-  else if (nLayers==24)
-    scan.process24layers();
-  else if (nLayers==22)
-    scan.process22layers();
-  else
-    scan.process20layers();
-
-
-  std::cout << " Found " << scan.validModels << " valid models out of " << scan.totModels << std::endl;
+  scan.process(modelTree);
+
+  std::cout << " Found " << scan.validModels << " valid models out of " << scan.totModels
+	    << ", " << scan.visitedModels << " tested after pruning." << std::endl;
   
   std::cout << " -- number of uniq X0tot: " << scan.modelMap.size() << std::endl;
   std::map<double,unsigned>::iterator iter;
@@ -318,20 +308,58 @@ int main(int argc, char** argv){//main
 
   gStyle->SetOptStat(0);
 
+  const unsigned nC = scan.nC;
+  const char* titles[4] = {"1<2<3<4<5","1>2>3<4<5","1<2<3>4>5","others"};
+  std::vector<TCanvas *> myc(nC,0);
+  std::vector<unsigned> nDrawn(nC,0);
+  for (unsigned iC(0);iC<nC;++iC){
+    std::ostringstream label;
+    label << "myc" << iC;
+    myc[iC] = new TCanvas(label.str().c_str(),label.str().c_str(),1);
+  }
+
+  const unsigned nBlocks = scan.blocks.size();
+  unsigned category = 0;
+  unsigned nB = 0;
+  std::vector<unsigned> steps(nBlocks,0);
+  modelTree->SetBranchAddress("category",&category);
+  modelTree->SetBranchAddress("nBlocks",&nB);
+  modelTree->SetBranchAddress("steps",&steps[0]);
+  std::vector<float> block(nBlocks,0);
+  std::vector<float> extraW(nBlocks,0);
+  for (unsigned iB(0); iB<nBlocks;++iB) block[iB] = iB;
+  for (Long64_t iM(0); iM<modelTree->GetEntries(); ++iM){
+    modelTree->GetEntry(iM);
+    if (category>=nC || nDrawn[category]>=maxDrawn) continue;
+    for (unsigned iB(0); iB<nBlocks;++iB) extraW[iB] = steps[iB]*scan.stepSizeW/scan.x0w;
+    TGraph *tmp = new TGraph(nBlocks,&block[0],&extraW[0]);
+    tmp->SetMaximum(nSteps*scan.stepSizeW/scan.x0w);
+    tmp->SetMinimum(0);
+    tmp->SetTitle((std::string(titles[category])+";block;extra thickness (X0)").c_str());
+    myc[category]->cd();
+    tmp->SetLineColor(nDrawn[category]%9+1);
+    tmp->Draw(nDrawn[category]==0?"AL":"L");
+    nDrawn[category]++;
+  }
+
   TLatex lat;
   char buf[500];
   for (unsigned iC(0);iC<nC;++iC){
-    sprintf(buf,"Number of models: %d",scan.counter[iC]);
-    scan.myc[iC]->cd();
+    sprintf(buf,"Number of models: %d (%d drawn)",scan.counter[iC],nDrawn[iC]);
+    myc[iC]->cd();
     lat.SetTextSize(0.05);
     lat.DrawLatexNDC(0.15,0.85,buf);
-    scan.myc[iC]->Update();
+    myc[iC]->Update();
   }
 
-  scan.myc[0]->Print(plotDir+"summary_ordered.pdf");
-  scan.myc[1]->Print(plotDir+"summary_downup.pdf");
-  scan.myc[2]->Print(plotDir+"summary_updown.pdf");
-  scan.myc[3]->Print(plotDir+"summary_others.pdf");
+  myc[0]->Print(plotDir+"summary_ordered.pdf");
+  myc[1]->Print(plotDir+"summary_downup.pdf");
+  myc[2]->Print(plotDir+"summary_updown.pdf");
+  myc[3]->Print(plotDir+"summary_others.pdf");
+
+  outputFile->cd();
+  modelTree->Write();
+  outputFile->Close();
 
   return 0;
   
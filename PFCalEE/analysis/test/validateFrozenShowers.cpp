@@ -0,0 +1,179 @@
+#include<string>
+#include<iostream>
+#include<fstream>
+#include<sstream>
+#include<iomanip>
+#include<cmath>
+
+#include "TFile.h"
+#include "TTree.h"
+#include "TH1F.h"
+#include "TProfile.h"
+
+#include "HGCSSSamplingSection.hh"
+#include "utilities.h"
+
+//Compare the per-layer energies of HGCSSSamplingSection between a full
+//simulation and a frozen shower (PFCalEE --frozenShowers) sample of the same gun.
+
+struct LayerSums {
+  std::vector<double> sum;
+  std::vector<double> sum2;
+  void resize(const unsigned n){ sum.resize(n,0); sum2.resize(n,0); };
+  void add(const unsigned iL, const double val){ sum[iL]+=val; sum2[iL]+=val*val; };
+  double mean(const unsigned iL, const unsigned n) const { return n>0 ? sum[iL]/n : 0; };
+  double rms(const unsigned iL, const unsigned n) const {
+    if (n==0) return 0;
+    const double m = mean(iL,n);
+    const double var = sum2[iL]/n-m*m;
+    return var>0 ? sqrt(var) : 0;
+  };
+};
+
+bool fillSample(const std::string & filePath, const unsigned pNevts,
+		const std::string & label, TFile *outputFile,
+		unsigned & nEvts, LayerSums & measured, LayerSums & absorber, LayerSums & total){
+
+  TFile *inputFile = 0;
+  if (!testInputFile(filePath,inputFile)) return false;
+  TTree *lTree = (TTree*)inputFile->Get("HGCSSTree");
+  if (!lTree){
+    std::cout << " -- Error, tree HGCSSTree cannot be opened in " << filePath << ". Exiting..." << std::endl;
+    return false;
+  }
+
+  std::vector<HGCSSSamplingSection> * ssvec = 0;
+  lTree->SetBranchAddress("HGCSSSamplingSectionVec",&ssvec);
+
+  nEvts = (pNevts > lTree->GetEntries() || pNevts==0) ? lTree->GetEntries() : pNevts;
+  std::cout << "- " << label << ": processing " << nEvts << " entries out of " << lTree->GetEntries() << std::endl;
+
+  outputFile->cd();
+  TH1F *p_measuredE = 0;
+  TH1F *p_totalE = 0;
+  TProfile *p_measuredVsLayer = 0;
+
+  for (unsigned ievt(0); ievt<nEvts; ++ievt){//loop on entries
+    if (ievt%100 == 0) std::cout << "... Processing entry: " << ievt << std::endl;
+    lTree->GetEntry(ievt);
+
+    const unsigned nLayers = (*ssvec).size();
+    if (ievt==0){
+      measured.resize(nLayers);
+      absorber.resize(nLayers);
+      total.resize(nLayers);
+      p_measuredVsLayer = new TProfile(("p_measuredVsLayer_"+label).c_str(),";layer;<E_{meas}> (MeV)",nLayers,0,nLayers);
+    }
+    else if (nLayers != measured.sum.size()){
+      std::cout << " -- Error, inconsistent number of layers in " << filePath << ". Exiting..." << std::endl;
+      return false;
+    }
+
+    double sumMeas = 0;
+    double sumTot = 0;
+    for (unsigned iL(0); iL<nLayers; ++iL){
+      const HGCSSSamplingSection & lSec = (*ssvec)[iL];
+      measured.add(iL,lSec.measuredE());
+      absorber.add(iL,lSec.absorberE());
+      total.add(iL,lSec.totalE());
+      p_measuredVsLayer->Fill(iL,lSec.measuredE());
+      sumMeas += lSec.measuredE();
+      sumTot += lSec.totalE();
+    }
+    if (!p_measuredE) {
+      p_measuredE = new TH1F(("p_measuredE_"+label).c_str(),";E_{meas} (MeV);events",500,0,5*sumMeas);
+      p_totalE = new TH1F(("p_totalE_"+label).c_str(),";E_{tot} (MeV);events",500,0,5*sumTot);
+    }
+    p_measuredE->Fill(sumMeas);
+    p_totalE->Fill(sumTot);
+  }
+  inputFile->Close();
+  return nEvts>0;
+}
+
+int main(int argc, char** argv){//main
+
+  if (argc < 4) {
+    std::cout << " Usage: "
+	      << argv[0] << " <full simulation PFcal.root>"
+	      << " <frozen shower PFcal.root>"
+	      << " <output root file>"
+	      << " <optional: nEntries to process (default=0=all)>"
+	      << std::endl;
+    return 1;
+  }
+
+  std::string fullPath = argv[1];
+  std::string fastPath = argv[2];
+  std::string outPath = argv[3];
+  unsigned pNevts = 0;
+  if (argc > 4) pNevts = atoi(argv[4]);
+
+  TFile *outputFile = TFile::Open(outPath.c_str(),"RECREATE");
+  if (!outputFile) {
+    std::cout << " -- Error, output file " << outPath << " cannot be opened. Exiting..." << std::endl;
+    return 1;
+  }
+
+  unsigned nFull = 0, nFast = 0;
+  LayerSums measFull, absFull, totFull;
+  LayerSums measFast, absFast, totFast;
+  if (!fillSample(fullPath,pNevts,"full",outputFile,nFull,measFull,absFull,totFull)) return 1;
+  if (!fillSample(fastPath,pNevts,"frozen",outputFile,nFast,measFast,absFast,totFast)) return 1;
+
+  if (measFull.sum.size() != measFast.sum.size()){
+    std::cout << " -- Error, samples have different numbers of layers: "
+	      << measFull.sum.size() << " vs " << measFast.sum.size() << std::endl;
+    return 1;
+  }
+  const unsigned nLayers = measFull.sum.size();
+
+  outputFile->cd();
+  TH1F *p_ratioMeasured = new TH1F("p_ratioMeasured",";layer;<E_{meas}> frozen/full",nLayers,0,nLayers);
+  TH1F *p_ratioAbsorber = new TH1F("p_ratioAbsorber",";layer;<E_{abs}> frozen/full",nLayers,0,nLayers);
+  TH1F *p_ratioTotal = new TH1F("p_ratioTotal",";layer;<E_{tot}> frozen/full",nLayers,0,nLayers);
+
+  std::cout << " -- Per-layer mean (RMS) energies in MeV, full vs frozen showers:" << std::endl
+	    << std::setw(6) << "layer"
+	    << std::setw(22) << "measuredE full"
+	    << std::setw(22) << "measuredE frozen"
+	    << std::setw(8) << "ratio"
+	    << std::setw(8) << "pull"
+	    << std::setw(8) << "absE"
+	    << std::setw(8) << "totE"
+	    << std::endl;
+
+  double maxPull = 0;
+  for (unsigned iL(0); iL<nLayers; ++iL){
+    const double mFull = measFull.mean(iL,nFull);
+    const double mFast = measFast.mean(iL,nFast);
+    const double rFull = measFull.rms(iL,nFull);
+    const double rFast = measFast.rms(iL,nFast);
+    const double ratio = mFull>0 ? mFast/mFull : 0;
+    const double err = sqrt(rFull*rFull/nFull+rFast*rFast/nFast);
+    const double pull = err>0 ? (mFast-mFull)/err : 0;
+    const double absRatio = absFull.mean(iL,nFull)>0 ? absFast.mean(iL,nFast)/absFull.mean(iL,nFull) : 0;
+    const double totRatio = totFull.mean(iL,nFull)>0 ? totFast.mean(iL,nFast)/totFull.mean(iL,nFull) : 0;
+    p_ratioMeasured->SetBinContent(iL+1,ratio);
+    if (mFull>0 && mFast>0) p_ratioMeasured->SetBinError(iL+1,ratio*sqrt(pow(rFull/mFull,2)/nFull+pow(rFast/mFast,2)/nFast));
+    p_ratioAbsorber->SetBinContent(iL+1,absRatio);
+    p_ratioTotal->SetBinContent(iL+1,totRatio);
+    if (fabs(pull)>maxPull) maxPull = fabs(pull);
+
+    std::cout << std::setw(6) << iL
+	      << std::setw(12) << std::setprecision(4) << mFull << " (" << std::setw(7) << rFull << ")"
+	      << std::setw(12) << mFast << " (" << std::setw(7) << rFast << ")"
+	      << std::setw(8) << ratio
+	      << std::setw(8) << pull
+	      << std::setw(8) << absRatio
+	      << std::setw(8) << totRatio
+	      << std::endl;
+  }
+  std::cout << " -- Largest |pull| on the layer measured energy: " << maxPull << std::endl;
+
+  outputFile->Write();
+  outputFile->Close();
+
+  return 0;
+
+}//main
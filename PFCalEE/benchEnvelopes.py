@@ -0,0 +1,52 @@
+#!/usr/bin/env python
+
+# Compare the flat geometry layout with the layer/subdetector envelopes
+# (PFCalEE --envelopes): same steering file and seed for each mode, CPU
+# and steps per event read from the --profile JSON summaries.
+
+import os, sys
+import argparse
+import json
+import subprocess
+
+parser = argparse.ArgumentParser(formatter_class=argparse.ArgumentDefaultsHelpFormatter)
+parser.add_argument('steer'                   ,                         help='steering macro, e.g. with /run/beamOn 50')
+parser.add_argument('-v', '--version'   , dest='version'   , type=int,  help='detector version', default=73)
+parser.add_argument('-m', '--model'     , dest='model'     , type=int,  help='detector model', default=2)
+parser.add_argument('-a', '--eta'       , dest='eta'       , type=float, help='incidence eta', default=2.)
+parser.add_argument(      '--modes'     , dest='modes'     , type=int,  help='envelope modes to run', nargs='+', default=[0,1,2])
+parser.add_argument(      '--smartless' , dest='smartless' ,            help='world,envelope smartless values', default='')
+parser.add_argument('-o', '--out'       , dest='out'       ,            help='output directory', default=os.getcwd())
+parser.add_argument(      '--exe'       , dest='exe'       ,            help='PFCalEE executable', default='PFCalEE')
+opt = parser.parse_args()
+
+modeNames = {0: 'flat', 1: 'layer', 2: 'subdet'}
+
+results = {}
+for mode in opt.modes:
+    prefix = os.path.join(opt.out, 'benchEnvelopes_%s' % modeNames.get(mode, str(mode)))
+    cmd = [opt.exe, opt.steer, '--version', str(opt.version), '--model', str(opt.model),
+           '--eta', str(opt.eta), '--envelopes', str(mode), '--profile', prefix]
+    if opt.smartless: cmd += ['--smartless', opt.smartless]
+    print(' -- running: ' + ' '.join(cmd))
+    with open(prefix + '.log', 'w') as log:
+        if subprocess.call(cmd, stdout=log, stderr=subprocess.STDOUT) != 0:
+            print(' -- ERROR! mode %d failed, see %s.log' % (mode, prefix))
+            continue
+    with open(prefix + '.json') as f:
+        results[mode] = json.load(f)
+
+if 0 not in results:
+    print(' -- WARNING! no flat reference, ratios not computed.')
+
+print('%8s %12s %12s %12s %14s %10s' % ('mode', 'cpu/evt(s)', 'wall/evt(s)', 'steps/evt', 'boundary/evt', 'cpu/flat'))
+for mode in sorted(results):
+    res = results[mode]
+    n = max(res['nEvents'], 1)
+    ratio = ''
+    if 0 in results and results[0]['cpuTime'] > 0:
+        ratio = '%10.3f' % ((res['cpuTime'] / n) / (results[0]['cpuTime'] / max(results[0]['nEvents'], 1)))
+    print('%8s %12.4f %12.4f %12.0f %14.0f %10s' % (modeNames.get(mode, str(mode)),
+                                                     res['cpuTime'] / n, res['wallTime'] / n,
+                                                     float(res['nSteps']) / n,
+                                                     float(res.get('nBoundarySteps', 0)) / n, ratio))
@@ -0,0 +1,77 @@
+#!/usr/bin/env python
+
+# Compare field propagation settings (/N03/det/field/ commands) with the
+# default configuration: the same steering file, with a field set by
+# /N03/det/setField, is run once per configuration with --profile.
+# Reports the CPU per event and the shift of the mean shower barycentre
+# (energy-weighted position of all deposits) w.r.t. the first configuration.
+
+import os, sys
+import argparse
+import json
+import math
+import subprocess
+
+defaultConfigs = [
+    ['default', ''],
+    ['deltaChord1mm', '/N03/det/field/deltaChord 1 mm'],
+    ['loose', '/N03/det/field/deltaChord 1 mm;/N03/det/field/deltaOneStep 0.1 mm;/N03/det/field/deltaIntersection 0.1 mm'],
+    ['helix', '/N03/det/field/stepper HelixExplicitEuler'],
+    ['noFieldInAbsorbers', '/N03/det/field/noFieldIn absorbers'],
+]
+
+parser = argparse.ArgumentParser(formatter_class=argparse.ArgumentDefaultsHelpFormatter)
+parser.add_argument('steer'                   ,                         help='steering macro with /N03/det/setField and /run/beamOn')
+parser.add_argument('-v', '--version'   , dest='version'   , type=int,  help='detector version', default=73)
+parser.add_argument('-m', '--model'     , dest='model'     , type=int,  help='detector model', default=2)
+parser.add_argument('-a', '--eta'       , dest='eta'       , type=float, help='incidence eta', default=2.)
+parser.add_argument('-c', '--config'    , dest='configs'   , nargs=2, action='append', metavar=('LABEL','COMMANDS'),
+                    help='configuration: label and ;-separated commands, the first one is the reference (default: built-in set)')
+parser.add_argument('-o', '--out'       , dest='out'       ,            help='output directory', default=os.getcwd())
+parser.add_argument(      '--exe'       , dest='exe'       ,            help='PFCalEE executable', default='PFCalEE')
+opt = parser.parse_args()
+
+configs = opt.configs if opt.configs else defaultConfigs
+with open(opt.steer) as f:
+    steerLines = f.readlines()
+
+results = []
+for label, commands in configs:
+    prefix = os.path.join(opt.out, 'benchField_%s' % label)
+    #settings first: they are kept and applied to the field when it is set
+    with open(prefix + '.mac', 'w') as mac:
+        for cmd in commands.split(';'):
+            if cmd.strip(): mac.write(cmd.strip() + '\n')
+        mac.writelines(steerLines)
+    cmd = [opt.exe, prefix + '.mac', '--version', str(opt.version), '--model', str(opt.model),
+           '--eta', str(opt.eta), '--profile', prefix]
+    print(' -- running %s: %s' % (label, ' '.join(cmd)))
+    with open(prefix + '.log', 'w') as log:
+        if subprocess.call(cmd, stdout=log, stderr=subprocess.STDOUT) != 0:
+            print(' -- ERROR! %s failed, see %s.log' % (label, prefix))
+            continue
+    with open(prefix + '.json') as f:
+        results.append([label, json.load(f)])
+
+if len(results) == 0 or results[0][0] != configs[0][0]:
+    print(' -- ERROR! reference configuration %s did not run.' % configs[0][0])
+    sys.exit(1)
+
+def showerMoments(res, axis):
+    sh = res['shower']
+    n = max(sh['n'], 1)
+    mean = sh['sum' + axis] / n
+    var = max(sh['sum' + axis + '2'] / n - mean * mean, 0)
+    return mean, math.sqrt(var / n)
+
+ref = results[0][1]
+refCpu = ref['cpuTime'] / max(ref['nEvents'], 1)
+print('%20s %12s %10s %18s %18s %18s' % ('config', 'cpu/evt(s)', 'cpu/ref', 'dX(mm)', 'dY(mm)', 'dZ(mm)'))
+for label, res in results:
+    cpu = res['cpuTime'] / max(res['nEvents'], 1)
+    shifts = []
+    for axis in ['X', 'Y', 'Z']:
+        mean, err = showerMoments(res, axis)
+        refMean, refErr = showerMoments(ref, axis)
+        shifts.append('%8.3f +- %6.3f' % (mean - refMean, math.sqrt(err * err + refErr * refErr)))
+    print('%20s %12.4f %10.3f %18s %18s %18s' % (label, cpu, cpu / refCpu if refCpu > 0 else 0, shifts[0], shifts[1], shifts[2]))
@@ -0,0 +1,57 @@
+#ifndef Checkpoint_h
+#define Checkpoint_h 1
+
+#include "globals.hh"
+
+#include <string>
+
+class TFile;
+class TTree;
+class HGCSSInfo;
+
+//Periodic checkpoints of the output file (PFCalEE --checkpoint <N>, --resume).
+//Every N events, and after the last event of the run, the Info, a
+//"Checkpoint" TObjString (number of events in the tree and the full
+//state of the random engine and distributions for the next event) and
+//an AutoSave of the tree are written to the output file.
+//With --resume an output with a consistent checkpoint is reopened: the
+//random state is restored at the start of the run, HepMC input events
+//already simulated are skipped and event numbers continue from the
+//checkpoint, so that the output is the same as for an uninterrupted job.
+//Without a usable checkpoint the job starts from scratch.
+//Only one /run/beamOn per job is supported.
+class Checkpoint
+{
+public:
+  Checkpoint(const unsigned every, const bool resume);
+  ~Checkpoint();
+
+  //open the output file, reopened if the job can be resumed
+  TFile *openOutput(const std::string & fileName);
+
+  inline bool resuming() const { return resuming_; };
+  //number of events in the reopened file
+  inline unsigned firstEvent() const { return firstEvent_; };
+  //Info of the reopened file, with the counters of the first events
+  inline const HGCSSInfo *resumedInfo() const { return resumedInfo_; };
+
+  //restore the random state and skip the input events, once per job.
+  //To be called from BeginOfRunAction, after the seeds of the macro are set.
+  void beginRun();
+
+  //to be called after the event is filled, lastEvent: last event of the run
+  void endEvent(TFile *outF, TTree *tree, HGCSSInfo *info, const bool lastEvent);
+
+private:
+
+  unsigned every_;
+  bool resume_;
+  bool resuming_;
+  bool restored_;
+  unsigned firstEvent_;
+  std::string engineState_;
+  HGCSSInfo *resumedInfo_;
+
+};
+
+#endif
@@ -4,6 +4,7 @@
 #include "SamplingSection.hh"
 
 #include "G4VUserDetectorConstruction.hh"
+#include "G4ThreeVector.hh"
 #include "globals.hh"
 
 #include <map>
@@ -16,8 +17,15 @@ class G4LogicalVolume;
 class G4VPhysicalVolume;
 class G4Material;
 class G4UniformMagField;
+class G4FieldManager;
+class G4ChordFinder;
+class G4MagIntegratorStepper;
+class G4Mag_UsualEqRhs;
 class DetectorMessenger;
 class G4Colour;
+class FrozenShowerModel;
+class FrozenShowerMessenger;
+class StartupCache;
 
 /**
    @class DetectorConstruction
@@ -27,6 +35,10 @@ class DetectorConstruction : public G4VUserDetectorConstruction
 {
 public:
 
+  //to be increased with any change of the geometry or material code:
+  //part of the startup cache key (StartupCache)
+  static const unsigned geometryRevision = 1;
+
   enum DetectorVersion {
     v_CALICE=0,
     v_HGCALEE_Si80=1,
@@ -132,6 +144,39 @@ public:
   const std::vector<G4LogicalVolume*>  & getSiLogVol() {return m_logicSi; }
   const std::vector<G4LogicalVolume*>  & getAlLogVol() {return m_logicAl; }
   const std::vector<G4LogicalVolume*>  & getAbsLogVol() {return m_logicAbs; }
+  const std::vector<G4LogicalVolume*>  & getEEAbsLogVol() {return m_logicEEAbs; }
+
+  enum FrozenShowerMode {
+    fs_OFF=0,
+    fs_GENERATE=1,
+    fs_REPLAY=2
+  };
+
+  /**
+     @short group the EE absorbers in the EEAbsorberReg region, and for fs_REPLAY
+     attach the frozen shower model reading libraryFile. To be called before Construct().
+   */
+  void SetFrozenShowers(const unsigned mode, const std::string & libraryFile="");
+
+  enum EnvelopeMode {
+    env_OFF=0,
+    env_LAYER=1,
+    env_SUBDET=2
+  };
+
+  /**
+     @short place the slabs of each layer (env_LAYER), and the layers of each
+     subdetector (env_SUBDET), in air envelopes instead of directly in the world.
+     smartless<=0 keeps the Geant4 default for the world/envelopes.
+     Slab names are unchanged. To be called before Construct().
+   */
+  void SetEnvelopes(const unsigned mode, const G4double smartlessWorld=0, const G4double smartlessEnvelope=0);
+
+  /**
+     @short read the geometry from a warm startup cache instead of constructing it.
+     To be called before Construct().
+   */
+  void SetStartupCache(StartupCache *cache) { m_startupCache = cache; }
 
 
   /**
@@ -148,6 +193,34 @@ public:
   void SetMagField(G4double fieldValue);
   G4UniformMagField* m_magField;      //pointer to the magnetic field
 
+  /**
+     @short field propagation settings, applied to the current field and to any field set later.
+     stepper: ClassicalRK4, SimpleRunge, SimpleHeum, CashKarpRKF45, DormandPrince745, NystromRK4,
+     HelixExplicitEuler, HelixImplicitEuler, HelixSimpleRunge, ExactHelix, "" for the Geant4 default.
+     Values <=0 keep the Geant4 defaults.
+   */
+  void SetFieldStepper(const std::string & stepper);
+  void SetFieldMinStep(G4double value);
+  void SetDeltaChord(G4double value);
+  void SetDeltaIntersection(G4double value);
+  void SetDeltaOneStep(G4double value);
+  void SetMinEpsilonStep(G4double value);
+  void SetMaxEpsilonStep(G4double value);
+
+  /**
+     @short no field in the volumes of the listed SamplingSection elements (e.g. "W,Pb"),
+     of all absorber elements ("absorbers"), or of the listed regions (e.g. "EEAbsorberReg").
+     "" attaches the field everywhere again.
+   */
+  void SetNoFieldIn(const std::string & list);
+
+  void PrintFieldSettings() const;
+
+  /**
+     @short attach the field-free manager to the volumes, after Construct()
+   */
+  void ConstructSDandField();
+
   /**
      @short set detector model
    */
@@ -241,6 +314,27 @@ private:
 			    const G4double & minL,
 			    const G4double & width);
 
+  //slab of the stack, position in the world frame
+  struct StackPlacement {
+    unsigned layer;
+    G4LogicalVolume *logi;
+    std::string name;
+    G4ThreeVector pos;
+    G4bool many;
+    G4VPhysicalVolume **vol;
+  };
+
+  //place the slabs in the world, or in envelopes following m_envelopeMode
+  void placeStack(const std::vector<StackPlacement> & slabs);
+
+  void buildFrozenShowerRegion();
+
+  //(re)build the chord finder and the field-free volumes from the settings
+  void applyFieldSettings();
+
+  //world from the startup cache GDML, 0 if not usable
+  G4VPhysicalVolume* loadCachedGeometry();
+
   G4double getCrackOffset(size_t layer);
   G4double getAngOffset(size_t layer);
 
@@ -272,6 +366,31 @@ private:
   std::vector<G4LogicalVolume*>   m_logicSi;    //pointer to the logical Si volumes
   std::vector<G4LogicalVolume*>   m_logicAl;    //pointer to the logical Si volumes
   std::vector<G4LogicalVolume*>   m_logicAbs;    //pointer to the logical absorber volumes situated just before the si
+  std::vector<G4LogicalVolume*>   m_logicEEAbs;    //pointer to the logical EE absorber volumes, for frozen showers
+
+  unsigned m_frozenShowerMode;
+  std::string m_frozenShowerLib;
+  FrozenShowerModel* m_frozenShowerModel;
+  FrozenShowerMessenger* m_frozenShowerMessenger;
+
+  StartupCache* m_startupCache;
+
+  std::string m_fieldStepperName;
+  G4double m_fieldMinStep;
+  G4double m_deltaChord;
+  G4double m_deltaIntersection;
+  G4double m_deltaOneStep;
+  G4double m_minEpsilonStep;
+  G4double m_maxEpsilonStep;
+  std::vector<std::string> m_noFieldIn;
+  G4Mag_UsualEqRhs* m_fieldEquation;
+  G4MagIntegratorStepper* m_fieldStepper;
+  G4ChordFinder* m_chordFinder;
+  G4FieldManager* m_noFieldManager;
+
+  unsigned m_envelopeMode;
+  G4double m_smartlessWorld;
+  G4double m_smartlessEnvelope;
 
   int m_coarseGranularity; //whether fine or coarse cells should be used
   DetectorMessenger* m_detectorMessenger;  //pointer to the Messenger
@@ -42,6 +42,7 @@ class G4UIdirectory;
 class G4UIcmdWithAString;
 class G4UIcmdWithAnInteger;
 class G4UIcmdWithADoubleAndUnit;
+class G4UIcmdWithADouble;
 class G4UIcmdWithoutParameter;
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -62,6 +63,17 @@ class DetectorMessenger: public G4UImessenger
     G4UIcmdWithADoubleAndUnit* MagFieldCmd;
     G4UIcmdWithAnInteger* SetModelCmd;
 
+    G4UIdirectory*             fieldDir;
+    G4UIcmdWithAString*        StepperCmd;
+    G4UIcmdWithADoubleAndUnit* MinStepCmd;
+    G4UIcmdWithADoubleAndUnit* DeltaChordCmd;
+    G4UIcmdWithADoubleAndUnit* DeltaIntersectionCmd;
+    G4UIcmdWithADoubleAndUnit* DeltaOneStepCmd;
+    G4UIcmdWithADouble*        MinEpsilonCmd;
+    G4UIcmdWithADouble*        MaxEpsilonCmd;
+    G4UIcmdWithAString*        NoFieldInCmd;
+    G4UIcmdWithoutParameter*   PrintFieldCmd;
+
 };
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -24,11 +24,16 @@
 
 class RunAction;
 class EventActionMessenger;
+class HGCSSInfo;
+class SimProfiler;
+class RegionOfInterest;
+class Checkpoint;
 
 class EventAction : public G4UserEventAction
 {
 public:
-  EventAction();
+  //checkpoint: periodic saves of the output, reopened if the job is resumed
+  EventAction(Checkpoint *checkpoint=0);
   virtual ~EventAction();
   void BeginOfEventAction(const G4Event*);
   void EndOfEventAction(const G4Event*);
@@ -48,6 +53,10 @@ public:
 
   bool isFirstVolume(const std::string volname) const;
 
+  void setProfiler(SimProfiler *profiler) { profiler_ = profiler; }
+
+  void setRegionOfInterest(RegionOfInterest *roi) { roi_ = roi; }
+
 private:
   RunAction*  runAct;
   std::vector<SamplingSection> *detector_;
@@ -57,6 +66,12 @@ private:
 
   TFile *outF_;
   TTree *tree_;
+  HGCSSInfo *info_;
+  SimProfiler *profiler_;
+  RegionOfInterest *roi_;
+  Checkpoint *checkpoint_;
+  //event beyond the end of a resumed run
+  bool skipEvent_;
   HGCSSEvent event_;
   HGCSSSamplingSectionVec ssvec_;
   HGCSSSimHitVec hitvec_;
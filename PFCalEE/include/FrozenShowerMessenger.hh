@@ -0,0 +1,36 @@
+#ifndef FrozenShowerMessenger_h
+#define FrozenShowerMessenger_h 1
+
+#include "globals.hh"
+#include "G4UImessenger.hh"
+
+class FrozenShowerModel;
+class ShowerLibraryBuilder;
+class G4UIdirectory;
+class G4UIcmdWithAnInteger;
+class G4UIcmdWithADoubleAndUnit;
+
+//commands for the frozen shower replay (model) or library generation (builder).
+//Only the commands of the non-null object are created.
+class FrozenShowerMessenger: public G4UImessenger
+{
+public:
+  FrozenShowerMessenger(FrozenShowerModel* model, ShowerLibraryBuilder* builder);
+  virtual ~FrozenShowerMessenger();
+
+  void SetNewValue(G4UIcommand*, G4String);
+
+private:
+  FrozenShowerModel* model_;
+  ShowerLibraryBuilder* builder_;
+
+  G4UIdirectory*             frozenDir;
+  G4UIcmdWithADoubleAndUnit* MinEnergyCmd;
+  G4UIcmdWithADoubleAndUnit* MaxEnergyCmd;
+  G4UIcmdWithAnInteger*      NEnergyBinsCmd;
+  G4UIcmdWithAnInteger*      NAngleBinsCmd;
+  G4UIcmdWithAnInteger*      MaxEntriesCmd;
+  G4UIcmdWithADoubleAndUnit* SpotSizeCmd;
+};
+
+#endif
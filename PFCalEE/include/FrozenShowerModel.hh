@@ -0,0 +1,50 @@
+#ifndef FrozenShowerModel_h
+#define FrozenShowerModel_h 1
+
+#include "G4VFastSimulationModel.hh"
+#include "G4Navigator.hh"
+#include "G4ThreeVector.hh"
+
+#include "ShowerLibrary.hh"
+
+class EventAction;
+
+//Fast simulation of low energy e+/e-/gamma in the ECAL absorbers:
+//the particle is killed and the deposits of a frozen shower from the library
+//are emitted directly into the SamplingSection hits through EventAction::Detect.
+class FrozenShowerModel : public G4VFastSimulationModel
+{
+public:
+  FrozenShowerModel(const G4String & name, G4Region* envelope, ShowerLibrary *library);
+  ~FrozenShowerModel();
+
+  G4bool IsApplicable(const G4ParticleDefinition & particle);
+  G4bool ModelTrigger(const G4FastTrack & fastTrack);
+  void DoIt(const G4FastTrack & fastTrack, G4FastStep & fastStep);
+
+  //only particles with kinetic energy in [minE,maxE[ are replaced.
+  //Values outside the library range are clamped to it.
+  void setMinEnergy(const G4double minE);
+  void setMaxEnergy(const G4double maxE);
+
+  void print() const;
+
+  //unit vectors u,v such that (u,v,dir) is orthonormal.
+  //Shared with ShowerLibraryBuilder to define the shower frame.
+  static void basis(const G4ThreeVector & dir, G4ThreeVector & u, G4ThreeVector & v);
+
+private:
+
+  ShowerLibrary *library_;
+  EventAction *eventAction_;
+  G4Navigator *navigator_;
+  G4double minE_;
+  G4double maxE_;
+
+  unsigned nReplaced_;
+  G4double eReplaced_;
+  unsigned nLost_;
+
+};
+
+#endif
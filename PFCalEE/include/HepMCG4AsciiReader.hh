@@ -46,6 +46,7 @@ protected:
   HepMC::IO_GenEvent* asciiInput;
 
   G4int verbose;
+  G4int nSkip;
   HepMCG4AsciiReaderMessenger* messenger;
 
   virtual HepMC::GenEvent* GenerateHepMCEvent();
@@ -59,6 +60,9 @@ public:
   G4String GetFileName() const;
 
   void SetVerboseLevel(G4int i);
+
+  //events to skip before the next one is generated
+  void SkipEvents(G4int n);
   G4int GetVerboseLevel() const; 
 
   // methods...
@@ -89,4 +93,9 @@ inline G4int HepMCG4AsciiReader::GetVerboseLevel() const
   return verbose;
 }
 
+inline void HepMCG4AsciiReader::SkipEvents(G4int n)
+{
+  nSkip= n;
+}
+
 #endif
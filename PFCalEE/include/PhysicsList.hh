@@ -46,7 +46,8 @@
 class PhysicsList: public QGSP_BERT //G4VUserPhysicsList
 {
 public:
-  PhysicsList();
+  //fastSimulation: register the fast simulation process for e+/e-/gamma (frozen showers)
+  PhysicsList(const bool fastSimulation=false);
   virtual ~PhysicsList();
 
   // Construct particle and physics
@@ -54,8 +55,19 @@ public:
   //void ConstructProcess();
  
   void SetCuts();
+
+  //physics list and cuts, for the startup cache key. The cuts of the
+  //default region are set first, the key is built from their values.
+  std::string cacheKey();
    
 private:
+  bool fastSimulation_;
+
+  //cuts of the default region, does not need the geometry
+  void SetProductionCuts();
+
+  //cut for all particles in the Si regions
+  inline G4double siliconCut() const { return defaultCutValue; };
 
   // these methods Construct physics processes and register them
   //void ConstructDecay();
@@ -63,6 +63,9 @@ public:
   G4VPrimaryGenerator* GetGenerator() const;
   G4String GetGeneratorName() const;
 
+  //resumed job: skip the input events already simulated
+  void SkipEvents(G4int n);
+
 private:
   int model_;
   double eta_;
@@ -0,0 +1,57 @@
+#ifndef RegionOfInterest_h
+#define RegionOfInterest_h 1
+
+#include "globals.hh"
+#include "G4ThreeVector.hh"
+
+#include <vector>
+
+class G4Event;
+class G4Track;
+class HGCSSInfo;
+
+//Optional track killing outside a region of interest (PFCalEE --roi).
+//One cone per primary particle (all the primaries of a HepMC event,
+//neutrinos excepted), with half-axes deltaEta and deltaPhi around the
+//primary direction: a point is inside if (dEta/deltaEta)^2+(dPhi/deltaPhi)^2<1,
+//with dEta,dPhi measured from the primary vertex.
+//Secondaries stepping outside all cones are killed, primaries are kept.
+class RegionOfInterest
+{
+public:
+  RegionOfInterest(const G4double deltaEta, const G4double deltaPhi);
+  ~RegionOfInterest(){};
+
+  //read the cone axes from the primaries
+  void beginEvent(const G4Event *evt);
+
+  bool contains(const G4ThreeVector & position) const;
+
+  //to be called from the stepping action with the post-step point,
+  //returns true if the track was killed
+  bool check(G4Track *track, const G4ThreeVector & position);
+
+  //copy the settings and counter into the file info
+  void fillInfo(HGCSSInfo & info) const;
+  //resumed job: continue the counter of the file info
+  void restoreCounters(const HGCSSInfo & info);
+
+  void print() const;
+
+private:
+
+  struct Cone {
+    G4ThreeVector vertex;
+    G4double eta;
+    G4double phi;
+  };
+
+  G4double deltaEta_;
+  G4double deltaPhi_;
+  std::vector<Cone> cones_;
+  unsigned long long nKilled_;
+  bool warned_;
+
+};
+
+#endif
@@ -5,6 +5,9 @@
 #include "globals.hh"
 
 class G4Run;
+class SimProfiler;
+class StartupCache;
+class Checkpoint;
 
 class RunAction : public G4UserRunAction
 {
@@ -17,12 +20,20 @@ public:
     
   void fillPerEvent(G4double, G4double, G4double, G4double); 
 
+  void setProfiler(SimProfiler *profiler) { profiler_ = profiler; }
+  void setStartupCache(StartupCache *cache) { cache_ = cache; }
+  void setCheckpoint(Checkpoint *checkpoint) { checkpoint_ = checkpoint; }
+
 private:
   G4double sumEAbs, sum2EAbs;
   G4double sumEGap, sum2EGap;
     
   G4double sumLAbs, sum2LAbs;
   G4double sumLGap, sum2LGap;    
+
+  SimProfiler *profiler_;
+  StartupCache *cache_;
+  Checkpoint *checkpoint_;
 };
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -31,6 +31,8 @@ public:
     ele_X0.clear();
     ele_L0.clear();
     ele_vol.clear();
+    supportcone_vol = 0;
+    dummylayer_vol = 0;
     hasScintillator = false;
     for (unsigned ie(0);  ie<aThicknessVec.size(); ++ie){
       //consider only material with some non-0 width...
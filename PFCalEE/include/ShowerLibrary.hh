@@ -0,0 +1,105 @@
+#ifndef ShowerLibrary_h
+#define ShowerLibrary_h 1
+
+#include "globals.hh"
+
+#include <string>
+#include <vector>
+#include <map>
+
+//one energy deposit of a frozen shower, in the frame of the incoming particle:
+//z along its direction, origin at its starting point.
+//Energy and charged track length are stored as fractions of the particle energy.
+struct ShowerSpot {
+  float x;
+  float y;
+  float z;
+  float t;
+  float e;
+  float dl;
+  int pdgId;
+};
+
+struct ShowerEntry {
+  G4double energy;
+  std::vector<ShowerSpot> spots;
+};
+
+//Library of pre-generated e+/e-/gamma showers, indexed by
+//(particle, energy bin, absorber material, entry angle bin).
+//Energy bins are logarithmic in [minE,maxE], angle bins uniform in cos(theta)
+//wrt the z axis, i.e. the layer normal.
+class ShowerLibrary
+{
+public:
+  ShowerLibrary(const G4double minE, const G4double maxE,
+		const unsigned nEnergyBins, const unsigned nAngleBins);
+
+  //read back a library written by write()
+  ShowerLibrary(const std::string & fileName);
+
+  ~ShowerLibrary(){};
+
+  //0=e-, 1=e+, 2=gamma, -1 otherwise
+  static int particleIndex(const G4int pdgId);
+
+  //-1 outside [minE,maxE[
+  int energyBin(const G4double energy) const;
+
+  int angleBin(const G4double cosTheta) const;
+
+  bool hasEntries(const int particle, const G4double energy,
+		  const std::string & absorber, const G4double cosTheta) const;
+
+  //random entry of the corresponding bin, 0 if empty
+  const ShowerEntry * getEntry(const int particle, const G4double energy,
+			       const std::string & absorber, const G4double cosTheta) const;
+
+  //false if the bin already has maxEntries entries
+  bool add(const int particle, const std::string & absorber,
+	   const G4double cosTheta, const ShowerEntry & entry,
+	   const unsigned maxEntries);
+
+  bool isFull(const int particle, const G4double energy,
+	      const std::string & absorber, const G4double cosTheta,
+	      const unsigned maxEntries) const;
+
+  void write(const std::string & fileName) const;
+
+  void print() const;
+
+  inline G4double minEnergy() const { return minE_; };
+  inline G4double maxEnergy() const { return maxE_; };
+  inline unsigned nEntries() const { return nEntries_; };
+
+private:
+
+  struct Key {
+    int particle;
+    int eBin;
+    int aBin;
+    std::string absorber;
+    bool operator<(const Key & other) const{
+      if (particle != other.particle) return particle < other.particle;
+      if (eBin != other.eBin) return eBin < other.eBin;
+      if (aBin != other.aBin) return aBin < other.aBin;
+      return absorber < other.absorber;
+    };
+  };
+
+  const std::vector<ShowerEntry> * bin(const int particle, const G4double energy,
+				       const std::string & absorber, const G4double cosTheta) const;
+
+  G4double minE_;
+  G4double maxE_;
+  unsigned nEnergyBins_;
+  unsigned nAngleBins_;
+  G4double logMinE_;
+  G4double logBinWidth_;
+  unsigned nEntries_;
+
+  std::map<Key,std::vector<ShowerEntry> > entries_;
+
+};
+
+#endif
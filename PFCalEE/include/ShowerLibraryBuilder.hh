@@ -0,0 +1,78 @@
+#ifndef ShowerLibraryBuilder_h
+#define ShowerLibraryBuilder_h 1
+
+#include "G4ThreeVector.hh"
+#include "globals.hh"
+
+#include "ShowerLibrary.hh"
+
+#include <string>
+#include <vector>
+#include <map>
+
+class G4Step;
+class G4Region;
+
+//Records the full simulation showers of e+/e-/gamma starting in the
+//ECAL absorber region into a ShowerLibrary, written at the end of the job.
+//Called from SteppingAction with the energy passed to EventAction::Detect.
+class ShowerLibraryBuilder
+{
+public:
+  ShowerLibraryBuilder(const std::string & outFile);
+  ~ShowerLibraryBuilder();
+
+  void addStep(const G4Step* aStep, const G4double edep, const G4double stepl);
+
+  //binning can only be changed before the first step
+  void setMinEnergy(const G4double val) { minE_ = val; };
+  void setMaxEnergy(const G4double val) { maxE_ = val; };
+  void setNEnergyBins(const unsigned val) { nEnergyBins_ = val; };
+  void setNAngleBins(const unsigned val) { nAngleBins_ = val; };
+  void setMaxEntriesPerBin(const unsigned val) { maxEntries_ = val; };
+  //deposits of a shower closer than this are merged into one spot
+  void setSpotSize(const G4double val) { spotSize_ = val; };
+
+private:
+
+  struct Shower {
+    int particle;
+    std::string absorber;
+    G4double cosTheta;
+    G4double energy;
+    G4double t0;
+    G4ThreeVector origin;
+    G4ThreeVector u;
+    G4ThreeVector v;
+    G4ThreeVector dir;
+    std::map<long long,unsigned> cells;
+    std::vector<ShowerSpot> spots;
+    //energy-weighted position sums for each spot
+    std::vector<G4ThreeVector> sumPos;
+  };
+
+  void addDeposit(Shower & shower, const G4ThreeVector & position,
+		  const G4double globalTime, const G4double edep,
+		  const G4double stepl, const G4int pdgId);
+
+  //store the showers of the current event in the library
+  void flush();
+
+  std::string outFile_;
+  ShowerLibrary *library_;
+  G4Region *region_;
+
+  G4double minE_;
+  G4double maxE_;
+  unsigned nEnergyBins_;
+  unsigned nAngleBins_;
+  unsigned maxEntries_;
+  G4double spotSize_;
+
+  G4int eventId_;
+  std::vector<Shower> showers_;
+  std::map<G4int,unsigned> trackToShower_;
+
+};
+
+#endif
@@ -0,0 +1,136 @@
+#ifndef SimProfiler_h
+#define SimProfiler_h 1
+
+#include "globals.hh"
+#include "G4ThreeVector.hh"
+#include "SamplingSection.hh"
+
+#include "TFile.h"
+#include "TTree.h"
+
+#include <chrono>
+#include <ctime>
+#include <map>
+#include <string>
+#include <vector>
+
+class G4VPhysicalVolume;
+
+//Opt-in CPU instrumentation (PFCalEE --profile <prefix>).
+//Per event: wall/CPU time split in tracking and EndOfEventAction
+//aggregation, steps and energy per material class (SamplingSection
+//ele_name, plus "Other" for volumes outside the sampling sections)
+//and steps per particle species. Steps limited by a volume boundary
+//are counted separately, as a measure of the navigation load. The
+//energy-weighted barycentre of the deposits locates the shower, to
+//check that a faster configuration does not move it.
+//Writes a TTree to <prefix>.root and a job summary to <prefix>.json.
+class SimProfiler
+{
+public:
+
+  enum Species {
+    sp_Electron=0,
+    sp_Photon=1,
+    sp_Muon=2,
+    sp_ChargedPion=3,
+    sp_Proton=4,
+    sp_Neutron=5,
+    sp_Ion=6,
+    sp_Other=7,
+    sp_N=8
+  };
+
+  SimProfiler(const std::string & prefix);
+  ~SimProfiler();
+
+  void beginRun();
+  void endRun(const unsigned nEvents);
+
+  void beginEvent(const G4int eventId);
+  void beginAggregation();
+  void endEvent();
+
+  inline void step(const G4VPhysicalVolume *volume, const G4int pdgId, const G4double edep, const bool atBoundary,
+		   const G4ThreeVector & position){
+    std::map<const G4VPhysicalVolume*,unsigned>::const_iterator lIter = volClass_.find(volume);
+    const unsigned iC = lIter != volClass_.end() ? lIter->second : classify(volume);
+    classSteps_[iC]++;
+    classE_[iC] += edep;
+    speciesSteps_[species(pdgId)]++;
+    nSteps_++;
+    if (atBoundary) nBoundarySteps_++;
+    if (edep>0) {
+      eventE_ += edep;
+      eventEX_ += edep*position.x();
+      eventEY_ += edep*position.y();
+      eventEZ_ += edep*position.z();
+    }
+  };
+
+  static Species species(const G4int pdgId);
+  static const char* speciesName(const unsigned sp);
+
+  void print() const;
+
+private:
+  typedef std::chrono::steady_clock Clock;
+
+  //material class of a volume not seen before, cached
+  unsigned classify(const G4VPhysicalVolume *volume);
+  void writeJSON() const;
+
+  std::string prefix_;
+  std::vector<SamplingSection> *detector_;
+
+  std::vector<std::string> classNames_;
+  std::map<const G4VPhysicalVolume*,unsigned> volClass_;
+
+  TFile *outF_;
+  TTree *tree_;
+
+  //per event, also the tree branches
+  G4int eventId_;
+  double wallTime_;
+  double cpuTime_;
+  double trackingWallTime_;
+  double aggregationWallTime_;
+  ULong64_t nSteps_;
+  ULong64_t nBoundarySteps_;
+  std::vector<ULong64_t> classSteps_;
+  std::vector<double> classE_;
+  std::vector<ULong64_t> speciesSteps_;
+  double showerX_;
+  double showerY_;
+  double showerZ_;
+  double eventE_;
+  double eventEX_;
+  double eventEY_;
+  double eventEZ_;
+
+  Clock::time_point eventStart_;
+  Clock::time_point aggregationStart_;
+  std::clock_t cpuStart_;
+  Clock::time_point runStart_;
+
+  //job totals
+  unsigned nEvents_;
+  double sumWallTime_;
+  double sumCpuTime_;
+  double sumTrackingTime_;
+  double sumAggregationTime_;
+  double runWallTime_;
+  ULong64_t sumSteps_;
+  ULong64_t sumBoundarySteps_;
+  std::vector<ULong64_t> sumClassSteps_;
+  std::vector<double> sumClassE_;
+  std::vector<ULong64_t> sumSpeciesSteps_;
+  //events with deposits, and moments of their barycentre
+  unsigned nShowers_;
+  double sumShowerX_, sumShowerX2_;
+  double sumShowerY_, sumShowerY2_;
+  double sumShowerZ_, sumShowerZ2_;
+
+};
+
+#endif
@@ -0,0 +1,54 @@
+#ifndef StackingAction_h
+#define StackingAction_h 1
+
+#include "G4UserStackingAction.hh"
+#include "globals.hh"
+
+class StackingActionMessenger;
+class HGCSSInfo;
+
+//Removes secondaries that cannot contribute to the digitised hits:
+//- tracks created after lateTimeCut are killed, or postponed to a
+//  waiting stage processed once the prompt part of the event is done,
+//- neutrons below thermalNeutronCut are killed,
+//- neutrons below rouletteEnergy survive with rouletteProbability and
+//  get their weight scaled by 1/rouletteProbability.
+//All cuts are disabled by default, primaries are never touched.
+class StackingAction : public G4UserStackingAction
+{
+public:
+  StackingAction();
+  virtual ~StackingAction();
+
+  G4ClassificationOfNewTrack ClassifyNewTrack(const G4Track* aTrack);
+
+  void setLateTimeCut(const G4double val) { lateTimeCut_ = val; };
+  void setPostponeLate(const G4bool val) { postponeLate_ = val; };
+  void setThermalNeutronCut(const G4double val) { thermalNeutronCut_ = val; };
+  void setRouletteEnergy(const G4double val) { rouletteEnergy_ = val; };
+  void setRouletteProbability(const G4double val) { rouletteProbability_ = val; };
+
+  //copy the settings and counters into the file info
+  void fillInfo(HGCSSInfo & info) const;
+  //resumed job: continue the counters of the file info
+  void restoreCounters(const HGCSSInfo & info);
+
+  void print() const;
+
+private:
+  StackingActionMessenger* messenger_;
+
+  G4double lateTimeCut_;
+  G4bool postponeLate_;
+  G4double thermalNeutronCut_;
+  G4double rouletteEnergy_;
+  G4double rouletteProbability_;
+
+  unsigned long long nKilledLate_;
+  unsigned long long nPostponedLate_;
+  unsigned long long nKilledThermal_;
+  unsigned long long nKilledRoulette_;
+  unsigned long long nSurvivedRoulette_;
+};
+
+#endif
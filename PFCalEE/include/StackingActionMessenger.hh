@@ -0,0 +1,31 @@
+#ifndef StackingActionMessenger_h
+#define StackingActionMessenger_h 1
+
+#include "globals.hh"
+#include "G4UImessenger.hh"
+
+class StackingAction;
+class G4UIdirectory;
+class G4UIcmdWithABool;
+class G4UIcmdWithADouble;
+class G4UIcmdWithADoubleAndUnit;
+
+class StackingActionMessenger: public G4UImessenger
+{
+public:
+  StackingActionMessenger(StackingAction*);
+  virtual ~StackingActionMessenger();
+
+  void SetNewValue(G4UIcommand*, G4String);
+
+private:
+  StackingAction*            stackingAction;
+  G4UIdirectory*             stackDir;
+  G4UIcmdWithADoubleAndUnit* LateTimeCutCmd;
+  G4UIcmdWithABool*          PostponeLateCmd;
+  G4UIcmdWithADoubleAndUnit* ThermalNeutronCutCmd;
+  G4UIcmdWithADoubleAndUnit* RouletteEnergyCmd;
+  G4UIcmdWithADouble*        RouletteProbabilityCmd;
+};
+
+#endif
@@ -0,0 +1,100 @@
+#ifndef StartupCache_h
+#define StartupCache_h 1
+
+#include "globals.hh"
+#include "SamplingSection.hh"
+
+#include <string>
+#include <vector>
+
+class G4VUserPhysicsList;
+class G4VPhysicalVolume;
+class DetectorConstruction;
+
+//Warm start of PFCalEE (--cache <dir>).
+//Jobs with the same key (detector settings, cuts, Geant4 version,
+//DetectorConstruction::geometryRevision) share
+//<dir>/<hash of the key>/ containing:
+// - manifest.txt: the key and, per layer, the SamplingSection metadata
+//   (elements, thicknesses, volume names and indices, X0/L0/dEdx, sensitiveZ),
+// - geometry.gdml: the constructed world, if Geant4 has GDML support,
+// - physics/: the physics tables (G4VUserPhysicsList::StorePhysicsTable).
+//A cold job writes them at the start of its first run, in a directory of
+//its own renamed into place once complete: jobs sharing the cache never
+//read partial files. A warm job reads the geometry instead of constructing
+//it and retrieves the tables.
+//The cache is stale, and replaced, if the manifest is missing or
+//incomplete, the key differs, the layer structure defined by the
+//DetectorConstruction constructor has changed or the X0, L0 and dEdx of
+//the materials differ from the ones stored. A stale cache is moved
+//aside to <dir>/<hash>.stale.<host>.<pid>, not deleted.
+class StartupCache
+{
+public:
+
+  struct LayerInfo {
+    std::vector<std::string> eleName;
+    std::vector<G4double> eleThick;
+    std::vector<G4double> eleX0;
+    std::vector<G4double> eleL0;
+    std::vector<G4double> eledEdx;
+    //one per ele_vol (element x sector), "-" if not placed
+    std::vector<std::string> volName;
+    //slab names repeat when a layer has an element twice (W/Cu/W):
+    //index among the daughters of the mother with the same name
+    std::vector<unsigned> volIndex;
+    std::string supportConeName;
+    std::string dummyLayerName;
+    G4double sensitiveZ;
+  };
+
+  StartupCache(const std::string & baseDir,
+	       const std::string & key,
+	       G4VUserPhysicsList *physics);
+  ~StartupCache(){};
+
+  //read the manifest and compare it to the key, structure and materials
+  //of the detector, refresh=true: ignore the existing cache
+  bool check(DetectorConstruction & detector, const bool refresh=false);
+
+  inline bool isWarm() const { return warm_; };
+  inline bool hasGeometry() const { return warm_ && hasGeometry_; };
+  inline const std::vector<LayerInfo> & layers() const { return layers_; };
+
+  //warm cache found unusable: build the tables and rewrite it
+  void invalidate();
+
+  std::string gdmlFile() const;
+  std::string physicsDir() const;
+
+  //index of aVol among the daughters of its mother with the same name
+  static unsigned nameIndex(const G4VPhysicalVolume *aVol);
+  //volume aName with that index, 0 if not found
+  static G4VPhysicalVolume *findVolume(const std::string & aName, const unsigned aIndex);
+
+  //cold cache: write the tables, geometry and manifest, once per job.
+  //To be called once the physics tables are built (BeginOfRunAction).
+  void store();
+
+private:
+
+  bool readManifest(const std::string & aDir);
+  bool writeManifest(const std::string & aDir,
+		     const std::vector<SamplingSection> & structure,
+		     const bool withGeometry) const;
+
+  //rename the complete directory aTmp to dir_
+  bool publish(const std::string & aTmp);
+
+  std::string dir_;
+  std::string key_;
+  G4VUserPhysicsList *physics_;
+  DetectorConstruction *detector_;
+  bool warm_;
+  bool hasGeometry_;
+  bool stored_;
+  std::vector<LayerInfo> layers_;
+
+};
+
+#endif
@@ -5,6 +5,9 @@
 #include "G4EmSaturation.hh"
 
 class EventAction;
+class ShowerLibraryBuilder;
+class SimProfiler;
+class RegionOfInterest;
 
 class SteppingAction : public G4UserSteppingAction
 {
@@ -13,12 +16,23 @@ public:
   virtual ~SteppingAction();
 
   void UserSteppingAction(const G4Step*);
+
+  //record frozen showers from the full simulation
+  void setShowerLibraryBuilder(ShowerLibraryBuilder *builder) { showerBuilder_ = builder; }
+
+  void setProfiler(SimProfiler *profiler) { profiler_ = profiler; }
+
+  //kill secondaries leaving the cones around the primaries
+  void setRegionOfInterest(RegionOfInterest *roi) { roi_ = roi; }
     
 private:
   EventAction *eventAction_;  
   //to correct the energy in the scintillator
   G4EmSaturation* saturationEngine;
   G4double timeLimit_;
+  ShowerLibraryBuilder *showerBuilder_;
+  SimProfiler *profiler_;
+  RegionOfInterest *roi_;
 
 };
 
@@ -0,0 +1,111 @@
+#include "Checkpoint.hh"
+
+#include "PrimaryGeneratorAction.hh"
+
+#include "G4RunManager.hh"
+#include "Randomize.hh"
+
+#include "TFile.h"
+#include "TTree.h"
+#include "TObjString.h"
+
+#include "HGCSSInfo.hh"
+
+#include <fstream>
+#include <iterator>
+#include <sstream>
+
+namespace {
+  const char* checkpointHeader = "PFCalEE-checkpoint";
+}
+
+Checkpoint::Checkpoint(const unsigned every, const bool resume)
+{
+  every_ = every;
+  resume_ = resume;
+  resuming_ = false;
+  restored_ = false;
+  firstEvent_ = 0;
+  resumedInfo_ = 0;
+}
+
+Checkpoint::~Checkpoint()
+{
+  delete resumedInfo_;
+}
+
+TFile *Checkpoint::openOutput(const std::string & fileName)
+{
+  std::ifstream lExists(fileName.c_str());
+  if (!resume_ || !lExists.is_open()) {
+    if (resume_) G4cout << " -- Checkpoint: no " << fileName << " to resume, starting from scratch." << G4endl;
+    return TFile::Open(fileName.c_str(),"RECREATE");
+  }
+  lExists.close();
+
+  TFile *lFile = TFile::Open(fileName.c_str(),"UPDATE");
+  if (lFile && !lFile->IsZombie()) {
+    TObjString *lState = (TObjString*)lFile->Get("Checkpoint");
+    TTree *lTree = (TTree*)lFile->Get("HGCSSTree");
+    HGCSSInfo *lInfo = (HGCSSInfo*)lFile->Get("Info");
+    if (lState && lTree && lInfo) {
+      std::istringstream lIn(lState->GetString().Data());
+      delete lState;
+      lState = 0;
+      std::string lHeader, lEol;
+      unsigned nEvents(0);
+      lIn >> lHeader >> nEvents;
+      std::getline(lIn,lEol);
+      engineState_.assign(std::istreambuf_iterator<char>(lIn),std::istreambuf_iterator<char>());
+      if (lHeader==checkpointHeader && nEvents>0 && nEvents==lTree->GetEntries() && engineState_.size()>0) {
+	resuming_ = true;
+	firstEvent_ = nEvents;
+	resumedInfo_ = lInfo;
+	G4cout << " -- Checkpoint: resuming " << fileName << " after " << nEvents << " events." << G4endl;
+	return lFile;
+      }
+      G4cout << " -- Checkpoint: " << nEvents << " events in the checkpoint but " << lTree->GetEntries() << " in the tree." << G4endl;
+    }
+    delete lState;
+    delete lInfo;
+  }
+  G4cout << " -- Checkpoint: no consistent checkpoint in " << fileName << ", starting from scratch." << G4endl;
+  if (lFile) lFile->Close();
+  delete lFile;
+  return TFile::Open(fileName.c_str(),"RECREATE");
+}
+
+void Checkpoint::beginRun()
+{
+  if (!resuming_ || restored_) return;
+  restored_ = true;
+
+  std::istringstream lIn(engineState_);
+  CLHEP::HepRandom::restoreFullState(lIn);
+  if (lIn.fail()) {
+    G4Exception("Checkpoint::beginRun","Checkpoint001",FatalException,
+		"the random state of the checkpoint cannot be restored.");
+  }
+
+  PrimaryGeneratorAction *lGen = (PrimaryGeneratorAction*)G4RunManager::GetRunManager()->GetUserPrimaryGeneratorAction();
+  if (lGen) lGen->SkipEvents(firstEvent_);
+  G4cout << " -- Checkpoint: random state restored, continuing from event " << firstEvent_ << G4endl;
+}
+
+void Checkpoint::endEvent(TFile *outF, TTree *tree, HGCSSInfo *info, const bool lastEvent)
+{
+  const Long64_t nEvents = tree->GetEntries();
+  if (!lastEvent && (every_==0 || nEvents%every_!=0)) return;
+
+  //state for the next event: nothing draws random numbers in between
+  std::ostringstream lOut;
+  lOut << checkpointHeader << " " << nEvents << std::endl;
+  CLHEP::HepRandom::saveFullState(lOut);
+
+  outF->cd();
+  outF->WriteObjectAny(info,"HGCSSInfo","Info","overwrite");
+  TObjString lState(lOut.str().c_str());
+  lState.Write("Checkpoint",TObject::kOverwrite);
+  //flushes the baskets and writes the tree header and the keys list
+  tree->AutoSave("SaveSelf");
+}
@@ -1,7 +1,11 @@
 #include "DetectorConstruction.hh"
 #include "DetectorMessenger.hh"
+#include "FrozenShowerModel.hh"
+#include "FrozenShowerMessenger.hh"
+#include "StartupCache.hh"
 
 #include "HGCSSSimHit.hh"
+#include "HGCSSDetectorDescription.hh"
 
 #include <boost/algorithm/string.hpp>
 
@@ -17,6 +21,19 @@
 #include "G4PVPlacement.hh"
 #include "G4PVReplica.hh"
 #include "G4UniformMagField.hh"
+#include "G4Mag_UsualEqRhs.hh"
+#include "G4ChordFinder.hh"
+#include "G4ClassicalRK4.hh"
+#include "G4SimpleRunge.hh"
+#include "G4SimpleHeum.hh"
+#include "G4CashKarpRKF45.hh"
+#include "G4DormandPrince745.hh"
+#include "G4NystromRK4.hh"
+#include "G4HelixExplicitEuler.hh"
+#include "G4HelixImplicitEuler.hh"
+#include "G4HelixSimpleRunge.hh"
+#include "G4ExactHelixStepper.hh"
+#include "G4RegionStore.hh"
 #include "G4GeometryManager.hh"
 #include "G4PhysicalVolumeStore.hh"
 #include "G4LogicalVolumeStore.hh"
@@ -24,11 +41,17 @@
 #include "G4VisAttributes.hh"
 #include "G4Colour.hh"
 #include "G4PhysicalConstants.hh"
+#include "G4Region.hh"
 #include "G4SystemOfUnits.hh"
 #include "G4FieldManager.hh"
 #include "G4TransportationManager.hh"
 #include "G4PhysicalConstants.hh"
+#include "G4GeometryTolerance.hh"
+#ifdef G4LIB_USE_GDML
+#include "G4GDMLParser.hh"
+#endif
 
+#include <algorithm>
 
 using namespace std;
 
@@ -43,6 +66,28 @@ DetectorConstruction::DetectorConstruction(G4int ver, G4int mod,
 {
   doHF_ = false;
 
+  m_frozenShowerMode = fs_OFF;
+  m_frozenShowerModel = 0;
+  m_frozenShowerMessenger = 0;
+
+  m_startupCache = 0;
+
+  m_magField = 0;
+  m_fieldMinStep = 0;
+  m_deltaChord = 0;
+  m_deltaIntersection = 0;
+  m_deltaOneStep = 0;
+  m_minEpsilonStep = 0;
+  m_maxEpsilonStep = 0;
+  m_fieldEquation = 0;
+  m_fieldStepper = 0;
+  m_chordFinder = 0;
+  m_noFieldManager = 0;
+
+  m_envelopeMode = env_OFF;
+  m_smartlessWorld = 0;
+  m_smartlessEnvelope = 0;
+
   lastEElayer_ = 9999;
   firstHFlayer_ = 9999;
   firstMixedlayer_ = 9999;
@@ -1560,7 +1605,26 @@ void DetectorConstruction::buildHF(){
 
 
 //
-DetectorConstruction::~DetectorConstruction() { delete m_detectorMessenger;}
+DetectorConstruction::~DetectorConstruction() {
+  delete m_detectorMessenger;
+  delete m_frozenShowerMessenger;
+  delete m_frozenShowerModel;
+  delete m_noFieldManager;
+  delete m_chordFinder;
+  delete m_fieldStepper;
+  delete m_fieldEquation;
+}
+
+void DetectorConstruction::SetFrozenShowers(const unsigned mode, const std::string & libraryFile){
+  m_frozenShowerMode = mode;
+  m_frozenShowerLib = libraryFile;
+}
+
+void DetectorConstruction::SetEnvelopes(const unsigned mode, const G4double smartlessWorld, const G4double smartlessEnvelope){
+  m_envelopeMode = mode;
+  m_smartlessWorld = smartlessWorld;
+  m_smartlessEnvelope = smartlessEnvelope;
+}
 
 
 double DetectorConstruction::getEtaFromRZ(const double & r, const double & z){
@@ -1860,6 +1924,23 @@ G4VPhysicalVolume* DetectorConstruction::Construct()
   G4LogicalVolumeStore::GetInstance()->Clean();
   G4SolidStore::GetInstance()->Clean();
 
+  //warm start
+  if (m_startupCache && m_startupCache->hasGeometry()){
+    G4VPhysicalVolume *lCached = loadCachedGeometry();
+    if (lCached) {
+      buildFrozenShowerRegion();
+      return lCached;
+    }
+    G4cout << " -- WARNING! Cached geometry cannot be used, constructing it and rewriting the cache." << G4endl;
+    m_startupCache->invalidate();
+    m_logicSi.clear();
+    m_logicAl.clear();
+    m_logicEEAbs.clear();
+    G4PhysicalVolumeStore::GetInstance()->Clean();
+    G4LogicalVolumeStore::GetInstance()->Clean();
+    G4SolidStore::GetInstance()->Clean();
+  }
+
   //world
   G4double expHall_z = model_ == DetectorConstruction::m_2016TB? 0.5*m : 14*m;
   G4double expHall_x = model_ == DetectorConstruction::m_2016TB? 20*cm : 3*m;
@@ -1906,6 +1987,10 @@ G4VPhysicalVolume* DetectorConstruction::Construct()
     buildSectorStack(iS,minL,m_sectorWidth-m_interSectorWidth);
     if (m_nSectors>1) fillInterSectorSpace(iS,minL+m_sectorWidth-m_interSectorWidth,m_interSectorWidth);
   }
+  if (m_smartlessWorld>0) m_logicWorld->SetSmartless(m_smartlessWorld);
+
+  buildFrozenShowerRegion();
+
   // Visualization attributes
   //
   m_logicWorld->SetVisAttributes(G4VisAttributes::GetInvisible());
@@ -1914,6 +1999,96 @@ G4VPhysicalVolume* DetectorConstruction::Construct()
   return experimentalHall_phys;
 }
 
+void DetectorConstruction::buildFrozenShowerRegion(){
+  //frozen showers: one region for all EE absorbers
+  if (m_frozenShowerMode != fs_OFF && m_logicEEAbs.size()>0){
+    G4Region* eeAbsRegion = new G4Region("EEAbsorberReg");
+    for (unsigned iA(0); iA<m_logicEEAbs.size(); ++iA){
+      m_logicEEAbs[iA]->SetRegion(eeAbsRegion);
+      eeAbsRegion->AddRootLogicalVolume(m_logicEEAbs[iA]);
+    }
+    G4cout << " -- Frozen showers: " << m_logicEEAbs.size() << " EE absorber volumes in EEAbsorberReg." << G4endl;
+    if (m_frozenShowerMode == fs_REPLAY){
+      m_frozenShowerModel = new FrozenShowerModel("FrozenShowerModel",eeAbsRegion,new ShowerLibrary(m_frozenShowerLib));
+      m_frozenShowerMessenger = new FrozenShowerMessenger(m_frozenShowerModel,0);
+    }
+  }
+}
+
+G4VPhysicalVolume* DetectorConstruction::loadCachedGeometry(){
+#ifdef G4LIB_USE_GDML
+  G4GDMLParser lParser;
+  lParser.Read(m_startupCache->gdmlFile(),false);
+  G4VPhysicalVolume *lHall = lParser.GetWorldVolume();
+  G4PhysicalVolumeStore *lStore = G4PhysicalVolumeStore::GetInstance();
+  m_physWorld = lStore->GetVolume("Wphys",false);
+  if (!lHall || !m_physWorld) return 0;
+  m_logicWorld = m_physWorld->GetLogicalVolume();
+  m_solidWorld = m_logicWorld->GetSolid();
+
+  //SamplingSection volumes and derived quantities, regions as in buildSectorStack
+  const std::vector<StartupCache::LayerInfo> & lLayers = m_startupCache->layers();
+  for (unsigned i(0); i<m_caloStruct.size(); ++i){
+    SamplingSection & lSec = m_caloStruct[i];
+    const StartupCache::LayerInfo & lInfo = lLayers[i];
+    lSec.sensitiveZ = lInfo.sensitiveZ;
+    for (unsigned ie(0); ie<lSec.n_elements; ++ie){
+      lSec.ele_X0[ie] = lInfo.eleX0[ie];
+      lSec.ele_L0[ie] = lInfo.eleL0[ie];
+      lSec.ele_dEdx[ie] = lInfo.eledEdx[ie];
+    }
+    for (unsigned iV(0); iV<lSec.ele_vol.size(); ++iV){
+      if (lInfo.volName[iV]=="-") continue;
+      lSec.ele_vol[iV] = StartupCache::findVolume(lInfo.volName[iV],lInfo.volIndex[iV]);
+      if (!lSec.ele_vol[iV]) {
+	G4cout << " -- ERROR! Volume " << lInfo.volName[iV] << " #" << lInfo.volIndex[iV] << " not found in " << m_startupCache->gdmlFile() << G4endl;
+	return 0;
+      }
+      const unsigned ie = iV%lSec.n_elements;
+      G4LogicalVolume *logi = lSec.ele_vol[iV]->GetLogicalVolume();
+      if (m_frozenShowerMode != fs_OFF && i<=lastEElayer_ && lSec.isAbsorberElement(ie)) m_logicEEAbs.push_back(logi);
+      if (lSec.isSensitiveElement(ie)) m_logicSi.push_back(logi);
+      if (lSec.ele_name[ie]=="Si"){
+	const std::string lName = logi->GetName();
+	G4Region* aRegion = new G4Region(lName.substr(0,lName.size()-3)+"Reg");
+	logi->SetRegion(aRegion);
+	aRegion->AddRootLogicalVolume(logi);
+      }
+    }
+    if (lInfo.supportConeName!="-"){
+      lSec.supportcone_vol = lStore->GetVolume(lInfo.supportConeName,false);
+      if (!lSec.supportcone_vol) return 0;
+      G4LogicalVolume *logi = lSec.supportcone_vol->GetLogicalVolume();
+      m_logicAl.push_back(logi);
+      const std::string lName = logi->GetName();
+      G4Region* aRegion = new G4Region(lName.substr(0,lName.size()-3)+"Reg");
+      logi->SetRegion(aRegion);
+      aRegion->AddRootLogicalVolume(logi);
+    }
+  }
+  m_caloStruct[0].dummylayer_vol = lStore->GetVolume(lLayers[0].dummyLayerName,false);
+  if (!m_caloStruct[0].dummylayer_vol) return 0;
+
+  //smartless values are not part of the GDML
+  if (m_smartlessWorld>0) m_logicWorld->SetSmartless(m_smartlessWorld);
+  if (m_smartlessEnvelope>0){
+    G4LogicalVolumeStore *lLogStore = G4LogicalVolumeStore::GetInstance();
+    //<subdet>Envlog and LayerEnv<N>log, as named by placeEnvelope
+    for (unsigned iV(0); iV<lLogStore->size(); ++iV){
+      const std::string lName = (*lLogStore)[iV]->GetName();
+      if (lName.find("Env")!=std::string::npos && lName.size()>3 && lName.compare(lName.size()-3,3,"log")==0)
+	(*lLogStore)[iV]->SetSmartless(m_smartlessEnvelope);
+    }
+  }
+  m_logicWorld->SetVisAttributes(G4VisAttributes::GetInvisible());
+
+  G4cout << " -- Geometry read from " << m_startupCache->gdmlFile() << G4endl;
+  return lHall;
+#else
+  return 0;
+#endif
+}
+
 void DetectorConstruction::buildSectorStack(const unsigned sectorNum,
 					    const G4double & minL,
 					    const G4double & width)
@@ -1929,6 +2104,9 @@ void DetectorConstruction::buildSectorStack(const unsigned sectorNum,
   G4double totalLengthX0 = 0;
   G4double totalLengthL0 = 0;
 
+  //placed after the loop, directly in the world or in envelopes
+  std::vector<StackPlacement> lSlabs;
+
   for(size_t i=0; i<m_caloStruct.size(); i++)
     {
       G4double crackOffset = getCrackOffset(i);
@@ -2005,6 +2183,9 @@ void DetectorConstruction::buildSectorStack(const unsigned sectorNum,
 	    totalLengthL0 += m_caloStruct[i].ele_thick[ie]/m_caloStruct[i].ele_L0[ie]; G4cout << " TotLambda=" << totalLengthL0 << G4endl;
 	  }
 
+	  if (m_frozenShowerMode != fs_OFF && i<=lastEElayer_ && m_caloStruct[i].isAbsorberElement(ie))
+	    m_logicEEAbs.push_back(logi);
+
 	  if (m_caloStruct[i].isSensitiveElement(ie)){
 	    if (idx<=1) m_caloStruct[i].sensitiveZ = ((i>=firstHFlayer_)?m_z0HF+zOverburden:m_z0pos+zOverburden);
 
@@ -2020,8 +2201,9 @@ void DetectorConstruction::buildSectorStack(const unsigned sectorNum,
 	       << "), logi,"
 	       << baseName+"phys, m_logicWorld, false, 0);" << endl;
 #endif
-	  m_caloStruct[i].ele_vol[nEle*sectorNum+ie]=
-	    new G4PVPlacement(0, G4ThreeVector(xpvpos,0.,zOffset+zOverburden+thick/2), logi, baseName+"phys", m_logicWorld, (eleName=="CuExtra")?true:false, 0);
+	  StackPlacement lSlab = {static_cast<unsigned>(i), logi, baseName+"phys", G4ThreeVector(xpvpos,0.,zOffset+zOverburden+thick/2),
+				  (eleName=="CuExtra")?true:false, &m_caloStruct[i].ele_vol[nEle*sectorNum+ie]};
+	  lSlabs.push_back(lSlab);
 	  //std::cout << " **** positionning layer " <<  m_caloStruct[i].ele_vol[nEle*sectorNum+ie]->GetName() << " at " << xpvpos << " 0 " << zOffset+zOverburden+thick/2 << std::endl;
 
 	  G4VisAttributes *simpleBoxVisAtt= new G4VisAttributes(m_caloStruct[i].g4Colour(ie));
@@ -2070,8 +2252,9 @@ void DetectorConstruction::buildSectorStack(const unsigned sectorNum,
 	m_logicAl.push_back(logi);
 	G4double xpvpos = -m_CalorSizeXY/2.+minL+width/2+crackOffset;
 	if (model_ == DetectorConstruction::m_FULLSECTION) xpvpos=0;
-	m_caloStruct[i].supportcone_vol=
-	new G4PVPlacement(0, G4ThreeVector(xpvpos,0.,zOffset+zOverburden-totalThicknessLayer/2), logi, baseName+"phys", m_logicWorld, false, 0);
+	StackPlacement lSlab = {static_cast<unsigned>(i), logi, baseName+"phys", G4ThreeVector(xpvpos,0.,zOffset+zOverburden-totalThicknessLayer/2),
+				false, &m_caloStruct[i].supportcone_vol};
+	lSlabs.push_back(lSlab);
 	G4VisAttributes *simpleBoxVisAtt= new G4VisAttributes(G4Colour::Red());
 	simpleBoxVisAtt->SetVisibility(true);
 	logi->SetVisAttributes(simpleBoxVisAtt);
@@ -2081,6 +2264,8 @@ void DetectorConstruction::buildSectorStack(const unsigned sectorNum,
 	aRegion->AddRootLogicalVolume(m_logicAl[nlogical-1]);
       }
     }//loop on layers
+  placeStack(lSlabs);
+
   std::cout << " Z positions of sensitive layers: " << std::endl;
   for (size_t i=0; i<m_caloStruct.size(); i++) {
     std::cout << "sensitiveZ_[" << i << "] = " << m_caloStruct[i].sensitiveZ << ";"  << std::endl;
@@ -2092,6 +2277,19 @@ void DetectorConstruction::buildSectorStack(const unsigned sectorNum,
     else std::cout << " etaBoundary_[" << i << "] =" << m_maxEta[i] << ";"  << std::endl;
   }
 
+  //cross-check against the description used by the digitisation
+  std::shared_ptr<const HGCSSDetectorDescription> lDesc =
+    HGCSSDetectorDescription::get(version_,model_,true,version_==23,model_!=DetectorConstruction::m_FULLSECTION);
+  if (lDesc->nLayers()!=m_caloStruct.size()) {
+    std::cout << " -- WARNING! HGCSSDetector has " << lDesc->nLayers() << " layers, geometry has " << m_caloStruct.size() << std::endl;
+  }
+  else if (lDesc->hasSensitiveZ()) {
+    for (size_t i=0; i<m_caloStruct.size(); i++) {
+      if (fabs(lDesc->sensitiveZ(i)-m_caloStruct[i].sensitiveZ)>0.01)
+	std::cout << " -- WARNING! sensitiveZ mismatch for layer " << i << ": HGCSSDetector " << lDesc->sensitiveZ(i) << " geometry " << m_caloStruct[i].sensitiveZ << std::endl;
+    }
+  }
+
   //dummy layer to get genparticles
   std::string eleName = "DummyLayer";
   double wDummy = 0.5;
@@ -2118,6 +2316,182 @@ void DetectorConstruction::buildSectorStack(const unsigned sectorNum,
 
 }//buildstack
 
+namespace {
+  //bounding box in the world frame, and radial range for the full section
+  struct StackExtent {
+    StackExtent():empty(true),rmin(0),rmax(0){};
+    bool empty;
+    G4ThreeVector min;
+    G4ThreeVector max;
+    G4double rmin;
+    G4double rmax;
+
+    void add(const G4ThreeVector & aMin, const G4ThreeVector & aMax, const G4double aRmin, const G4double aRmax){
+      if (empty) {
+	min = aMin;
+	max = aMax;
+	rmin = aRmin;
+	rmax = aRmax;
+	empty = false;
+	return;
+      }
+      min.set(std::min(min.x(),aMin.x()),std::min(min.y(),aMin.y()),std::min(min.z(),aMin.z()));
+      max.set(std::max(max.x(),aMax.x()),std::max(max.y(),aMax.y()),std::max(max.z(),aMax.z()));
+      rmin = std::min(rmin,aRmin);
+      rmax = std::max(rmax,aRmax);
+    };
+    void add(const StackExtent & other){
+      if (!other.empty) add(other.min,other.max,other.rmin,other.rmax);
+    };
+    //touching within the surface tolerance is not an overlap
+    bool overlapZ(const StackExtent & other) const{
+      const G4double tol = 0.5*G4GeometryTolerance::GetInstance()->GetSurfaceTolerance();
+      return !empty && !other.empty && min.z()<other.max.z()-tol && other.min.z()<max.z()-tol;
+    };
+    //tubs envelopes stay on the beam axis
+    G4ThreeVector centre(const bool isTubs) const{
+      if (isTubs) return G4ThreeVector(0,0,(min.z()+max.z())/2);
+      return (min+max)/2;
+    };
+  };
+
+  G4LogicalVolume *placeEnvelope(const std::string & name,
+				 const StackExtent & ext,
+				 const bool isTubs,
+				 G4Material *material,
+				 const G4double smartless,
+				 G4LogicalVolume *mother,
+				 const G4ThreeVector & motherCentre){
+    G4VSolid *solid;
+    const G4double halfZ = (ext.max.z()-ext.min.z())/2;
+    if (isTubs) solid = new G4Tubs(name+"box",ext.rmin,ext.rmax,halfZ,0,2*pi);
+    else solid = new G4Box(name+"box",(ext.max.x()-ext.min.x())/2,(ext.max.y()-ext.min.y())/2,halfZ);
+    G4LogicalVolume *logi = new G4LogicalVolume(solid, material, name+"log");
+    logi->SetVisAttributes(G4VisAttributes::GetInvisible());
+    if (smartless>0) logi->SetSmartless(smartless);
+    new G4PVPlacement(0, ext.centre(isTubs)-motherCentre, logi, name+"phys", mother, false, 0);
+    return logi;
+  }
+}
+
+void DetectorConstruction::placeStack(const std::vector<StackPlacement> & slabs){
+
+  if (m_envelopeMode!=env_OFF && m_nSectors>1){
+    G4cout << " -- WARNING! Envelopes are only implemented for a single sector, using the flat layout." << G4endl;
+    m_envelopeMode = env_OFF;
+  }
+  if (m_envelopeMode==env_OFF){
+    for (unsigned iS(0); iS<slabs.size(); ++iS){
+      const StackPlacement & lSlab = slabs[iS];
+      *lSlab.vol = new G4PVPlacement(0, lSlab.pos, lSlab.logi, lSlab.name, m_logicWorld, lSlab.many, 0);
+    }
+    return;
+  }
+
+  const bool isTubs = model_ == DetectorConstruction::m_FULLSECTION;
+  const unsigned nLayers = m_caloStruct.size();
+
+  //extent of each layer, world radii for solids other than tubs
+  std::vector<StackExtent> lLayerExt(nLayers);
+  for (unsigned iS(0); iS<slabs.size(); ++iS){
+    const StackPlacement & lSlab = slabs[iS];
+    const G4VSolid *lSolid = lSlab.logi->GetSolid();
+    G4ThreeVector lMin, lMax;
+    lSolid->BoundingLimits(lMin,lMax);
+    G4double rmin = m_minRadius*0.9;
+    G4double rmax = m_maxRadius*1.1;
+    const G4Tubs *lTubs = dynamic_cast<const G4Tubs*>(lSolid);
+    if (lTubs) {
+      rmin = lTubs->GetInnerRadius();
+      rmax = lTubs->GetOuterRadius();
+    }
+    lLayerExt[lSlab.layer].add(lSlab.pos+lMin,lSlab.pos+lMax,rmin,rmax);
+  }
+
+  //layers overlapping in z (Si and scintillator parts of the mixed
+  //layers, support cone) share one envelope
+  std::vector<StackExtent> lGroupExt;
+  std::vector<std::vector<unsigned> > lGroupLayers;
+  for (unsigned iL(0); iL<nLayers; ++iL){
+    if (lLayerExt[iL].empty) continue;
+    StackExtent lExt = lLayerExt[iL];
+    std::vector<unsigned> lLayers(1,iL);
+    bool merged = true;
+    while (merged) {
+      merged = false;
+      for (unsigned iG(0); iG<lGroupExt.size(); ++iG){
+	if (!lGroupExt[iG].overlapZ(lExt)) continue;
+	lExt.add(lGroupExt[iG]);
+	lLayers.insert(lLayers.end(),lGroupLayers[iG].begin(),lGroupLayers[iG].end());
+	lGroupExt.erase(lGroupExt.begin()+iG);
+	lGroupLayers.erase(lGroupLayers.begin()+iG);
+	merged = true;
+	break;
+      }
+    }
+    std::sort(lLayers.begin(),lLayers.end());
+    lGroupExt.push_back(lExt);
+    lGroupLayers.push_back(lLayers);
+  }
+  std::vector<unsigned> lLayerGroup(nLayers,0);
+  for (unsigned iG(0); iG<lGroupLayers.size(); ++iG){
+    for (unsigned iL(0); iL<lGroupLayers[iG].size(); ++iL) lLayerGroup[lGroupLayers[iG][iL]] = iG;
+  }
+
+  //subdetector of the first layer of each envelope
+  const unsigned nSubdets = 4;
+  const char* lSubdetNames[nSubdets] = {"EE","FH","BH","HF"};
+  std::vector<StackExtent> lSubdetExt(nSubdets);
+  std::vector<unsigned> lGroupSubdet(lGroupExt.size(),0);
+  for (unsigned iG(0); iG<lGroupExt.size(); ++iG){
+    const unsigned iL = lGroupLayers[iG][0];
+    unsigned iD = 1;
+    if (iL<=lastEElayer_) iD = 0;
+    else if (iL>=firstHFlayer_) iD = 3;
+    else if (iL>=std::min(firstMixedlayer_,firstScintlayer_)) iD = 2;
+    lGroupSubdet[iG] = iD;
+    lSubdetExt[iD].add(lGroupExt[iG]);
+  }
+  bool useSubdet = m_envelopeMode==env_SUBDET;
+  for (unsigned iD(0); iD<nSubdets && useSubdet; ++iD){
+    for (unsigned jD(iD+1); jD<nSubdets; ++jD){
+      if (!lSubdetExt[iD].overlapZ(lSubdetExt[jD])) continue;
+      G4cout << " -- WARNING! " << lSubdetNames[iD] << " and " << lSubdetNames[jD]
+	     << " overlap in z, no subdetector envelopes." << G4endl;
+      useSubdet = false;
+      break;
+    }
+  }
+
+  std::vector<G4LogicalVolume*> lSubdetLog(nSubdets,0);
+  unsigned nSubdetEnv = 0;
+  for (unsigned iD(0); iD<nSubdets && useSubdet; ++iD){
+    if (lSubdetExt[iD].empty) continue;
+    lSubdetLog[iD] = placeEnvelope(std::string(lSubdetNames[iD])+"Env",lSubdetExt[iD],isTubs,
+				   m_materials["Air"],m_smartlessEnvelope,m_logicWorld,G4ThreeVector());
+    nSubdetEnv++;
+  }
+
+  std::vector<G4LogicalVolume*> lGroupLog(lGroupExt.size(),0);
+  for (unsigned iG(0); iG<lGroupExt.size(); ++iG){
+    char nameBuf[100];
+    sprintf(nameBuf,"LayerEnv%d",int(lGroupLayers[iG][0]+1));
+    const unsigned iD = lGroupSubdet[iG];
+    lGroupLog[iG] = placeEnvelope(nameBuf,lGroupExt[iG],isTubs,m_materials["Air"],m_smartlessEnvelope,
+				  useSubdet ? lSubdetLog[iD] : m_logicWorld,
+				  useSubdet ? lSubdetExt[iD].centre(isTubs) : G4ThreeVector());
+  }
+
+  for (unsigned iS(0); iS<slabs.size(); ++iS){
+    const StackPlacement & lSlab = slabs[iS];
+    const unsigned iG = lLayerGroup[lSlab.layer];
+    *lSlab.vol = new G4PVPlacement(0, lSlab.pos-lGroupExt[iG].centre(isTubs), lSlab.logi, lSlab.name, lGroupLog[iG], lSlab.many, 0);
+  }
+
+  G4cout << " -- Envelopes: " << lGroupExt.size() << " layer envelopes for " << nLayers << " layers, "
+	 << nSubdetEnv << " subdetector envelopes." << G4endl;
+}
+
 void DetectorConstruction::fillInterSectorSpace(const unsigned sectorNum,
 						const G4double & minL,
 						const G4double & width)
@@ -2201,8 +2575,154 @@ void DetectorConstruction::SetMagField(G4double fieldValue)
   if(m_magField) delete m_magField;                //delete the existing magn field
   m_magField = new G4UniformMagField(G4ThreeVector(0.,0.,fieldValue));
   fieldMgr->SetDetectorField(m_magField);
-  fieldMgr->CreateChordFinder(m_magField);
-  fieldMgr->SetDetectorField(m_magField);
+  applyFieldSettings();
+}
+
+void DetectorConstruction::SetFieldStepper(const std::string & stepper)
+{
+  m_fieldStepperName = stepper;
+  applyFieldSettings();
+}
+
+void DetectorConstruction::SetFieldMinStep(G4double value)
+{
+  m_fieldMinStep = value;
+  applyFieldSettings();
+}
+
+void DetectorConstruction::SetDeltaChord(G4double value)
+{
+  m_deltaChord = value;
+  applyFieldSettings();
+}
+
+void DetectorConstruction::SetDeltaIntersection(G4double value)
+{
+  m_deltaIntersection = value;
+  applyFieldSettings();
+}
+
+void DetectorConstruction::SetDeltaOneStep(G4double value)
+{
+  m_deltaOneStep = value;
+  applyFieldSettings();
+}
+
+void DetectorConstruction::SetMinEpsilonStep(G4double value)
+{
+  m_minEpsilonStep = value;
+  applyFieldSettings();
+}
+
+void DetectorConstruction::SetMaxEpsilonStep(G4double value)
+{
+  m_maxEpsilonStep = value;
+  applyFieldSettings();
+}
+
+void DetectorConstruction::SetNoFieldIn(const std::string & list)
+{
+  m_noFieldIn.clear();
+  if (list.size()>0) boost::split(m_noFieldIn, list, boost::is_any_of(","));
+  applyFieldSettings();
+}
+
+void DetectorConstruction::ConstructSDandField()
+{
+  applyFieldSettings();
+}
+
+void DetectorConstruction::applyFieldSettings()
+{
+  if (!m_magField) return;
+  G4FieldManager* fieldMgr = G4TransportationManager::GetTransportationManager()->GetFieldManager();
+
+  //own chord finder, never CreateChordFinder: the field manager would
+  //then delete it. Stepper and equation only if a stepper is requested.
+  G4ChordFinder *oldChordFinder = m_chordFinder;
+  G4MagIntegratorStepper *oldStepper = m_fieldStepper;
+  G4Mag_UsualEqRhs *oldEquation = m_fieldEquation;
+  m_fieldStepper = 0;
+  m_fieldEquation = 0;
+  const std::string & lName = m_fieldStepperName;
+  if (lName.size()>0){
+    m_fieldEquation = new G4Mag_UsualEqRhs(m_magField);
+    if (lName=="ClassicalRK4") m_fieldStepper = new G4ClassicalRK4(m_fieldEquation);
+    else if (lName=="SimpleRunge") m_fieldStepper = new G4SimpleRunge(m_fieldEquation);
+    else if (lName=="SimpleHeum") m_fieldStepper = new G4SimpleHeum(m_fieldEquation);
+    else if (lName=="CashKarpRKF45") m_fieldStepper = new G4CashKarpRKF45(m_fieldEquation);
+    else if (lName=="DormandPrince745") m_fieldStepper = new G4DormandPrince745(m_fieldEquation);
+    else if (lName=="NystromRK4") m_fieldStepper = new G4NystromRK4(m_fieldEquation);
+    else if (lName=="HelixExplicitEuler") m_fieldStepper = new G4HelixExplicitEuler(m_fieldEquation);
+    else if (lName=="HelixImplicitEuler") m_fieldStepper = new G4HelixImplicitEuler(m_fieldEquation);
+    else if (lName=="HelixSimpleRunge") m_fieldStepper = new G4HelixSimpleRunge(m_fieldEquation);
+    else if (lName=="ExactHelix") m_fieldStepper = new G4ExactHelixStepper(m_fieldEquation);
+    else {
+      G4cout << " -- WARNING! Unknown stepper " << lName << ", using the Geant4 default." << G4endl;
+      delete m_fieldEquation;
+      m_fieldEquation = 0;
+    }
+  }
+  m_chordFinder = new G4ChordFinder(m_magField, m_fieldMinStep>0 ? m_fieldMinStep : 0.01*mm, m_fieldStepper);
+  fieldMgr->SetChordFinder(m_chordFinder);
+  delete oldChordFinder;
+  delete oldStepper;
+  delete oldEquation;
+
+  if (m_deltaChord>0) fieldMgr->GetChordFinder()->SetDeltaChord(m_deltaChord);
+  if (m_deltaIntersection>0) fieldMgr->SetDeltaIntersection(m_deltaIntersection);
+  if (m_deltaOneStep>0) fieldMgr->SetDeltaOneStep(m_deltaOneStep);
+  if (m_minEpsilonStep>0) fieldMgr->SetMinimumEpsilonStep(m_minEpsilonStep);
+  if (m_maxEpsilonStep>0) fieldMgr->SetMaximumEpsilonStep(m_maxEpsilonStep);
+
+  //field-free volumes: a field manager without field overrides the global one
+  if (!m_noFieldManager) m_noFieldManager = new G4FieldManager();
+  G4FieldManager *lElementMgr = 0;
+  for (unsigned i(0); i<m_caloStruct.size(); ++i){
+    SamplingSection & lSec = m_caloStruct[i];
+    for (unsigned iV(0); iV<lSec.ele_vol.size(); ++iV){
+      if (!lSec.ele_vol[iV]) continue;
+      const unsigned ie = iV%lSec.n_elements;
+      bool noField = false;
+      for (unsigned iN(0); iN<m_noFieldIn.size() && !noField; ++iN){
+	noField = m_noFieldIn[iN]==lSec.ele_name[ie] || (m_noFieldIn[iN]=="absorbers" && lSec.isAbsorberElement(ie));
+      }
+      lElementMgr = noField ? m_noFieldManager : 0;
+      lSec.ele_vol[iV]->GetLogicalVolume()->SetFieldManager(lElementMgr,false);
+    }
+    if (lSec.supportcone_vol) {
+      bool noField = false;
+      for (unsigned iN(0); iN<m_noFieldIn.size() && !noField; ++iN) noField = m_noFieldIn[iN]=="SupportCone";
+      lSec.supportcone_vol->GetLogicalVolume()->SetFieldManager(noField ? m_noFieldManager : 0,false);
+    }
+  }
+  G4RegionStore *lRegions = G4RegionStore::GetInstance();
+  for (unsigned iR(0); iR<lRegions->size(); ++iR){
+    G4Region *lRegion = (*lRegions)[iR];
+    bool noField = false;
+    for (unsigned iN(0); iN<m_noFieldIn.size() && !noField; ++iN) noField = m_noFieldIn[iN]==lRegion->GetName();
+    if (noField) lRegion->SetFieldManager(m_noFieldManager);
+    else if (lRegion->GetFieldManager()==m_noFieldManager) lRegion->SetFieldManager(0);
+  }
+
+  PrintFieldSettings();
+}
+
+void DetectorConstruction::PrintFieldSettings() const
+{
+  if (!m_magField) return;
+  G4FieldManager* fieldMgr = G4TransportationManager::GetTransportationManager()->GetFieldManager();
+  G4cout << " -- Field: Bz=" << m_magField->GetConstantFieldValue().z()/tesla << " T"
+	 << " stepper=" << (m_fieldStepperName.size()>0 ? m_fieldStepperName : "default")
+	 << " deltaChord=" << fieldMgr->GetChordFinder()->GetDeltaChord()/mm << " mm"
+	 << " deltaIntersection=" << fieldMgr->GetDeltaIntersection()/mm << " mm"
+	 << " deltaOneStep=" << fieldMgr->GetDeltaOneStep()/mm << " mm"
+	 << " epsilon=[" << fieldMgr->GetMinimumEpsilonStep() << "," << fieldMgr->GetMaximumEpsilonStep() << "]";
+  if (m_noFieldIn.size()>0) {
+    G4cout << " no field in";
+    for (unsigned iN(0); iN<m_noFieldIn.size(); ++iN) G4cout << " " << m_noFieldIn[iN];
+  }
+  G4cout << G4endl;
 }
 
 void DetectorConstruction::SetDetModel(G4int model)
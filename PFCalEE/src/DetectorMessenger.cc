@@ -38,6 +38,7 @@
 #include "G4UIcmdWithAString.hh"
 #include "G4UIcmdWithAnInteger.hh"
 #include "G4UIcmdWithADoubleAndUnit.hh"
+#include "G4UIcmdWithADouble.hh"
 #include "G4UIcmdWithoutParameter.hh"
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -65,6 +66,62 @@ DetectorMessenger::DetectorMessenger(
   SetModelCmd->SetDefaultValue(0);
   SetModelCmd->AvailableForStates(G4State_PreInit,G4State_Idle);  
 
+  fieldDir = new G4UIdirectory("/N03/det/field/");
+  fieldDir->SetGuidance("field propagation settings, applied to the field of setField");
+
+  StepperCmd = new G4UIcmdWithAString("/N03/det/field/stepper",this);
+  StepperCmd->SetGuidance("Integration stepper, empty for the Geant4 default.");
+  StepperCmd->SetGuidance("ClassicalRK4 SimpleRunge SimpleHeum CashKarpRKF45 DormandPrince745 NystromRK4");
+  StepperCmd->SetGuidance("HelixExplicitEuler HelixImplicitEuler HelixSimpleRunge ExactHelix");
+  StepperCmd->SetParameterName("stepper",true);
+  StepperCmd->SetDefaultValue("");
+  StepperCmd->AvailableForStates(G4State_PreInit,G4State_Idle);
+
+  MinStepCmd = new G4UIcmdWithADoubleAndUnit("/N03/det/field/minStep",this);
+  MinStepCmd->SetGuidance("Minimum step of the chord finder.");
+  MinStepCmd->SetParameterName("minStep",false);
+  MinStepCmd->SetUnitCategory("Length");
+  MinStepCmd->AvailableForStates(G4State_PreInit,G4State_Idle);
+
+  DeltaChordCmd = new G4UIcmdWithADoubleAndUnit("/N03/det/field/deltaChord",this);
+  DeltaChordCmd->SetGuidance("Maximum sagitta of the chords.");
+  DeltaChordCmd->SetParameterName("deltaChord",false);
+  DeltaChordCmd->SetUnitCategory("Length");
+  DeltaChordCmd->AvailableForStates(G4State_PreInit,G4State_Idle);
+
+  DeltaIntersectionCmd = new G4UIcmdWithADoubleAndUnit("/N03/det/field/deltaIntersection",this);
+  DeltaIntersectionCmd->SetGuidance("Accuracy of the boundary intersections.");
+  DeltaIntersectionCmd->SetParameterName("deltaIntersection",false);
+  DeltaIntersectionCmd->SetUnitCategory("Length");
+  DeltaIntersectionCmd->AvailableForStates(G4State_PreInit,G4State_Idle);
+
+  DeltaOneStepCmd = new G4UIcmdWithADoubleAndUnit("/N03/det/field/deltaOneStep",this);
+  DeltaOneStepCmd->SetGuidance("Accuracy of the end point of a step.");
+  DeltaOneStepCmd->SetParameterName("deltaOneStep",false);
+  DeltaOneStepCmd->SetUnitCategory("Length");
+  DeltaOneStepCmd->AvailableForStates(G4State_PreInit,G4State_Idle);
+
+  MinEpsilonCmd = new G4UIcmdWithADouble("/N03/det/field/minEpsilon",this);
+  MinEpsilonCmd->SetGuidance("Minimum relative accuracy of a step.");
+  MinEpsilonCmd->SetParameterName("minEpsilon",false);
+  MinEpsilonCmd->AvailableForStates(G4State_PreInit,G4State_Idle);
+
+  MaxEpsilonCmd = new G4UIcmdWithADouble("/N03/det/field/maxEpsilon",this);
+  MaxEpsilonCmd->SetGuidance("Maximum relative accuracy of a step.");
+  MaxEpsilonCmd->SetParameterName("maxEpsilon",false);
+  MaxEpsilonCmd->AvailableForStates(G4State_PreInit,G4State_Idle);
+
+  NoFieldInCmd = new G4UIcmdWithAString("/N03/det/field/noFieldIn",this);
+  NoFieldInCmd->SetGuidance("csv list of elements (e.g. W,Pb), absorbers, or regions without field.");
+  NoFieldInCmd->SetGuidance("Empty: field everywhere.");
+  NoFieldInCmd->SetParameterName("list",true);
+  NoFieldInCmd->SetDefaultValue("");
+  NoFieldInCmd->AvailableForStates(G4State_PreInit,G4State_Idle);
+
+  PrintFieldCmd = new G4UIcmdWithoutParameter("/N03/det/field/print",this);
+  PrintFieldCmd->SetGuidance("Print the field settings.");
+  PrintFieldCmd->AvailableForStates(G4State_PreInit,G4State_Idle);
+
 }
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -73,6 +130,16 @@ DetectorMessenger::~DetectorMessenger()
 {
   delete MagFieldCmd;
   delete SetModelCmd;
+  delete StepperCmd;
+  delete MinStepCmd;
+  delete DeltaChordCmd;
+  delete DeltaIntersectionCmd;
+  delete DeltaOneStepCmd;
+  delete MinEpsilonCmd;
+  delete MaxEpsilonCmd;
+  delete NoFieldInCmd;
+  delete PrintFieldCmd;
+  delete fieldDir;
   delete detDir;
   delete N03Dir;  
 }
@@ -85,6 +152,24 @@ void DetectorMessenger::SetNewValue(G4UIcommand* command,G4String newValue)
    { Detector->SetMagField(MagFieldCmd->GetNewDoubleValue(newValue));}
   if (command == SetModelCmd )
     { Detector->SetDetModel(SetModelCmd->GetNewIntValue(newValue));}
+  if (command == StepperCmd )
+    { Detector->SetFieldStepper(newValue);}
+  if (command == MinStepCmd )
+    { Detector->SetFieldMinStep(MinStepCmd->GetNewDoubleValue(newValue));}
+  if (command == DeltaChordCmd )
+    { Detector->SetDeltaChord(DeltaChordCmd->GetNewDoubleValue(newValue));}
+  if (command == DeltaIntersectionCmd )
+    { Detector->SetDeltaIntersection(DeltaIntersectionCmd->GetNewDoubleValue(newValue));}
+  if (command == DeltaOneStepCmd )
+    { Detector->SetDeltaOneStep(DeltaOneStepCmd->GetNewDoubleValue(newValue));}
+  if (command == MinEpsilonCmd )
+    { Detector->SetMinEpsilonStep(MinEpsilonCmd->GetNewDoubleValue(newValue));}
+  if (command == MaxEpsilonCmd )
+    { Detector->SetMaxEpsilonStep(MaxEpsilonCmd->GetNewDoubleValue(newValue));}
+  if (command == NoFieldInCmd )
+    { Detector->SetNoFieldIn(newValue);}
+  if (command == PrintFieldCmd )
+    { Detector->PrintFieldSettings();}
 
 }
 
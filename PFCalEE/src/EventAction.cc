@@ -3,23 +3,33 @@
 #include "RunAction.hh"
 #include "EventActionMessenger.hh"
 #include "DetectorConstruction.hh"
+#include "StackingAction.hh"
+#include "SimProfiler.hh"
+#include "RegionOfInterest.hh"
+#include "Checkpoint.hh"
 
 #include "HGCSSInfo.hh"
 
 #include "G4RunManager.hh"
 #include "G4Event.hh"
+#include "G4Run.hh"
 #include "G4UnitsTable.hh"
 
 #include "Randomize.hh"
 #include <iomanip>
 
 //
-EventAction::EventAction()
+EventAction::EventAction(Checkpoint *checkpoint)
 {
   runAct = (RunAction*)G4RunManager::GetRunManager()->GetUserRunAction();
   eventMessenger = new EventActionMessenger(this);
   printModulo = 10;
-  outF_=TFile::Open("PFcal.root","RECREATE");
+  profiler_ = 0;
+  roi_ = 0;
+  checkpoint_ = checkpoint;
+  skipEvent_ = false;
+  outF_ = checkpoint_ ? checkpoint_->openOutput("PFcal.root") : TFile::Open("PFcal.root","RECREATE");
+  const bool resuming = checkpoint_ && checkpoint_->resuming();
   outF_->cd();
 
   double xysize = ((DetectorConstruction*)G4RunManager::GetRunManager()->GetUserDetectorConstruction())->GetCalorSizeXY();
@@ -29,7 +39,8 @@ EventAction::EventAction()
   firstCoarseScintlayer_ = ((DetectorConstruction*)G4RunManager::GetRunManager()->GetUserDetectorConstruction())->firstCoarseScintlayer();
 
   //save some info
-  HGCSSInfo *info = new HGCSSInfo();
+  info_ = new HGCSSInfo();
+  HGCSSInfo *info = info_;
   info->calorSizeXY(xysize);
   info->cellSize(coarseGranularity_>0 ? CELL_SIZE_X : coarseGranularity_<0 ? ULTRAFINE_CELL_SIZE_X : FINE_CELL_SIZE_X);
   info->model(((DetectorConstruction*)G4RunManager::GetRunManager()->GetUserDetectorConstruction())->getModel());
@@ -39,7 +50,8 @@ EventAction::EventAction()
 	    << " model = " << info->model()
 	    << " shape = " << shape_
 	    << std::endl;
-  outF_->WriteObjectAny(info,"HGCSSInfo","Info");
+  //a resumed file has it already, rewritten with the counters
+  if (!resuming) outF_->WriteObjectAny(info,"HGCSSInfo","Info");
 
   //honeycomb or diamond or triangles
   geomConv_ = new HGCSSGeometryConversion(info->model(),coarseGranularity_>0 ? CELL_SIZE_X : coarseGranularity_<0 ? ULTRAFINE_CELL_SIZE_X : FINE_CELL_SIZE_X);
@@ -55,12 +67,26 @@ EventAction::EventAction()
   geomConv_->initialiseSquareMap2(etamin,etamax,-1.*TMath::Pi(),TMath::Pi(),TMath::Pi()*2./288.);//eta phi segmentation
 
 
-  tree_=new TTree("HGCSSTree","HGC Standalone simulation tree");
-  tree_->Branch("HGCSSEvent","HGCSSEvent",&event_);
-  tree_->Branch("HGCSSSamplingSectionVec","std::vector<HGCSSSamplingSection>",&ssvec_);
-  tree_->Branch("HGCSSSimHitVec","std::vector<HGCSSSimHit>",&hitvec_);
-  tree_->Branch("HGCSSAluSimHitVec","std::vector<HGCSSSimHit>",&alhitvec_);
-  tree_->Branch("HGCSSGenParticleVec","std::vector<HGCSSGenParticle>",&genvec_);
+  if (resuming){
+    //new entries are appended
+    tree_=(TTree*)outF_->Get("HGCSSTree");
+    tree_->SetBranchAddress("HGCSSEvent",&event_);
+    tree_->SetBranchAddress("HGCSSSamplingSectionVec",&ssvec_);
+    tree_->SetBranchAddress("HGCSSSimHitVec",&hitvec_);
+    tree_->SetBranchAddress("HGCSSAluSimHitVec",&alhitvec_);
+    tree_->SetBranchAddress("HGCSSGenParticleVec",&genvec_);
+  }
+  else {
+    tree_=new TTree("HGCSSTree","HGC Standalone simulation tree");
+    tree_->Branch("HGCSSEvent","HGCSSEvent",&event_);
+    tree_->Branch("HGCSSSamplingSectionVec","std::vector<HGCSSSamplingSection>",&ssvec_);
+    tree_->Branch("HGCSSSimHitVec","std::vector<HGCSSSimHit>",&hitvec_);
+    tree_->Branch("HGCSSAluSimHitVec","std::vector<HGCSSSimHit>",&alhitvec_);
+    tree_->Branch("HGCSSGenParticleVec","std::vector<HGCSSGenParticle>",&genvec_);
+  }
+  //the autosave would overwrite the tree header between checkpoints:
+  //only Checkpoint::endEvent writes it
+  if (checkpoint_) tree_->SetAutoSave(0);
 
   //fout_.open("ProcessDepAbove5MeV.dat");
   //if (!fout_.is_open()){
@@ -73,8 +99,13 @@ EventAction::EventAction()
 EventAction::~EventAction()
 {
   outF_->cd();
-  tree_->Write();
+  //replaces the checkpoint cycles
+  if (checkpoint_) tree_->Write("",TObject::kOverwrite);
+  else tree_->Write();
+  //rewrite with the final stacking counters
+  outF_->WriteObjectAny(info_,"HGCSSInfo","Info","overwrite");
   outF_->Close();
+  delete info_;
   //fout_.close();
   delete eventMessenger;
 }
@@ -83,6 +114,19 @@ EventAction::~EventAction()
 void EventAction::BeginOfEventAction(const G4Event* evt)
 {
   evtNb_ = evt->GetEventID();
+  if (checkpoint_) {
+    //resumed job: the run ends at the event number of the macro
+    evtNb_ += checkpoint_->firstEvent();
+    skipEvent_ = evtNb_ >= G4RunManager::GetRunManager()->GetCurrentRun()->GetNumberOfEventToBeProcessed();
+    if (skipEvent_) {
+      G4cout << " -- Checkpoint: all events already simulated." << G4endl;
+      G4RunManager::GetRunManager()->AbortRun(true);
+      G4RunManager::GetRunManager()->AbortEvent();
+      return;
+    }
+  }
+  if (profiler_) profiler_->beginEvent(evtNb_);
+  if (roi_) roi_->beginEvent(evt);
   if (evtNb_%printModulo == 0) {
     G4cout << "\n---> Begin of event: " << evtNb_ << G4endl;
     CLHEP::HepRandom::showEngineStatus();
@@ -117,6 +161,8 @@ bool EventAction::isFirstVolume(const std::string volname) const{
 void EventAction::EndOfEventAction(const G4Event* g4evt)
 {
   //return;
+  if (skipEvent_) return;
+  if (profiler_) profiler_->beginAggregation();
   bool debug(evtNb_%printModulo == 0);
   hitvec_.clear();
 
@@ -218,9 +264,27 @@ void EventAction::EndOfEventAction(const G4Event* g4evt)
 
   tree_->Fill();
 
+  const StackingAction *stacking = (const StackingAction*)G4RunManager::GetRunManager()->GetUserStackingAction();
+  if (stacking) {
+    stacking->fillInfo(*info_);
+    if (debug) stacking->print();
+  }
+  if (roi_) {
+    roi_->fillInfo(*info_);
+    if (debug) roi_->print();
+  }
+
+  if (checkpoint_) {
+    const bool lastEvent = evtNb_+1 >= G4RunManager::GetRunManager()->GetCurrentRun()->GetNumberOfEventToBeProcessed();
+    checkpoint_->endEvent(outF_,tree_,info_,lastEvent);
+    if (lastEvent && checkpoint_->firstEvent()>0) G4RunManager::GetRunManager()->AbortRun(true);
+  }
+
   //reset vectors
   genvec_.clear();
   hitvec_.clear();
   alhitvec_.clear();
   ssvec_.clear();
+
+  if (profiler_) profiler_->endEvent();
 }
@@ -0,0 +1,84 @@
+#include "FrozenShowerMessenger.hh"
+
+#include "FrozenShowerModel.hh"
+#include "ShowerLibraryBuilder.hh"
+
+#include "G4UIdirectory.hh"
+#include "G4UIcmdWithAnInteger.hh"
+#include "G4UIcmdWithADoubleAndUnit.hh"
+
+FrozenShowerMessenger::FrozenShowerMessenger(FrozenShowerModel* model, ShowerLibraryBuilder* builder)
+  :model_(model),builder_(builder),
+   NEnergyBinsCmd(0),NAngleBinsCmd(0),MaxEntriesCmd(0),SpotSizeCmd(0)
+{
+  frozenDir = new G4UIdirectory("/N03/frozen/");
+  frozenDir->SetGuidance("frozen shower library control");
+
+  MinEnergyCmd = new G4UIcmdWithADoubleAndUnit("/N03/frozen/minEnergy",this);
+  MinEnergyCmd->SetGuidance("Minimum kinetic energy of e+/e-/gamma replaced by (or recorded as) frozen showers.");
+  MinEnergyCmd->SetParameterName("minE",false);
+  MinEnergyCmd->SetUnitCategory("Energy");
+  MinEnergyCmd->SetRange("minE>0.");
+  MinEnergyCmd->AvailableForStates(G4State_PreInit,G4State_Idle);
+
+  MaxEnergyCmd = new G4UIcmdWithADoubleAndUnit("/N03/frozen/maxEnergy",this);
+  MaxEnergyCmd->SetGuidance("Maximum kinetic energy of e+/e-/gamma replaced by (or recorded as) frozen showers.");
+  MaxEnergyCmd->SetParameterName("maxE",false);
+  MaxEnergyCmd->SetUnitCategory("Energy");
+  MaxEnergyCmd->SetRange("maxE>0.");
+  MaxEnergyCmd->AvailableForStates(G4State_PreInit,G4State_Idle);
+
+  if (builder_){
+    NEnergyBinsCmd = new G4UIcmdWithAnInteger("/N03/frozen/nEnergyBins",this);
+    NEnergyBinsCmd->SetGuidance("Number of logarithmic energy bins of the library.");
+    NEnergyBinsCmd->SetParameterName("nBins",false);
+    NEnergyBinsCmd->SetRange("nBins>0");
+    NEnergyBinsCmd->AvailableForStates(G4State_PreInit,G4State_Idle);
+
+    NAngleBinsCmd = new G4UIcmdWithAnInteger("/N03/frozen/nAngleBins",this);
+    NAngleBinsCmd->SetGuidance("Number of cos(theta) bins of the library.");
+    NAngleBinsCmd->SetParameterName("nBins",false);
+    NAngleBinsCmd->SetRange("nBins>0");
+    NAngleBinsCmd->AvailableForStates(G4State_PreInit,G4State_Idle);
+
+    MaxEntriesCmd = new G4UIcmdWithAnInteger("/N03/frozen/maxEntriesPerBin",this);
+    MaxEntriesCmd->SetGuidance("Number of showers stored per (particle,energy,absorber,angle) bin.");
+    MaxEntriesCmd->SetParameterName("nEntries",false);
+    MaxEntriesCmd->SetRange("nEntries>0");
+    MaxEntriesCmd->AvailableForStates(G4State_PreInit,G4State_Idle);
+
+    SpotSizeCmd = new G4UIcmdWithADoubleAndUnit("/N03/frozen/spotSize",this);
+    SpotSizeCmd->SetGuidance("Deposits of a shower within this distance are merged.");
+    SpotSizeCmd->SetParameterName("size",false);
+    SpotSizeCmd->SetUnitCategory("Length");
+    SpotSizeCmd->SetRange("size>0.");
+    SpotSizeCmd->AvailableForStates(G4State_PreInit,G4State_Idle);
+  }
+}
+
+FrozenShowerMessenger::~FrozenShowerMessenger()
+{
+  delete MinEnergyCmd;
+  delete MaxEnergyCmd;
+  delete NEnergyBinsCmd;
+  delete NAngleBinsCmd;
+  delete MaxEntriesCmd;
+  delete SpotSizeCmd;
+  delete frozenDir;
+}
+
+void FrozenShowerMessenger::SetNewValue(G4UIcommand* command, G4String newValue)
+{
+  if (command == MinEnergyCmd) {
+    if (model_) model_->setMinEnergy(MinEnergyCmd->GetNewDoubleValue(newValue));
+    if (builder_) builder_->setMinEnergy(MinEnergyCmd->GetNewDoubleValue(newValue));
+  }
+  else if (command == MaxEnergyCmd) {
+    if (model_) model_->setMaxEnergy(MaxEnergyCmd->GetNewDoubleValue(newValue));
+    if (builder_) builder_->setMaxEnergy(MaxEnergyCmd->GetNewDoubleValue(newValue));
+  }
+  else if (command == NEnergyBinsCmd) builder_->setNEnergyBins(NEnergyBinsCmd->GetNewIntValue(newValue));
+  else if (command == NAngleBinsCmd) builder_->setNAngleBins(NAngleBinsCmd->GetNewIntValue(newValue));
+  else if (command == MaxEntriesCmd) builder_->setMaxEntriesPerBin(MaxEntriesCmd->GetNewIntValue(newValue));
+  else if (command == SpotSizeCmd) builder_->setSpotSize(SpotSizeCmd->GetNewDoubleValue(newValue));
+}
@@ -0,0 +1,124 @@
+#include "FrozenShowerModel.hh"
+
+#include "EventAction.hh"
+
+#include "G4RunManager.hh"
+#include "G4TransportationManager.hh"
+#include "G4FastTrack.hh"
+#include "G4FastStep.hh"
+#include "G4Track.hh"
+#include "G4Material.hh"
+#include "G4Electron.hh"
+#include "G4Positron.hh"
+#include "G4Gamma.hh"
+#include "G4SystemOfUnits.hh"
+#include "G4PhysicalConstants.hh"
+#include "Randomize.hh"
+
+#include "HGCSSGenParticle.hh"
+
+#include <cmath>
+#include <algorithm>
+
+FrozenShowerModel::FrozenShowerModel(const G4String & name, G4Region* envelope, ShowerLibrary *library)
+  : G4VFastSimulationModel(name,envelope)
+{
+  library_ = library;
+  eventAction_ = 0;
+  navigator_ = new G4Navigator();
+  minE_ = library_->minEnergy();
+  maxE_ = library_->maxEnergy();
+  nReplaced_ = 0;
+  eReplaced_ = 0;
+  nLost_ = 0;
+}
+
+FrozenShowerModel::~FrozenShowerModel()
+{
+  print();
+  delete navigator_;
+  delete library_;
+}
+
+void FrozenShowerModel::setMinEnergy(const G4double minE){
+  minE_ = std::max(minE,library_->minEnergy());
+}
+
+void FrozenShowerModel::setMaxEnergy(const G4double maxE){
+  maxE_ = std::min(maxE,library_->maxEnergy());
+}
+
+G4bool FrozenShowerModel::IsApplicable(const G4ParticleDefinition & particle){
+  return &particle == G4Electron::ElectronDefinition() ||
+    &particle == G4Positron::PositronDefinition() ||
+    &particle == G4Gamma::GammaDefinition();
+}
+
+G4bool FrozenShowerModel::ModelTrigger(const G4FastTrack & fastTrack){
+  const G4Track *lTrack = fastTrack.GetPrimaryTrack();
+  const G4double energy = lTrack->GetKineticEnergy();
+  if (energy < minE_ || energy >= maxE_) return false;
+  return library_->hasEntries(ShowerLibrary::particleIndex(lTrack->GetDefinition()->GetPDGEncoding()),
+			      energy,
+			      lTrack->GetMaterial()->GetName(),
+			      lTrack->GetMomentumDirection().z());
+}
+
+void FrozenShowerModel::basis(const G4ThreeVector & dir, G4ThreeVector & u, G4ThreeVector & v){
+  u = dir.orthogonal().unit();
+  v = dir.cross(u);
+}
+
+void FrozenShowerModel::DoIt(const G4FastTrack & fastTrack, G4FastStep & fastStep){
+  const G4Track *lTrack = fastTrack.GetPrimaryTrack();
+  const G4double energy = lTrack->GetKineticEnergy();
+  const G4ThreeVector & dir = lTrack->GetMomentumDirection();
+  const ShowerEntry *lEntry = library_->getEntry(ShowerLibrary::particleIndex(lTrack->GetDefinition()->GetPDGEncoding()),
+						 energy,
+						 lTrack->GetMaterial()->GetName(),
+						 dir.z());
+  //ModelTrigger guarantees a non-empty bin
+  if (!lEntry) return;
+
+  if (!eventAction_) eventAction_ = (EventAction*)G4RunManager::GetRunManager()->GetUserEventAction();
+  if (!navigator_->GetWorldVolume())
+    navigator_->SetWorldVolume(G4TransportationManager::GetTransportationManager()->GetNavigatorForTracking()->GetWorldVolume());
+
+  //random rotation around the particle direction
+  G4ThreeVector u0,v0;
+  basis(dir,u0,v0);
+  const G4double phi = twopi*G4UniformRand();
+  const G4double cphi = cos(phi);
+  const G4double sphi = sin(phi);
+  const G4ThreeVector u = cphi*u0+sphi*v0;
+  const G4ThreeVector v = cphi*v0-sphi*u0;
+
+  const G4ThreeVector & origin = lTrack->GetPosition();
+  const G4double t0 = lTrack->GetGlobalTime();
+  const G4int trackID = lTrack->GetTrackID();
+  HGCSSGenParticle genPart;
+
+  for (unsigned iS(0); iS<lEntry->spots.size(); ++iS){
+    const ShowerSpot & spot = lEntry->spots[iS];
+    const G4ThreeVector position = origin + spot.x*u + spot.y*v + spot.z*dir;
+    G4VPhysicalVolume *volume = navigator_->LocateGlobalPointAndSetup(position,0,false,true);
+    if (!volume) {
+      nLost_++;
+      continue;
+    }
+    eventAction_->Detect(spot.e*energy,spot.dl*energy,t0+spot.t,spot.pdgId,
+			 volume,position,trackID,trackID,genPart);
+  }
+
+  nReplaced_++;
+  eReplaced_ += energy;
+
+  fastStep.KillPrimaryTrack();
+  fastStep.ProposePrimaryTrackPathLength(0.0);
+  fastStep.ProposeTotalEnergyDeposited(0.0);
+}
+
+void FrozenShowerModel::print() const{
+  G4cout << " -- FrozenShowerModel: " << nReplaced_ << " particles replaced for a total of "
+	 << eReplaced_/GeV << " GeV, " << nLost_ << " deposits outside the world." << G4endl;
+}
@@ -40,7 +40,7 @@
 
 ////////////////////////////////////////
 HepMCG4AsciiReader::HepMCG4AsciiReader()
-  :  filename("xxx.dat"), verbose(0)
+  :  filename("xxx.dat"), verbose(0), nSkip(0)
 ////////////////////////////////////////
 {
   asciiInput= new HepMC::IO_GenEvent(filename.c_str(), std::ios::in);
@@ -69,6 +69,12 @@ void HepMCG4AsciiReader::Initialize()
 HepMC::GenEvent* HepMCG4AsciiReader::GenerateHepMCEvent()
 /////////////////////////////////////////////////////////
 {
+  for(; nSkip>0; nSkip--) {
+    HepMC::GenEvent* skipped= asciiInput-> read_next_event();
+    if(!skipped) return 0;
+    delete skipped;
+  }
+
   HepMC::GenEvent* evt= asciiInput-> read_next_event();
   if(!evt) return 0; // no more event
 
@@ -36,6 +36,7 @@
 #include "G4RunManager.hh"
 
 #include "G4ProcessManager.hh"
+#include "G4FastSimulationPhysics.hh"
 
 // #include "G4BosonConstructor.hh"
 // #include "G4LeptonConstructor.hh"
@@ -46,13 +47,23 @@
 #include "G4SystemOfUnits.hh"
 #include "G4UnitsTable.hh"
 
+#include <sstream>
+
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
 //PhysicsList::PhysicsList():  QGSP_FTFP_BERT() //G4VUserPhysicsList()
-PhysicsList::PhysicsList():  QGSP_BERT() //G4VUserPhysicsList()
+PhysicsList::PhysicsList(const bool fastSimulation):  QGSP_BERT() //G4VUserPhysicsList()
 {
+  fastSimulation_ = fastSimulation;
   defaultCutValue = 0.03*mm;
   SetVerboseLevel(1);
+  if (fastSimulation) {
+    G4FastSimulationPhysics* fastSimulationPhysics = new G4FastSimulationPhysics();
+    fastSimulationPhysics->ActivateFastSimulation("e-");
+    fastSimulationPhysics->ActivateFastSimulation("e+");
+    fastSimulationPhysics->ActivateFastSimulation("gamma");
+    RegisterPhysics(fastSimulationPhysics);
+  }
 }
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -215,18 +226,7 @@ void PhysicsList::SetCuts()
     G4cout << "CutLength : " << G4BestUnit(defaultCutValue,"Length") << G4endl;
   }
 
-  // set cut values for gamma at first and for e- second and next for e+,
-  // because some processes for e+/e- need cut values for gamma
-  //
-
-  SetCutValue(0.7*mm, "gamma");
-  SetCutValue(0.7*mm, "e-");
-  SetCutValue(0.7*mm, "e+");
-  SetCutValue(0.7*mm, "proton");
-  //SetCutValue(defaultCutValue, "gamma");
-  //SetCutValue(defaultCutValue, "e-");
-  //SetCutValue(defaultCutValue, "e+");
-  //SetCutValue(defaultCutValue, "proton");
+  SetProductionCuts();
 
    //set smaller cut for Si
    const std::vector<G4LogicalVolume*> & logSi = ((DetectorConstruction*)G4RunManager::GetRunManager()->GetUserDetectorConstruction())->getSiLogVol();
@@ -236,7 +236,7 @@ void PhysicsList::SetCuts()
       //sprintf(nameBuf,"Si%dReg",int(i+1)); 
       G4Region* reg = logSi[i]->GetRegion();
       G4ProductionCuts* cuts = new G4ProductionCuts;
-      cuts->SetProductionCut(defaultCutValue);
+      cuts->SetProductionCut(siliconCut());
       reg->SetProductionCuts(cuts);    
     }
 
@@ -257,3 +257,34 @@ void PhysicsList::SetCuts()
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
+void PhysicsList::SetProductionCuts()
+{
+  // set cut values for gamma at first and for e- second and next for e+,
+  // because some processes for e+/e- need cut values for gamma
+  //
+
+  SetCutValue(0.7*mm, "gamma");
+  SetCutValue(0.7*mm, "e-");
+  SetCutValue(0.7*mm, "e+");
+  SetCutValue(0.7*mm, "proton");
+  //SetCutValue(defaultCutValue, "gamma");
+  //SetCutValue(defaultCutValue, "e-");
+  //SetCutValue(defaultCutValue, "e+");
+  //SetCutValue(defaultCutValue, "proton");
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+std::string PhysicsList::cacheKey()
+{
+  //the values used by SetCuts, not copies of them
+  SetProductionCuts();
+  std::ostringstream lKey;
+  lKey << "physics=QGSP_BERT cuts=" << GetCutValue("gamma")/mm << "," << GetCutValue("e-")/mm
+       << "," << GetCutValue("e+")/mm << "," << GetCutValue("proton")/mm
+       << "mm Si=" << siliconCut()/mm << "mm fastSimulation=" << fastSimulation_;
+  return lKey.str();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
@@ -96,6 +96,14 @@ PrimaryGeneratorAction::PrimaryGeneratorAction(G4int mod, double eta)
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
+void PrimaryGeneratorAction::SkipEvents(G4int n)
+{
+  hepmcAscii->SkipEvents(n);
+  if (n>0 && currentGenerator==pythiaGen)
+    G4cout << " -- WARNING! PrimaryGeneratorAction: pythia events cannot be skipped, the resumed job will not reproduce them." << G4endl;
+}
+
+
 PrimaryGeneratorAction::~PrimaryGeneratorAction()
 {
   delete particleGun;
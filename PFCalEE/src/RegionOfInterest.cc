@@ -0,0 +1,88 @@
+#include "RegionOfInterest.hh"
+
+#include "G4Event.hh"
+#include "G4PrimaryVertex.hh"
+#include "G4PrimaryParticle.hh"
+#include "G4Track.hh"
+#include "G4PhysicalConstants.hh"
+
+#include "HGCSSInfo.hh"
+
+#include <cstdlib>
+
+RegionOfInterest::RegionOfInterest(const G4double deltaEta, const G4double deltaPhi)
+{
+  deltaEta_ = deltaEta;
+  deltaPhi_ = deltaPhi;
+  nKilled_ = 0;
+  warned_ = false;
+}
+
+void RegionOfInterest::beginEvent(const G4Event *evt)
+{
+  cones_.clear();
+  for (G4int iV(0); iV<evt->GetNumberOfPrimaryVertex(); ++iV){
+    const G4PrimaryVertex *vtx = evt->GetPrimaryVertex(iV);
+    for (G4int iP(0); iP<vtx->GetNumberOfParticle(); ++iP){
+      const G4PrimaryParticle *part = vtx->GetPrimary(iP);
+      const int pdgId = abs(part->GetPDGcode());
+      if (pdgId==12 || pdgId==14 || pdgId==16) continue;
+      const G4ThreeVector & dir = part->GetMomentumDirection();
+      if (dir.perp2()==0) {
+	//along the beam axis, eta is undefined
+	if (!warned_) G4cout << " -- WARNING! RegionOfInterest: primaries along z are ignored." << G4endl;
+	warned_ = true;
+	continue;
+      }
+      Cone cone;
+      cone.vertex = vtx->GetPosition();
+      cone.eta = dir.eta();
+      cone.phi = dir.phi();
+      cones_.push_back(cone);
+    }
+  }
+}
+
+bool RegionOfInterest::contains(const G4ThreeVector & position) const
+{
+  //no usable primary: keep everything
+  if (cones_.empty()) return true;
+  for (unsigned iC(0); iC<cones_.size(); ++iC){
+    const Cone & cone = cones_[iC];
+    const G4ThreeVector pos = position-cone.vertex;
+    if (pos.perp2()==0) return true;
+    const G4double x = (pos.eta()-cone.eta)/deltaEta_;
+    G4double dphi = pos.phi()-cone.phi;
+    if (dphi>pi) dphi -= twopi;
+    else if (dphi<-pi) dphi += twopi;
+    const G4double y = dphi/deltaPhi_;
+    if (x*x+y*y < 1) return true;
+  }
+  return false;
+}
+
+bool RegionOfInterest::check(G4Track *track, const G4ThreeVector & position)
+{
+  if (track->GetParentID()==0 || contains(position)) return false;
+  track->SetTrackStatus(fStopAndKill);
+  nKilled_++;
+  return true;
+}
+
+void RegionOfInterest::fillInfo(HGCSSInfo & info) const
+{
+  info.roiDeltaEta(deltaEta_);
+  info.roiDeltaPhi(deltaPhi_);
+  info.nKilledRoI(nKilled_);
+}
+
+void RegionOfInterest::restoreCounters(const HGCSSInfo & info)
+{
+  nKilled_ = info.nKilledRoI();
+}
+
+void RegionOfInterest::print() const
+{
+  G4cout << " -- RegionOfInterest: deltaEta=" << deltaEta_ << " deltaPhi=" << deltaPhi_
+	 << " cones=" << cones_.size() << " killed=" << nKilled_ << G4endl;
+}
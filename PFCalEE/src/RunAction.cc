@@ -30,6 +30,9 @@
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
 #include "RunAction.hh"
+#include "SimProfiler.hh"
+#include "StartupCache.hh"
+#include "Checkpoint.hh"
 
 #include "G4Run.hh"
 #include "G4RunManager.hh"
@@ -38,7 +41,11 @@
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
 RunAction::RunAction()
-{}
+{
+  profiler_ = 0;
+  cache_ = 0;
+  checkpoint_ = 0;
+}
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
@@ -58,6 +65,14 @@ void RunAction::BeginOfRunAction(const G4Run* aRun)
   //
   sumEAbs = sum2EAbs =sumEGap = sum2EGap = 0.;
   sumLAbs = sum2LAbs =sumLGap = sum2LGap = 0.; 
+
+  //physics tables are built by now
+  if (cache_) cache_->store();
+
+  //after the seeds of the macro
+  if (checkpoint_) checkpoint_->beginRun();
+
+  if (profiler_) profiler_->beginRun();
 }
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -79,6 +94,7 @@ void RunAction::fillPerEvent(G4double EAbs, G4double EGap,
 void RunAction::EndOfRunAction(const G4Run* aRun)
 {
   G4int NbOfEvents = aRun->GetNumberOfEvent();
+  if (profiler_) profiler_->endRun(NbOfEvents);
   if (NbOfEvents == 0) return;
   
   G4cout
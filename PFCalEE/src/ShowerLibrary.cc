@@ -0,0 +1,223 @@
+#include "ShowerLibrary.hh"
+
+#include "Randomize.hh"
+#include "G4SystemOfUnits.hh"
+
+#include "TFile.h"
+#include "TTree.h"
+
+#include <cmath>
+#include <cstdlib>
+
+ShowerLibrary::ShowerLibrary(const G4double minE, const G4double maxE,
+			     const unsigned nEnergyBins, const unsigned nAngleBins)
+{
+  minE_ = minE;
+  maxE_ = maxE;
+  nEnergyBins_ = nEnergyBins>0 ? nEnergyBins : 1;
+  nAngleBins_ = nAngleBins>0 ? nAngleBins : 1;
+  logMinE_ = log(minE_);
+  logBinWidth_ = (log(maxE_)-logMinE_)/nEnergyBins_;
+  nEntries_ = 0;
+}
+
+ShowerLibrary::ShowerLibrary(const std::string & fileName)
+{
+  nEntries_ = 0;
+  TFile *lFile = TFile::Open(fileName.c_str());
+  if (!lFile) {
+    G4cout << " -- ERROR! Shower library " << fileName << " cannot be opened. Exiting..." << G4endl;
+    exit(1);
+  }
+  TTree *binning = (TTree*)lFile->Get("ShowerLibraryBinning");
+  TTree *tree = (TTree*)lFile->Get("ShowerLibrary");
+  if (!binning || !tree || binning->GetEntries()!=1) {
+    G4cout << " -- ERROR! " << fileName << " is not a shower library. Exiting..." << G4endl;
+    exit(1);
+  }
+  binning->SetBranchAddress("minE",&minE_);
+  binning->SetBranchAddress("maxE",&maxE_);
+  binning->SetBranchAddress("nEnergyBins",&nEnergyBins_);
+  binning->SetBranchAddress("nAngleBins",&nAngleBins_);
+  binning->GetEntry(0);
+  logMinE_ = log(minE_);
+  logBinWidth_ = (log(maxE_)-logMinE_)/nEnergyBins_;
+
+  Int_t particle = 0, eBin = 0, aBin = 0;
+  Double_t energy = 0;
+  std::string *absorber = 0;
+  std::vector<float> *x = 0, *y = 0, *z = 0, *t = 0, *e = 0, *dl = 0;
+  std::vector<int> *pdgId = 0;
+  tree->SetBranchAddress("particle",&particle);
+  tree->SetBranchAddress("eBin",&eBin);
+  tree->SetBranchAddress("aBin",&aBin);
+  tree->SetBranchAddress("absorber",&absorber);
+  tree->SetBranchAddress("energy",&energy);
+  tree->SetBranchAddress("x",&x);
+  tree->SetBranchAddress("y",&y);
+  tree->SetBranchAddress("z",&z);
+  tree->SetBranchAddress("t",&t);
+  tree->SetBranchAddress("e",&e);
+  tree->SetBranchAddress("dl",&dl);
+  tree->SetBranchAddress("pdgId",&pdgId);
+
+  for (Long64_t ientry(0); ientry<tree->GetEntries(); ++ientry){
+    tree->GetEntry(ientry);
+    Key lKey = {particle,eBin,aBin,*absorber};
+    ShowerEntry lEntry;
+    lEntry.energy = energy;
+    lEntry.spots.resize(x->size());
+    for (unsigned iS(0); iS<x->size(); ++iS){
+      ShowerSpot & spot = lEntry.spots[iS];
+      spot.x = (*x)[iS];
+      spot.y = (*y)[iS];
+      spot.z = (*z)[iS];
+      spot.t = (*t)[iS];
+      spot.e = (*e)[iS];
+      spot.dl = (*dl)[iS];
+      spot.pdgId = (*pdgId)[iS];
+    }
+    entries_[lKey].push_back(lEntry);
+    ++nEntries_;
+  }
+  lFile->Close();
+  print();
+}
+
+int ShowerLibrary::particleIndex(const G4int pdgId){
+  if (pdgId==11) return 0;
+  if (pdgId==-11) return 1;
+  if (pdgId==22) return 2;
+  return -1;
+}
+
+int ShowerLibrary::energyBin(const G4double energy) const{
+  if (energy < minE_ || energy >= maxE_) return -1;
+  int lBin = static_cast<int>((log(energy)-logMinE_)/logBinWidth_);
+  return lBin < static_cast<int>(nEnergyBins_) ? lBin : nEnergyBins_-1;
+}
+
+int ShowerLibrary::angleBin(const G4double cosTheta) const{
+  int lBin = static_cast<int>((cosTheta+1.)/2.*nAngleBins_);
+  if (lBin<0) return 0;
+  return lBin < static_cast<int>(nAngleBins_) ? lBin : nAngleBins_-1;
+}
+
+const std::vector<ShowerEntry> * ShowerLibrary::bin(const int particle, const G4double energy,
+						    const std::string & absorber, const G4double cosTheta) const{
+  int eBin = energyBin(energy);
+  if (particle<0 || eBin<0) return 0;
+  Key lKey = {particle,eBin,angleBin(cosTheta),absorber};
+  std::map<Key,std::vector<ShowerEntry> >::const_iterator lIter = entries_.find(lKey);
+  if (lIter == entries_.end()) return 0;
+  return &(lIter->second);
+}
+
+bool ShowerLibrary::hasEntries(const int particle, const G4double energy,
+			       const std::string & absorber, const G4double cosTheta) const{
+  const std::vector<ShowerEntry> * lBin = bin(particle,energy,absorber,cosTheta);
+  return lBin && lBin->size()>0;
+}
+
+const ShowerEntry * ShowerLibrary::getEntry(const int particle, const G4double energy,
+					    const std::string & absorber, const G4double cosTheta) const{
+  const std::vector<ShowerEntry> * lBin = bin(particle,energy,absorber,cosTheta);
+  if (!lBin || lBin->size()==0) return 0;
+  unsigned idx = static_cast<unsigned>(G4UniformRand()*lBin->size());
+  if (idx >= lBin->size()) idx = lBin->size()-1;
+  return &((*lBin)[idx]);
+}
+
+bool ShowerLibrary::isFull(const int particle, const G4double energy,
+			   const std::string & absorber, const G4double cosTheta,
+			   const unsigned maxEntries) const{
+  const std::vector<ShowerEntry> * lBin = bin(particle,energy,absorber,cosTheta);
+  return lBin && lBin->size() >= maxEntries;
+}
+
+bool ShowerLibrary::add(const int particle, const std::string & absorber,
+			const G4double cosTheta, const ShowerEntry & entry,
+			const unsigned maxEntries){
+  int eBin = energyBin(entry.energy);
+  if (particle<0 || eBin<0) return false;
+  Key lKey = {particle,eBin,angleBin(cosTheta),absorber};
+  std::vector<ShowerEntry> & lBin = entries_[lKey];
+  if (lBin.size() >= maxEntries) return false;
+  lBin.push_back(entry);
+  ++nEntries_;
+  return true;
+}
+
+void ShowerLibrary::write(const std::string & fileName) const{
+  TFile *lFile = TFile::Open(fileName.c_str(),"RECREATE");
+  if (!lFile) {
+    G4cout << " -- ERROR! Cannot write shower library to " << fileName << G4endl;
+    return;
+  }
+  lFile->cd();
+  G4double minE = minE_, maxE = maxE_;
+  unsigned nEnergyBins = nEnergyBins_, nAngleBins = nAngleBins_;
+  TTree *binning = new TTree("ShowerLibraryBinning","Shower library binning");
+  binning->Branch("minE",&minE);
+  binning->Branch("maxE",&maxE);
+  binning->Branch("nEnergyBins",&nEnergyBins);
+  binning->Branch("nAngleBins",&nAngleBins);
+  binning->Fill();
+  binning->Write();
+
+  Int_t particle = 0, eBin = 0, aBin = 0;
+  Double_t energy = 0;
+  std::string absorber;
+  std::vector<float> x, y, z, t, e, dl;
+  std::vector<int> pdgId;
+  TTree *tree = new TTree("ShowerLibrary","Frozen e/gamma showers");
+  tree->Branch("particle",&particle);
+  tree->Branch("eBin",&eBin);
+  tree->Branch("aBin",&aBin);
+  tree->Branch("absorber",&absorber);
+  tree->Branch("energy",&energy);
+  tree->Branch("x",&x);
+  tree->Branch("y",&y);
+  tree->Branch("z",&z);
+  tree->Branch("t",&t);
+  tree->Branch("e",&e);
+  tree->Branch("dl",&dl);
+  tree->Branch("pdgId",&pdgId);
+
+  std::map<Key,std::vector<ShowerEntry> >::const_iterator lIter = entries_.begin();
+  for (; lIter != entries_.end(); ++lIter){
+    particle = lIter->first.particle;
+    eBin = lIter->first.eBin;
+    aBin = lIter->first.aBin;
+    absorber = lIter->first.absorber;
+    for (unsigned iE(0); iE<lIter->second.size(); ++iE){
+      const ShowerEntry & lEntry = lIter->second[iE];
+      energy = lEntry.energy;
+      const unsigned nSpots = lEntry.spots.size();
+      x.resize(nSpots); y.resize(nSpots); z.resize(nSpots); t.resize(nSpots);
+      e.resize(nSpots); dl.resize(nSpots); pdgId.resize(nSpots);
+      for (unsigned iS(0); iS<nSpots; ++iS){
+	const ShowerSpot & spot = lEntry.spots[iS];
+	x[iS] = spot.x;
+	y[iS] = spot.y;
+	z[iS] = spot.z;
+	t[iS] = spot.t;
+	e[iS] = spot.e;
+	dl[iS] = spot.dl;
+	pdgId[iS] = spot.pdgId;
+      }
+      tree->Fill();
+    }
+  }
+  tree->Write();
+  lFile->Close();
+  G4cout << " -- Shower library with " << nEntries_ << " entries written to " << fileName << G4endl;
+}
+
+void ShowerLibrary::print() const{
+  G4cout << " -------------------------- " << G4endl
+	 << " -- Shower library: E = [" << minE_/MeV << "," << maxE_/MeV << "[ MeV in "
+	 << nEnergyBins_ << " log bins, " << nAngleBins_ << " cos(theta) bins" << G4endl
+	 << " -- " << entries_.size() << " filled bins, " << nEntries_ << " showers." << G4endl
+	 << " -------------------------- " << G4endl;
+}
@@ -0,0 +1,154 @@
+#include "ShowerLibraryBuilder.hh"
+#include "FrozenShowerModel.hh"
+
+#include "G4Step.hh"
+#include "G4Track.hh"
+#include "G4Material.hh"
+#include "G4Region.hh"
+#include "G4RegionStore.hh"
+#include "G4LogicalVolume.hh"
+#include "G4RunManager.hh"
+#include "G4Event.hh"
+#include "G4SystemOfUnits.hh"
+
+#include <cmath>
+
+ShowerLibraryBuilder::ShowerLibraryBuilder(const std::string & outFile)
+{
+  outFile_ = outFile;
+  library_ = 0;
+  region_ = 0;
+  minE_ = 1*MeV;
+  maxE_ = 100*MeV;
+  nEnergyBins_ = 10;
+  nAngleBins_ = 10;
+  maxEntries_ = 100;
+  spotSize_ = 0.1*mm;
+  eventId_ = -1;
+}
+
+ShowerLibraryBuilder::~ShowerLibraryBuilder()
+{
+  if (!library_) return;
+  flush();
+  library_->print();
+  library_->write(outFile_);
+  delete library_;
+}
+
+void ShowerLibraryBuilder::addStep(const G4Step* aStep, const G4double edep, const G4double stepl){
+
+  if (!library_) {
+    library_ = new ShowerLibrary(minE_,maxE_,nEnergyBins_,nAngleBins_);
+    region_ = G4RegionStore::GetInstance()->GetRegion("EEAbsorberReg",false);
+    if (!region_) G4cout << " -- WARNING! ShowerLibraryBuilder: no EEAbsorberReg region, library will stay empty." << G4endl;
+  }
+
+  const G4int eventId = G4RunManager::GetRunManager()->GetCurrentEvent()->GetEventID();
+  if (eventId != eventId_){
+    flush();
+    eventId_ = eventId;
+  }
+
+  const G4Track* lTrack = aStep->GetTrack();
+  const G4int trackID = lTrack->GetTrackID();
+  const G4int pdgId = lTrack->GetDefinition()->GetPDGEncoding();
+  const G4StepPoint *thePreStepPoint = aStep->GetPreStepPoint();
+
+  std::map<G4int,unsigned>::iterator lIter = trackToShower_.find(trackID);
+  if (lIter == trackToShower_.end() && lTrack->GetCurrentStepNumber()==1){
+    //secondaries created after the shower started belong to it
+    std::map<G4int,unsigned>::iterator lParent = trackToShower_.find(lTrack->GetParentID());
+    if (lParent != trackToShower_.end() &&
+	lTrack->GetGlobalTime()-lTrack->GetLocalTime() >= showers_[lParent->second].t0){
+      lIter = trackToShower_.insert(std::pair<G4int,unsigned>(trackID,lParent->second)).first;
+    }
+  }
+
+  if (lIter == trackToShower_.end()){
+    //same conditions as FrozenShowerModel::ModelTrigger
+    const int particle = ShowerLibrary::particleIndex(pdgId);
+    const G4double energy = thePreStepPoint->GetKineticEnergy();
+    if (particle<0 || !region_ || energy < minE_ || energy >= maxE_) return;
+    if (thePreStepPoint->GetPhysicalVolume()->GetLogicalVolume()->GetRegion() != region_) return;
+    const std::string absorber = thePreStepPoint->GetMaterial()->GetName();
+    const G4ThreeVector & dir = thePreStepPoint->GetMomentumDirection();
+    if (library_->isFull(particle,energy,absorber,dir.z(),maxEntries_)) return;
+
+    Shower lShower;
+    lShower.particle = particle;
+    lShower.absorber = absorber;
+    lShower.cosTheta = dir.z();
+    lShower.energy = energy;
+    lShower.t0 = thePreStepPoint->GetGlobalTime();
+    lShower.origin = thePreStepPoint->GetPosition();
+    lShower.dir = dir;
+    FrozenShowerModel::basis(dir,lShower.u,lShower.v);
+    showers_.push_back(lShower);
+    lIter = trackToShower_.insert(std::pair<G4int,unsigned>(trackID,showers_.size()-1)).first;
+  }
+
+  if (edep>0 || stepl>0)
+    addDeposit(showers_[lIter->second],thePreStepPoint->GetPosition(),
+	       lTrack->GetGlobalTime(),edep,stepl,pdgId);
+
+}
+
+void ShowerLibraryBuilder::addDeposit(Shower & shower, const G4ThreeVector & position,
+				      const G4double globalTime, const G4double edep,
+				      const G4double stepl, const G4int pdgId){
+  const G4ThreeVector rel = position-shower.origin;
+  const G4double x = rel.dot(shower.u);
+  const G4double y = rel.dot(shower.v);
+  const G4double z = rel.dot(shower.dir);
+  const long long offset = 1<<20;
+  const long long ix = static_cast<long long>(floor(x/spotSize_))+offset;
+  const long long iy = static_cast<long long>(floor(y/spotSize_))+offset;
+  const long long iz = static_cast<long long>(floor(z/spotSize_))+offset;
+  const long long key = (ix<<42) | (iy<<21) | iz;
+
+  std::map<long long,unsigned>::iterator lIter = shower.cells.find(key);
+  if (lIter == shower.cells.end()){
+    ShowerSpot spot;
+    spot.x = x;
+    spot.y = y;
+    spot.z = z;
+    spot.t = globalTime-shower.t0;
+    spot.e = edep;
+    spot.dl = stepl;
+    spot.pdgId = pdgId;
+    shower.cells[key] = shower.spots.size();
+    shower.spots.push_back(spot);
+    shower.sumPos.push_back(edep*G4ThreeVector(x,y,z));
+    return;
+  }
+  ShowerSpot & spot = shower.spots[lIter->second];
+  spot.e += edep;
+  spot.dl += stepl;
+  if (globalTime-shower.t0 < spot.t) spot.t = globalTime-shower.t0;
+  shower.sumPos[lIter->second] += edep*G4ThreeVector(x,y,z);
+}
+
+void ShowerLibraryBuilder::flush(){
+  for (unsigned iS(0); iS<showers_.size(); ++iS){
+    Shower & lShower = showers_[iS];
+    ShowerEntry lEntry;
+    lEntry.energy = lShower.energy;
+    lEntry.spots.reserve(lShower.spots.size());
+    for (unsigned iC(0); iC<lShower.spots.size(); ++iC){
+      ShowerSpot spot = lShower.spots[iC];
+      if (spot.e>0) {
+	const G4ThreeVector pos = lShower.sumPos[iC]/spot.e;
+	spot.x = pos.x();
+	spot.y = pos.y();
+	spot.z = pos.z();
+      }
+      spot.e /= lShower.energy;
+      spot.dl /= lShower.energy;
+      lEntry.spots.push_back(spot);
+    }
+    library_->add(lShower.particle,lShower.absorber,lShower.cosTheta,lEntry,maxEntries_);
+  }
+  showers_.clear();
+  trackToShower_.clear();
+}
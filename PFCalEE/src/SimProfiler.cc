@@ -0,0 +1,266 @@
+#include "SimProfiler.hh"
+
+#include "DetectorConstruction.hh"
+
+#include "G4RunManager.hh"
+#include "G4VPhysicalVolume.hh"
+#include "G4SystemOfUnits.hh"
+
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+
+SimProfiler::SimProfiler(const std::string & prefix)
+{
+  prefix_ = prefix;
+  detector_ = 0;
+  outF_ = 0;
+  tree_ = 0;
+  eventId_ = -1;
+  wallTime_ = 0;
+  cpuTime_ = 0;
+  trackingWallTime_ = 0;
+  aggregationWallTime_ = 0;
+  nSteps_ = 0;
+  nBoundarySteps_ = 0;
+  showerX_ = 0;
+  showerY_ = 0;
+  showerZ_ = 0;
+  eventE_ = 0;
+  eventEX_ = 0;
+  eventEY_ = 0;
+  eventEZ_ = 0;
+  speciesSteps_.resize(sp_N,0);
+  sumSpeciesSteps_.resize(sp_N,0);
+  cpuStart_ = 0;
+  nEvents_ = 0;
+  sumWallTime_ = 0;
+  sumCpuTime_ = 0;
+  sumTrackingTime_ = 0;
+  sumAggregationTime_ = 0;
+  runWallTime_ = 0;
+  sumSteps_ = 0;
+  sumBoundarySteps_ = 0;
+  nShowers_ = 0;
+  sumShowerX_ = 0;
+  sumShowerX2_ = 0;
+  sumShowerY_ = 0;
+  sumShowerY2_ = 0;
+  sumShowerZ_ = 0;
+  sumShowerZ2_ = 0;
+}
+
+SimProfiler::~SimProfiler()
+{
+  if (outF_) {
+    outF_->cd();
+    if (tree_) tree_->Write();
+    outF_->WriteObjectAny(&classNames_,"std::vector<std::string>","materialClasses");
+    outF_->Close();
+  }
+  print();
+  writeJSON();
+}
+
+void SimProfiler::beginRun(){
+  runStart_ = Clock::now();
+  if (tree_) return;
+
+  detector_ = ((DetectorConstruction*)G4RunManager::GetRunManager()->GetUserDetectorConstruction())->getStructure();
+  for (unsigned iL(0); iL<detector_->size(); ++iL){
+    const SamplingSection & lSec = (*detector_)[iL];
+    for (unsigned ie(0); ie<lSec.n_elements; ++ie){
+      bool found = false;
+      for (unsigned iC(0); iC<classNames_.size(); ++iC){
+	if (classNames_[iC]==lSec.ele_name[ie]) { found = true; break; }
+      }
+      if (!found) classNames_.push_back(lSec.ele_name[ie]);
+    }
+  }
+  classNames_.push_back("Other");
+  classSteps_.resize(classNames_.size(),0);
+  classE_.resize(classNames_.size(),0);
+  sumClassSteps_.resize(classNames_.size(),0);
+  sumClassE_.resize(classNames_.size(),0);
+
+  outF_ = TFile::Open((prefix_+".root").c_str(),"RECREATE");
+  if (!outF_) {
+    G4cout << " -- ERROR! SimProfiler cannot open " << prefix_ << ".root, exiting..." << G4endl;
+    exit(1);
+  }
+  outF_->cd();
+  tree_ = new TTree("SimProfileTree","PFCalEE per event CPU profile");
+  tree_->Branch("eventId",&eventId_);
+  tree_->Branch("wallTime",&wallTime_);
+  tree_->Branch("cpuTime",&cpuTime_);
+  tree_->Branch("trackingWallTime",&trackingWallTime_);
+  tree_->Branch("aggregationWallTime",&aggregationWallTime_);
+  tree_->Branch("nSteps",&nSteps_);
+  tree_->Branch("nBoundarySteps",&nBoundarySteps_);
+  tree_->Branch("classSteps",&classSteps_);
+  tree_->Branch("classE",&classE_);
+  tree_->Branch("speciesSteps",&speciesSteps_);
+  tree_->Branch("showerX",&showerX_);
+  tree_->Branch("showerY",&showerY_);
+  tree_->Branch("showerZ",&showerZ_);
+}
+
+void SimProfiler::endRun(const unsigned nEvents){
+  runWallTime_ += std::chrono::duration<double>(Clock::now()-runStart_).count();
+  G4cout << " -- SimProfiler: run of " << nEvents << " events done." << G4endl;
+}
+
+void SimProfiler::beginEvent(const G4int eventId){
+  eventId_ = eventId;
+  nSteps_ = 0;
+  nBoundarySteps_ = 0;
+  eventE_ = 0;
+  eventEX_ = 0;
+  eventEY_ = 0;
+  eventEZ_ = 0;
+  for (unsigned iC(0); iC<classSteps_.size(); ++iC){
+    classSteps_[iC] = 0;
+    classE_[iC] = 0;
+  }
+  for (unsigned iS(0); iS<speciesSteps_.size(); ++iS) speciesSteps_[iS] = 0;
+  cpuStart_ = std::clock();
+  eventStart_ = Clock::now();
+}
+
+void SimProfiler::beginAggregation(){
+  aggregationStart_ = Clock::now();
+}
+
+void SimProfiler::endEvent(){
+  const Clock::time_point lEnd = Clock::now();
+  wallTime_ = std::chrono::duration<double>(lEnd-eventStart_).count();
+  trackingWallTime_ = std::chrono::duration<double>(aggregationStart_-eventStart_).count();
+  aggregationWallTime_ = std::chrono::duration<double>(lEnd-aggregationStart_).count();
+  cpuTime_ = static_cast<double>(std::clock()-cpuStart_)/CLOCKS_PER_SEC;
+
+  nEvents_++;
+  sumWallTime_ += wallTime_;
+  sumCpuTime_ += cpuTime_;
+  sumTrackingTime_ += trackingWallTime_;
+  sumAggregationTime_ += aggregationWallTime_;
+  sumSteps_ += nSteps_;
+  sumBoundarySteps_ += nBoundarySteps_;
+  for (unsigned iC(0); iC<classSteps_.size(); ++iC){
+    sumClassSteps_[iC] += classSteps_[iC];
+    sumClassE_[iC] += classE_[iC];
+  }
+  for (unsigned iS(0); iS<speciesSteps_.size(); ++iS) sumSpeciesSteps_[iS] += speciesSteps_[iS];
+
+  showerX_ = showerY_ = showerZ_ = 0;
+  if (eventE_>0) {
+    showerX_ = eventEX_/eventE_;
+    showerY_ = eventEY_/eventE_;
+    showerZ_ = eventEZ_/eventE_;
+    nShowers_++;
+    sumShowerX_ += showerX_;
+    sumShowerX2_ += showerX_*showerX_;
+    sumShowerY_ += showerY_;
+    sumShowerY2_ += showerY_*showerY_;
+    sumShowerZ_ += showerZ_;
+    sumShowerZ2_ += showerZ_*showerZ_;
+  }
+
+  if (tree_) tree_->Fill();
+}
+
+unsigned SimProfiler::classify(const G4VPhysicalVolume *volume){
+  unsigned iClass = classNames_.size()-1;
+  if (volume && detector_){
+    const std::string lstr = volume->GetName();
+    for (unsigned iL(0); iL<detector_->size() && iClass==classNames_.size()-1; ++iL){
+      const SamplingSection & lSec = (*detector_)[iL];
+      for (unsigned ie(0); ie<lSec.ele_vol.size(); ++ie){
+	if (lSec.ele_vol[ie] && lSec.ele_vol[ie]->GetName()==lstr){
+	  const std::string & eleName = lSec.ele_name[ie%lSec.n_elements];
+	  for (unsigned iC(0); iC<classNames_.size(); ++iC){
+	    if (classNames_[iC]==eleName) { iClass = iC; break; }
+	  }
+	  break;
+	}
+      }
+    }
+  }
+  volClass_[volume] = iClass;
+  return iClass;
+}
+
+SimProfiler::Species SimProfiler::species(const G4int pdgId){
+  const G4int absId = abs(pdgId);
+  if (absId==11) return sp_Electron;
+  if (absId==22) return sp_Photon;
+  if (absId==13) return sp_Muon;
+  if (absId==211) return sp_ChargedPion;
+  if (absId==2212) return sp_Proton;
+  if (absId==2112) return sp_Neutron;
+  if (absId>1000000000) return sp_Ion;
+  return sp_Other;
+}
+
+const char* SimProfiler::speciesName(const unsigned sp){
+  static const char* names[sp_N] = {"e","gamma","mu","pi","p","n","ion","other"};
+  return sp<sp_N ? names[sp] : "";
+}
+
+void SimProfiler::print() const{
+  if (nEvents_==0) return;
+  G4cout << " ============== SimProfiler summary ==============" << G4endl
+	 << " -- " << nEvents_ << " events, " << runWallTime_ << " s in runs" << G4endl
+	 << " -- per event: wall " << sumWallTime_/nEvents_ << " s, CPU " << sumCpuTime_/nEvents_
+	 << " s, tracking " << sumTrackingTime_/nEvents_ << " s, EndOfEventAction "
+	 << sumAggregationTime_/nEvents_ << " s, " << sumSteps_/nEvents_ << " steps, "
+	 << sumBoundarySteps_/nEvents_ << " at volume boundaries" << G4endl
+	 << " -- " << std::setw(12) << "material" << std::setw(12) << "steps(%)" << std::setw(14) << "<E>/evt(MeV)" << G4endl;
+  for (unsigned iC(0); iC<classNames_.size(); ++iC){
+    G4cout << " -- " << std::setw(12) << classNames_[iC]
+	   << std::setw(12) << std::setprecision(3) << (sumSteps_>0 ? 100.*sumClassSteps_[iC]/sumSteps_ : 0)
+	   << std::setw(14) << sumClassE_[iC]/MeV/nEvents_ << G4endl;
+  }
+  G4cout << " -- " << std::setw(12) << "species" << std::setw(12) << "steps(%)" << G4endl;
+  for (unsigned iS(0); iS<sp_N; ++iS){
+    G4cout << " -- " << std::setw(12) << speciesName(iS)
+	   << std::setw(12) << std::setprecision(3) << (sumSteps_>0 ? 100.*sumSpeciesSteps_[iS]/sumSteps_ : 0) << G4endl;
+  }
+  G4cout << " =================================================" << G4endl;
+}
+
+void SimProfiler::writeJSON() const{
+  std::ofstream lOut((prefix_+".json").c_str());
+  if (!lOut.is_open()) {
+    G4cout << " -- ERROR! SimProfiler cannot write " << prefix_ << ".json" << G4endl;
+    return;
+  }
+  lOut << std::setprecision(10);
+  lOut << "{" << std::endl
+       << "  \"nEvents\": " << nEvents_ << "," << std::endl
+       << "  \"runWallTime\": " << runWallTime_ << "," << std::endl
+       << "  \"wallTime\": " << sumWallTime_ << "," << std::endl
+       << "  \"cpuTime\": " << sumCpuTime_ << "," << std::endl
+       << "  \"trackingWallTime\": " << sumTrackingTime_ << "," << std::endl
+       << "  \"aggregationWallTime\": " << sumAggregationTime_ << "," << std::endl
+       << "  \"nSteps\": " << sumSteps_ << "," << std::endl
+       << "  \"nBoundarySteps\": " << sumBoundarySteps_ << "," << std::endl
+       << "  \"materials\": {";
+  for (unsigned iC(0); iC<classNames_.size(); ++iC){
+    lOut << (iC>0?",":"") << std::endl
+	 << "    \"" << classNames_[iC] << "\": {\"steps\": " << sumClassSteps_[iC]
+	 << ", \"energyMeV\": " << sumClassE_[iC]/MeV << "}";
+  }
+  lOut << std::endl << "  }," << std::endl
+       << "  \"species\": {";
+  for (unsigned iS(0); iS<sp_N; ++iS){
+    lOut << (iS>0?",":"") << std::endl
+	 << "    \"" << speciesName(iS) << "\": " << sumSpeciesSteps_[iS];
+  }
+  lOut << std::endl << "  }," << std::endl
+       << "  \"shower\": {\"n\": " << nShowers_
+       << ", \"sumX\": " << sumShowerX_ << ", \"sumX2\": " << sumShowerX2_
+       << ", \"sumY\": " << sumShowerY_ << ", \"sumY2\": " << sumShowerY2_
+       << ", \"sumZ\": " << sumShowerZ_ << ", \"sumZ2\": " << sumShowerZ2_ << "}" << std::endl
+       << "}" << std::endl;
+  lOut.close();
+}
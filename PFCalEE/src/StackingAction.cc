@@ -0,0 +1,95 @@
+#include "StackingAction.hh"
+#include "StackingActionMessenger.hh"
+
+#include "G4Track.hh"
+#include "G4SystemOfUnits.hh"
+#include "Randomize.hh"
+
+#include "HGCSSInfo.hh"
+
+StackingAction::StackingAction()
+{
+  messenger_ = new StackingActionMessenger(this);
+  lateTimeCut_ = 0;
+  postponeLate_ = false;
+  thermalNeutronCut_ = 0;
+  rouletteEnergy_ = 0;
+  rouletteProbability_ = 1;
+  nKilledLate_ = 0;
+  nPostponedLate_ = 0;
+  nKilledThermal_ = 0;
+  nKilledRoulette_ = 0;
+  nSurvivedRoulette_ = 0;
+}
+
+StackingAction::~StackingAction()
+{
+  delete messenger_;
+}
+
+G4ClassificationOfNewTrack StackingAction::ClassifyNewTrack(const G4Track* aTrack)
+{
+  if (aTrack->GetParentID()==0) return fUrgent;
+
+  if (lateTimeCut_>0 && aTrack->GetGlobalTime() > lateTimeCut_){
+    if (postponeLate_) {
+      nPostponedLate_++;
+      return fWaiting;
+    }
+    nKilledLate_++;
+    return fKill;
+  }
+
+  if (aTrack->GetDefinition()->GetPDGEncoding()==2112){
+    const G4double energy = aTrack->GetKineticEnergy();
+    if (energy < thermalNeutronCut_){
+      nKilledThermal_++;
+      return fKill;
+    }
+    if (energy < rouletteEnergy_ && rouletteProbability_<1){
+      if (G4UniformRand() >= rouletteProbability_){
+	nKilledRoulette_++;
+	return fKill;
+      }
+      nSurvivedRoulette_++;
+      const_cast<G4Track*>(aTrack)->SetWeight(aTrack->GetWeight()/rouletteProbability_);
+    }
+  }
+
+  return fUrgent;
+}
+
+void StackingAction::fillInfo(HGCSSInfo & info) const
+{
+  info.lateTimeCut(lateTimeCut_/ns);
+  info.thermalNeutronCut(thermalNeutronCut_/MeV);
+  info.rouletteEnergy(rouletteEnergy_/MeV);
+  info.rouletteProbability(rouletteProbability_);
+  info.nKilledLate(nKilledLate_);
+  info.nPostponedLate(nPostponedLate_);
+  info.nKilledThermal(nKilledThermal_);
+  info.nKilledRoulette(nKilledRoulette_);
+  info.nSurvivedRoulette(nSurvivedRoulette_);
+}
+
+void StackingAction::restoreCounters(const HGCSSInfo & info)
+{
+  nKilledLate_ = info.nKilledLate();
+  nPostponedLate_ = info.nPostponedLate();
+  nKilledThermal_ = info.nKilledThermal();
+  nKilledRoulette_ = info.nKilledRoulette();
+  nSurvivedRoulette_ = info.nSurvivedRoulette();
+}
+
+void StackingAction::print() const
+{
+  G4cout << " -- StackingAction: lateTimeCut=" << lateTimeCut_/ns << " ns ("
+	 << (postponeLate_?"postpone":"kill") << ")"
+	 << " thermalNeutronCut=" << thermalNeutronCut_/MeV << " MeV"
+	 << " roulette E<" << rouletteEnergy_/MeV << " MeV p=" << rouletteProbability_ << G4endl
+	 << "    killed late=" << nKilledLate_
+	 << " postponed late=" << nPostponedLate_
+	 << " killed thermal n=" << nKilledThermal_
+	 << " roulette killed=" << nKilledRoulette_
+	 << " survived=" << nSurvivedRoulette_ << G4endl;
+}
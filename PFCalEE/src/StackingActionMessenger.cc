@@ -0,0 +1,71 @@
+#include "StackingActionMessenger.hh"
+
+#include "StackingAction.hh"
+#include "G4UIdirectory.hh"
+#include "G4UIcmdWithABool.hh"
+#include "G4UIcmdWithADouble.hh"
+#include "G4UIcmdWithADoubleAndUnit.hh"
+
+StackingActionMessenger::StackingActionMessenger(StackingAction* action)
+:stackingAction(action)
+{
+  stackDir = new G4UIdirectory("/N03/stack/");
+  stackDir->SetGuidance("secondary track killing");
+
+  LateTimeCutCmd = new G4UIcmdWithADoubleAndUnit("/N03/stack/lateTimeCut",this);
+  LateTimeCutCmd->SetGuidance("Secondaries created after this global time are killed or postponed. 0 to disable.");
+  LateTimeCutCmd->SetParameterName("time",false);
+  LateTimeCutCmd->SetUnitCategory("Time");
+  LateTimeCutCmd->SetRange("time>=0.");
+  LateTimeCutCmd->AvailableForStates(G4State_PreInit,G4State_Idle);
+
+  PostponeLateCmd = new G4UIcmdWithABool("/N03/stack/postponeLate",this);
+  PostponeLateCmd->SetGuidance("Postpone late secondaries to a waiting stage instead of killing them.");
+  PostponeLateCmd->SetParameterName("postpone",true);
+  PostponeLateCmd->SetDefaultValue(true);
+  PostponeLateCmd->AvailableForStates(G4State_PreInit,G4State_Idle);
+
+  ThermalNeutronCutCmd = new G4UIcmdWithADoubleAndUnit("/N03/stack/thermalNeutronCut",this);
+  ThermalNeutronCutCmd->SetGuidance("Neutrons created below this kinetic energy are killed. 0 to disable.");
+  ThermalNeutronCutCmd->SetParameterName("energy",false);
+  ThermalNeutronCutCmd->SetUnitCategory("Energy");
+  ThermalNeutronCutCmd->SetRange("energy>=0.");
+  ThermalNeutronCutCmd->AvailableForStates(G4State_PreInit,G4State_Idle);
+
+  RouletteEnergyCmd = new G4UIcmdWithADoubleAndUnit("/N03/stack/rouletteEnergy",this);
+  RouletteEnergyCmd->SetGuidance("Russian roulette for neutrons created below this kinetic energy. 0 to disable.");
+  RouletteEnergyCmd->SetParameterName("energy",false);
+  RouletteEnergyCmd->SetUnitCategory("Energy");
+  RouletteEnergyCmd->SetRange("energy>=0.");
+  RouletteEnergyCmd->AvailableForStates(G4State_PreInit,G4State_Idle);
+
+  RouletteProbabilityCmd = new G4UIcmdWithADouble("/N03/stack/rouletteProbability",this);
+  RouletteProbabilityCmd->SetGuidance("Survival probability of the Russian roulette, survivors are weighted by its inverse.");
+  RouletteProbabilityCmd->SetParameterName("prob",false);
+  RouletteProbabilityCmd->SetRange("prob>0. && prob<=1.");
+  RouletteProbabilityCmd->AvailableForStates(G4State_PreInit,G4State_Idle);
+}
+
+StackingActionMessenger::~StackingActionMessenger()
+{
+  delete LateTimeCutCmd;
+  delete PostponeLateCmd;
+  delete ThermalNeutronCutCmd;
+  delete RouletteEnergyCmd;
+  delete RouletteProbabilityCmd;
+  delete stackDir;
+}
+
+void StackingActionMessenger::SetNewValue(G4UIcommand* command, G4String newValue)
+{
+  if (command == LateTimeCutCmd)
+    stackingAction->setLateTimeCut(LateTimeCutCmd->GetNewDoubleValue(newValue));
+  else if (command == PostponeLateCmd)
+    stackingAction->setPostponeLate(PostponeLateCmd->GetNewBoolValue(newValue));
+  else if (command == ThermalNeutronCutCmd)
+    stackingAction->setThermalNeutronCut(ThermalNeutronCutCmd->GetNewDoubleValue(newValue));
+  else if (command == RouletteEnergyCmd)
+    stackingAction->setRouletteEnergy(RouletteEnergyCmd->GetNewDoubleValue(newValue));
+  else if (command == RouletteProbabilityCmd)
+    stackingAction->setRouletteProbability(RouletteProbabilityCmd->GetNewDoubleValue(newValue));
+}
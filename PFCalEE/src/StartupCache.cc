@@ -0,0 +1,302 @@
+#include "StartupCache.hh"
+
+#include "DetectorConstruction.hh"
+
+#include "G4Material.hh"
+#include "G4VUserPhysicsList.hh"
+#include "G4VPhysicalVolume.hh"
+#include "G4LogicalVolume.hh"
+#include "G4PhysicalVolumeStore.hh"
+#include "G4TransportationManager.hh"
+#include "G4Navigator.hh"
+#include "G4Version.hh"
+#ifdef G4LIB_USE_GDML
+#include "G4GDMLParser.hh"
+#endif
+
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <map>
+#include <sstream>
+#include <ftw.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+  //stable across compilers, unlike std::hash
+  std::string hashKey(const std::string & key){
+    unsigned long long h = 14695981039346656037ULL;
+    for (unsigned i(0); i<key.size(); ++i){
+      h ^= static_cast<unsigned char>(key[i]);
+      h *= 1099511628211ULL;
+    }
+    std::ostringstream lOut;
+    lOut << std::hex << std::setw(16) << std::setfill('0') << h;
+    return lOut.str();
+  }
+
+  bool makeDir(const std::string & path){
+    if (mkdir(path.c_str(),0755)==0 || errno==EEXIST) return true;
+    G4cout << " -- ERROR! StartupCache cannot create " << path << G4endl;
+    return false;
+  }
+
+  int removeEntry(const char *path, const struct stat *, int, struct FTW *){
+    return std::remove(path);
+  }
+
+  //only for directories written by this job
+  void removeTree(const std::string & path){
+    nftw(path.c_str(),removeEntry,16,FTW_DEPTH|FTW_PHYS);
+  }
+
+  //unique among jobs sharing the cache directory
+  std::string jobSuffix(){
+    char lHost[256] = "";
+    gethostname(lHost,sizeof(lHost)-1);
+    std::ostringstream lOut;
+    lOut << lHost << "." << getpid();
+    return lOut.str();
+  }
+
+  bool sameValue(const G4double a, const G4double b){
+    return fabs(a-b) <= 1e-9*std::max(1.,fabs(a));
+  }
+
+  const char* manifestHeader = "PFCalEE-startup-cache-v2";
+}
+
+StartupCache::StartupCache(const std::string & baseDir,
+			   const std::string & key,
+			   G4VUserPhysicsList *physics)
+{
+  std::ostringstream lKey;
+  lKey << key << " geant4=" << G4VERSION_NUMBER;
+  key_ = lKey.str();
+  dir_ = baseDir+"/"+hashKey(key_);
+  physics_ = physics;
+  detector_ = 0;
+  warm_ = false;
+  hasGeometry_ = false;
+  stored_ = false;
+}
+
+void StartupCache::invalidate(){
+  warm_ = false;
+  hasGeometry_ = false;
+  physics_->ResetPhysicsTableRetrieved();
+}
+
+std::string StartupCache::gdmlFile() const{
+  return dir_+"/geometry.gdml";
+}
+
+std::string StartupCache::physicsDir() const{
+  return dir_+"/physics";
+}
+
+bool StartupCache::check(DetectorConstruction & detector, const bool refresh){
+  detector_ = &detector;
+  warm_ = !refresh && readManifest(dir_);
+  if (warm_) G4cout << " -- StartupCache: warm start from " << dir_
+		    << (hasGeometry_ ? " (geometry and physics tables)" : " (physics tables)") << G4endl;
+  else G4cout << " -- StartupCache: no valid cache in " << dir_ << ", it will be written at the start of the run." << G4endl;
+  return warm_;
+}
+
+bool StartupCache::readManifest(const std::string & aDir){
+  const std::vector<SamplingSection> & structure = *detector_->getStructure();
+  layers_.clear();
+  hasGeometry_ = false;
+  std::ifstream lIn((aDir+"/manifest.txt").c_str());
+  if (!lIn.is_open()) return false;
+
+  std::string lHeader, lKeyTag, lKey;
+  lIn >> lHeader >> lKeyTag;
+  std::getline(lIn,lKey);
+  if (lHeader!=manifestHeader || lKeyTag!="key" || lKey.size()<1 || lKey.substr(1)!=key_) {
+    G4cout << " -- StartupCache: key mismatch in " << aDir << ", cache is stale." << G4endl;
+    return false;
+  }
+
+  std::string lTag;
+  unsigned gdml(0), nLayers(0);
+  lIn >> lTag >> gdml >> lTag >> nLayers;
+  if (!lIn.good() || nLayers!=structure.size()) {
+    G4cout << " -- StartupCache: layer structure changed, cache is stale." << G4endl;
+    return false;
+  }
+
+  layers_.resize(nLayers);
+  for (unsigned iL(0); iL<nLayers; ++iL){
+    LayerInfo & lInfo = layers_[iL];
+    const SamplingSection & lSec = structure[iL];
+    unsigned nEle(0), nVol(0);
+    lIn >> lTag >> nEle >> nVol >> lInfo.sensitiveZ >> lInfo.supportConeName >> lInfo.dummyLayerName;
+    if (!lIn.good() || lTag!="layer" || nEle!=lSec.n_elements || nVol!=lSec.ele_vol.size()) {
+      G4cout << " -- StartupCache: layer " << iL << " changed, cache is stale." << G4endl;
+      layers_.clear();
+      return false;
+    }
+    lInfo.eleName.resize(nEle);
+    lInfo.eleThick.resize(nEle);
+    lInfo.eleX0.resize(nEle);
+    lInfo.eleL0.resize(nEle);
+    lInfo.eledEdx.resize(nEle);
+    for (unsigned ie(0); ie<nEle; ++ie){
+      lIn >> lInfo.eleName[ie] >> lInfo.eleThick[ie] >> lInfo.eleX0[ie] >> lInfo.eleL0[ie] >> lInfo.eledEdx[ie];
+      if (lInfo.eleName[ie]!=lSec.ele_name[ie] || !sameValue(lInfo.eleThick[ie],lSec.ele_thick[ie])) {
+	G4cout << " -- StartupCache: element " << ie << " of layer " << iL << " changed, cache is stale." << G4endl;
+	layers_.clear();
+	return false;
+      }
+      //as filled in Construct, from the materials of this build
+      std::map<std::string,G4Material*>::const_iterator lMat = detector_->m_materials.find(lSec.ele_name[ie]);
+      std::map<std::string,G4double>::const_iterator ldEdx = detector_->m_dEdx.find(lSec.ele_name[ie]);
+      if (lMat==detector_->m_materials.end() || !lMat->second ||
+	  !sameValue(lInfo.eleX0[ie],lMat->second->GetRadlen()) ||
+	  !sameValue(lInfo.eleL0[ie],lMat->second->GetNuclearInterLength()) ||
+	  !sameValue(lInfo.eledEdx[ie],ldEdx!=detector_->m_dEdx.end() ? ldEdx->second : 0)) {
+	G4cout << " -- StartupCache: material " << lSec.ele_name[ie] << " of layer " << iL << " changed, cache is stale." << G4endl;
+	layers_.clear();
+	return false;
+      }
+    }
+    lInfo.volName.resize(nVol);
+    lInfo.volIndex.resize(nVol,0);
+    for (unsigned iV(0); iV<nVol; ++iV) lIn >> lInfo.volName[iV] >> lInfo.volIndex[iV];
+  }
+  lIn >> lTag;
+  if (lTag!="complete") {
+    G4cout << " -- StartupCache: incomplete manifest in " << aDir << ", cache is stale." << G4endl;
+    layers_.clear();
+    return false;
+  }
+
+#ifdef G4LIB_USE_GDML
+  std::ifstream lGdml((aDir+"/geometry.gdml").c_str());
+  hasGeometry_ = gdml==1 && lGdml.is_open();
+#endif
+  return true;
+}
+
+bool StartupCache::writeManifest(const std::string & aDir,
+				 const std::vector<SamplingSection> & structure,
+				 const bool withGeometry) const{
+  const std::string lFile = aDir+"/manifest.txt";
+  std::ofstream lOut(lFile.c_str());
+  if (!lOut.is_open()) {
+    G4cout << " -- ERROR! StartupCache cannot write " << lFile << G4endl;
+    return false;
+  }
+  lOut << std::setprecision(17);
+  lOut << manifestHeader << " key " << key_ << std::endl
+       << "gdml " << (withGeometry?1:0) << std::endl
+       << "layers " << structure.size() << std::endl;
+  for (unsigned iL(0); iL<structure.size(); ++iL){
+    const SamplingSection & lSec = structure[iL];
+    lOut << "layer " << lSec.n_elements << " " << lSec.ele_vol.size() << " " << lSec.sensitiveZ << " "
+	 << (lSec.supportcone_vol ? lSec.supportcone_vol->GetName() : G4String("-")) << " "
+	 << (iL==0 && lSec.dummylayer_vol ? lSec.dummylayer_vol->GetName() : G4String("-")) << std::endl;
+    for (unsigned ie(0); ie<lSec.n_elements; ++ie){
+      lOut << lSec.ele_name[ie] << " " << lSec.ele_thick[ie] << " " << lSec.ele_X0[ie] << " "
+	   << lSec.ele_L0[ie] << " " << lSec.ele_dEdx[ie] << std::endl;
+    }
+    for (unsigned iV(0); iV<lSec.ele_vol.size(); ++iV){
+      if (lSec.ele_vol[iV]) lOut << lSec.ele_vol[iV]->GetName() << " " << nameIndex(lSec.ele_vol[iV]) << " ";
+      else lOut << "- 0 ";
+    }
+    lOut << std::endl;
+  }
+  lOut << "complete" << std::endl;
+  lOut.close();
+  return lOut.good();
+}
+
+unsigned StartupCache::nameIndex(const G4VPhysicalVolume *aVol){
+  const G4LogicalVolume *lMother = aVol->GetMotherLogical();
+  if (!lMother) return 0;
+  unsigned lIndex = 0;
+  for (size_t iD(0); iD<lMother->GetNoDaughters(); ++iD){
+    const G4VPhysicalVolume *lDaughter = lMother->GetDaughter(iD);
+    if (lDaughter==aVol) break;
+    if (lDaughter->GetName()==aVol->GetName()) lIndex++;
+  }
+  return lIndex;
+}
+
+G4VPhysicalVolume *StartupCache::findVolume(const std::string & aName, const unsigned aIndex){
+  //names differ between layers: all with aName share the mother of the first
+  G4VPhysicalVolume *lFirst = G4PhysicalVolumeStore::GetInstance()->GetVolume(aName,false);
+  if (!lFirst || aIndex==0) return lFirst;
+  const G4LogicalVolume *lMother = lFirst->GetMotherLogical();
+  if (!lMother) return 0;
+  unsigned lIndex = 0;
+  for (size_t iD(0); iD<lMother->GetNoDaughters(); ++iD){
+    G4VPhysicalVolume *lDaughter = lMother->GetDaughter(iD);
+    if (lDaughter->GetName()!=aName) continue;
+    if (lIndex==aIndex) return lDaughter;
+    lIndex++;
+  }
+  return 0;
+}
+
+bool StartupCache::publish(const std::string & aTmp){
+  if (std::rename(aTmp.c_str(),dir_.c_str())==0) return true;
+
+  //dir_ exists: written by another job meanwhile, or stale
+  if (readManifest(dir_)) {
+    G4cout << " -- StartupCache: " << dir_ << " written by another job meanwhile, it is kept." << G4endl;
+    layers_.clear();
+    hasGeometry_ = false;
+    removeTree(aTmp);
+    return false;
+  }
+  //jobs may still read the stale cache: moved aside, not deleted
+  const std::string lStale = dir_+".stale."+jobSuffix();
+  if (std::rename(dir_.c_str(),lStale.c_str())==0)
+    G4cout << " -- StartupCache: stale cache moved to " << lStale << ", to be removed once no job uses it." << G4endl;
+  if (std::rename(aTmp.c_str(),dir_.c_str())==0) return true;
+  G4cout << " -- ERROR! StartupCache cannot rename " << aTmp << " to " << dir_ << G4endl;
+  removeTree(aTmp);
+  return false;
+}
+
+void StartupCache::store(){
+  if (warm_ || stored_ || !detector_) return;
+  stored_ = true;
+
+  //private directory, renamed into place once complete
+  const std::string lBase = dir_.substr(0,dir_.rfind('/'));
+  const std::string lTmp = dir_+".tmp."+jobSuffix();
+  if (!makeDir(lBase)) return;
+  //leftover of an interrupted job with the same host and pid
+  removeTree(lTmp);
+  if (!makeDir(lTmp) || !makeDir(lTmp+"/physics")) return;
+
+  if (!physics_->StorePhysicsTable(lTmp+"/physics")) {
+    G4cout << " -- ERROR! StartupCache: physics tables could not be stored in " << lTmp << "/physics" << G4endl;
+    removeTree(lTmp);
+    return;
+  }
+
+  bool withGeometry = false;
+#ifdef G4LIB_USE_GDML
+  const G4VPhysicalVolume *lWorld = G4TransportationManager::GetTransportationManager()->GetNavigatorForTracking()->GetWorldVolume();
+  G4GDMLParser lParser;
+  //unique names with pointer suffix, stripped back when read
+  lParser.Write(lTmp+"/geometry.gdml",lWorld);
+  withGeometry = true;
+#endif
+
+  if (!writeManifest(lTmp,*detector_->getStructure(),withGeometry)) {
+    removeTree(lTmp);
+    return;
+  }
+  if (publish(lTmp))
+    G4cout << " -- StartupCache: written to " << dir_ << G4endl;
+}
@@ -2,6 +2,9 @@
 
 #include "DetectorConstruction.hh"
 #include "EventAction.hh"
+#include "ShowerLibraryBuilder.hh"
+#include "SimProfiler.hh"
+#include "RegionOfInterest.hh"
 
 #include "G4Step.hh"
 #include "G4RunManager.hh"
@@ -15,6 +18,9 @@ SteppingAction::SteppingAction()
   eventAction_->Add(  ((DetectorConstruction*)G4RunManager::GetRunManager()->GetUserDetectorConstruction())->getStructure() );
   saturationEngine = new G4EmSaturation(0);
   timeLimit_ = 100;//ns
+  showerBuilder_ = 0;
+  profiler_ = 0;
+  roi_ = 0;
 }
 
 //
@@ -59,6 +65,13 @@ void SteppingAction::UserSteppingAction(const G4Step* aStep)
   G4double stepl = 0.;
   if (lTrack->GetDefinition()->GetPDGCharge() != 0.) stepl = aStep->GetStepLength();
 
+  //tracks surviving the stacking action Russian roulette carry a weight
+  const G4double weight = lTrack->GetWeight();
+  if (weight != 1.) {
+    edep *= weight;
+    stepl *= weight;
+  }
+
   //const G4ThreeVector &pos=aStep->GetPreStepPoint()->GetPosition();
 
   //Int_t iz=Int_t(pos.z()/eventAction_->GetCellSize())+4;
@@ -176,5 +189,9 @@ void SteppingAction::UserSteppingAction(const G4Step* aStep)
 
   //if (globalTime < 10) //timeLimit_) 
   eventAction_->Detect(edep,stepl,globalTime,pdgId,volume,position,trackID,parentID,genPart);
+  if (showerBuilder_) showerBuilder_->addStep(aStep,edep,stepl);
+  if (profiler_) profiler_->step(volume,pdgId,edep,thePostStepPoint->GetStepStatus()==fGeomBoundary,position);
+  //the deposit of this step is kept
+  if (roi_) roi_->check(aStep->GetTrack(),thePostStepPoint->GetPosition());
   //eventAction_->Detect(edep,stepl,globalTime,pdgId,volume,iyiz);
 }
@@ -0,0 +1,571 @@
+#include<string>
+#include<vector>
+#include<chrono>
+#include<algorithm>
+#include<iostream>
+#include<fstream>
+#include<sstream>
+#include<iomanip>
+#include<cmath>
+#include<cstdlib>
+#include<unistd.h>
+
+#include "TFile.h"
+#include "TH2Poly.h"
+#include "TRandom3.h"
+#include "TMath.h"
+
+#include "G4SiHit.hh"
+#include "HGCSSSimHit.hh"
+#include "HGCSSRecoHit.hh"
+#include "HGCSSCluster.hh"
+#include "HGCSSCalibration.hh"
+#include "HGCSSDigitisation.hh"
+#include "HGCSSDetector.hh"
+#include "HGCSSDetectorDescription.hh"
+#include "HGCSSGeometryConversion.hh"
+#include "HGCSSPUenergy.hh"
+
+#include "Clusterizer.hh"
+#include "PositionFit.hh"
+
+//Micro-benchmarks of the userlib hot paths on synthetic showers.
+//Same seed -> same inputs, so numbers can be compared between the
+//tags listed in VERSIONS. Results are written as JSON, one record
+//per benchmark, shape, detector version and particle type.
+//Usage: benchUserlib <output.json> [tag] [nEvents] [versions, e.g. 30,63] [shapes, e.g. 1,2,3,4] [seed]
+
+static const unsigned BENCH_SCHEMA = 1;
+
+//results of the timed loops end up here so they are not optimised away
+volatile double benchSink = 0;
+
+typedef std::chrono::steady_clock BenchClock;
+
+struct BenchResult {
+  std::string name;
+  std::string particle;
+  unsigned version;
+  unsigned shape;
+  unsigned long long nOps;
+  double nsPerOp;
+  double nsPerOpMin;
+};
+
+struct BenchConfig {
+  unsigned nEvents;
+  unsigned nRepeat;
+  double calorSizeXY;
+  unsigned model;
+  unsigned seed;
+};
+
+//shower shape parameters: electron-like (narrow, EE only) or pion-like
+//(wide, late start, through the whole detector), hits per event in
+//the Si/scint layers before cell merging
+struct ParticleModel {
+  std::string name;
+  unsigned nHits;
+  double molR;
+  double tailR;
+  double tailFrac;
+  double showerMax;
+  double showerWidth;
+};
+
+//time f(), nRepeat times; f returns the number of operations done
+template <class F>
+void timeIt(F f, const unsigned nRepeat, BenchResult & res){
+  double sum = 0;
+  double best = -1;
+  unsigned long long nOps = 0;
+  for (unsigned iR(0); iR<nRepeat; ++iR){
+    const BenchClock::time_point lStart = BenchClock::now();
+    const unsigned long long n = f();
+    const double ns = std::chrono::duration<double,std::nano>(BenchClock::now()-lStart).count();
+    const double perOp = n>0 ? ns/n : 0;
+    sum += perOp;
+    if (best<0 || perOp<best) best = perOp;
+    nOps = n;
+  }
+  res.nOps = nOps;
+  res.nsPerOp = nRepeat>0 ? sum/nRepeat : 0;
+  res.nsPerOpMin = best<0 ? 0 : best;
+}
+
+void extractList(const std::string & aStr, std::vector<unsigned> & vec){
+  if (aStr.empty()) return;
+  vec.clear();
+  std::stringstream lStr(aStr);
+  std::string lItem;
+  while (std::getline(lStr,lItem,',')) {
+    if (!lItem.empty()) vec.push_back(atoi(lItem.c_str()));
+  }
+}
+
+TH2Poly *cellMap(HGCSSGeometryConversion & geomConv, const HGCSSSubDetector & subdet, const unsigned shape){
+  if (subdet.isScint) return subdet.type==DetectorEnum::BHCAL1 ? geomConv.squareMap1() : geomConv.squareMap2();
+  if (shape==4) return geomConv.squareMap();
+  if (shape==2) return geomConv.diamondMap();
+  if (shape==3) return geomConv.triangleMap();
+  return geomConv.hexagonMap();
+}
+
+//synthetic G4 hits for nEvents showers, reproducible from the seed
+void generateHits(const HGCSSDetectorDescription & det,
+		  const ParticleModel & particle,
+		  const BenchConfig & cfg,
+		  const unsigned seed,
+		  std::vector<std::vector<G4SiHit> > & events){
+  TRandom3 lRndm(seed);
+  const unsigned nLayers = det.nLayers();
+  events.clear();
+  events.resize(cfg.nEvents);
+  for (unsigned iE(0); iE<cfg.nEvents; ++iE){
+    //shower axis at eta 1.7-2.7 in the map acceptance
+    const double eta = lRndm.Uniform(1.7,2.7);
+    const double phi = lRndm.Uniform(-TMath::Pi(),TMath::Pi());
+    const double tanTheta = 1./sinh(eta);
+    std::vector<G4SiHit> & lHits = events[iE];
+    lHits.reserve(particle.nHits);
+    for (unsigned iH(0); iH<particle.nHits; ++iH){
+      //longitudinal: gaussian in layer index around shower max
+      int iL = static_cast<int>(lRndm.Gaus(particle.showerMax,particle.showerWidth)+0.5);
+      if (iL<0 || iL>=static_cast<int>(nLayers)) iL = lRndm.Integer(nLayers);
+      const double z = det.hasSensitiveZ() ? det.sensitiveZ(iL) : 3200.+10.*iL;
+      const double r = (lRndm.Rndm()<particle.tailFrac ? particle.tailR : particle.molR)*lRndm.Exp(1.);
+      const double a = lRndm.Uniform(0,2*TMath::Pi());
+      G4SiHit lHit;
+      lHit.energy = lRndm.Landau(0.085,0.01);
+      if (lHit.energy<0) lHit.energy = 0.001;
+      lHit.time = z/299.792458+lRndm.Exp(0.5);
+      lHit.layer = iL;
+      lHit.pdgId = lRndm.Rndm()<0.8 ? 11 : 22;
+      lHit.hit_x = z*tanTheta*cos(phi)+r*cos(a);
+      lHit.hit_y = z*tanTheta*sin(phi)+r*sin(a);
+      lHit.hit_z = z;
+      lHit.trackId = iH;
+      lHit.parentId = 0;
+      lHits.push_back(lHit);
+    }
+  }
+}
+
+//synthetic inputs of PositionFit::fitEvent in folder: z positions,
+//error matrices and per event initial positions
+void writeFitInputs(const std::string & folder, const unsigned version,
+		    const std::vector<double> & zpos, const unsigned nEvents, const unsigned seed){
+  const unsigned nLayers = zpos.size();
+  std::ostringstream lName;
+  lName << folder << "/data/zPositions_v" << version << ".dat";
+  std::ofstream fz(lName.str().c_str());
+  for (unsigned iL(0); iL<nLayers; ++iL) fz << iL << " " << zpos[iL] << std::endl;
+  fz.close();
+
+  std::vector<double> sigma(nLayers,0);
+  for (unsigned iL(0); iL<nLayers; ++iL) sigma[iL] = 1.+0.1*iL;
+  for (unsigned xy(0); xy<2; ++xy){
+    std::ofstream fm((folder+(xy==0?"/errorMatrix_x.dat":"/errorMatrix_y.dat")).c_str());
+    for (unsigned iL(0); iL<nLayers; ++iL){
+      for (unsigned jL(0); jL<nLayers; ++jL){
+	const unsigned d = iL>jL ? iL-jL : jL-iL;
+	fm << iL << " " << jL << " " << std::setprecision(15) << sigma[iL]*sigma[jL]*pow(0.5,d) << std::endl;
+      }
+    }
+    fm.close();
+  }
+
+  TRandom3 lRndm(seed);
+  for (unsigned iE(0); iE<nEvents; ++iE){
+    std::ostringstream lEvt;
+    lEvt << folder << "/initialPos_evt" << iE << ".dat";
+    std::ofstream fp(lEvt.str().c_str());
+    const double x0 = lRndm.Uniform(-50,50);
+    const double y0 = lRndm.Uniform(300,1500);
+    const double tx = x0/zpos[0];
+    const double ty = y0/zpos[0];
+    for (unsigned iL(0); iL<nLayers; ++iL){
+      const double xt = tx*zpos[iL];
+      const double yt = ty*zpos[iL];
+      fp << iL << " " << xt+lRndm.Gaus(0,sigma[iL]) << " " << yt+lRndm.Gaus(0,sigma[iL])
+	 << " " << xt << " " << yt << std::endl;
+    }
+    fp.close();
+  }
+}
+
+void benchFitEvent(const unsigned version, const unsigned nLayers,
+		   const std::vector<double> & zpos,
+		   const HGCSSGeometryConversion & geomConv,
+		   const BenchConfig & cfg, std::vector<BenchResult> & results){
+
+  char lTemplate[] = "/tmp/benchUserlibXXXXXX";
+  if (!mkdtemp(lTemplate)) {
+    std::cout << " -- Warning, cannot create a temporary folder, skipping PositionFit::fitEvent." << std::endl;
+    return;
+  }
+  const std::string folder = lTemplate;
+  const std::string lDataDir = folder+"/data";
+  if (system(("mkdir -p "+lDataDir).c_str())!=0) return;
+  writeFitInputs(folder,version,zpos,cfg.nEvents,cfg.seed);
+
+  //getZpositions reads data/zPositions_v<version>.dat from the current folder
+  char lCwd[4096];
+  if (!getcwd(lCwd,sizeof(lCwd))) return;
+  if (chdir(folder.c_str())!=0) return;
+
+  TFile *outputFile = TFile::Open((folder+"/fit.root").c_str(),"RECREATE");
+  {
+    PositionFit lFit(2,25,nLayers,3,false,0,true);
+    lFit.initialise(outputFile,"PositionFit",folder,geomConv,HGCSSPUenergy());
+    if (lFit.getZpositions(version) && lFit.initialiseLeastSquareFit()){
+      BenchResult res;
+      res.name = "PositionFit::fitEvent";
+      res.particle = "e";
+      res.version = version;
+      res.shape = 0;
+      const std::vector<unsigned> lToRemove;
+      timeIt([&](){
+	  unsigned long long n = 0;
+	  for (unsigned iE(0); iE<cfg.nEvents; ++iE){
+	    FitResult lResult;
+	    lFit.fitEvent(iE,lResult,lToRemove,false);
+	    n++;
+	  }
+	  return n;
+	},cfg.nRepeat,res);
+      results.push_back(res);
+    }
+    else std::cout << " -- Warning, PositionFit setup failed for version " << version << ", skipping fitEvent." << std::endl;
+  }
+  outputFile->Close();
+
+  if (chdir(lCwd)!=0) std::cout << " -- Warning, cannot go back to " << lCwd << std::endl;
+  if (system(("rm -rf "+folder).c_str())!=0) std::cout << " -- Warning, cannot remove " << folder << std::endl;
+}
+
+void benchConfiguration(const unsigned version, const unsigned shape, const bool doFit,
+			const std::vector<ParticleModel> & particles,
+			const BenchConfig & cfg, std::vector<BenchResult> & results){
+
+  HGCSSDetector & myDetector = theDetector();
+  myDetector.buildDetector(version,cfg.model,true,version==23,false);
+  std::shared_ptr<const HGCSSDetectorDescription> det = myDetector.description();
+  const unsigned nLayers = det->nLayers();
+
+  const float cellSize = CELL_SIZE_X;
+  HGCSSGeometryConversion geomConv(cfg.model,cellSize,false,3);
+  geomConv.setXYwidth(cfg.calorSizeXY);
+  geomConv.setVersion(version);
+  geomConv.setDetector(det);
+  if (shape==2) geomConv.initialiseDiamondMap(cfg.calorSizeXY,10.);
+  else if (shape==3) geomConv.initialiseTriangleMap(cfg.calorSizeXY,10.*sqrt(2.));
+  else if (shape==1) geomConv.initialiseHoneyComb(cfg.calorSizeXY,cellSize);
+  else if (shape==4) geomConv.initialiseSquareMap(cfg.calorSizeXY,10.);
+  geomConv.initialiseSquareMap1(1.3,3.0,-1.*TMath::Pi(),TMath::Pi(),TMath::Pi()*2./360.);
+  geomConv.initialiseSquareMap2(1.3,3.0,-1.*TMath::Pi(),TMath::Pi(),TMath::Pi()*2./288.);
+  std::vector<unsigned> granularity(nLayers,1);
+  geomConv.setGranularity(granularity);
+  geomConv.initialiseHistos(false,"",false);
+
+  HGCSSCalibration mycalib;
+  mycalib.setDetector(det);
+  mycalib.setVertex(0,0,0);
+
+  HGCSSDigitisation myDigitiser;
+  myDigitiser.setRandomSeed(cfg.seed);
+  for (unsigned iL(0); iL<nLayers; ++iL) myDigitiser.setNoise(iL,0.12);
+
+  std::vector<const HGCSSSubDetector*> subdets(nLayers,0);
+  std::vector<TH2Poly*> maps(nLayers,0);
+  for (unsigned iL(0); iL<nLayers; ++iL){
+    subdets[iL] = &det->subDetectorByLayer(iL);
+    maps[iL] = cellMap(geomConv,*subdets[iL],shape);
+  }
+
+  for (unsigned iP(0); iP<particles.size(); ++iP){
+    const ParticleModel & particle = particles[iP];
+    std::vector<std::vector<G4SiHit> > events;
+    generateHits(*det,particle,cfg,cfg.seed+iP,events);
+
+    BenchResult res;
+    res.particle = particle.name;
+    res.version = version;
+    res.shape = shape;
+
+    //TH2Poly cell lookup alone
+    res.name = "TH2Poly::FindBin";
+    timeIt([&](){
+	unsigned long long n = 0;
+	int sum = 0;
+	for (unsigned iE(0); iE<events.size(); ++iE){
+	  for (unsigned iH(0); iH<events[iE].size(); ++iH){
+	    const G4SiHit & lHit = events[iE][iH];
+	    if (subdets[lHit.layer]->isScint) {
+	      ROOT::Math::XYZPoint pos(lHit.hit_x,lHit.hit_y,lHit.hit_z);
+	      sum += maps[lHit.layer]->FindBin(pos.eta(),pos.phi());
+	    }
+	    else sum += maps[lHit.layer]->FindBin(lHit.hit_x,lHit.hit_y);
+	    n++;
+	  }
+	}
+	benchSink = sum;
+	return n;
+      },cfg.nRepeat,res);
+    results.push_back(res);
+
+    //HGCSSSimHit construction, includes the cell lookup
+    std::vector<std::vector<HGCSSSimHit> > simhits(events.size());
+    res.name = "HGCSSSimHit::HGCSSSimHit";
+    const unsigned lSiLayer = 0;
+    timeIt([&](){
+	unsigned long long n = 0;
+	for (unsigned iE(0); iE<events.size(); ++iE){
+	  simhits[iE].clear();
+	  simhits[iE].reserve(events[iE].size());
+	  for (unsigned iH(0); iH<events[iE].size(); ++iH){
+	    const G4SiHit & lHit = events[iE][iH];
+	    simhits[iE].push_back(HGCSSSimHit(lHit,lSiLayer,maps[lHit.layer],cellSize,subdets[lHit.layer]->isScint));
+	    n++;
+	  }
+	}
+	return n;
+      },cfg.nRepeat,res);
+    results.push_back(res);
+
+    res.name = "HGCSSSimHit::get_xy";
+    timeIt([&](){
+	unsigned long long n = 0;
+	double sum = 0;
+	for (unsigned iE(0); iE<simhits.size(); ++iE){
+	  for (unsigned iH(0); iH<simhits[iE].size(); ++iH){
+	    const HGCSSSimHit & lHit = simhits[iE][iH];
+	    std::pair<double,double> xy = lHit.get_xy(*subdets[lHit.layer()],geomConv,shape);
+	    sum += xy.first;
+	    n++;
+	  }
+	}
+	benchSink = sum;
+	return n;
+      },cfg.nRepeat,res);
+    results.push_back(res);
+
+    res.name = "HGCSSGeometryConversion::fill";
+    timeIt([&](){
+	unsigned long long n = 0;
+	for (unsigned iE(0); iE<simhits.size(); ++iE){
+	  geomConv.initialiseHistos(false,"",false);
+	  for (unsigned iH(0); iH<simhits[iE].size(); ++iH){
+	    const HGCSSSimHit & lHit = simhits[iE][iH];
+	    geomConv.fill(lHit.layer(),lHit.energy(),lHit.time(),lHit.cellid(),lHit.get_z());
+	    n++;
+	  }
+	}
+	return n;
+      },cfg.nRepeat,res);
+    results.push_back(res);
+
+    //calibration, single hit and batch calls
+    std::vector<unsigned> layer;
+    std::vector<double> radius, time, posx, posy, posz, result;
+    for (unsigned iE(0); iE<simhits.size(); ++iE){
+      for (unsigned iH(0); iH<simhits[iE].size(); ++iH){
+	const HGCSSSimHit & lHit = simhits[iE][iH];
+	const G4SiHit & lG4Hit = events[iE][iH];
+	layer.push_back(lHit.layer());
+	radius.push_back(sqrt(lG4Hit.hit_x*lG4Hit.hit_x+lG4Hit.hit_y*lG4Hit.hit_y));
+	time.push_back(lG4Hit.time);
+	posx.push_back(lG4Hit.hit_x);
+	posy.push_back(lG4Hit.hit_y);
+	posz.push_back(lG4Hit.hit_z);
+      }
+    }
+    const unsigned nCalib = layer.size();
+    result.resize(nCalib,0);
+
+    res.name = "HGCSSCalibration::MeVToMip";
+    timeIt([&](){
+	for (unsigned iH(0); iH<nCalib; ++iH) result[iH] = mycalib.MeVToMip(layer[iH],radius[iH]);
+	return static_cast<unsigned long long>(nCalib);
+      },cfg.nRepeat,res);
+    results.push_back(res);
+
+    res.name = "HGCSSCalibration::MeVToMip(batch)";
+    timeIt([&](){
+	mycalib.MeVToMip(nCalib,layer.data(),radius.data(),result.data());
+	return static_cast<unsigned long long>(nCalib);
+      },cfg.nRepeat,res);
+    results.push_back(res);
+
+    res.name = "HGCSSCalibration::correctTime";
+    timeIt([&](){
+	for (unsigned iH(0); iH<nCalib; ++iH) result[iH] = mycalib.correctTime(time[iH],posx[iH],posy[iH],posz[iH]);
+	return static_cast<unsigned long long>(nCalib);
+      },cfg.nRepeat,res);
+    results.push_back(res);
+
+    res.name = "HGCSSCalibration::correctTime(batch)";
+    timeIt([&](){
+	mycalib.correctTime(nCalib,time.data(),posx.data(),posy.data(),posz.data(),result.data());
+	return static_cast<unsigned long long>(nCalib);
+      },cfg.nRepeat,res);
+    results.push_back(res);
+
+    //noise and ADC per cell of the maps, as in the digitizer cell loop
+    res.name = "HGCSSDigitisation::noiseADC";
+    timeIt([&](){
+	unsigned long long n = 0;
+	unsigned sum = 0;
+	TH1F *lHist = 0;
+	for (unsigned iL(0); iL<nLayers; ++iL){
+	  const HGCSSSubDetector & subdet = *subdets[iL];
+	  const unsigned nCells = maps[iL]->GetNumberOfBins();
+	  for (unsigned iC(0); iC<nCells; ++iC){
+	    double lE = 0;
+	    myDigitiser.addNoise(lE,iL,lHist);
+	    const unsigned adc = myDigitiser.adcConverter(lE,subdet.type);
+	    sum += adc;
+	    if (adc>0) lE = myDigitiser.adcToMIP(adc,subdet.type);
+	    n++;
+	  }
+	}
+	benchSink = sum;
+	return n;
+      },cfg.nRepeat,res);
+    results.push_back(res);
+
+    //clustering of the per event rechits
+    std::vector<std::vector<HGCSSRecoHit> > rechits(simhits.size());
+    for (unsigned iE(0); iE<simhits.size(); ++iE){
+      for (unsigned iH(0); iH<simhits[iE].size(); ++iH){
+	const HGCSSSimHit & lHit = simhits[iE][iH];
+	HGCSSRecoHit lRecHit(lHit,*subdets[lHit.layer()],geomConv,shape);
+	const G4SiHit & lG4Hit = events[iE][iH];
+	const double r = sqrt(lG4Hit.hit_x*lG4Hit.hit_x+lG4Hit.hit_y*lG4Hit.hit_y);
+	lRecHit.energy(lHit.energy()*mycalib.MeVToMip(lHit.layer(),r));
+	rechits[iE].push_back(lRecHit);
+      }
+    }
+    res.name = "Clusterizer::buildClusters";
+    timeIt([&](){
+	unsigned long long n = 0;
+	Clusterizer lClusterizer;
+	for (unsigned iE(0); iE<rechits.size(); ++iE){
+	  const unsigned nHits = rechits[iE].size();
+	  std::vector<bool> rechitMask(nHits,true);
+	  std::vector<bool> seedable(nHits,false);
+	  for (unsigned iH(0); iH<nHits; ++iH) seedable[iH] = rechits[iE][iH].energy()>10;
+	  HGCSSClusterVec lClusters;
+	  lClusterizer.buildClusters(&rechits[iE],rechitMask,seedable,lClusters);
+	  n++;
+	}
+	return n;
+      },cfg.nRepeat,res);
+    results.push_back(res);
+  }
+
+  //shape independent, once per version
+  if (doFit) {
+    std::vector<double> zpos(nLayers,0);
+    for (unsigned iL(0); iL<nLayers; ++iL) zpos[iL] = det->hasSensitiveZ() ? det->sensitiveZ(iL) : 3200.+10.*iL;
+    benchFitEvent(version,nLayers,zpos,geomConv,cfg,results);
+  }
+
+}
+
+void writeJSON(const std::string & outPath, const std::string & tag,
+	       const BenchConfig & cfg, const std::vector<BenchResult> & results){
+  std::ofstream lOut(outPath.c_str());
+  if (!lOut.is_open()) {
+    std::cout << " -- Error, cannot write " << outPath << std::endl;
+    return;
+  }
+  lOut << "{" << std::endl
+       << "  \"schema\": " << BENCH_SCHEMA << "," << std::endl
+       << "  \"tag\": \"" << tag << "\"," << std::endl
+       << "  \"seed\": " << cfg.seed << "," << std::endl
+       << "  \"nEvents\": " << cfg.nEvents << "," << std::endl
+       << "  \"nRepeat\": " << cfg.nRepeat << "," << std::endl
+       << "  \"model\": " << cfg.model << "," << std::endl
+       << "  \"calorSizeXY\": " << cfg.calorSizeXY << "," << std::endl
+       << "  \"results\": [";
+  for (unsigned iR(0); iR<results.size(); ++iR){
+    const BenchResult & r = results[iR];
+    lOut << (iR>0?",":"") << std::endl
+	 << "    {\"name\": \"" << r.name << "\""
+	 << ", \"particle\": \"" << r.particle << "\""
+	 << ", \"version\": " << r.version
+	 << ", \"shape\": " << r.shape
+	 << ", \"nOps\": " << r.nOps
+	 << ", \"nsPerOp\": " << std::setprecision(6) << r.nsPerOp
+	 << ", \"nsPerOpMin\": " << r.nsPerOpMin << "}";
+  }
+  lOut << std::endl << "  ]" << std::endl
+       << "}" << std::endl;
+  lOut.close();
+}
+
+int main(int argc, char** argv){//main
+
+  if (argc < 2) {
+    std::cout << " Usage: "
+	      << argv[0] << " <output json>"
+	      << " <optional: tag (default=master)>"
+	      << " <optional: nEvents (default=20)>"
+	      << " <optional: versions (default=12,30,63,70)>"
+	      << " <optional: shapes (default=1,2,3,4)>"
+	      << " <optional: seed (default=1234)>"
+	      << std::endl;
+    return 1;
+  }
+
+  const std::string outPath = argv[1];
+  const std::string tag = argc>2 ? argv[2] : "master";
+
+  BenchConfig cfg;
+  cfg.nEvents = argc>3 ? atoi(argv[3]) : 20;
+  cfg.nRepeat = 5;
+  cfg.calorSizeXY = 2800;
+  cfg.model = 2;
+  cfg.seed = argc>6 ? atoi(argv[6]) : 1234;
+
+  std::vector<unsigned> versions;
+  versions.push_back(12);
+  versions.push_back(30);
+  versions.push_back(63);
+  versions.push_back(70);
+  if (argc>4) extractList(argv[4],versions);
+  std::vector<unsigned> shapes;
+  for (unsigned iS(1); iS<5; ++iS) shapes.push_back(iS);
+  if (argc>5) extractList(argv[5],shapes);
+
+  std::vector<ParticleModel> particles;
+  ParticleModel lEle = {"e",2000,15.,40.,0.1,8.,4.};
+  ParticleModel lPion = {"pi",5000,40.,150.,0.3,30.,12.};
+  particles.push_back(lEle);
+  particles.push_back(lPion);
+
+  std::vector<BenchResult> results;
+  for (unsigned iV(0); iV<versions.size(); ++iV){
+    for (unsigned iS(0); iS<shapes.size(); ++iS){
+      std::cout << " -- Benchmarking version " << versions[iV] << " shape " << shapes[iS] << std::endl;
+      benchConfiguration(versions[iV],shapes[iS],iS==0,particles,cfg,results);
+    }
+  }
+
+  std::cout << " ============== benchUserlib " << tag << " ==============" << std::endl
+	    << std::setw(38) << "benchmark" << std::setw(5) << "p" << std::setw(5) << "v" << std::setw(4) << "s"
+	    << std::setw(12) << "n" << std::setw(12) << "ns/op" << std::setw(12) << "min" << std::endl;
+  for (unsigned iR(0); iR<results.size(); ++iR){
+    const BenchResult & r = results[iR];
+    std::cout << std::setw(38) << r.name << std::setw(5) << r.particle << std::setw(5) << r.version << std::setw(4) << r.shape
+	      << std::setw(12) << r.nOps << std::setw(12) << std::setprecision(4) << r.nsPerOp
+	      << std::setw(12) << r.nsPerOpMin << std::endl;
+  }
+
+  writeJSON(outPath,tag,cfg,results);
+  std::cout << " -- Results written to " << outPath << std::endl;
+
+  return 0;
+
+}//main
@@ -7,6 +7,7 @@
 #include "TH2D.h"
 
 #include "HGCSSDetector.hh"
+#include "HGCSSDetectorDescription.hh"
 
 class HGCSSCalibration {
 
@@ -15,6 +16,9 @@ public:
     vtx_x_ = 0;
     vtx_y_ = 0;
     vtx_z_ = 0;
+    bypassRadius_ = false;
+    nSiLayers_ = 2;
+    fillLayerTables();
   };
 
   HGCSSCalibration(std::string filePath, 
@@ -23,6 +27,25 @@ public:
 
   ~HGCSSCalibration();
 
+  //use this description instead of the one of theDetector()
+  inline void setDetector(const std::shared_ptr<const HGCSSDetectorDescription> & aDet){
+    detector_ = aDet;
+    fillLayerTables();
+  };
+
+  //error if neither setDetector() nor buildDetector() was called
+  inline const HGCSSDetectorDescription & detector() const{
+    if (detector_) return *detector_;
+    const std::shared_ptr<const HGCSSDetectorDescription> & lDet = theDetector().description();
+    if (!lDet) detectorError();
+    return *lDet;
+  };
+
+  //per-layer MeV to mip tables, from detector(). Filled at construction,
+  //to be called again if theDetector() is rebuilt afterwards: the MeVToMip
+  //calls exit with an error if the tables are from another description.
+  void fillLayerTables();
+
   inline void setVertex(const double & x,
 			const double & y,
 			const double & z){
@@ -68,13 +91,49 @@ public:
   double MeVToMip(const unsigned layer, const double aRadius,
 		  const bool absWeight=false) const;
 
+  //batch versions: result[i] for hit i, same as the single-hit calls
+  void MeVToMip(const unsigned nHits,
+		const unsigned * layer,
+		const double * aRadius,
+		double * result,
+		const bool absWeight=false) const;
+
+  void correctTime(const unsigned nHits,
+		   const double * aTime,
+		   const double * posx,
+		   const double * posy,
+		   const double * posz,
+		   double * result) const;
+
 private:
 
+  //MeV to mip factors for one layer: without thickness correction
+  //and per radius region, [absWeight][300um,200um,100um]
+  struct LayerCalib {
+    double rOut;
+    double rIn;
+    double base[2];
+    double weight[2][3];
+  };
+
+  //tables filled from the current description, error otherwise
+  inline const std::vector<LayerCalib> & layerTables() const{
+    const HGCSSDetectorDescription * lCurrent = detector_ ? detector_.get() : theDetector().description().get();
+    if (!lCurrent || lCurrent!=tableSource_.get()) tablesError();
+    return layerCalib_;
+  };
+  void tablesError() const;
+  void detectorError() const;
+
   double vtx_x_;
   double vtx_y_;
   double vtx_z_;
   bool bypassRadius_;
   unsigned nSiLayers_;
+  std::shared_ptr<const HGCSSDetectorDescription> detector_;
+  std::vector<LayerCalib> layerCalib_;
+  //description the tables were filled from, kept alive
+  std::shared_ptr<const HGCSSDetectorDescription> tableSource_;
 };
 
 
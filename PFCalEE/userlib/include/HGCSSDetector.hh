@@ -5,6 +5,7 @@
 #include <string>
 #include <vector>
 #include <map>
+#include <memory>
 #include "TH2D.h"
 
 enum DetectorEnum {
@@ -54,10 +55,13 @@ private:
 
 };
 
+class HGCSSDetectorDescription;
+
 class HGCSSDetector {
 
 public:
   friend HGCSSDetector & theDetector();
+  friend class HGCSSDetectorDescription;
 
   inline void initialiseIndices(const unsigned versionNumber, const unsigned model=2){
     
@@ -1383,6 +1387,11 @@ public:
 
   void printDetector(std::ostream & aOs) const ;
 
+  //immutable flat copy of the built detector, safe to share between threads
+  inline const std::shared_ptr<const HGCSSDetectorDescription> & description() const{
+    return description_;
+  };
+
   inline double sensitiveZ(const unsigned layer){
     if (layer<sensitiveZ_.size()) return sensitiveZ_[layer];
     else {
@@ -1421,6 +1430,8 @@ private:
   std::vector<double> sensitiveZ_;
   std::vector<double> etaBoundary_;
 
+  std::shared_ptr<const HGCSSDetectorDescription> description_;
+
 };
 
 HGCSSDetector & theDetector();
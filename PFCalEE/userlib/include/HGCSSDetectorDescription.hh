@@ -0,0 +1,139 @@
+#ifndef HGCSSDetectorDescription_h
+#define HGCSSDetectorDescription_h
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <memory>
+
+#include "HGCSSDetector.hh"
+
+//Immutable detector description with flat per-layer arrays.
+//Built once per configuration from HGCSSDetector and shared (const)
+//between threads, e.g. digitizer workers. Per-layer accessors exit
+//with an error for aLayer >= nLayers(), as HGCSSDetector::getSection.
+class HGCSSDetectorDescription {
+
+public:
+  //shared description for this configuration, built on first call.
+  static std::shared_ptr<const HGCSSDetectorDescription> get(const unsigned versionNumber,
+							       const unsigned model=2,
+							       bool concept=true,
+							       bool isCaliceHcal=false,
+							       bool bypassR=false);
+
+  HGCSSDetectorDescription(const HGCSSDetector & aDet,
+			   const unsigned versionNumber,
+			   const unsigned model);
+
+  ~HGCSSDetectorDescription(){};
+
+  inline unsigned version() const{
+    return version_;
+  };
+
+  inline unsigned model() const{
+    return model_;
+  };
+
+  inline unsigned nLayers() const{
+    return nLayers_;
+  };
+
+  inline unsigned nSections() const{
+    return subdets_.size();
+  };
+
+  inline unsigned section(const unsigned aLayer) const{
+    return section_[checkLayer(aLayer)];
+  };
+
+  //nSections() if not present in this detector
+  inline unsigned section(const DetectorEnum adet) const{
+    return enumSection_[adet];
+  };
+
+  inline bool hasSubDetector(const DetectorEnum adet) const{
+    return enumSection_[adet] < nSections();
+  };
+
+  inline const HGCSSSubDetector & subDetectorByLayer(const unsigned aLayer) const{
+    return subdets_[section_[checkLayer(aLayer)]];
+  };
+
+  inline const HGCSSSubDetector & subDetectorBySection(const unsigned aSection) const{
+    return subdets_[aSection];
+  };
+
+  const HGCSSSubDetector & subDetectorByEnum(const DetectorEnum adet) const;
+
+  inline DetectorEnum type(const unsigned aLayer) const{
+    return type_[checkLayer(aLayer)];
+  };
+
+  inline bool isSi(const unsigned aLayer) const{
+    return isSi_[checkLayer(aLayer)];
+  };
+
+  inline bool isScint(const unsigned aLayer) const{
+    return isScint_[checkLayer(aLayer)];
+  };
+
+  inline double mipWeight(const unsigned aLayer) const{
+    return mipWeight_[checkLayer(aLayer)];
+  };
+
+  inline double absWeight(const unsigned aLayer) const{
+    return absWeight_[checkLayer(aLayer)];
+  };
+
+  inline double radiusLim(const unsigned aLayer) const{
+    return radiusLim_[checkLayer(aLayer)];
+  };
+
+  //sensitive z positions are only defined for some versions
+  inline bool hasSensitiveZ() const{
+    return hasSensitiveZ_;
+  };
+
+  inline double sensitiveZ(const unsigned aLayer) const{
+    return sensitiveZ_[checkLayer(aLayer)];
+  };
+
+  //0 if not defined for this version, as HGCSSDetector::etaBoundary
+  inline double etaBoundary(const unsigned aLayer) const{
+    return etaBoundary_[checkLayer(aLayer)];
+  };
+
+  void Print(std::ostream & aOs) const;
+
+private:
+  static const unsigned nDetEnums_ = 6;
+
+  //one comparison inline, the error path out of line
+  inline unsigned checkLayer(const unsigned aLayer) const{
+    if (aLayer>=nLayers_) layerError(aLayer);
+    return aLayer;
+  };
+  void layerError(const unsigned aLayer) const;
+
+  unsigned version_;
+  unsigned model_;
+  unsigned nLayers_;
+  std::vector<HGCSSSubDetector> subdets_;
+  unsigned enumSection_[nDetEnums_];
+
+  std::vector<unsigned> section_;
+  std::vector<DetectorEnum> type_;
+  std::vector<bool> isSi_;
+  std::vector<bool> isScint_;
+  std::vector<double> mipWeight_;
+  std::vector<double> absWeight_;
+  std::vector<double> radiusLim_;
+  bool hasSensitiveZ_;
+  std::vector<double> sensitiveZ_;
+  std::vector<double> etaBoundary_;
+
+};
+
+#endif
@@ -138,6 +138,18 @@ public:
   double ipXtalk(const std::vector<double> & aSimEvec);
 
   void addNoise(double & aDigiE, const unsigned & alay, TH1F * & hist);
+
+  //pure noise cells: probability for the noise of layer alay to be above aThresh (in MIPs)
+  double noiseTailProbability(const unsigned & alay, const double & aThresh);
+
+  //number of cells above threshold out of nCells, for a tail probability p
+  unsigned nNoiseAbove(const unsigned nCells, const double & p);
+
+  //uniform in [0,n)
+  unsigned randomIndex(const unsigned n);
+
+  //noise of layer alay conditional on being above aThresh, p = noiseTailProbability(alay,aThresh)
+  double tailNoise(const unsigned & alay, const double & aThresh, const double & p, TH1F * & hist);
   
   unsigned adcConverter(double eMIP, DetectorEnum adet);
 
@@ -0,0 +1,97 @@
+#ifndef HGCSSFileCatalogue_h
+#define HGCSSFileCatalogue_h
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <map>
+
+#include "Rtypes.h"
+
+class TChain;
+class HGCSSInfo;
+
+//integrity of a catalogued file
+enum HGCSSFileStatus {
+  fs_OK=0,
+  fs_Unreadable=1,//cannot be opened or zombie
+  fs_Recovered=2,//not closed properly, keys recovered
+  fs_NoTree=3,
+  fs_Empty=4,
+  fs_N=5
+};
+
+//one file of a production, as read once by the scan
+struct HGCSSFileRecord {
+  std::string path;
+  std::string tree;
+  unsigned status;
+  Long64_t entries;
+  Long64_t bytes;
+  bool hasInfo;
+  int version;
+  int model;
+  unsigned shape;
+  double cellSize;
+};
+
+//Index of the files of a production (bin/catalogue): tree name and entries,
+//size, HGCSSInfo and integrity of each file, so that chains can be built
+//with known entry counts without opening the files.
+//Text file, one line per file:
+//path tree status entries bytes hasInfo version model shape cellSize
+class HGCSSFileCatalogue {
+
+public:
+  HGCSSFileCatalogue(){};
+  ~HGCSSFileCatalogue(){};
+
+  //open the file and fill its record, the tree is the first of
+  //HGCSSTree, RecoTree, PUTree found in the file.
+  static HGCSSFileRecord scanFile(const std::string & path);
+
+  //scan the .root files of aDir with names containing pattern, with nThreads
+  //in parallel. Files already in the catalogue are scanned again.
+  //Returns the number of files scanned.
+  unsigned scan(const std::string & aDir,
+		const std::string & pattern="",
+		const unsigned nThreads=1);
+
+  //add the records of an index file, several can be read.
+  bool read(const std::string & fileName);
+  bool write(const std::string & fileName) const;
+
+  //path as stored: repeated slashes removed from local paths
+  static std::string normalise(const std::string & path);
+
+  //0 if not catalogued
+  const HGCSSFileRecord * find(const std::string & path) const;
+
+  //add a good file to the chain with its entries, without opening it.
+  //false if the file is not catalogued or not usable.
+  bool addFile(TChain & chain, const std::string & path) const;
+
+  //add all the good files with the tree of the chain and path containing pattern
+  unsigned fillChain(TChain & chain, const std::string & pattern="") const;
+
+  //false if the file is not catalogued or has no Info
+  bool fillInfo(const std::string & path, HGCSSInfo & info) const;
+
+  inline const std::vector<HGCSSFileRecord> & records() const{
+    return records_;
+  };
+
+  static const char * statusName(const unsigned status);
+
+  void print(std::ostream & aOs=std::cout) const;
+
+private:
+
+  void add(const HGCSSFileRecord & record);
+
+  std::vector<HGCSSFileRecord> records_;
+  std::map<std::string,unsigned> index_;
+
+};
+
+#endif
@@ -10,6 +10,7 @@
 #include "TH2Poly.h"
 #include "TMath.h"
 #include "HGCSSDetector.hh"
+#include "HGCSSDetectorDescription.hh"
 
 struct MergeCells {
   double energy;
@@ -17,6 +18,16 @@ struct MergeCells {
   //double z;
 };
 
+//cell centre in the dense per-map arrays.
+//Si: x,y in mm and rho=sqrt(x^2+y^2).
+//Scint: x,y per mm of z (tan(theta)cos(phi), tan(theta)sin(phi)) and eta.
+struct CellCentre {
+  double x;
+  double y;
+  double rho;
+  double eta;
+};
+
 
 class HGCSSGeometryConversion{
   
@@ -32,6 +43,19 @@ public:
     version_ = aV;
   };
 
+  //use this description instead of the one of theDetector()
+  inline void setDetector(const std::shared_ptr<const HGCSSDetectorDescription> & aDet){
+    detector_ = aDet;
+  };
+
+  //error if neither setDetector() nor buildDetector() was called
+  inline const HGCSSDetectorDescription & detector() const{
+    if (detector_) return *detector_;
+    const std::shared_ptr<const HGCSSDetectorDescription> & lDet = theDetector().description();
+    if (!lDet) detectorError();
+    return *lDet;
+  };
+
   inline TH2Poly *hexagonMap(){
     static TH2Poly hc;
     return &hc;
@@ -95,26 +119,32 @@ public:
 
   inline void copyhexaGeom(const std::map<int,std::pair<double,double> > & ageom) {
     hexaGeom = ageom;
+    fillCells(hexaGeom,hexaCells_,false);
   };
 
   inline void copydiamGeom(const std::map<int,std::pair<double,double> > &ageom){
     diamGeom = ageom;
+    fillCells(diamGeom,diamCells_,false);
   };
 
   inline void copytriangleGeom(const std::map<int,std::pair<double,double> > &ageom){
     triangleGeom = ageom;
+    fillCells(triangleGeom,triangleCells_,false);
   };
 
   inline void copysquareGeom(const std::map<int,std::pair<double,double> > &ageom){
     squareGeom = ageom;
+    fillCells(squareGeom,squareCells_,false);
   };
 
   inline void copysquareGeom1(const std::map<int,std::pair<double,double> > &ageom){
     squareGeom1 = ageom;
+    fillCells(squareGeom1,squareCells1_,true);
   };
 
   inline void copysquareGeom2(const std::map<int,std::pair<double,double> > &ageom){
     squareGeom2 = ageom;
+    fillCells(squareGeom2,squareCells2_,true);
   };
 
   void initialiseSquareMap(const double xymin, const double side);
@@ -143,6 +173,46 @@ public:
 
   void fillXY(TH2Poly* hist, std::map<int,std::pair<double,double> > & geom);
 
+  //dense cell centres indexed by cellid, for the map used by this subdetector/shape
+  inline const std::vector<CellCentre> & cells(const HGCSSSubDetector & subdet,
+					       const unsigned shape) const{
+    if (subdet.isScint) return subdet.type==DetectorEnum::BHCAL1 ? squareCells1_ : squareCells2_;
+    if (shape==4) return squareCells_;
+    if (shape==2) return diamCells_;
+    if (shape==3) return triangleCells_;
+    return hexaCells_;
+  };
+
+  const std::map<int,std::pair<double,double> > & geomMap(const HGCSSSubDetector & subdet,
+							   const unsigned shape) const;
+
+  //x-y of the cell centre, scintillator cells projected to z.
+  inline std::pair<double,double> cellXY(const HGCSSSubDetector & subdet,
+					 const unsigned shape,
+					 const unsigned cellid,
+					 const double z) const{
+    const std::vector<CellCentre> & lCells = cells(subdet,shape);
+    if (cellid < lCells.size()){
+      const CellCentre & cc = lCells[cellid];
+      if (subdet.isScint) return std::pair<double,double>(z*cc.x,z*cc.y);
+      return std::pair<double,double>(cc.x,cc.y);
+    }
+    return cellXYFromMap(subdet,shape,cellid,z);
+  };
+
+  inline double cellEta(const HGCSSSubDetector & subdet,
+			const unsigned shape,
+			const unsigned cellid,
+			const double z) const{
+    const std::vector<CellCentre> & lCells = cells(subdet,shape);
+    if (cellid < lCells.size()){
+      const CellCentre & cc = lCells[cellid];
+      if (subdet.isScint) return z>0 ? cc.eta : -cc.eta;
+      if (cc.rho>0) return asinh(z/cc.rho);
+    }
+    return cellEtaFromMap(subdet,shape,cellid,z);
+  };
+
   void setGranularity(const std::vector<unsigned> & granul);
 
   unsigned getGranularity(const unsigned aLayer, const HGCSSSubDetector & adet);
@@ -176,6 +246,10 @@ public:
 
   double cellSizeInCm(const unsigned aLayer, const double aR) const;
 
+  //area of a cell in cm2, for the PU densities per unit area: regular
+  //hexagons of side cellSizeInCm if hexagon, squares otherwise.
+  double cellAreaInCm2(const unsigned aLayer, const double aR, const bool hexagon) const;
+
   unsigned getNumberOfSiLayers(const DetectorEnum type,
 			       const double radius,
 			       const double z,
@@ -244,6 +318,20 @@ public:
 
 private:
 
+  void fillCells(const std::map<int,std::pair<double,double> > & geom,
+		 std::vector<CellCentre> & aCells,
+		 const bool isEtaPhi);
+
+  //slow paths for ids not in the dense arrays
+  std::pair<double,double> cellXYFromMap(const HGCSSSubDetector & subdet,
+					 const unsigned shape,
+					 const unsigned cellid,
+					 const double z) const;
+  double cellEtaFromMap(const HGCSSSubDetector & subdet,
+			const unsigned shape,
+			const unsigned cellid,
+			const double z) const;
+
   void myHoneycomb(TH2Poly* map,
 		   Double_t xstart,
 		   Double_t ystart,
@@ -251,6 +339,8 @@ private:
 		   Int_t k,     // # hexagons in a column
 		   Int_t s);    // # columns
   
+  void detectorError() const;
+
   bool dopatch_;
   double width_;
   double cellSize_;
@@ -259,6 +349,13 @@ private:
   bool bypassRadius_;
   unsigned nSiLayers_;
   unsigned version_;
+  std::shared_ptr<const HGCSSDetectorDescription> detector_;
+  std::vector<CellCentre> hexaCells_;
+  std::vector<CellCentre> diamCells_;
+  std::vector<CellCentre> triangleCells_;
+  std::vector<CellCentre> squareCells_;
+  std::vector<CellCentre> squareCells1_;
+  std::vector<CellCentre> squareCells2_;
   //std::map<DetectorEnum,std::vector<TH2Poly *> > HistMapE_;
   //std::map<DetectorEnum,std::vector<TH2Poly *> > HistMapTime_;
   //std::map<DetectorEnum,std::vector<TH2Poly *> > HistMapZ_;
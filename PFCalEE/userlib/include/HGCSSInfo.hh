@@ -16,6 +16,18 @@ public:
     model_ = -1;
     cellsize_ = 2.5;//mm
     shape_ = 1;
+    lateTimeCut_ = 0;
+    thermalNeutronCut_ = 0;
+    rouletteEnergy_ = 0;
+    rouletteProbability_ = 1;
+    nKilledLate_ = 0;
+    nPostponedLate_ = 0;
+    nKilledThermal_ = 0;
+    nKilledRoulette_ = 0;
+    nSurvivedRoulette_ = 0;
+    roiDeltaEta_ = 0;
+    roiDeltaPhi_ = 0;
+    nKilledRoI_ = 0;
   };
   
   virtual ~HGCSSInfo(){};
@@ -60,6 +72,119 @@ public:
     return calorSizeXY_;
   };
 
+  //stacking action settings, 0 = disabled. Times in ns, energies in MeV.
+  inline void lateTimeCut(const double & aVal){
+    lateTimeCut_ = aVal;
+  };
+
+  inline double lateTimeCut() const{
+    return lateTimeCut_;
+  };
+
+  inline void thermalNeutronCut(const double & aVal){
+    thermalNeutronCut_ = aVal;
+  };
+
+  inline double thermalNeutronCut() const{
+    return thermalNeutronCut_;
+  };
+
+  inline void rouletteEnergy(const double & aVal){
+    rouletteEnergy_ = aVal;
+  };
+
+  inline double rouletteEnergy() const{
+    return rouletteEnergy_;
+  };
+
+  inline void rouletteProbability(const double & aVal){
+    rouletteProbability_ = aVal;
+  };
+
+  inline double rouletteProbability() const{
+    return rouletteProbability_;
+  };
+
+  //number of tracks removed by the stacking action, summed over the runs of the file
+  inline void nKilledLate(const ULong64_t & aVal){
+    nKilledLate_ = aVal;
+  };
+
+  inline ULong64_t nKilledLate() const{
+    return nKilledLate_;
+  };
+
+  inline void nPostponedLate(const ULong64_t & aVal){
+    nPostponedLate_ = aVal;
+  };
+
+  inline ULong64_t nPostponedLate() const{
+    return nPostponedLate_;
+  };
+
+  inline void nKilledThermal(const ULong64_t & aVal){
+    nKilledThermal_ = aVal;
+  };
+
+  inline ULong64_t nKilledThermal() const{
+    return nKilledThermal_;
+  };
+
+  inline void nKilledRoulette(const ULong64_t & aVal){
+    nKilledRoulette_ = aVal;
+  };
+
+  inline ULong64_t nKilledRoulette() const{
+    return nKilledRoulette_;
+  };
+
+  inline void nSurvivedRoulette(const ULong64_t & aVal){
+    nSurvivedRoulette_ = aVal;
+  };
+
+  inline ULong64_t nSurvivedRoulette() const{
+    return nSurvivedRoulette_;
+  };
+
+  //region of interest of the stepping action, 0 = disabled.
+  //Half-axes in (eta,phi) of the cone around each primary direction,
+  //taken from its vertex. Tracks outside all cones were killed.
+  inline void roiDeltaEta(const double & aVal){
+    roiDeltaEta_ = aVal;
+  };
+
+  inline double roiDeltaEta() const{
+    return roiDeltaEta_;
+  };
+
+  inline void roiDeltaPhi(const double & aVal){
+    roiDeltaPhi_ = aVal;
+  };
+
+  inline double roiDeltaPhi() const{
+    return roiDeltaPhi_;
+  };
+
+  inline bool hasRoI() const{
+    return roiDeltaEta_>0 && roiDeltaPhi_>0;
+  };
+
+  //dEta,dPhi: distance to the primary direction
+  inline bool inRoI(const double & dEta, const double & dPhi) const{
+    if (!hasRoI()) return true;
+    const double x = dEta/roiDeltaEta_;
+    const double y = dPhi/roiDeltaPhi_;
+    return x*x+y*y < 1;
+  };
+
+  inline void nKilledRoI(const ULong64_t & aVal){
+    nKilledRoI_ = aVal;
+  };
+
+  inline ULong64_t nKilledRoI() const{
+    return nKilledRoI_;
+  };
+
 private:
 
   int version_;
@@ -68,7 +193,20 @@ private:
   double calorSizeXY_;
   unsigned shape_;
 
-  ClassDef(HGCSSInfo,2);
+  double lateTimeCut_;
+  double thermalNeutronCut_;
+  double rouletteEnergy_;
+  double rouletteProbability_;
+  ULong64_t nKilledLate_;
+  ULong64_t nPostponedLate_;
+  ULong64_t nKilledThermal_;
+  ULong64_t nKilledRoulette_;
+  ULong64_t nSurvivedRoulette_;
+  double roiDeltaEta_;
+  double roiDeltaPhi_;
+  ULong64_t nKilledRoI_;
+
+  ClassDef(HGCSSInfo,4);
 
 
 
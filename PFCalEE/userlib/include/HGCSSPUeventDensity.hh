@@ -0,0 +1,83 @@
+#ifndef HGCSSPUeventDensity_h
+#define HGCSSPUeventDensity_h
+
+#include <vector>
+#include <cmath>
+
+#include "HGCSSRecoHit.hh"
+
+//Event-by-event pile-up energy density, alternative to the mean
+//parametrisation of HGCSSPUenergy. fill() bins the rechits of one
+//event once, per layer, in an eta x phi grid; grid cells with their
+//centre inside a signal cone are excluded. The density per unit area
+//(MIP/cm2) of each eta ring is then the energy of the non-excluded
+//cells over their area, so getDensity is a table look-up.
+class HGCSSPUeventDensity{
+
+public:
+  HGCSSPUeventDensity(const unsigned nLayers=0,
+		      const double etaMin=1.5,
+		      const double etaMax=3.0,
+		      const unsigned nEtaBins=30,
+		      const unsigned nPhiBins=36);
+  ~HGCSSPUeventDensity(){};
+
+  //cones excluded from the density, until clearSignalCones()
+  void addSignalCone(const double eta, const double phi, const double dR);
+  inline void clearSignalCones(){
+    coneEta_.clear();
+    conePhi_.clear();
+    coneDR_.clear();
+    exclusionUpToDate_ = false;
+  };
+
+  //one pass on the event rechits, layer z taken from the hits
+  void fill(const std::vector<HGCSSRecoHit> & rechitvec,
+	    const bool applyPuMixFix=false);
+
+  //density in MIP/cm2 of the eta ring, 0 outside the grid
+  inline double getDensityPerArea(const double eta, const unsigned layer) const{
+    if (layer>=nLayers_ || eta<etaMin_ || eta>=etaMax_) return 0;
+    return density_[layer*nEta_+static_cast<unsigned>((eta-etaMin_)/etaStep_)];
+  };
+
+  //same signature as HGCSSPUenergy::getDensity: energy expected in a cell
+  //of cellArea cm2. No PU scaling, the event already has its own PU.
+  inline double getDensity(const double eta, const unsigned layer, const double cellArea) const{
+    return getDensityPerArea(fabs(eta),layer)*cellArea;
+  };
+
+  inline unsigned nLayers() const{
+    return nLayers_;
+  };
+
+private:
+  inline unsigned gridIndex(const unsigned layer, const unsigned iEta, const unsigned iPhi) const{
+    return (layer*nEta_+iEta)*nPhi_+iPhi;
+  };
+
+  void updateExclusion();
+
+  unsigned nLayers_;
+  double etaMin_;
+  double etaMax_;
+  unsigned nEta_;
+  unsigned nPhi_;
+  double etaStep_;
+  double phiStep_;
+
+  std::vector<double> coneEta_;
+  std::vector<double> conePhi_;
+  std::vector<double> coneDR_;
+  //per eta x phi cell, not per layer
+  std::vector<bool> excluded_;
+  bool exclusionUpToDate_;
+
+  std::vector<double> gridE_;
+  std::vector<double> sumZ_;
+  std::vector<unsigned> nZ_;
+  std::vector<double> density_;
+
+};
+
+#endif
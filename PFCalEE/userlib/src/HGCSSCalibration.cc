@@ -12,6 +12,7 @@ HGCSSCalibration::HGCSSCalibration(std::string filePath,
   vtx_z_ = 0;
   bypassRadius_ = bypassR;
   nSiLayers_ = nSi;
+  fillLayerTables();
 }
 
 
@@ -32,10 +33,10 @@ double HGCSSCalibration::addTimeOfFlight(const double & aTime,
 					 const double & vtxx,
 					 const double & vtxy,
 					 const double & vtxz){
-  double distance = sqrt(pow(posx-vtxx-vtx_x_,2)+
-			 pow(posy-vtxy-vtx_y_,2)+
-			 pow(posz-vtxz-vtx_z_,2)
-			 );
+  const double dx = posx-vtxx-vtx_x_;
+  const double dy = posy-vtxy-vtx_y_;
+  const double dz = posz-vtxz-vtx_z_;
+  double distance = sqrt(dx*dx+dy*dy+dz*dz);
   double c = 299.792458;//3.e8*1000./1.e9;//in mm / ns...
   double cor = distance/c;
   // if (aTime>0 && cor > aTime) std::cout << " -- Problem ! Time correction is too large ";
@@ -60,10 +61,10 @@ double HGCSSCalibration::correctTime(const double & aTime,
 				     const double & vtxx,
 				     const double & vtxy,
 				     const double & vtxz){
-  double distance = sqrt(pow(posx-vtxx,2)+
-			 pow(posy-vtxy,2)+
-			 pow(posz-vtxz,2)
-			 );
+  const double dx = posx-vtxx;
+  const double dy = posy-vtxy;
+  const double dz = posz-vtxz;
+  double distance = sqrt(dx*dx+dy*dy+dz*dz);
   double c = 299.792458;//3.e8*1000./1.e9;//in mm / ns...
   double cor = distance/c;
   // if (aTime>0 && cor > aTime) std::cout << " -- Problem ! Time correction is too large ";
@@ -75,10 +76,72 @@ double HGCSSCalibration::correctTime(const double & aTime,
   return result;
 }
 
+void HGCSSCalibration::correctTime(const unsigned nHits,
+				   const double * aTime,
+				   const double * posx,
+				   const double * posy,
+				   const double * posz,
+				   double * result) const{
+  const double c = 299.792458;//in mm / ns
+  const double vx = vtx_x_;
+  const double vy = vtx_y_;
+  const double vz = vtx_z_;
+  for (unsigned iH(0); iH<nHits; ++iH){
+    const double dx = posx[iH]-vx;
+    const double dy = posy[iH]-vy;
+    const double dz = posz[iH]-vz;
+    result[iH] = aTime[iH]-sqrt(dx*dx+dy*dy+dz*dz)/c;
+  }
+}
+
+void HGCSSCalibration::fillLayerTables(){
+  layerCalib_.clear();
+  tableSource_ = detector_ ? detector_ : theDetector().description();
+  if (!tableSource_) {
+    std::cout << " -- Warning! HGCSSCalibration created before the detector was built, call setDetector() or fillLayerTables() once it is." << std::endl;
+    return;
+  }
+  const HGCSSDetectorDescription & det = *tableSource_;
+  layerCalib_.resize(det.nLayers());
+  for (unsigned iL(0); iL<det.nLayers(); ++iL){
+    LayerCalib & lc = layerCalib_[iL];
+    lc.rOut = det.type(iL) == DetectorEnum::FHCAL ? 1000 : 1200;
+    lc.rIn = det.radiusLim(iL);
+    for (unsigned iA(0); iA<2; ++iA){
+      const double res = det.mipWeight(iL)*(iA?det.absWeight(iL) : 1.0);
+      lc.base[iA] = res;
+      if (!det.isSi(iL)) {
+	lc.weight[iA][0] = lc.weight[iA][1] = lc.weight[iA][2] = res;
+      }
+      else if (bypassRadius_) {
+	lc.weight[iA][0] = lc.weight[iA][1] = lc.weight[iA][2] = res*2./nSiLayers_;
+      }
+      else {
+	lc.weight[iA][0] = res*2./3.;//300um
+	lc.weight[iA][1] = res;
+	lc.weight[iA][2] = res*2.;//100um
+      }
+    }
+  }
+}
+
+void HGCSSCalibration::tablesError() const{
+  std::cerr << " -- Error ! HGCSSCalibration tables "
+	    << (tableSource_ ? "filled from another detector description" : "not filled, the detector was not built")
+	    << ": call setDetector() or fillLayerTables() after buildDetector()." << std::endl;
+  exit(1);
+}
+
+void HGCSSCalibration::detectorError() const{
+  std::cerr << " -- Error ! HGCSSCalibration used before the detector was built:"
+	    << " call setDetector() or buildDetector() first." << std::endl;
+  exit(1);
+}
+
 double HGCSSCalibration::MeVToMip(const unsigned layer, const bool absWeight) const{
-  if (layer < theDetector().nLayers())
-    return theDetector().subDetectorByLayer(layer).mipWeight
-      *(absWeight?theDetector().subDetectorByLayer(layer).absWeight : 1.0);
+  const std::vector<LayerCalib> & lTables = layerTables();
+  if (layer < lTables.size())
+    return lTables[layer].base[absWeight];
   return 1;
 }
 
@@ -95,21 +158,29 @@ double HGCSSCalibration::MeVToMip(const unsigned layer, const bool absWeight) co
   }*/
 
 double HGCSSCalibration::MeVToMip(const unsigned layer, const double aRadius, const bool absWeight) const{
-  double res = 1;
-  if (layer < theDetector().nLayers())
-    res = theDetector().subDetectorByLayer(layer).mipWeight
-      *(absWeight?theDetector().subDetectorByLayer(layer).absWeight : 1.0);
-
-  if (theDetector().subDetectorByLayer(layer).isSi == false) return res;
-
-  if (bypassRadius_) return res*2./nSiLayers_;
+  const std::vector<LayerCalib> & lTables = layerTables();
+  if (layer >= lTables.size()) return 1;
+  const LayerCalib & lc = lTables[layer];
+  const unsigned region = aRadius>lc.rOut ? 0 : (aRadius<lc.rIn ? 2 : 1);
+  return lc.weight[absWeight][region];
+}
 
-  double r1 = 1200;
-  double r2 = theDetector().subDetectorByLayer(layer).radiusLim;
-  if (theDetector().subDetectorByLayer(layer).type == DetectorEnum::FHCAL) {
-    r1 = 1000;
+void HGCSSCalibration::MeVToMip(const unsigned nHits,
+				const unsigned * layer,
+				const double * aRadius,
+				double * result,
+				const bool absWeight) const{
+  const std::vector<LayerCalib> & lTables = layerTables();
+  const LayerCalib * lc = lTables.data();
+  const unsigned nLayers = lTables.size();
+  for (unsigned iH(0); iH<nHits; ++iH){
+    const unsigned iL = layer[iH];
+    if (iL >= nLayers) {
+      result[iH] = 1;
+      continue;
+    }
+    const double r = aRadius[iH];
+    const unsigned region = r>lc[iL].rOut ? 0 : (r<lc[iL].rIn ? 2 : 1);
+    result[iH] = lc[iL].weight[absWeight][region];
   }
-  if (aRadius>r1) return res*2./3.;//300um
-  else if (aRadius < r2) return res*2.;//100um
-  return res;
 }
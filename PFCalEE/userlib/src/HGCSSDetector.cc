@@ -1,4 +1,5 @@
 #include "HGCSSDetector.hh"
+#include "HGCSSDetectorDescription.hh"
 #include <iostream>
 
 HGCSSDetector & theDetector(){
@@ -31,7 +32,7 @@ void HGCSSDetector::buildDetector(const unsigned versionNumber,
   //if (versionNumber>=30) 
   if (!bypassRadius_) FECAL.radiusLim = 750;
   else FECAL.radiusLim = 0;
-  if (FECAL.nLayers()>0) theDetector().addSubdetector(FECAL);
+  if (FECAL.nLayers()>0) addSubdetector(FECAL);
   
   HGCSSSubDetector MECAL;
   MECAL.type = DetectorEnum::MECAL;
@@ -46,7 +47,7 @@ void HGCSSDetector::buildDetector(const unsigned versionNumber,
   //if (versionNumber>=30) 
   if (!bypassRadius_) MECAL.radiusLim = 750;
   else MECAL.radiusLim = 0;
-  if (MECAL.nLayers()>0) theDetector().addSubdetector(MECAL);
+  if (MECAL.nLayers()>0) addSubdetector(MECAL);
   
   HGCSSSubDetector BECAL;
   BECAL.type = DetectorEnum::BECAL;
@@ -61,7 +62,7 @@ void HGCSSDetector::buildDetector(const unsigned versionNumber,
   //if (versionNumber>=30) 
   if (!bypassRadius_) BECAL.radiusLim = 750;
   else BECAL.radiusLim = 0;
-  if (BECAL.nLayers()>0) theDetector().addSubdetector(BECAL);
+  if (BECAL.nLayers()>0) addSubdetector(BECAL);
   
   HGCSSSubDetector FHCAL;
   FHCAL.type = DetectorEnum::FHCAL;
@@ -85,7 +86,7 @@ void HGCSSDetector::buildDetector(const unsigned versionNumber,
     FHCAL.isScint = true;
     FHCAL.isSi = false;
   }
-  if (FHCAL.nLayers()>0) theDetector().addSubdetector(FHCAL);
+  if (FHCAL.nLayers()>0) addSubdetector(FHCAL);
   
   HGCSSSubDetector BHCAL;
   BHCAL.type = DetectorEnum::BHCAL1;
@@ -106,7 +107,7 @@ void HGCSSDetector::buildDetector(const unsigned versionNumber,
     BHCAL.gevWeight = FHCAL.gevWeight;//MIPtoGeV
     BHCAL.gevOffset = 0.0;
   }
-  if (BHCAL.nLayers()>0) theDetector().addSubdetector(BHCAL);
+  if (BHCAL.nLayers()>0) addSubdetector(BHCAL);
   
   HGCSSSubDetector BHCAL2;
   BHCAL2.type = DetectorEnum::BHCAL2;
@@ -125,9 +126,11 @@ void HGCSSDetector::buildDetector(const unsigned versionNumber,
   BHCAL2.gevOffset = 0.0;
   BHCAL2.isScint = true;
   
-  if (BHCAL2.nLayers()>0) theDetector().addSubdetector(BHCAL2);
+  if (BHCAL2.nLayers()>0) addSubdetector(BHCAL2);
   
   finishInitialisation();
+
+  description_ = std::make_shared<const HGCSSDetectorDescription>(*this,versionNumber,model);
   
 }
 
@@ -190,6 +193,7 @@ void HGCSSDetector::reset() {
   enumMap_.clear();
   indices_.clear();
   section_.clear();
+  description_.reset();
 }
 
 void HGCSSDetector::printDetector(std::ostream & aOs) const{
@@ -0,0 +1,103 @@
+#include "HGCSSDetectorDescription.hh"
+#include <map>
+#include <mutex>
+#include <tuple>
+
+std::shared_ptr<const HGCSSDetectorDescription> HGCSSDetectorDescription::get(const unsigned versionNumber,
+									      const unsigned model,
+									      bool concept,
+									      bool isCaliceHcal,
+									      bool bypassR){
+  typedef std::tuple<unsigned,unsigned,bool,bool,bool> Key;
+  static std::map<Key,std::shared_ptr<const HGCSSDetectorDescription> > lCache;
+  static std::mutex lMutex;
+
+  std::lock_guard<std::mutex> lock(lMutex);
+  Key lKey(versionNumber,model,concept,isCaliceHcal,bypassR);
+  std::map<Key,std::shared_ptr<const HGCSSDetectorDescription> >::iterator lIter = lCache.find(lKey);
+  if (lIter != lCache.end()) return lIter->second;
+
+  //private detector object, leaves theDetector() untouched
+  HGCSSDetector lDet;
+  lDet.buildDetector(versionNumber,model,concept,isCaliceHcal,bypassR);
+  lCache[lKey] = lDet.description();
+  return lDet.description();
+}
+
+HGCSSDetectorDescription::HGCSSDetectorDescription(const HGCSSDetector & aDet,
+						   const unsigned versionNumber,
+						   const unsigned model){
+  version_ = versionNumber;
+  model_ = model;
+  nLayers_ = aDet.nLayers();
+
+  for (unsigned iS(0); iS<aDet.nSections(); ++iS){
+    subdets_.push_back(aDet.subDetectorBySection(iS));
+  }
+  for (unsigned iD(0); iD<nDetEnums_; ++iD){
+    enumSection_[iD] = subdets_.size();
+  }
+  for (unsigned iS(0); iS<subdets_.size(); ++iS){
+    enumSection_[subdets_[iS].type] = iS;
+  }
+
+  section_.resize(nLayers_,0);
+  type_.resize(nLayers_,DetectorEnum::FECAL);
+  isSi_.resize(nLayers_,false);
+  isScint_.resize(nLayers_,false);
+  mipWeight_.resize(nLayers_,1);
+  absWeight_.resize(nLayers_,1);
+  radiusLim_.resize(nLayers_,0);
+  hasSensitiveZ_ = aDet.sensitiveZ_.size() >= nLayers_;
+  sensitiveZ_.resize(nLayers_,0);
+  etaBoundary_.resize(nLayers_,0);
+
+  for (unsigned iL(0); iL<nLayers_; ++iL){
+    section_[iL] = aDet.getSection(iL);
+    const HGCSSSubDetector & subdet = subdets_[section_[iL]];
+    type_[iL] = subdet.type;
+    isSi_[iL] = subdet.isSi;
+    isScint_[iL] = subdet.isScint;
+    mipWeight_[iL] = subdet.mipWeight;
+    absWeight_[iL] = subdet.absWeight;
+    radiusLim_[iL] = subdet.radiusLim;
+    if (iL<aDet.sensitiveZ_.size()) sensitiveZ_[iL] = aDet.sensitiveZ_[iL];
+    if (iL<aDet.etaBoundary_.size()) etaBoundary_[iL] = aDet.etaBoundary_[iL];
+  }
+}
+
+const HGCSSSubDetector & HGCSSDetectorDescription::subDetectorByEnum(const DetectorEnum adet) const{
+  if (!hasSubDetector(adet)){
+    std::cerr << " -- Error ! Trying to access subdetector enum not present in this detector: "
+	      << adet
+	      << std::endl;
+    exit(1);
+  }
+  return subdets_[enumSection_[adet]];
+}
+
+void HGCSSDetectorDescription::layerError(const unsigned aLayer) const{
+  std::cerr << " -- Error ! Trying to access layer " << aLayer
+	    << " outside of range. nLayers = " << nLayers_
+	    << std::endl;
+  exit(1);
+}
+
+void HGCSSDetectorDescription::Print(std::ostream & aOs) const{
+  aOs << " -------------------------- " << std::endl
+      << " -- Detector description -- " << std::endl
+      << " -------------------------- " << std::endl
+      << " - version = " << version_ << ", model = " << model_ << std::endl
+      << " - nSections = " << nSections() << std::endl
+      << " - nLayers = " << nLayers_ << std::endl;
+  for (unsigned iL(0); iL<nLayers_; ++iL){
+    aOs << " - Layer " << iL << " " << subdets_[section_[iL]].name
+	<< " mipW=" << mipWeight_[iL]
+	<< " absW=" << absWeight_[iL]
+	<< " rLim=" << radiusLim_[iL]
+	<< " z=" << sensitiveZ_[iL]
+	<< " etaB=" << etaBoundary_[iL]
+	<< std::endl;
+  }
+  aOs << " -------------------------- " << std::endl;
+}
@@ -1,4 +1,6 @@
 #include "HGCSSDigitisation.hh"
+#include "TMath.h"
+#include <algorithm>
 #include <cmath>
 #include <sstream>
 #include <iostream>
@@ -94,6 +96,29 @@ void HGCSSDigitisation::addNoise(double & aDigiE, const unsigned & alay ,
   if (print) std::cout << lNoise << " " << aDigiE << std::endl;
 }
 
+double HGCSSDigitisation::noiseTailProbability(const unsigned & alay, const double & aThresh){
+  const double sigma = noise_[alay];
+  if (sigma<=0) return aThresh>0 ? 0 : 1;
+  return 0.5*TMath::Erfc(aThresh/(sigma*sqrt(2.)));
+}
+
+unsigned HGCSSDigitisation::nNoiseAbove(const unsigned nCells, const double & p){
+  if (nCells==0 || p<=0) return 0;
+  return rndm_.Binomial(nCells,p);
+}
+
+unsigned HGCSSDigitisation::randomIndex(const unsigned n){
+  return rndm_.Integer(n);
+}
+
+double HGCSSDigitisation::tailNoise(const unsigned & alay, const double & aThresh, const double & p,
+				    TH1F * & hist){
+  //inverse of the upper tail, p*u is small so the lower quantile is precise
+  const double lNoise = std::max(aThresh,-noise_[alay]*TMath::NormQuantile(p*rndm_.Rndm()));
+  if (hist) hist->Fill(lNoise);
+  return lNoise;
+}
+
 unsigned HGCSSDigitisation::adcConverter(double eMIP, DetectorEnum adet){
   if (eMIP<0) eMIP=0;
   double eADC = static_cast<unsigned>(eMIP*mipToADC_[adet]);
@@ -0,0 +1,250 @@
+#include "HGCSSFileCatalogue.hh"
+#include "HGCSSInfo.hh"
+
+#include <algorithm>
+#include <atomic>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <thread>
+
+#include "TChain.h"
+#include "TFile.h"
+#include "TList.h"
+#include "TROOT.h"
+#include "TSystemDirectory.h"
+#include "TSystemFile.h"
+#include "TTree.h"
+
+namespace {
+  const char * treeNames[3] = {"HGCSSTree","RecoTree","PUTree"};
+  const char * statusNames[fs_N] = {"ok","unreadable","recovered","notree","empty"};
+
+  //recovered files are readable up to the last saved baskets
+  bool usable(const HGCSSFileRecord & record){
+    return (record.status==fs_OK || record.status==fs_Recovered) && record.entries>0;
+  }
+}
+
+const char * HGCSSFileCatalogue::statusName(const unsigned status){
+  return status<fs_N ? statusNames[status] : "unknown";
+}
+
+std::string HGCSSFileCatalogue::normalise(const std::string & path){
+  //urls are kept as they are, root://host//path is needed
+  if (path.find("://")!=path.npos) return path;
+  std::string result;
+  for (size_t i(0); i<path.size(); ++i){
+    if (path[i]=='/' && result.size()>0 && result[result.size()-1]=='/') continue;
+    result += path[i];
+  }
+  return result;
+}
+
+HGCSSFileRecord HGCSSFileCatalogue::scanFile(const std::string & path){
+  HGCSSFileRecord record;
+  record.path = normalise(path);
+  record.tree = "";
+  record.status = fs_Unreadable;
+  record.entries = 0;
+  record.bytes = 0;
+  record.hasInfo = false;
+  record.version = -1;
+  record.model = -1;
+  record.shape = 0;
+  record.cellSize = 0;
+
+  TFile *lFile = TFile::Open(path.c_str());
+  if (!lFile || lFile->IsZombie()) {
+    delete lFile;
+    return record;
+  }
+  record.bytes = lFile->GetSize();
+
+  TTree *lTree = 0;
+  for (unsigned iT(0); iT<3 && !lTree; ++iT){
+    lTree = dynamic_cast<TTree*>(lFile->Get(treeNames[iT]));
+    if (lTree) record.tree = treeNames[iT];
+  }
+  HGCSSInfo *lInfo = (HGCSSInfo*)lFile->Get("Info");
+  if (lInfo) {
+    record.hasInfo = true;
+    record.version = lInfo->version();
+    record.model = lInfo->model();
+    record.shape = lInfo->shape();
+    record.cellSize = lInfo->cellSize();
+    delete lInfo;
+  }
+
+  if (!lTree) record.status = fs_NoTree;
+  else {
+    record.entries = lTree->GetEntries();
+    if (record.entries==0) record.status = fs_Empty;
+    else if (lFile->TestBit(TFile::kRecovered)) record.status = fs_Recovered;
+    else record.status = fs_OK;
+  }
+  lFile->Close();
+  delete lFile;
+  return record;
+}
+
+unsigned HGCSSFileCatalogue::scan(const std::string & aDir,
+				  const std::string & pattern,
+				  const unsigned nThreads){
+  std::vector<std::string> lFiles;
+  TSystemDirectory dir(aDir.c_str(),aDir.c_str());
+  TList *files = dir.GetListOfFiles();
+  if (!files) {
+    std::cout << " -- Error, directory " << aDir << " cannot be listed." << std::endl;
+    return 0;
+  }
+  TSystemFile *file;
+  TIter next(files);
+  while ((file=(TSystemFile*)next())) {
+    if (file->IsDirectory()) continue;
+    std::string fname(file->GetName());
+    if (fname.find(".root")==fname.npos) continue;
+    if (fname.find(pattern)==fname.npos) continue;
+    lFiles.push_back(aDir+"/"+fname);
+  }
+  delete files;
+  std::sort(lFiles.begin(),lFiles.end());
+
+  //one slot per file: the order does not depend on the threads
+  std::vector<HGCSSFileRecord> lRecords(lFiles.size());
+  if (nThreads>1) {
+    ROOT::EnableThreadSafety();
+    std::atomic<unsigned> iNext(0);
+    std::vector<std::thread> threads;
+    for (unsigned iT(0); iT<nThreads; ++iT){
+      threads.push_back(std::thread([&](){
+	    for (unsigned iF=iNext++; iF<lFiles.size(); iF=iNext++){
+	      lRecords[iF] = scanFile(lFiles[iF]);
+	    }
+	  }));
+    }
+    for (unsigned iT(0); iT<nThreads; ++iT) threads[iT].join();
+  }
+  else {
+    for (unsigned iF(0); iF<lFiles.size(); ++iF){
+      lRecords[iF] = scanFile(lFiles[iF]);
+    }
+  }
+
+  for (unsigned iF(0); iF<lRecords.size(); ++iF){
+    add(lRecords[iF]);
+  }
+  return lRecords.size();
+}
+
+void HGCSSFileCatalogue::add(const HGCSSFileRecord & record){
+  std::map<std::string,unsigned>::iterator lIter = index_.find(record.path);
+  if (lIter!=index_.end()) records_[lIter->second] = record;
+  else {
+    index_[record.path] = records_.size();
+    records_.push_back(record);
+  }
+}
+
+bool HGCSSFileCatalogue::read(const std::string & fileName){
+  std::ifstream lIn(fileName.c_str());
+  if (!lIn.is_open()) {
+    std::cout << " -- Error, catalogue " << fileName << " cannot be opened." << std::endl;
+    return false;
+  }
+  std::string lLine;
+  unsigned nLine = 0;
+  while (std::getline(lIn,lLine)){
+    nLine++;
+    if (lLine.size()==0 || lLine[0]=='#') continue;
+    std::istringstream lStr(lLine);
+    HGCSSFileRecord record;
+    if (!(lStr >> record.path >> record.tree >> record.status >> record.entries >> record.bytes
+	  >> record.hasInfo >> record.version >> record.model >> record.shape >> record.cellSize)) {
+      std::cout << " -- Error, wrong format in " << fileName << " line " << nLine << ": " << lLine << std::endl;
+      return false;
+    }
+    if (record.tree=="-") record.tree = "";
+    add(record);
+  }
+  return true;
+}
+
+bool HGCSSFileCatalogue::write(const std::string & fileName) const{
+  std::ofstream lOut(fileName.c_str());
+  if (!lOut.is_open()) {
+    std::cout << " -- Error, catalogue " << fileName << " cannot be written." << std::endl;
+    return false;
+  }
+  lOut << "# path tree status entries bytes hasInfo version model shape cellSize" << std::endl;
+  for (unsigned iR(0); iR<records_.size(); ++iR){
+    const HGCSSFileRecord & record = records_[iR];
+    lOut << record.path << " "
+	 << (record.tree.size()>0 ? record.tree : "-") << " "
+	 << record.status << " "
+	 << record.entries << " "
+	 << record.bytes << " "
+	 << record.hasInfo << " "
+	 << record.version << " "
+	 << record.model << " "
+	 << record.shape << " "
+	 << std::setprecision(10) << record.cellSize << std::endl;
+  }
+  return true;
+}
+
+const HGCSSFileRecord * HGCSSFileCatalogue::find(const std::string & path) const{
+  std::map<std::string,unsigned>::const_iterator lIter = index_.find(normalise(path));
+  if (lIter==index_.end()) return 0;
+  return &records_[lIter->second];
+}
+
+bool HGCSSFileCatalogue::addFile(TChain & chain, const std::string & path) const{
+  const HGCSSFileRecord * record = find(path);
+  if (!record || !usable(*record) || record->tree!=chain.GetName()) return false;
+  //with the number of entries the file is not opened
+  chain.AddFile(path.c_str(),record->entries);
+  return true;
+}
+
+unsigned HGCSSFileCatalogue::fillChain(TChain & chain, const std::string & pattern) const{
+  unsigned nFiles = 0;
+  for (unsigned iR(0); iR<records_.size(); ++iR){
+    const HGCSSFileRecord & record = records_[iR];
+    if (!usable(record) || record.tree!=chain.GetName()) continue;
+    if (record.path.find(pattern)==record.path.npos) continue;
+    chain.AddFile(record.path.c_str(),record.entries);
+    nFiles++;
+  }
+  return nFiles;
+}
+
+bool HGCSSFileCatalogue::fillInfo(const std::string & path, HGCSSInfo & info) const{
+  const HGCSSFileRecord * record = find(path);
+  if (!record || !record->hasInfo) return false;
+  info.version(record->version);
+  info.model(record->model);
+  info.shape(record->shape);
+  info.cellSize(record->cellSize);
+  return true;
+}
+
+void HGCSSFileCatalogue::print(std::ostream & aOs) const{
+  unsigned nStatus[fs_N] = {0,0,0,0,0};
+  Long64_t nEntries = 0;
+  Long64_t nBytes = 0;
+  for (unsigned iR(0); iR<records_.size(); ++iR){
+    const HGCSSFileRecord & record = records_[iR];
+    if (record.status<fs_N) nStatus[record.status]++;
+    if (usable(record)) nEntries += record.entries;
+    nBytes += record.bytes;
+    if (record.status!=fs_OK) aOs << " -- " << statusName(record.status) << ": " << record.path << std::endl;
+  }
+  aOs << " -- " << records_.size() << " files, " << nBytes/1048576. << " MB, "
+      << nEntries << " entries in usable files." << std::endl
+      << " -- ";
+  for (unsigned iS(0); iS<fs_N; ++iS){
+    aOs << statusName(iS) << ": " << nStatus[iS] << (iS+1<fs_N ? ", " : "");
+  }
+  aOs << std::endl;
+}
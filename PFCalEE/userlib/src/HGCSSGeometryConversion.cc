@@ -2,7 +2,15 @@
 #include <sstream>
 #include <iostream>
 #include <cmath>
+#include <cstdlib>
 #include "TList.h"
+#include "Math/Point3D.h"
+
+void HGCSSGeometryConversion::detectorError() const{
+  std::cerr << " -- Error ! HGCSSGeometryConversion used before the detector was built:"
+	    << " call setDetector() or buildDetector() first." << std::endl;
+  exit(1);
+}
 
 void HGCSSGeometryConversion::convertFromEtaPhi(std::pair<double,double> & xy, const double & z){
   double theta = 2*atan(exp(-1.*xy.first));
@@ -64,7 +72,8 @@ unsigned HGCSSGeometryConversion::getNumberOfSiLayers(const DetectorEnum type,
 						      const double z,
                                                       bool realistic) const
 {
-  if (theDetector().subDetectorByEnum(type).isScint) return 3;
+  const HGCSSSubDetector & subdet = detector().subDetectorByEnum(type);
+  if (subdet.isScint) return 3;
   if (model_ != 2) return nSiLayers_;
 
   if(realistic){
@@ -85,7 +94,7 @@ unsigned HGCSSGeometryConversion::getNumberOfSiLayers(const DetectorEnum type,
   if (type == DetectorEnum::FHCAL) {
     r1 = 1000;
   }
-  double r2 = theDetector().subDetectorByEnum(type).radiusLim;
+  double r2 = subdet.radiusLim;
   if (radius>r1) return 3;
   else if (radius>r2) return 2;
   else return 1;
@@ -135,16 +144,19 @@ HGCSSGeometryConversion::~HGCSSGeometryConversion(){
 void HGCSSGeometryConversion::initialiseSquareMap(const double xymin, const double side){
   initialiseSquareMap(squareMap(),xymin,side,true);
   fillXY(squareMap(),squareGeom);
+  fillCells(squareGeom,squareCells_,false);
 }
 
 void HGCSSGeometryConversion::initialiseSquareMap1(const double xmin, const double xmax, const double ymin, const double ymax, const double side){
   initialiseSquareMap(squareMap1(),xmin,xmax,ymin,ymax,side,true);
   fillXY(squareMap1(),squareGeom1);
+  fillCells(squareGeom1,squareCells1_,true);
 }
 
 void HGCSSGeometryConversion::initialiseSquareMap2(const double xmin, const double xmax, const double ymin, const double ymax, const double side){
   initialiseSquareMap(squareMap2(),xmin,xmax,ymin,ymax,side,true);
   fillXY(squareMap2(),squareGeom2);
+  fillCells(squareGeom2,squareCells2_,true);
 }
 
 void HGCSSGeometryConversion::initialiseSquareMap(TH2Poly *map, const double xymin, const double side, bool print){
@@ -217,6 +229,7 @@ void HGCSSGeometryConversion::initialiseDiamondMap(const double & xmin, const do
   double tmpside = side/(2.*sqrt(3.));
   initialiseDiamondMap(diamondMap(),xmin,ymin,tmpside,2,true);
   fillXY(diamondMap(),diamGeom);
+  fillCells(diamGeom,diamCells_,false);
 }
 
 void HGCSSGeometryConversion::initialiseDiamondMap(TH2Poly *map, const double & xmin, const double & ymin, const double side, const unsigned nhexa, bool print){
@@ -259,6 +272,7 @@ void HGCSSGeometryConversion::initialiseDiamondMap(TH2Poly *map, const double &
 void HGCSSGeometryConversion::initialiseTriangleMap(const double xymin, const double side){
   initialiseTriangleMap(triangleMap(),xymin,side,true);
   fillXY(triangleMap(),triangleGeom);
+  fillCells(triangleGeom,triangleCells_,false);
 }
 
 void HGCSSGeometryConversion::initialiseTriangleMap(TH2Poly *map, const double xymin, const double side, bool print){
@@ -307,11 +321,13 @@ void HGCSSGeometryConversion::initialiseTriangleMap(TH2Poly *map, const double x
 void HGCSSGeometryConversion::initialiseHoneyComb(const double width, const double side){
   initialiseHoneyComb(hexagonMap(),width,side,true);
   fillXY(hexagonMap(),hexaGeom);
+  fillCells(hexaGeom,hexaCells_,false);
 }
 
 void HGCSSGeometryConversion::initialiseHoneyComb(const double width, const double side,double & xstart, double & ystart){
   initialiseHoneyComb(hexagonMap(),width,side,true,xstart,ystart);
   fillXY(hexagonMap(),hexaGeom);
+  fillCells(hexaGeom,hexaCells_,false);
 }
 
 void HGCSSGeometryConversion::initialiseHoneyComb(TH2Poly *map, const double width, const double side, bool print){
@@ -430,6 +446,66 @@ void HGCSSGeometryConversion::fillXY(TH2Poly* hist, std::map<int,std::pair<doubl
   
 }
 
+void HGCSSGeometryConversion::fillCells(const std::map<int,std::pair<double,double> > & geom,
+					std::vector<CellCentre> & aCells,
+					const bool isEtaPhi){
+  aCells.clear();
+  if (geom.size()==0) return;
+  //ids are 1-based TH2Poly bin numbers
+  if (geom.begin()->first < 0) return;
+  const unsigned maxId = geom.rbegin()->first;
+  CellCentre empty = {0,0,0,0};
+  aCells.resize(maxId+1,empty);
+  std::map<int,std::pair<double,double> >::const_iterator liter=geom.begin();
+  for ( ; liter != geom.end();++liter){
+    CellCentre & cc = aCells[liter->first];
+    if (isEtaPhi){
+      //same as convertFromEtaPhi, per unit z
+      double theta = 2*atan(exp(-1.*liter->second.first));
+      double tanTheta = sin(theta)/cos(theta);
+      cc.x = tanTheta*cos(liter->second.second);
+      cc.y = tanTheta*sin(liter->second.second);
+      cc.rho = fabs(tanTheta);
+      cc.eta = liter->second.first;
+    }
+    else {
+      cc.x = liter->second.first;
+      cc.y = liter->second.second;
+      cc.rho = sqrt(cc.x*cc.x+cc.y*cc.y);
+      cc.eta = 0;
+    }
+  }
+}
+
+const std::map<int,std::pair<double,double> > & HGCSSGeometryConversion::geomMap(const HGCSSSubDetector & subdet,
+										 const unsigned shape) const{
+  if (subdet.isScint) return subdet.type==DetectorEnum::BHCAL1 ? squareGeom1 : squareGeom2;
+  if (shape==4) return squareGeom;
+  if (shape==2) return diamGeom;
+  if (shape==3) return triangleGeom;
+  return hexaGeom;
+}
+
+std::pair<double,double> HGCSSGeometryConversion::cellXYFromMap(const HGCSSSubDetector & subdet,
+								const unsigned shape,
+								const unsigned cellid,
+								const double z) const{
+  const std::map<int,std::pair<double,double> > & geom = geomMap(subdet,shape);
+  std::map<int,std::pair<double,double> >::const_iterator liter = geom.find(cellid);
+  std::pair<double,double> xy(0,0);
+  if (liter != geom.end()) xy = liter->second;
+  if (subdet.isScint) convertFromEtaPhi(xy,z);
+  return xy;
+}
+
+double HGCSSGeometryConversion::cellEtaFromMap(const HGCSSSubDetector & subdet,
+					       const unsigned shape,
+					       const unsigned cellid,
+					       const double z) const{
+  std::pair<double,double> xy = cellXYFromMap(subdet,shape,cellid,z);
+  return ROOT::Math::XYZPoint(xy.first,xy.second,z).eta();
+}
+
 /*void HGCSSGeometryConversion::deleteHistos(std::vector<TH2Poly *> & aVec){
   if (aVec.size()!=0){
     for (unsigned iL(0); iL<aVec.size();++iL){
@@ -452,8 +528,9 @@ void HGCSSGeometryConversion::setGranularity(const std::vector<unsigned> & granu
 }
 
 double HGCSSGeometryConversion::cellSize(const unsigned aLayer, const double aR) const{
-  if (theDetector().subDetectorByLayer(aLayer).isScint){
-    if (theDetector().subDetectorByLayer(aLayer).type == DetectorEnum::BHCAL1) return 0.01745;//FH in eta-phi = 1deg in r-phi
+  const HGCSSDetectorDescription & det = detector();
+  if (det.isScint(aLayer)){
+    if (det.type(aLayer) == DetectorEnum::BHCAL1) return 0.01745;//FH in eta-phi = 1deg in r-phi
     else return 0.02182;//BH in eta-phi = 1.5deg in r-phi
     //return 20.*granularity_[aLayer];
   }
@@ -467,6 +544,12 @@ double HGCSSGeometryConversion::cellSizeInCm(const unsigned aLayer, const double
   return cellSize(aLayer, aR)/10.;
 }
 
+double HGCSSGeometryConversion::cellAreaInCm2(const unsigned aLayer, const double aR, const bool hexagon) const{
+  const double lSize = cellSizeInCm(aLayer,aR);
+  if (hexagon && !detector().isScint(aLayer)) return 1.5*sqrt(3.)*lSize*lSize;
+  return lSize*lSize;
+}
+
 void HGCSSGeometryConversion::initialiseHistos(const bool recreate,
 					       std::string uniqStr,
 					       const bool print){
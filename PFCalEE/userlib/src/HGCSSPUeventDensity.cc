@@ -0,0 +1,104 @@
+#include "HGCSSPUeventDensity.hh"
+
+#include <iostream>
+
+#include "TMath.h"
+
+HGCSSPUeventDensity::HGCSSPUeventDensity(const unsigned nLayers,
+					 const double etaMin,
+					 const double etaMax,
+					 const unsigned nEtaBins,
+					 const unsigned nPhiBins){
+  nLayers_ = nLayers;
+  etaMin_ = etaMin;
+  etaMax_ = etaMax;
+  nEta_ = nEtaBins;
+  nPhi_ = nPhiBins;
+  etaStep_ = (etaMax_-etaMin_)/nEta_;
+  phiStep_ = 2*TMath::Pi()/nPhi_;
+  excluded_.resize(nEta_*nPhi_,false);
+  exclusionUpToDate_ = true;
+  gridE_.resize(nLayers_*nEta_*nPhi_,0);
+  sumZ_.resize(nLayers_,0);
+  nZ_.resize(nLayers_,0);
+  density_.resize(nLayers_*nEta_,0);
+}
+
+void HGCSSPUeventDensity::addSignalCone(const double eta, const double phi, const double dR){
+  coneEta_.push_back(fabs(eta));
+  conePhi_.push_back(phi);
+  coneDR_.push_back(dR);
+  exclusionUpToDate_ = false;
+}
+
+void HGCSSPUeventDensity::updateExclusion(){
+  for (unsigned iEta(0); iEta<nEta_; ++iEta){
+    const double eta = etaMin_+(iEta+0.5)*etaStep_;
+    for (unsigned iPhi(0); iPhi<nPhi_; ++iPhi){
+      const double phi = -TMath::Pi()+(iPhi+0.5)*phiStep_;
+      bool lExcl = false;
+      for (unsigned iC(0); iC<coneEta_.size() && !lExcl; ++iC){
+	double dphi = phi-conePhi_[iC];
+	if (dphi<-TMath::Pi()) dphi += 2*TMath::Pi();
+	if (dphi>TMath::Pi()) dphi -= 2*TMath::Pi();
+	const double deta = eta-coneEta_[iC];
+	lExcl = deta*deta+dphi*dphi < coneDR_[iC]*coneDR_[iC];
+      }
+      excluded_[iEta*nPhi_+iPhi] = lExcl;
+    }
+  }
+  exclusionUpToDate_ = true;
+}
+
+void HGCSSPUeventDensity::fill(const std::vector<HGCSSRecoHit> & rechitvec,
+			       const bool applyPuMixFix){
+  if (!exclusionUpToDate_) updateExclusion();
+
+  for (unsigned i(0); i<gridE_.size(); ++i) gridE_[i] = 0;
+  for (unsigned iL(0); iL<nLayers_; ++iL){
+    sumZ_[iL] = 0;
+    nZ_[iL] = 0;
+  }
+
+  for (unsigned iH(0); iH<rechitvec.size(); ++iH){//loop on rechits
+    const HGCSSRecoHit & lHit = rechitvec[iH];
+    const unsigned layer = lHit.layer();
+    if (layer>=nLayers_) continue;
+    double posx = lHit.get_x();
+    double posy = lHit.get_y();
+    if (applyPuMixFix) {
+      posx-=1.25;
+      posy-=1.25;
+    }
+    const double posz = fabs(lHit.get_z());
+    const double r = sqrt(posx*posx+posy*posy);
+    if (r<=0) continue;
+    sumZ_[layer] += posz;
+    nZ_[layer]++;
+    const double eta = asinh(posz/r);
+    if (eta<etaMin_ || eta>=etaMax_) continue;
+    const unsigned iEta = static_cast<unsigned>((eta-etaMin_)/etaStep_);
+    unsigned iPhi = static_cast<unsigned>((atan2(posy,posx)+TMath::Pi())/phiStep_);
+    if (iPhi>=nPhi_) iPhi = nPhi_-1;
+    if (excluded_[iEta*nPhi_+iPhi]) continue;
+    gridE_[gridIndex(layer,iEta,iPhi)] += lHit.energy();
+  }//loop on rechits
+
+  for (unsigned iL(0); iL<nLayers_; ++iL){//loop on layers
+    const double z = nZ_[iL]>0 ? sumZ_[iL]/nZ_[iL] : 0;
+    for (unsigned iEta(0); iEta<nEta_; ++iEta){
+      double lE = 0;
+      unsigned nIncluded = 0;
+      for (unsigned iPhi(0); iPhi<nPhi_; ++iPhi){
+	if (excluded_[iEta*nPhi_+iPhi]) continue;
+	lE += gridE_[gridIndex(iL,iEta,iPhi)];
+	nIncluded++;
+      }
+      //area of one grid cell of the ring, in cm2
+      const double rLow = z/sinh(etaMin_+iEta*etaStep_)/10.;
+      const double rHigh = z/sinh(etaMin_+(iEta+1)*etaStep_)/10.;
+      const double area = nIncluded*phiStep_/2.*(rLow*rLow-rHigh*rHigh);
+      density_[iL*nEta_+iEta] = area>0 ? lE/area : 0;
+    }
+  }//loop on layers
+}
@@ -136,29 +136,7 @@ void HGCSSSimHit::Add(const G4SiHit & aSiHit){
 std::pair<double,double> HGCSSSimHit::get_xy(const HGCSSSubDetector & subdet,
 					     const HGCSSGeometryConversion & aGeom,
 					     const unsigned shape) const {
-  if (subdet.isScint){
-    std::pair<double,double> etaphi = subdet.type==DetectorEnum::BHCAL1?aGeom.squareGeom1.find(cellid_)->second : aGeom.squareGeom2.find(cellid_)->second;
-    //convert back to x-y
-    double theta = 2*atan(exp(-1.*etaphi.first));
-    double phi = etaphi.second;
-    double r = zpos_/cos(theta);
-    double x = r*sin(theta)*cos(phi);
-    double y = r*sin(theta)*sin(phi);
-
-    //std::cout << " -- check scint hit: zpos " << zpos_ << " cellid_=" << cellid_ 
-    //<< " eta=" << etaphi.first 
-    //<< " theta=" << theta << " phi=" << phi 
-    //<< " x=" << x << " y=" << y << std::endl;
-
-    return std::pair<double,double>(x,y);
-  }
-  else if (shape==4) return aGeom.squareGeom.find(cellid_)->second;
-  else {
-    if (shape==2) return aGeom.diamGeom.find(cellid_)->second;
-    else if (shape==3) return aGeom.triangleGeom.find(cellid_)->second;
-    else return aGeom.hexaGeom.find(cellid_)->second;
-  }
-
+  return aGeom.cellXY(subdet,shape,cellid_,zpos_);
 }
 
 ROOT::Math::XYZPoint HGCSSSimHit::position(const HGCSSSubDetector & subdet,
@@ -177,7 +155,7 @@ double HGCSSSimHit::theta(const HGCSSSubDetector & subdet,
 double HGCSSSimHit::eta(const HGCSSSubDetector & subdet,
 			const HGCSSGeometryConversion & aGeom,
 			const unsigned shape) const {
-  return position(subdet,aGeom,shape).eta();
+  return aGeom.cellEta(subdet,shape,cellid_,zpos_);
 }
 
 double HGCSSSimHit::phi(const HGCSSSubDetector & subdet,
@@ -0,0 +1,57 @@
+#include<string>
+#include<vector>
+#include<iostream>
+#include <boost/algorithm/string.hpp>
+#include "boost/program_options.hpp"
+
+#include "HGCSSFileCatalogue.hh"
+
+namespace po=boost::program_options;
+
+//Index of the files of production directories, to build chains without
+//opening the files (catalogue option of the digitizer and analyses).
+//./bin/catalogue -i <dir1>,<dir2> -o <index> [-p HGcal_] [-t 8] [-u]
+int main(int argc, char** argv){//main
+
+  std::string inDirs;
+  std::string outFile;
+  std::string pattern;
+  unsigned nThreads;
+  bool update;
+
+  po::options_description config("Configuration");
+  config.add_options()
+    ("help,h", "print the options")
+    ("inDirs,i",   po::value<std::string>(&inDirs)->required())
+    ("outFile,o",  po::value<std::string>(&outFile)->required())
+    ("pattern,p",  po::value<std::string>(&pattern)->default_value(""))
+    ("threads,t",  po::value<unsigned>(&nThreads)->default_value(8))
+    ("update,u",   po::value<bool>(&update)->default_value(false)->implicit_value(true))
+    ;
+  po::variables_map vm;
+  po::store(po::command_line_parser(argc, argv).options(config).run(), vm);
+  if (vm.count("help")) {
+    std::cout << config << std::endl;
+    return 0;
+  }
+  po::notify(vm);
+
+  HGCSSFileCatalogue catalogue;
+  //keep the records of the other directories
+  if (update && !catalogue.read(outFile)) return 1;
+
+  std::vector<std::string> lDirs;
+  boost::split(lDirs,inDirs,boost::is_any_of(","));
+  for (unsigned iD(0); iD<lDirs.size(); ++iD){
+    if (lDirs[iD].size()==0) continue;
+    std::cout << " -- Scanning " << lDirs[iD] << " with " << nThreads << " threads..." << std::flush;
+    const unsigned nFiles = catalogue.scan(lDirs[iD],pattern,nThreads);
+    std::cout << " " << nFiles << " files." << std::endl;
+  }
+
+  catalogue.print();
+  if (!catalogue.write(outFile)) return 1;
+  std::cout << " -- Catalogue written to " << outFile << std::endl;
+  return 0;
+
+}//main
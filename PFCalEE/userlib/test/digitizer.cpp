@@ -1,5 +1,10 @@
 #include<string>
 #include<set>
+#include<thread>
+#include<atomic>
+#include<chrono>
+#include<iomanip>
+#include<algorithm>
 #include<iostream>
 #include<fstream>
 #include<sstream>
@@ -19,6 +24,8 @@
 #include "TCanvas.h"
 #include "TStyle.h"
 #include "TRandom3.h"
+#include "TROOT.h"
+#include "TObjString.h"
 #include "Math/Vector4D.h"
 
 #include "TSystemDirectory.h"
@@ -34,7 +41,9 @@
 #include "HGCSSCalibration.hh"
 #include "HGCSSDigitisation.hh"
 #include "HGCSSDetector.hh"
+#include "HGCSSDetectorDescription.hh"
 #include "HGCSSGeometryConversion.hh"
+#include "HGCSSFileCatalogue.hh"
 
 using namespace fastjet;
 
@@ -193,9 +202,69 @@ void processHist(const unsigned iL,
 }//processHist
 */
 
-void processHist(const unsigned iL,
+//projective eta-phi towers summing rechits over all layers,
+//used as jet inputs instead of the individual rechits.
+struct JetTowers {
+  double etaMin;
+  double etaMax;
+  double deta;
+  double dphi;
+  double threshold;
+  unsigned nEta;
+  unsigned nPhi;
+  std::vector<double> energy;
+  std::vector<unsigned> filled;
+
+  void initialise(const double aEtaMin, const double aEtaMax,
+		  const double aDeta, const double aDphi,
+		  const double aThreshold){
+    etaMin = aEtaMin;
+    etaMax = aEtaMax;
+    nEta = std::max(1,static_cast<int>(ceil((etaMax-etaMin)/aDeta-1e-9)));
+    nPhi = std::max(1,static_cast<int>(ceil(2*TMath::Pi()/aDphi-1e-9)));
+    deta = (etaMax-etaMin)/nEta;
+    dphi = 2*TMath::Pi()/nPhi;
+    threshold = aThreshold;
+    energy.assign(nEta*nPhi,0);
+    filled.clear();
+  };
+
+  //hits outside the eta range go to the first/last ring
+  inline void add(const double eta, const double phi, const double E){
+    int iEta = static_cast<int>(floor((eta-etaMin)/deta));
+    iEta = std::min(std::max(iEta,0),static_cast<int>(nEta)-1);
+    double lphi = phi<0 ? phi+2*TMath::Pi() : phi;
+    unsigned iPhi = std::min(static_cast<unsigned>(lphi/dphi),nPhi-1);
+    unsigned idx = iEta*nPhi+iPhi;
+    if (energy[idx]==0) filled.push_back(idx);
+    energy[idx] += E;
+  };
+
+  //massless pseudojet at the centre of each tower above threshold, then reset
+  void fillParticles(std::vector<PseudoJet> & lParticles){
+    for (unsigned i(0); i<filled.size(); ++i){
+      const unsigned idx = filled[i];
+      const double E = energy[idx];
+      energy[idx] = 0;
+      if (E<=threshold) continue;
+      const double eta = etaMin+(idx/nPhi+0.5)*deta;
+      const double phi = (idx%nPhi+0.5)*dphi;
+      const double pt = E/cosh(eta);
+      lParticles.push_back(PseudoJet(pt*cos(phi),pt*sin(phi),pt*sinh(eta),E));
+    }
+    filled.clear();
+  };
+};
+
+//Digitise the cells of the map. With noiseCells (acceptance of layer iL, sorted),
+//the cells of the list missing from the map are pure noise: the number above
+//threshold is drawn from the Gaussian tail and only those are digitised, unless
+//the tail probability exceeds tailMaxFraction. Returns the number of pure noise cells
+//digitised (tail: saved above threshold).
+unsigned processHist(const unsigned iL,
 		 std::map<unsigned,MergeCells> & histE,
-		 std::map<int,std::pair<double,double> > & geom,
+		 const HGCSSGeometryConversion & geomConv,
+		 const unsigned shape,
 		 HGCSSDigitisation & myDigitiser,
 		 TH1F* & p_noise,
 		 //const TH2Poly* histZ,
@@ -207,7 +276,10 @@ void processHist(const unsigned iL,
 		 HGCSSRecoHitVec & lDigiHits,
 		 HGCSSRecoHitVec & lRecoHits,
 		 const bool pMakeJets,
-		 std::vector<PseudoJet> & lParticles
+		 std::vector<PseudoJet> & lParticles,
+		 JetTowers * towers=0,
+		 const std::vector<unsigned> * noiseCells=0,
+		 const double tailMaxFraction=0
 		 ){
 
   bool doSaturation=false;//true;
@@ -216,22 +288,39 @@ void processHist(const unsigned iL,
   bool isScint = subdet.isScint;
   bool isSi = subdet.isSi;
   //double rLim = subdet.radiusLim;
-  std::map<unsigned,MergeCells>::iterator lIter = histE.begin();
-  for (; lIter!=histE.end();++lIter){//loop on elements of the map
-    //bin numbering starts at 1....
-    //get bin number of map element iele
-    unsigned iB = lIter->first;
-    //cut overflows: very large IDs from the TH2Poly.
-    if(iB>4000000000) continue;
-    std::pair<double,double> xy = geom[iB];
-    if (isScint) HGCSSGeometryConversion::convertFromEtaPhi(xy,meanZpos);
+  double posz = meanZpos;
+
+  auto saveHit = [&](const unsigned iB, const double digiE, const unsigned adc,
+		     const double hitTime, const double noiseFrac){
+    std::pair<double,double> xy = geomConv.cellXY(subdet,shape,iB,meanZpos);
+    //double calibE = myDigitiser.MIPtoGeV(subdet,digiE);
+    HGCSSRecoHit lRecHit;
+    lRecHit.layer(iL);
+    lRecHit.energy(digiE);
+    lRecHit.time(hitTime);
+    lRecHit.adcCounts(adc);
+    lRecHit.x(xy.first);
+    lRecHit.y(xy.second);
+    lRecHit.z(posz);
+    lRecHit.noiseFraction(noiseFrac);
+    //unsigned x_cell = static_cast<unsigned>(fabs(x)/(cellSize*granularity[iL]));
+    //unsigned y_cell = static_cast<unsigned>(fabs(y)/(cellSize*granularity[iL]));
+    //lRecHit.encodeCellId(x>0,y>0,x_cell,y_cell,granularity[iL]);
+
+    if (pSaveDigis) lDigiHits.push_back(lRecHit);
+
+    lRecoHits.push_back(lRecHit);
+
+    if (pMakeJets && posz>0){
+      if (towers) towers->add(lRecHit.eta(),lRecHit.phi(),lRecHit.E());
+      else lParticles.push_back( PseudoJet(lRecHit.px(),lRecHit.py(),lRecHit.pz(),lRecHit.E()));
+    }
+  };
+
+  //full digitisation of one cell, signal and noise
+  auto digitiseCell = [&](const unsigned iB, const double simE, const double hitTime){
     double digiE = 0;
-    double simE = lIter->second.energy;
-    double hitTime = simE>0 ? lIter->second.time/simE : 0;
 
-    //double time = 0;
-    //if (simE>0) time = histE[iele].time/simE;
-    
     //fill vector with neighbours and calculate cross-talk
     double xtalkE = simE;
     //CAMM @TODO
@@ -245,32 +334,20 @@ void processHist(const unsigned iL,
       simEvec.push_back(histE->GetBinContent(histE->FindBin(x,y+side)));
       xtalkE = myDigitiser.ipXtalk(simEvec);
       }*/
-      
-    //bool passTime = myDigitiser.passTimeCut(adet,time);
-    //if (!passTime) continue;
-      
-    double posz = meanZpos;
-    //for noise only hits
-    //if (simE>0) posz = histZ->GetBinContent(iX,iY)/simE;
-    //else posz = meanZpos;
-    
-    
-    //if (fabs(x) > 500 || fabs(y)>500) std::cout << " x=" << x << ", y=" << y << std::endl;
-    
-    
+
     //correct for particle angle in conversion to MIP
     //not necessary, if not done for aborber thickness either
     double simEcor = xtalkE;//isTBsetup ? xtalkE : myDigitiser.mipCor(xtalkE,x,y,posz);
     digiE = simEcor;
-    
+
     if (isScint && simEcor>0 && doSaturation) {
       digiE = myDigitiser.digiE(simEcor);
     }
     myDigitiser.addNoise(digiE,iL,p_noise);
-    
+
     double noiseFrac = 1.0;
     if (simEcor>0) noiseFrac = (digiE-simEcor)/simEcor;
-    
+
     ////for silicon-based Calo
     unsigned adc = 0;
     //if (isSi){
@@ -280,37 +357,753 @@ void processHist(const unsigned iL,
     bool aboveThresh = adc >= pThreshInADC[iL];//digiE > 0.5;
     //(isSi && adc >= pThreshInADC[iL]) ||
     //(isScint && digiE >= pThreshInADC[iL]*myDigitiser.adcToMIP(1,adet,false));
-    //histE->SetBinContent(iX,iY,digiE);
     if ((!pSaveDigis && aboveThresh) ||
 	pSaveDigis)
-      {//save hits
-	//double calibE = myDigitiser.MIPtoGeV(subdet,digiE);
-	HGCSSRecoHit lRecHit;
-	lRecHit.layer(iL);
-	lRecHit.energy(digiE);
-	lRecHit.time(hitTime);
-	lRecHit.adcCounts(adc);
-	lRecHit.x(xy.first);
-	lRecHit.y(xy.second);
-	lRecHit.z(posz);
-	lRecHit.noiseFraction(noiseFrac);
-	//unsigned x_cell = static_cast<unsigned>(fabs(x)/(cellSize*granularity[iL]));
-	//unsigned y_cell = static_cast<unsigned>(fabs(y)/(cellSize*granularity[iL]));
-	//lRecHit.encodeCellId(x>0,y>0,x_cell,y_cell,granularity[iL]);
-	
-	if (pSaveDigis) lDigiHits.push_back(lRecHit);
-	
-	lRecoHits.push_back(lRecHit);
-	
-	if (pMakeJets){
-	  if (posz>0) lParticles.push_back( PseudoJet(lRecHit.px(),lRecHit.py(),lRecHit.pz(),lRecHit.E()));
-	}
-	
-      }//save hits
+      saveHit(iB,digiE,adc,hitTime,noiseFrac);
+  };
+
+  std::map<unsigned,MergeCells>::iterator lIter = histE.begin();
+  for (; lIter!=histE.end();++lIter){//loop on elements of the map
+    //bin numbering starts at 1....
+    //get bin number of map element iele
+    unsigned iB = lIter->first;
+    //cut overflows: very large IDs from the TH2Poly.
+    if(iB>4000000000) continue;
+    double simE = lIter->second.energy;
+    double hitTime = simE>0 ? lIter->second.time/simE : 0;
+    digitiseCell(iB,simE,hitTime);
   }//loop on bins
-     
+
+  if (!noiseCells) return 0;
+
+  //pure noise cells
+  const std::vector<unsigned> & lCells = *noiseCells;
+  const unsigned thresh = pThreshInADC[iL];
+  const double threshMIP = myDigitiser.adcToMIP(thresh,adet,false);
+  const double p = myDigitiser.noiseTailProbability(iL,threshMIP);
+  if (thresh==0 || p>tailMaxFraction){
+    //a large fraction passes: full noise in each cell
+    unsigned nNoise = 0;
+    for (unsigned iC(0); iC<lCells.size(); ++iC){
+      if (histE.find(lCells[iC])!=histE.end()) continue;
+      digitiseCell(lCells[iC],0,0);
+      nNoise++;
+    }
+    return nNoise;
+  }
+
+  unsigned nEmpty = lCells.size();
+  for (lIter = histE.begin(); lIter!=histE.end();++lIter){
+    if (std::binary_search(lCells.begin(),lCells.end(),lIter->first)) nEmpty--;
+  }
+  const unsigned nAbove = myDigitiser.nNoiseAbove(nEmpty,p);
+  //ids uniform among the empty cells of the acceptance
+  std::set<unsigned> lChosen;
+  unsigned nRedraw = 0;
+  while (lChosen.size()<nAbove){
+    const unsigned iB = lCells[myDigitiser.randomIndex(lCells.size())];
+    if (histE.find(iB)!=histE.end() || lChosen.find(iB)!=lChosen.end()) continue;
+    double digiE = myDigitiser.tailNoise(iL,threshMIP,p,p_noise);
+    unsigned adc = myDigitiser.adcConverter(digiE,adet);
+    //rounded below the threshold: drawn again, the cell stays free
+    if (adc<thresh) {
+      if (++nRedraw>100*nAbove) break;
+      continue;
+    }
+    lChosen.insert(iB);
+    digiE = myDigitiser.adcToMIP(adc,adet);
+    saveHit(iB,digiE,adc,0,1.0);
+  }
+  return lChosen.size();
+
 }//processHist
 
+//seed of the RNG stream "stream" for event ievt: splitmix64 finaliser,
+//never 0 since TRandom3::SetSeed(0) would seed from the clock.
+unsigned eventSeed(const unsigned pSeed, const unsigned ievt, const unsigned stream){
+  ULong64_t z = (static_cast<ULong64_t>(pSeed)<<32 | ievt) + 0x9E3779B97F4A7C15ULL*(stream+1);
+  z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+  z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+  z = z ^ (z >> 31);
+  unsigned seed = static_cast<unsigned>(z ^ (z >> 32));
+  return seed==0 ? 1 : seed;
+}
+
+//one digitisation setting of a multi-configuration job (--digiConfigs):
+//noise, thresholds and intercalibration applied to the same cell maps.
+struct DigiConfig {
+  std::string name;
+  std::string noiseStr;
+  std::string threshStr;
+  unsigned interCalib;
+  std::vector<double> noiseInMips;
+  std::vector<unsigned> threshInADC;
+};
+
+//One configuration per line: name [noiseStr=...] [threshStr=...] [interCalib=...],
+//missing settings are taken from defaults. Empty lines and # comments are skipped.
+bool readDigiConfigs(const std::string & fileName,
+		     const DigiConfig & defaults,
+		     std::vector<DigiConfig> & configs){
+  std::ifstream lIn(fileName.c_str());
+  if (!lIn.is_open()) {
+    std::cout << " -- Error, configuration list " << fileName << " cannot be opened." << std::endl;
+    return false;
+  }
+  std::string lLine;
+  while (std::getline(lIn,lLine)){
+    if (lLine.find("#")!=lLine.npos) lLine = lLine.substr(0,lLine.find("#"));
+    std::istringstream lStr(lLine);
+    DigiConfig lConfig = defaults;
+    if (!(lStr >> lConfig.name)) continue;
+    std::string lToken;
+    while (lStr >> lToken){
+      const size_t pos = lToken.find("=");
+      const std::string key = lToken.substr(0,pos);
+      const std::string value = pos==lToken.npos ? "" : lToken.substr(pos+1);
+      if (key=="noiseStr") lConfig.noiseStr = value;
+      else if (key=="threshStr") lConfig.threshStr = value;
+      else if (key=="interCalib") std::istringstream(value)>>lConfig.interCalib;
+      else {
+	std::cout << " -- Error, unknown setting " << lToken << " for configuration " << lConfig.name << std::endl;
+	return false;
+      }
+    }
+    for (unsigned iC(0); iC<configs.size(); ++iC){
+      if (configs[iC].name==lConfig.name) {
+	std::cout << " -- Error, configuration " << lConfig.name << " defined twice." << std::endl;
+	return false;
+      }
+    }
+    configs.push_back(lConfig);
+  }
+  if (configs.empty()) std::cout << " -- Error, no configuration in " << fileName << std::endl;
+  return !configs.empty();
+}
+
+//read-only settings shared by all workers
+struct DigiSettings {
+  std::shared_ptr<const HGCSSDetectorDescription> det;
+  unsigned debug;
+  unsigned shape;
+  unsigned nLayers;
+  unsigned nPU;
+  unsigned nPuEvts;
+  bool signalIsPu;
+  //one premixed PU event per signal event
+  bool premix;
+  bool doEtaSel;
+  double etamean;
+  double deta;
+  bool addNoiseHits;
+  //pure noise cells sampled from the tail above threshold
+  bool tailNoise;
+  double noiseTailMaxFraction;
+  //cells of each layer where noise is simulated, sorted
+  std::vector<std::vector<unsigned> > noiseCells;
+  bool isTBsetup;
+  bool pSaveDigis;
+  bool pSaveSims;
+  bool pMakeJets;
+  bool jetTowers;
+  double towerEtaMin;
+  double towerEtaMax;
+  double towerDeta;
+  double towerDphi;
+  double towerThresh;
+  const double * outerScintBoundary;
+  std::vector<DigiConfig> configs;
+  JetDefinition jet_def;
+};
+
+//simhits passing the geometry cuts, calibrated together
+struct SimHitBatch {
+  std::vector<unsigned> idx;
+  std::vector<unsigned> layer;
+  std::vector<double> x;
+  std::vector<double> y;
+  std::vector<double> z;
+  std::vector<double> radius;
+  std::vector<double> time;
+  std::vector<double> mipWeight;
+  std::vector<double> realtime;
+  void clear(){
+    idx.clear();
+    layer.clear();
+    x.clear();
+    y.clear();
+    z.clear();
+    radius.clear();
+    time.clear();
+  };
+};
+
+//per-event cost of each processing stage, summed over the job for the throughput report
+enum DigiStage {
+  st_Read=0,
+  st_Signal=1,
+  st_PU=2,
+  st_Noise=3,
+  st_Digitise=4,
+  st_Jets=5,
+  st_Write=6,
+  st_N=7
+};
+const char* digiStageName[st_N] = {"read","signal","pu","noise","digitise","jets","write"};
+//what the count of each stage is
+const char* digiStageUnit[st_N] = {"simhits","simhits","simhits","cells","cells","inputs","recohits"};
+
+typedef std::chrono::steady_clock DigiClock;
+inline double secondsSince(const DigiClock::time_point & start){
+  return std::chrono::duration<double>(DigiClock::now()-start).count();
+}
+
+struct DigiStageStats {
+  double seconds[st_N];
+  unsigned long long counts[st_N];
+  unsigned long long bytesRead;
+  unsigned long long bytesWritten;
+  void reset(){
+    for (unsigned iS(0); iS<st_N; ++iS){
+      seconds[iS] = 0;
+      counts[iS] = 0;
+    }
+    bytesRead = 0;
+    bytesWritten = 0;
+  };
+  void add(const DigiStageStats & other){
+    for (unsigned iS(0); iS<st_N; ++iS){
+      seconds[iS] += other.seconds[iS];
+      counts[iS] += other.counts[iS];
+    }
+    bytesRead += other.bytesRead;
+    bytesWritten += other.bytesWritten;
+  };
+};
+
+//premixed PU event of the library (--premixOut, --premixPath): summed cell maps
+//of nPuVtx minbias events, in MIPs before noise. Cells of layer iL are the
+//entries [layerEnd[iL-1],layerEnd[iL]), time is the energy-weighted mean.
+struct PremixEvent {
+  unsigned nPuVtx;
+  std::vector<unsigned> *layerEnd;
+  std::vector<unsigned> *cellid;
+  std::vector<float> *energy;
+  std::vector<float> *time;
+  PremixEvent(const PremixEvent &) = delete;
+  PremixEvent & operator=(const PremixEvent &) = delete;
+  PremixEvent():
+    nPuVtx(0),
+    layerEnd(new std::vector<unsigned>()),
+    cellid(new std::vector<unsigned>()),
+    energy(new std::vector<float>()),
+    time(new std::vector<float>())
+  {};
+  ~PremixEvent(){
+    delete layerEnd;
+    delete cellid;
+    delete energy;
+    delete time;
+  };
+  void branch(TTree *tree){
+    tree->Branch("nPuVtx",&nPuVtx);
+    tree->Branch("layerEnd",&layerEnd);
+    tree->Branch("cellid",&cellid);
+    tree->Branch("energy",&energy);
+    tree->Branch("time",&time);
+  };
+  void setBranchAddress(TTree *tree){
+    tree->SetBranchAddress("nPuVtx",&nPuVtx);
+    tree->SetBranchAddress("layerEnd",&layerEnd);
+    tree->SetBranchAddress("cellid",&cellid);
+    tree->SetBranchAddress("energy",&energy);
+    tree->SetBranchAddress("time",&time);
+  };
+};
+
+//mutable per-worker state: cell maps, vertex, RNG, PU input.
+//digitiser applies the time cut, digitisers/p_noise are per configuration.
+struct DigiWorkspace {
+  HGCSSGeometryConversion geomConv;
+  HGCSSCalibration calib;
+  HGCSSDigitisation digitiser;
+  std::vector<HGCSSDigitisation> digitisers;
+  TChain *puTree;
+  std::vector<HGCSSSimHit> * puhitvec;
+  std::vector<TH1F*> p_noise;
+  std::vector<PseudoJet> particles;
+  SimHitBatch batch;
+  JetTowers towers;
+  //premixed PU library, instead of puTree
+  TChain *premixTree;
+  PremixEvent *premix;
+};
+
+//output of one configuration for one event
+struct DigiOutput {
+  HGCSSRecoHitVec digiHits;
+  HGCSSRecoHitVec recoHits;
+  HGCSSRecoJetVec caloJets;
+};
+
+//input and output of one event
+struct DigiEvent {
+  unsigned ievt;
+  HGCSSEvent event;
+  unsigned nPuVtx;
+  HGCSSSimHitVec hits;
+  HGCSSSimHitVec simHits;
+  std::vector<DigiOutput> outputs;
+  //printout, flushed in event order by the main thread
+  std::string log;
+  DigiStageStats stats;
+};
+
+//Select hits in acceptance, calibrate them in one batch, then fill the cell maps.
+//Hits with energy>0 and a valid cellid are copied to savedSims if given.
+void addSimHits(const std::vector<HGCSSSimHit> & hits,
+		DigiWorkspace & ws,
+		const DigiSettings & cfg,
+		std::ostringstream & log,
+		HGCSSSimHitVec * savedSims=0){
+
+  SimHitBatch & b = ws.batch;
+  b.clear();
+  for (unsigned iH(0); iH<hits.size(); ++iH){//loop on hits
+    const HGCSSSimHit & lHit = hits[iH];
+    if (lHit.energy()<=0) continue;
+    if(lHit.cellid()>4000000000) continue;
+    //do not save hits with 0 energy...
+    if (savedSims) savedSims->push_back(lHit);
+
+    unsigned layer = lHit.layer();
+    const HGCSSSubDetector & subdet = cfg.det->subDetectorByLayer(layer);
+    if (cfg.debug > 1 && subdet.isScint) log << " - layer " << layer << " " << subdet.name << " " << layer-subdet.layerIdMin << std::endl;
+
+    if (cfg.doEtaSel){
+      bool passeta = fabs(lHit.eta(subdet,ws.geomConv,cfg.shape)-cfg.etamean)<cfg.deta;
+      if (!passeta) continue;
+    }
+
+    std::pair<double,double> xy = lHit.get_xy(subdet,ws.geomConv,cfg.shape);
+    double posz = lHit.get_z();
+    double radius = sqrt(xy.first*xy.first+xy.second*xy.second);
+    if (lHit.silayer() >= ws.geomConv.getNumberOfSiLayers(subdet.type,radius,posz)) continue;
+    b.idx.push_back(iH);
+    b.layer.push_back(layer);
+    b.x.push_back(xy.first);
+    b.y.push_back(xy.second);
+    b.z.push_back(posz);
+    b.radius.push_back(radius);
+    b.time.push_back(lHit.time());
+  }//loop on hits
+
+  const unsigned nHits = b.idx.size();
+  b.mipWeight.resize(nHits);
+  b.realtime.resize(nHits);
+  ws.calib.MeVToMip(nHits,b.layer.data(),b.radius.data(),b.mipWeight.data());
+  ws.calib.correctTime(nHits,b.time.data(),b.x.data(),b.y.data(),b.z.data(),b.realtime.data());
+
+  for (unsigned i(0); i<nHits; ++i){
+    const HGCSSSimHit & lHit = hits[b.idx[i]];
+    const unsigned layer = b.layer[i];
+    double energy = lHit.energy()*b.mipWeight[i];
+    double realtime = b.realtime[i];
+    bool passTime = ws.digitiser.passTimeCut(cfg.det->type(layer),realtime);
+    if (!passTime || energy<=0) continue;
+    if (cfg.debug > 1) log << " hit " << b.idx[i]
+			   << " lay " << layer
+			   << " x " << b.x[i]
+			   << " y " << b.y[i]
+			   << " z " << b.z[i]
+			   << " t " << lHit.time() << " " << realtime
+			   << std::endl;
+    ws.geomConv.fill(layer,energy,realtime,lHit.cellid(),b.z[i]);
+  }
+}
+
+//copy the cell maps filled with PU only into the library event
+void fillPremixEvent(const unsigned nPuVtx,
+		     DigiWorkspace & ws,
+		     const DigiSettings & cfg,
+		     PremixEvent & premix){
+  premix.nPuVtx = nPuVtx;
+  premix.layerEnd->clear();
+  premix.cellid->clear();
+  premix.energy->clear();
+  premix.time->clear();
+  for (unsigned iL(0); iL<cfg.nLayers; ++iL){//loop on layers
+    const std::map<unsigned,MergeCells> & histE = ws.geomConv.get2DHist(iL);
+    std::map<unsigned,MergeCells>::const_iterator lIter = histE.begin();
+    for (; lIter!=histE.end();++lIter){
+      if (lIter->second.energy<=0) continue;
+      premix.cellid->push_back(lIter->first);
+      premix.energy->push_back(lIter->second.energy);
+      premix.time->push_back(lIter->second.time/lIter->second.energy);
+    }
+    premix.layerEnd->push_back(premix.cellid->size());
+  }//loop on layers
+}
+
+//cells of each layer in the acceptance of the noise-only hits: eta ring if
+//saving only one eta ring, physical bounds of the detector otherwise.
+void fillNoiseAcceptance(DigiSettings & cfg,
+			 HGCSSGeometryConversion & geomConv){
+  const HGCSSDetectorDescription & myDetector = *cfg.det;
+  cfg.noiseCells.assign(cfg.nLayers,std::vector<unsigned>());
+  for (unsigned iL(0); iL<cfg.nLayers; ++iL){//loop on layers
+    const HGCSSSubDetector & subdet = myDetector.subDetectorByLayer(iL);
+    bool isScint = subdet.isScint;
+    unsigned nBins = geomConv.geomMap(subdet,cfg.shape).size();
+    double meanZpos = myDetector.sensitiveZ(iL);
+    double etaBoundary = myDetector.etaBoundary(iL);
+    for (unsigned iB(1); iB<nBins+1;++iB){
+      double eta = geomConv.cellEta(subdet,cfg.shape,iB,meanZpos);
+      bool passeta = eta>1.3 && eta<3.0;
+      if (cfg.doEtaSel) passeta = fabs(eta-cfg.etamean)<cfg.deta;
+      else {
+	if (isScint) passeta = eta>cfg.outerScintBoundary[iL] && eta<=etaBoundary; // only simulate noise within the physical bounds of the detector
+	else passeta = eta>etaBoundary && eta<3.0;
+      }
+      if (passeta) cfg.noiseCells[iL].push_back(iB);
+    }
+  }//loop on layers
+}
+
+//signal+PU overlay in the cell maps, extended with the noise-only cells.
+//Does not depend on the configuration: done once per event.
+void fillCellMaps(DigiEvent & evt,
+		  DigiWorkspace & ws,
+		  const DigiSettings & cfg,
+		  TRandom3 & puRndm,
+		  std::ostringstream & log){
+
+  const HGCSSDetectorDescription & myDetector = *cfg.det;
+  ws.calib.setVertex(evt.event.vtx_x(),evt.event.vtx_y(),evt.event.vtx_z());
+  DigiStageStats & stats = evt.stats;
+
+  DigiClock::time_point tStage = DigiClock::now();
+  addSimHits(evt.hits,ws,cfg,log,cfg.pSaveSims?&evt.simHits:0);
+  stats.seconds[st_Signal] += secondsSince(tStage);
+  stats.counts[st_Signal] += evt.hits.size();
+
+  evt.nPuVtx = 0;
+  tStage = DigiClock::now();
+  if (cfg.premix){
+    const Long64_t nPremix = ws.premixTree->GetEntries();
+    const Long64_t ipremix = puRndm.Integer(nPremix);
+    const int nBytes = ws.premixTree->GetEntry(ipremix);
+    if (nBytes>0) stats.bytesRead += nBytes;
+    const PremixEvent & lPremix = *ws.premix;
+    evt.nPuVtx = lPremix.nPuVtx;
+    log << " -- Adding premixed event " << ipremix << " with " << evt.nPuVtx << " events to signal event: " << evt.ievt << std::endl;
+    unsigned iCell = 0;
+    for (unsigned iL(0); iL<lPremix.layerEnd->size() && iL<cfg.nLayers; ++iL){
+      const double posz = myDetector.sensitiveZ(iL);
+      for (; iCell<(*lPremix.layerEnd)[iL]; ++iCell){
+	ws.geomConv.fill(iL,(*lPremix.energy)[iCell],(*lPremix.time)[iCell],(*lPremix.cellid)[iCell],posz);
+      }
+    }
+    stats.counts[st_PU] += lPremix.cellid->size();
+  }
+  else if(cfg.nPU!=0){
+    //get PU events
+    //get poisson <140>
+    evt.nPuVtx = puRndm.Poisson(cfg.nPU);
+    if (cfg.signalIsPu) evt.nPuVtx -= 1;
+    log << " -- Adding " << evt.nPuVtx << " events to signal event: " << evt.ievt << std::endl;
+    std::set<unsigned> lidxSet;
+    for (unsigned iV(0); iV<evt.nPuVtx; ++iV){//loop on interactions
+      unsigned ipuevt = 0;
+      while (1){
+	ipuevt = puRndm.Integer(cfg.nPuEvts);
+	if (lidxSet.find(ipuevt)==lidxSet.end()){
+	  lidxSet.insert(ipuevt);
+	  break;
+	}
+	else {
+	  log << " -- Found duplicate ! Taking another shot." << std::endl;
+	}
+      }
+      const int nBytes = ws.puTree->GetEntry(ipuevt);
+      if (nBytes>0) stats.bytesRead += nBytes;
+      addSimHits(*ws.puhitvec,ws,cfg,log);
+      stats.counts[st_PU] += ws.puhitvec->size();
+    }//loop on interactions
+  }//add PU
+  stats.seconds[st_PU] += secondsSince(tStage);
+
+  if (cfg.debug>0) {
+    log << " **DEBUG** simhits = " << evt.hits.size() << " " << evt.simHits.size() << std::endl;
+  }
+
+  //create hits, everywhere to have also pure noise
+  //with tailNoise the empty cells are sampled in processHist instead
+  tStage = DigiClock::now();
+  for (unsigned iL(0); iL<cfg.nLayers; ++iL){//loop on layers
+    std::map<unsigned,MergeCells> & histE = ws.geomConv.get2DHist(iL);
+    const HGCSSSubDetector & subdet = myDetector.subDetectorByLayer(iL);
+
+    //double meanZpos = geomConv.getAverageZ(iL);
+    double meanZpos = myDetector.sensitiveZ(iL);
+    //extend map to include all cells in eta=1.4-3 region
+    if (cfg.addNoiseHits && !cfg.tailNoise) {
+      const unsigned nCellsBefore = histE.size();
+      const std::vector<unsigned> & lCells = cfg.noiseCells[iL];
+      MergeCells tmpCell;
+      tmpCell.energy = 0;
+      tmpCell.time = 0;
+      for (unsigned iC(0); iC<lCells.size();++iC){
+	histE.insert(std::pair<unsigned,MergeCells>(lCells[iC],tmpCell));
+      }
+      stats.counts[st_Noise] += histE.size()-nCellsBefore;
+    }
+
+    if (cfg.debug>0){
+      log << " -- Layer " << iL << " " << subdet.name << " z=" << meanZpos
+	  << " bins = " << ws.geomConv.geomMap(subdet,cfg.shape).size() << " histE entries = " << histE.size() << std::endl;
+    }
+  }//loop on layers
+  stats.seconds[st_Noise] += secondsSince(tStage);
+}
+
+//digitise, apply threshold and make jets from the filled cell maps
+//with the settings of configuration iC.
+void digitiseCells(DigiEvent & evt,
+		   DigiWorkspace & ws,
+		   const DigiSettings & cfg,
+		   const unsigned iC,
+		   std::ostringstream & log){
+
+  const HGCSSDetectorDescription & myDetector = *cfg.det;
+  const DigiConfig & config = cfg.configs[iC];
+  HGCSSDigitisation & digitiser = ws.digitisers[iC];
+  DigiOutput & out = evt.outputs[iC];
+  DigiStageStats & stats = evt.stats;
+  if (cfg.configs.size()>1) log << " -- Configuration " << config.name << std::endl;
+
+  DigiClock::time_point tStage = DigiClock::now();
+  unsigned nTotBins = 0;
+  for (unsigned iL(0); iL<cfg.nLayers; ++iL){//loop on layers
+    std::map<unsigned,MergeCells> & histE = ws.geomConv.get2DHist(iL);
+    const HGCSSSubDetector & subdet = myDetector.subDetectorByLayer(iL);
+    const unsigned shape = cfg.shape;
+
+    nTotBins += ws.geomConv.geomMap(subdet,shape).size();
+    if (cfg.pSaveDigis) out.digiHits.reserve(nTotBins);
+
+    double meanZpos = myDetector.sensitiveZ(iL);
+
+    //cell-to-cell cross-talk for scintillator
+    if (subdet.isScint){
+      //2.5% per 30-mm edge
+      //myDigitiser.setIPCrossTalk(0.025*geomConv.cellSize(iL,0)/30.);
+    }
+    else {
+      digitiser.setIPCrossTalk(0);
+    }
+
+    stats.counts[st_Digitise] += histE.size();
+    stats.counts[st_Digitise] += processHist(iL,histE,ws.geomConv,shape,digitiser,ws.p_noise[iC],meanZpos,cfg.isTBsetup,subdet,config.threshInADC,cfg.pSaveDigis,out.digiHits,out.recoHits,cfg.pMakeJets,ws.particles,cfg.jetTowers?&ws.towers:0,
+					     cfg.tailNoise?&cfg.noiseCells[iL]:0,cfg.noiseTailMaxFraction);
+
+  }//loop on layers
+  stats.seconds[st_Digitise] += secondsSince(tStage);
+
+  if (cfg.debug) {
+    log << " **DEBUG** sim-digi-reco hits = " << evt.hits.size() << "-" << out.digiHits.size() << "-" << out.recoHits.size() << std::endl;
+  }
+
+  if (cfg.pMakeJets){//pMakeJets
+
+    tStage = DigiClock::now();
+    if (cfg.jetTowers) {
+      ws.towers.fillParticles(ws.particles);
+      if (cfg.debug) log << " -- " << ws.particles.size() << " towers above " << cfg.towerThresh << " MIPs." << std::endl;
+    }
+    // run the clustering, extract the jets
+    ClusterSequence cs(ws.particles, cfg.jet_def);
+    std::vector<PseudoJet> jets = sorted_by_pt(cs.inclusive_jets());
+    stats.counts[st_Jets] += ws.particles.size();
+
+    // print the jets
+    log <<   "-- evt " << evt.ievt << ": found " << jets.size() << " Jets." << std::endl;
+    for (unsigned i = 0; i < jets.size(); i++) {
+      const PseudoJet & lFastJet = jets[i];
+      //TOFIX // inverted y and z...
+      HGCSSRecoJet ljet(lFastJet.px(),
+			lFastJet.py(),
+			lFastJet.pz(),
+			lFastJet.E());
+      if (lFastJet.has_constituents()) ljet.nConstituents(lFastJet.constituents().size());
+      if (lFastJet.has_area()){
+	ljet.area(lFastJet.area());
+	ljet.area_error(lFastJet.area_error());
+      }
+
+      out.caloJets.push_back(ljet);
+      log << " -------- jet " << i << ": "
+	  << lFastJet.E() << " "
+	  << lFastJet.perp() << " "
+	  << lFastJet.rap() << " " << lFastJet.phi() << " "
+	  << lFastJet.constituents().size() << std::endl;
+    }
+    stats.seconds[st_Jets] += secondsSince(tStage);
+
+  }//pMakeJets
+
+  ws.particles.clear();
+}
+
+//signal+PU overlay once, then digitisation and jets for each configuration.
+//Only touches ws and evt, so events can run concurrently on different workspaces.
+void digitiseEvent(DigiEvent & evt,
+		   DigiWorkspace & ws,
+		   const DigiSettings & cfg,
+		   TRandom3 & puRndm){
+
+  std::ostringstream log;
+  fillCellMaps(evt,ws,cfg,puRndm,log);
+  evt.outputs.resize(cfg.configs.size());
+  for (unsigned iC(0); iC<cfg.configs.size(); ++iC){
+    digitiseCells(evt,ws,cfg,iC,log);
+  }
+  ws.geomConv.initialiseHistos();
+  evt.log = log.str();
+}
+
+
+//end of job table. With threads, stage times are summed over workers
+//and can exceed the wall time of the event loop.
+void printThroughput(const DigiStageStats & stats,
+		     const unsigned nEvts,
+		     const unsigned nThreads,
+		     const double wallSeconds){
+  double totSeconds = 0;
+  for (unsigned iS(0); iS<st_N; ++iS) totSeconds += stats.seconds[iS];
+  std::cout << " ----------------------------------------" << std::endl
+	    << " -- Throughput: " << nEvts << " events in " << wallSeconds << " s";
+  if (nThreads>0) std::cout << " with " << nThreads << " threads";
+  std::cout << ", " << (wallSeconds>0 ? nEvts/wallSeconds : 0) << " events/s" << std::endl
+	    << std::setw(10) << "stage"
+	    << std::setw(12) << "time (s)"
+	    << std::setw(8) << "%"
+	    << std::setw(12) << "ms/event"
+	    << std::setw(14) << "count"
+	    << std::setw(10) << "unit"
+	    << std::setw(14) << "count/s"
+	    << std::endl;
+  for (unsigned iS(0); iS<st_N; ++iS){
+    std::cout << std::setw(10) << digiStageName[iS]
+	      << std::setw(12) << std::setprecision(4) << stats.seconds[iS]
+	      << std::setw(8) << std::setprecision(3) << (totSeconds>0 ? 100.*stats.seconds[iS]/totSeconds : 0)
+	      << std::setw(12) << std::setprecision(4) << (nEvts>0 ? 1000.*stats.seconds[iS]/nEvts : 0)
+	      << std::setw(14) << stats.counts[iS]
+	      << std::setw(10) << digiStageUnit[iS]
+	      << std::setw(14) << std::setprecision(4) << (stats.seconds[iS]>0 ? stats.counts[iS]/stats.seconds[iS] : 0)
+	      << std::endl;
+  }
+  std::cout << " -- Read " << stats.bytesRead/1.e6 << " MB, wrote " << stats.bytesWritten/1.e6
+	    << " MB (uncompressed), " << (wallSeconds>0 ? stats.counts[st_Signal]/wallSeconds : 0) << " signal simhits/s" << std::endl
+	    << " ----------------------------------------" << std::endl;
+}
+
+//machine-readable copy of the throughput table, one entry per stage,
+//written to the current directory
+void writeTimingTree(const DigiStageStats & stats,
+		     const unsigned nEvts,
+		     const unsigned nThreads,
+		     const double loopSeconds){
+  TTree *timingTree = new TTree("DigiTimingTree","digitizer stage timers");
+  std::string stageName;
+  std::string stageUnit;
+  double stageSeconds = 0;
+  ULong64_t stageCount = 0;
+  unsigned nEvtsOut = nEvts;
+  unsigned nThreadsOut = nThreads;
+  double wallSeconds = loopSeconds;
+  ULong64_t bytesRead = stats.bytesRead;
+  ULong64_t bytesWritten = stats.bytesWritten;
+  timingTree->Branch("stage",&stageName);
+  timingTree->Branch("unit",&stageUnit);
+  timingTree->Branch("seconds",&stageSeconds);
+  timingTree->Branch("count",&stageCount);
+  timingTree->Branch("nEvents",&nEvtsOut);
+  timingTree->Branch("nThreads",&nThreadsOut);
+  timingTree->Branch("wallSeconds",&wallSeconds);
+  timingTree->Branch("bytesRead",&bytesRead);
+  timingTree->Branch("bytesWritten",&bytesWritten);
+  for (unsigned iS(0); iS<st_N; ++iS){
+    stageName = digiStageName[iS];
+    stageUnit = digiStageUnit[iS];
+    stageSeconds = stats.seconds[iS];
+    stageCount = stats.counts[iS];
+    timingTree->Fill();
+  }
+  timingTree->Write();
+}
+
+//settings the premixed cell maps depend on, besides the geometry,
+//stored as "PremixSettings" in the library files
+std::string premixSettings(const unsigned nPU,
+			   const unsigned nSiLayers,
+			   const double etamean,
+			   const double deta){
+  std::ostringstream lStr;
+  lStr << "nPU=" << nPU << " nSiLayers=" << nSiLayers
+       << " etamean=" << etamean << " deta=" << deta;
+  return lStr.str();
+}
+
+//the library must have been made with the geometry of the signal,
+//returns the <PU> of the library, 0 if it cannot be used.
+unsigned checkPremixLibrary(const std::string & fileName,
+			    const HGCSSInfo & info,
+			    const std::string & settings){
+  TFile *lFile = TFile::Open(fileName.c_str());
+  if (!lFile) {
+    std::cout << " -- Error, premixed PU file " << fileName << " cannot be opened." << std::endl;
+    return 0;
+  }
+  HGCSSInfo *lInfo = (HGCSSInfo*)lFile->Get("Info");
+  TObjString *lSettings = (TObjString*)lFile->Get("PremixSettings");
+  unsigned nPU = 0;
+  if (!lInfo || !lSettings) {
+    std::cout << " -- Error, " << fileName << " is not a premixed PU library." << std::endl;
+  }
+  else if (lInfo->version()!=info.version() || lInfo->model()!=info.model() || lInfo->shape()!=info.shape()) {
+    std::cout << " -- Error, premixed PU library for version " << lInfo->version()
+	      << " model " << lInfo->model() << " shape " << lInfo->shape()
+	      << ", signal is version " << info.version()
+	      << " model " << info.model() << " shape " << info.shape() << std::endl;
+  }
+  else {
+    std::string lStr = lSettings->GetString().Data();
+    std::istringstream(lStr.substr(lStr.find("=")+1))>>nPU;
+    //same settings apart from the number of PU
+    if (lStr.substr(lStr.find(" "))!=settings.substr(settings.find(" "))) {
+      std::cout << " -- WARNING! Premixed PU library made with " << lStr
+		<< ", job settings are " << settings << std::endl;
+    }
+    std::cout << " -- Premixed PU library " << fileName << ": " << lStr << std::endl;
+  }
+  lFile->Close();
+  delete lFile;
+  return nPU;
+}
+
+//output file of one configuration and the branch buffers of its RecoTree
+struct DigiOutputFile {
+  TFile *file;
+  TTree *tree;
+  TH1F *p_noise;
+  HGCSSEvent event;
+  unsigned nPuVtx;
+  HGCSSSimHitVec simHits;
+  HGCSSRecoHitVec digiHits;
+  HGCSSRecoHitVec recoHits;
+  HGCSSRecoJetVec caloJets;
+};
 
 int main(int argc, char** argv){//main  
 
@@ -327,20 +1120,32 @@ int main(int argc, char** argv){//main
   std::string noiseStr;//noise (in Mips) layer_i-layer_j:factor,layer:factor,...
   std::string threshStr;//threshold (in ADC counts) layer_i-layer_j:factor,layer:factor,...
   unsigned interCalib;//intercalib factor in %
+  std::string digiConfigs;//file with a list of named noise/threshold/intercalib configurations
   unsigned nSiLayers;//Number of si layers for TB setups
   unsigned nPU;//number of PU to overlay
   std::string puPath;
+  std::string puCatalogue;//file catalogue of puPath (bin/catalogue): PU chain built without opening the files
+  std::string premixOut;//write a library of pNevts premixed PU events to this file instead of digitising
+  std::string premixPath;//premixed PU library (wildcards allowed), overlaid instead of nPU minbias events
   //for selecting a ring in eta - for noise studies.
   double etamean;//ring etamean (default=0=no eta sel)
   double deta;//ring +/- delta eta value
   //remove noise hits everywhere to speed up processing, e.g. for muons.
   bool addNoiseHits;
+  //sample only the pure noise cells above threshold
+  bool noiseTail;
+  double noiseTailMaxFraction;//full noise in layers where a larger fraction passes
 
   unsigned pSeed ;
   unsigned debug;
   bool pSaveDigis;
   bool pSaveSims;
   bool pMakeJets;
+  bool jetTowers;
+  double towerDeta;
+  double towerDphi;
+  double towerThresh;
+  unsigned nThreads;//0: single RNG stream, N: N workers with per-event RNG streams
  
   po::options_description preconfig("Configuration"); 
   preconfig.add_options()("cfg,c",po::value<std::string>(&cfg)->required());
@@ -356,17 +1161,28 @@ int main(int argc, char** argv){//main
     ("noiseStr",      po::value<std::string>(&noiseStr)->required())
     ("threshStr",     po::value<std::string>(&threshStr)->required())
     ("interCalib",    po::value<unsigned>(&interCalib)->default_value(3))
+    ("digiConfigs",   po::value<std::string>(&digiConfigs)->default_value(""))
     ("nSiLayers",     po::value<unsigned>(&nSiLayers)->default_value(2))
     ("nPU",           po::value<unsigned>(&nPU)->default_value(0))
     ("puPath",        po::value<std::string>(&puPath)->default_value(""))
+    ("puCatalogue",   po::value<std::string>(&puCatalogue)->default_value(""))
+    ("premixOut",     po::value<std::string>(&premixOut)->default_value(""))
+    ("premixPath",    po::value<std::string>(&premixPath)->default_value(""))
     ("etamean",       po::value<double>(&etamean)->default_value(0))
     ("deta",          po::value<double>(&deta)->default_value(10))
     ("addNoiseHits,a",po::value<bool>(&addNoiseHits)->default_value(true))
+    ("noiseTail",     po::value<bool>(&noiseTail)->default_value(false))
+    ("noiseTailMaxFraction",po::value<double>(&noiseTailMaxFraction)->default_value(0.05))
     ("pSeed,s",       po::value<unsigned>(&pSeed)->default_value(0))
     ("debug,d",       po::value<unsigned>(&debug)->default_value(0))
     ("pSaveDigis",    po::value<bool>(&pSaveDigis)->default_value(false))
     ("pSaveSims",     po::value<bool>(&pSaveSims)->default_value(false))
     ("pMakeJets",     po::value<bool>(&pMakeJets)->default_value(false))
+    ("jetTowers",     po::value<bool>(&jetTowers)->default_value(false))
+    ("towerDeta",     po::value<double>(&towerDeta)->default_value(0.087))
+    ("towerDphi",     po::value<double>(&towerDphi)->default_value(0.087))
+    ("towerThresh",   po::value<double>(&towerThresh)->default_value(0))
+    ("threads,t",     po::value<unsigned>(&nThreads)->default_value(0))
     ;
 
   po::store(po::command_line_parser(argc, argv).options(config).allow_unregistered().run(), vm);
@@ -380,6 +1196,14 @@ int main(int argc, char** argv){//main
     std::cout << " -- Error! Missing full path to minbias file. Exiting." << std::endl;
     return 1;
   }
+  if (premixOut.size()>0 && (nPU==0 || pNevts==0)) {
+    std::cout << " -- Error! Premixing needs nPU, puPath and the number of premixed events pNevts. Exiting." << std::endl;
+    return 1;
+  }
+  if (premixPath.size()>0 && (nPU>0 || premixOut.size()>0)) {
+    std::cout << " -- Error! With premixPath the PU is taken from the library, nPU must be 0. Exiting." << std::endl;
+    return 1;
+  }
 
   std::cout << " ----------------------------------------" << std::endl
             << " -- Input parameters: " << std::endl
@@ -393,9 +1217,12 @@ int main(int argc, char** argv){//main
             << " -- noise: " << noiseStr << std::endl
             << " -- thresholds: " << threshStr << std::endl
             << " -- intercalibration factor (in %): " << interCalib << std::endl
+            << " -- configurations: " << (digiConfigs.size()>0 ? digiConfigs : "single") << std::endl
 	    << " -- number of Si layers: " << nSiLayers << std::endl
             << " -- number of PU: " << nPU << std::endl
 	    << " -- pu file path: " << puPath << std::endl
+	    << " -- premixed pu: " << (premixPath.size()>0 ? premixPath : "none") << std::endl
+	    << " -- noise hits: " << (addNoiseHits ? (noiseTail ? "tail sampled" : "all cells") : "none") << std::endl
     ;
 
 
@@ -419,6 +1246,11 @@ int main(int argc, char** argv){//main
   if (pSaveDigis) std::cout << " -- DigiHits are saved." << std::endl;
   if (pSaveSims) std::cout << " -- SimHits are saved." << std::endl;
   if (pMakeJets) std::cout << " -- Making jets." << std::endl;
+  if (pMakeJets && jetTowers) std::cout << " -- Jet inputs are eta-phi towers of " << towerDeta << "x" << towerDphi << " above " << towerThresh << " MIPs." << std::endl;
+  if (nThreads>0) {
+    std::cout << " -- Running with " << nThreads << " threads, random streams seeded per event." << std::endl;
+    ROOT::EnableThreadSafety();
+  }
   std::cout << " ----------------------------------------" << std::endl;
   
   //////////////////////////////////////////////////////////
@@ -430,6 +1262,8 @@ int main(int argc, char** argv){//main
   // choose a jet definition
   double R = 0.5;
   JetDefinition jet_def(antikt_algorithm, R);
+  //O(N^2) tiled clustering suits the few thousand towers per event
+  if (jetTowers) jet_def = JetDefinition(antikt_algorithm, R, E_scheme, N2Tiled);
 
   // define the outer edge of the scint layers
   double outerScintBoundary [69] = { 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
@@ -502,10 +1336,13 @@ int main(int argc, char** argv){//main
   bool signalIsPu = false;
 
   TChain *puTree = new TChain("HGCSSTree");
-  unsigned nPuVtx = 0;
   unsigned nPuEvts = 0;
-  std::vector<HGCSSSimHit> * puhitvec = 0;
+  std::vector<TString> puFiles;
+  //entries of each file, TTree::kMaxEntries if not catalogued
+  std::vector<Long64_t> puEntries;
+  HGCSSFileCatalogue catalogue;
   if(nPU!=0){
+    if (puCatalogue.size()>0 && !catalogue.read(puCatalogue)) return 1;
     
     TString localMountPuPath(puPath.c_str());
     localMountPuPath.ReplaceAll("root://eoscms/","");
@@ -525,19 +1362,42 @@ int main(int argc, char** argv){//main
       if( !fname.Contains(lversion) ) continue;
       if(  fname.Contains("Digi") ) continue;
       TString puInput(localMountPuPath+"/"+fname);
-      if (puInput==inFilePath.c_str()) {
+      if (puInput==inFilePath.c_str() && premixOut.size()==0) {
         std::cout << " -- duplicate: file already used as signal. Removing." << std::endl; 
         signalIsPu = true;
         continue;
       }
-      puTree->AddFile(puInput);
+      const HGCSSFileRecord * record = catalogue.find(puInput.Data());
+      if (catalogue.addFile(*puTree,puInput.Data())) puEntries.push_back(record->entries);
+      else if (record) {
+	std::cout << " -- Skipping MinBias file " << puInput << ": " << HGCSSFileCatalogue::statusName(record->status) << std::endl;
+	continue;
+      }
+      else {
+	puTree->AddFile(puInput);
+	puEntries.push_back(TTree::kMaxEntries);
+      }
+      puFiles.push_back(puInput);
       std::cout << "Adding MinBias file:" << puInput << std::endl;
     }
 
-    puTree->SetBranchAddress("HGCSSSimHitVec",&puhitvec);
     nPuEvts = puTree->GetEntries();
     std::cout << "- Number of PU events available: " << nPuEvts  << std::endl;
   }
+
+  TChain *premixTree = 0;
+  if (premixPath.size()>0){
+    premixTree = new TChain("PremixTree");
+    premixTree->Add(premixPath.c_str());
+    if (premixTree->GetNtrees()==0 || premixTree->GetEntries()==0) {
+      std::cout << " -- Error, no premixed PU events in " << premixPath << ". Exiting..." << std::endl;
+      return 1;
+    }
+    const unsigned nPremixPU = checkPremixLibrary(premixTree->GetListOfFiles()->At(0)->GetTitle(),*info,
+						  premixSettings(0,nSiLayers,etamean,deta));
+    if (nPremixPU==0) return 1;
+    std::cout << "- Number of premixed PU events available: " << premixTree->GetEntries() << " with <PU>=" << nPremixPU << std::endl;
+  }
   /////////////////////////////////////////////////////////////
   //input signal tree
   /////////////////////////////////////////////////////////////
@@ -574,10 +1434,18 @@ int main(int argc, char** argv){//main
   HGCSSCalibration mycalib(inFilePath,bypassR,nSiLayers);
 
   const unsigned nLayers = myDetector.nLayers();
+  //read-only copy shared by all workers
+  std::shared_ptr<const HGCSSDetectorDescription> detDescription = myDetector.description();
+  if (!detDescription->hasSensitiveZ()){
+    std::cout << " ERROR! No sensitive z positions defined for version " << versionNumber << " model " << model << ". Exiting..." << std::endl;
+    return 1;
+  }
+  mycalib.setDetector(detDescription);
 
   HGCSSGeometryConversion geomConv(model,cellSize,bypassR,nSiLayers);
   geomConv.setXYwidth(calorSizeXY);
   geomConv.setVersion(versionNumber);
+  geomConv.setDetector(detDescription);
   //const double xWidth = geomConv.getXYwidth();
 
   if (shape==2) geomConv.initialiseDiamondMap(calorSizeXY,10.);
@@ -592,98 +1460,206 @@ int main(int argc, char** argv){//main
   geomConv.initialiseSquareMap2(1.3,3.0,-1.*TMath::Pi(),TMath::Pi(),TMath::Pi()*2./288.);//eta phi segmentation, hardcoded '1.3' to include outer edge fo BH
   //geomConv.initialiseSquareMap2(1.4,3.0,0,2*TMath::Pi(),0.02618);//eta phi segmentation
 
+  //time cut, shared by all configurations
   HGCSSDigitisation myDigitiser;
-  myDigitiser.setIntercalibrationFactor(interCalib);
-  std::cout << " -- Intercalibration factor set to (%): " << interCalib << std::endl;
 
   std::vector<unsigned> granularity;
   granularity.resize(nLayers,1);
-  std::vector<double> pNoiseInMips;
-  pNoiseInMips.resize(nLayers,0.12);
-  std::vector<unsigned> pThreshInADC;
-  pThreshInADC.resize(nLayers,5);
-
   extractParameterFromStr<std::vector<unsigned> >(granulStr,granularity);
-  extractParameterFromStr<std::vector<double> >(noiseStr,pNoiseInMips);
-  extractParameterFromStr<std::vector<unsigned> >(threshStr,pThreshInADC);
 
-  //unsigned nbCells = 0;
+  //the cell maps are shared: granularity, nSiLayers and PU are common to all configurations
+  std::vector<DigiConfig> configs;
+  DigiConfig defaultConfig;
+  defaultConfig.noiseStr = noiseStr;
+  defaultConfig.threshStr = threshStr;
+  defaultConfig.interCalib = interCalib;
+  if (digiConfigs.size()==0) configs.push_back(defaultConfig);
+  else if (!readDigiConfigs(digiConfigs,defaultConfig,configs)) return 1;
+
+  //each configuration has its own digitiser, seeded as a single configuration job
+  std::vector<HGCSSDigitisation> digitisers;
+  for (unsigned iC(0); iC<configs.size(); ++iC){
+    DigiConfig & config = configs[iC];
+    config.noiseInMips.resize(nLayers,0.12);
+    config.threshInADC.resize(nLayers,5);
+    extractParameterFromStr<std::vector<double> >(config.noiseStr,config.noiseInMips);
+    extractParameterFromStr<std::vector<unsigned> >(config.threshStr,config.threshInADC);
+
+    //unsigned nbCells = 0;
+
+    if (doEtaSel){
+      for (unsigned iL(0); iL<nLayers; ++iL){
+	config.noiseInMips[iL] = 0;
+	config.threshInADC[iL] = 1;
+      }
+    }
 
-  if (doEtaSel){
+    HGCSSDigitisation lDigitiser;
+    lDigitiser.setIntercalibrationFactor(config.interCalib);
+    if (configs.size()>1) std::cout << " -- Configuration " << config.name << ":" << std::endl;
+    std::cout << " -- Intercalibration factor set to (%): " << config.interCalib << std::endl;
+
+    std::cout << " -- Granularities and noise are setup like this:" << std::endl;
     for (unsigned iL(0); iL<nLayers; ++iL){
-      pNoiseInMips[iL] = 0;
-      pThreshInADC[iL] = 1;
+      std::cout << "Layer " ;
+      if (iL<10) std::cout << " ";
+      std::cout << iL << " : " << granularity[iL] << ", " << config.noiseInMips[iL] << " mips, " << config.threshInADC[iL] << " adc - ";
+      if (iL%5==4) std::cout << std::endl;
+      lDigitiser.setNoise(iL,config.noiseInMips[iL]);
+      //nbCells += N_CELLS_XY_MAX/(granularity[iL]*granularity[iL]);
     }
+    std::cout << std::endl;
+    //std::cout << " -- Total number of cells = " << nbCells << std::endl;
+    lDigitiser.setRandomSeed(pSeed);
+    digitisers.push_back(lDigitiser);
   }
 
-  std::cout << " -- Granularities and noise are setup like this:" << std::endl;
-  for (unsigned iL(0); iL<nLayers; ++iL){
-    std::cout << "Layer " ;
-    if (iL<10) std::cout << " ";
-    std::cout << iL << " : " << granularity[iL] << ", " << pNoiseInMips[iL] << " mips, " << pThreshInADC[iL] << " adc - ";
-    if (iL%5==4) std::cout << std::endl;
-    myDigitiser.setNoise(iL,pNoiseInMips[iL]);
-    //nbCells += N_CELLS_XY_MAX/(granularity[iL]*granularity[iL]);
-  }
-  std::cout << std::endl;     
-  //std::cout << " -- Total number of cells = " << nbCells << std::endl;
-
   geomConv.setGranularity(granularity);
   geomConv.initialiseHistos();
 
   TRandom3 *lRndm = new TRandom3();
   lRndm->SetSeed(pSeed);
-  myDigitiser.setRandomSeed(pSeed);
 
   std::cout << " -- Random3 seed = " << lRndm->GetSeed() << std::endl
 	    << " ----------------------------------------" << std::endl;
 
 
+  DigiSettings settings;
+  settings.det = detDescription;
+  settings.debug = debug;
+  settings.shape = shape;
+  settings.nLayers = nLayers;
+  settings.nPU = nPU;
+  settings.nPuEvts = nPuEvts;
+  settings.signalIsPu = signalIsPu;
+  settings.premix = premixTree!=0;
+  settings.doEtaSel = doEtaSel;
+  settings.etamean = etamean;
+  settings.deta = deta;
+  settings.addNoiseHits = addNoiseHits;
+  //the digis need the noise of every cell
+  settings.tailNoise = noiseTail && addNoiseHits && !pSaveDigis;
+  settings.noiseTailMaxFraction = noiseTailMaxFraction;
+  settings.isTBsetup = isTBsetup;
+  settings.pSaveDigis = pSaveDigis;
+  settings.pSaveSims = pSaveSims;
+  settings.pMakeJets = pMakeJets;
+  settings.outerScintBoundary = outerScintBoundary;
+  settings.configs = configs;
+  settings.jet_def = jet_def;
+  settings.jetTowers = jetTowers;
+  settings.towerEtaMin = 1.3;
+  settings.towerEtaMax = 3.0;
+  settings.towerDeta = towerDeta;
+  settings.towerDphi = towerDphi;
+  settings.towerThresh = towerThresh;
+  if (addNoiseHits) fillNoiseAcceptance(settings,geomConv);
+  if (noiseTail && !settings.tailNoise) std::cout << " -- noiseTail ignored: needs addNoiseHits and no pSaveDigis." << std::endl;
+
+  //job totals of the stage timers
+  DigiStageStats jobStats;
+  jobStats.reset();
+
   /////////////////////////////////////////////////////////////
   //output
   /////////////////////////////////////////////////////////////
 
-  std::ostringstream outputStr;
-  outputStr << outFilePath << "/DigiPFcal" ;
-  //if (doEtaSel) {
-  //outputStr << "_eta" << (etamean-deta) << "_" << (etamean+deta);
-  //}
-  if (pSaveDigis)  outputStr << "_withDigiHits";
-  if (pSaveSims)  outputStr << "_withSimHits";
-  outputStr << ".root";
-  
-  TFile *outputFile = TFile::Open(outputStr.str().c_str(),"RECREATE");
-
-  if (!outputFile) {
-    std::cout << " -- Error, output file " << outputStr.str() << " cannot be opened. Exiting..." << std::endl;
-    return 1;
-  }
-  else {
-    std::cout << " -- File will be saved as " << outputStr.str() << std::endl;
-  }
-
   HGCSSInfo *lInfo = new HGCSSInfo();
   lInfo->calorSizeXY(calorSizeXY);
   lInfo->cellSize(cellSize);
   lInfo->version(versionNumber);
   lInfo->model(model);
   lInfo->shape(shape);
-  TTree *outputTree = new TTree("RecoTree","HGC Standalone simulation reco tree");
-  HGCSSSimHitVec lSimHits;
-  HGCSSRecoHitVec lDigiHits;
-  HGCSSRecoHitVec lRecoHits;
-  HGCSSRecoJetVec lCaloJets;
-  unsigned maxSimHits = 0;
-  unsigned maxRecHits = 0;
-  unsigned maxRecJets = 0;
-  HGCSSEvent lEvent;
-  outputTree->Branch("HGCSSEvent",&lEvent);
-  if (nPU!=0) outputTree->Branch("nPuVtx",&nPuVtx);
-  if (pSaveSims) outputTree->Branch("HGCSSSimHitVec","std::vector<HGCSSSimHit>",&lSimHits);
-  if (pSaveDigis) outputTree->Branch("HGCSSDigiHitVec","std::vector<HGCSSRecoHit>",&lDigiHits);
-  outputTree->Branch("HGCSSRecoHitVec","std::vector<HGCSSRecoHit>",&lRecoHits);
-  if (pMakeJets) outputTree->Branch("HGCSSRecoJetVec","std::vector<HGCSSRecoJet>",&lCaloJets);
-  TH1F * p_noise = new TH1F("noiseCheck",";noise (MIPs)",100,-5,5);
+
+  if (premixOut.size()>0){
+    //premixed PU library: cell maps of the PU only, before noise and ADC
+    settings.addNoiseHits = false;
+    settings.signalIsPu = false;
+    TFile *premixFile = TFile::Open(premixOut.c_str(),"RECREATE");
+    if (!premixFile) {
+      std::cout << " -- Error, output file " << premixOut << " cannot be opened. Exiting..." << std::endl;
+      return 1;
+    }
+    std::cout << " -- Premixed PU library of " << pNevts << " events will be saved as " << premixOut << std::endl;
+    TTree *premixOutTree = new TTree("PremixTree","HGC premixed PU cell maps");
+    PremixEvent premix;
+    premix.branch(premixOutTree);
+
+    DigiWorkspace ws = {geomConv,mycalib,myDigitiser,digitisers,puTree,0,std::vector<TH1F*>(),std::vector<PseudoJet>(),SimHitBatch(),JetTowers(),0,0};
+    puTree->SetBranchAddress("HGCSSSimHitVec",&ws.puhitvec);
+    //time of flight corrected for the nominal vertex
+    DigiEvent evt;
+    evt.event.vtx_x(0);
+    evt.event.vtx_y(0);
+    evt.event.vtx_z(0);
+    DigiClock::time_point tLoop = DigiClock::now();
+    for (unsigned ievt(0); ievt<pNevts; ++ievt){//loop on premixed events
+      evt.stats.reset();
+      evt.ievt = ievt;
+      evt.event.eventNumber(ievt);
+      std::ostringstream log;
+      fillCellMaps(evt,ws,settings,*lRndm,log);
+      fillPremixEvent(evt.nPuVtx,ws,settings,premix);
+      ws.geomConv.initialiseHistos();
+      DigiClock::time_point tWrite = DigiClock::now();
+      const int nBytes = premixOutTree->Fill();
+      if (nBytes>0) evt.stats.bytesWritten += nBytes;
+      evt.stats.seconds[st_Write] += secondsSince(tWrite);
+      evt.stats.counts[st_Write] += premix.cellid->size();
+      if (debug>0) std::cout << log.str();
+      else if (ievt%50 == 0) std::cout << "... Premixing event: " << ievt << std::endl;
+      jobStats.add(evt.stats);
+    }//loop on premixed events
+    const double loopSeconds = secondsSince(tLoop);
+    printThroughput(jobStats,pNevts,0,loopSeconds);
+
+    premixFile->cd();
+    writeTimingTree(jobStats,pNevts,0,loopSeconds);
+    premixFile->WriteObjectAny(lInfo,"HGCSSInfo","Info");
+    TObjString lSettings(premixSettings(nPU,nSiLayers,etamean,deta).c_str());
+    lSettings.Write("PremixSettings");
+    premixOutTree->Write();
+    premixFile->Close();
+    return 0;
+  }
+
+  //one output file per configuration, DigiPFcal_<name>*.root with --digiConfigs
+  std::vector<DigiOutputFile*> outputs;
+  for (unsigned iC(0); iC<configs.size(); ++iC){
+    std::ostringstream outputStr;
+    outputStr << outFilePath << "/DigiPFcal" ;
+    if (digiConfigs.size()>0) outputStr << "_" << configs[iC].name;
+    //if (doEtaSel) {
+    //outputStr << "_eta" << (etamean-deta) << "_" << (etamean+deta);
+    //}
+    if (pSaveDigis)  outputStr << "_withDigiHits";
+    if (pSaveSims)  outputStr << "_withSimHits";
+    outputStr << ".root";
+
+    DigiOutputFile *out = new DigiOutputFile();
+    out->file = TFile::Open(outputStr.str().c_str(),"RECREATE");
+
+    if (!out->file) {
+      std::cout << " -- Error, output file " << outputStr.str() << " cannot be opened. Exiting..." << std::endl;
+      return 1;
+    }
+    else {
+      std::cout << " -- File will be saved as " << outputStr.str() << std::endl;
+    }
+
+    out->nPuVtx = 0;
+    out->tree = new TTree("RecoTree","HGC Standalone simulation reco tree");
+    out->tree->Branch("HGCSSEvent",&out->event);
+    if (nPU!=0 || premixTree) out->tree->Branch("nPuVtx",&out->nPuVtx);
+    if (pSaveSims) out->tree->Branch("HGCSSSimHitVec","std::vector<HGCSSSimHit>",&out->simHits);
+    if (pSaveDigis) out->tree->Branch("HGCSSDigiHitVec","std::vector<HGCSSRecoHit>",&out->digiHits);
+    out->tree->Branch("HGCSSRecoHitVec","std::vector<HGCSSRecoHit>",&out->recoHits);
+    if (pMakeJets) out->tree->Branch("HGCSSRecoJetVec","std::vector<HGCSSRecoJet>",&out->caloJets);
+    out->p_noise = new TH1F("noiseCheck",";noise (MIPs)",100,-5,5);
+    outputs.push_back(out);
+  }
+  std::vector<TH1F*> noiseHists;
+  for (unsigned iC(0); iC<outputs.size(); ++iC) noiseHists.push_back(outputs[iC]->p_noise);
 
 
   /////////////////////////////////////////////////////////////
@@ -694,283 +1670,158 @@ int main(int argc, char** argv){//main
 
   std::cout << "- Processing = " << nEvts  << " events out of " << inputTree->GetEntries() << std::endl;
 
-  std::vector<PseudoJet> lParticles;
-
-  auto siLayerNumberLessThan = [&geomConv](unsigned layer, const DetectorEnum type, float radius, float posz) -> bool {
-				 return layer < geomConv.getNumberOfSiLayers(type,radius,posz);
-			       };
-  
-  for (unsigned ievt(evtmin); ievt<evtmin+nEvts; ++ievt){//loop on entries
-
-    inputTree->GetEntry(ievt);
-    lEvent.eventNumber(event->eventNumber());
-    lEvent.vtx_x(event->vtx_x());
-    lEvent.vtx_y(event->vtx_y());
-    lEvent.vtx_z(event->vtx_z());
-    //unsigned layer = volNb;
-    
-    mycalib.setVertex(lEvent.vtx_x(),lEvent.vtx_y(),lEvent.vtx_z());
-
+  //read one input event, in the main thread only
+  auto readEvent = [&](const unsigned ievt, DigiEvent & evt){
+    evt.stats.reset();
+    DigiClock::time_point tRead = DigiClock::now();
+    const int nBytes = inputTree->GetEntry(ievt);
+    if (nBytes>0) evt.stats.bytesRead += nBytes;
+    evt.ievt = ievt;
+    evt.event.eventNumber(event->eventNumber());
+    evt.event.vtx_x(event->vtx_x());
+    evt.event.vtx_y(event->vtx_y());
+    evt.event.vtx_z(event->vtx_z());
+    evt.hits.swap(*hitvec);
+    evt.stats.seconds[st_Read] += secondsSince(tRead);
+    evt.stats.counts[st_Read] += evt.hits.size();
     if (debug>0) {
       std::cout << " **DEBUG** Processing evt " << ievt << std::endl;
     }
     else if (ievt%50 == 0) std::cout << "... Processing event: " << ievt << std::endl;
-    
-
-    for (unsigned iH(0); iH<(*hitvec).size(); ++iH){//loop on hits
-      HGCSSSimHit lHit = (*hitvec)[iH];
-      if (lHit.energy()<=0) continue;
-      if(lHit.cellid()>4000000000) continue;
-
-      //do not save hits with 0 energy...
-      if (lHit.energy()>0 && pSaveSims) lSimHits.push_back(lHit);
-      
-      unsigned layer = lHit.layer();
-      const HGCSSSubDetector & subdet = myDetector.subDetectorByLayer(layer);
-      DetectorEnum type = subdet.type;
-      if (debug > 1 && subdet.isScint) std::cout << " - layer " << layer << " " << subdet.name << " " << layer-subdet.layerIdMin << std::endl;
-
-      if (doEtaSel){
-	bool passeta = fabs(lHit.eta(subdet,geomConv,shape)-etamean)<deta;
-	if (!passeta) continue;
+  };
+
+  //fill output trees, in event order
+  auto writeEvent = [&](DigiEvent & evt){
+    std::cout << evt.log;
+    for (unsigned iC(0); iC<outputs.size(); ++iC){
+      DigiOutputFile & out = *outputs[iC];
+      DigiOutput & evtOut = evt.outputs[iC];
+      out.event = evt.event;
+      out.nPuVtx = evt.nPuVtx;
+      //the simhits are the same for all configurations
+      if (iC+1<outputs.size()) out.simHits = evt.simHits;
+      else out.simHits.swap(evt.simHits);
+      out.digiHits.swap(evtOut.digiHits);
+      out.recoHits.swap(evtOut.recoHits);
+      out.caloJets.swap(evtOut.caloJets);
+      DigiClock::time_point tWrite = DigiClock::now();
+      const int nBytes = out.tree->Fill();
+      if (nBytes>0) evt.stats.bytesWritten += nBytes;
+      evt.stats.seconds[st_Write] += secondsSince(tWrite);
+      evt.stats.counts[st_Write] += out.recoHits.size();
+      //the slot gets back the cleared vectors, keeping their allocated space.
+      out.simHits.clear();
+      out.digiHits.clear();
+      out.recoHits.clear();
+      out.caloJets.clear();
+    }
+    jobStats.add(evt.stats);
+  };
+
+  DigiClock::time_point tLoop = DigiClock::now();
+  if (nThreads==0){
+    //single RNG stream for the whole job
+    DigiWorkspace ws = {geomConv,mycalib,myDigitiser,digitisers,puTree,0,noiseHists,std::vector<PseudoJet>(),SimHitBatch(),JetTowers(),premixTree,0};
+    ws.towers.initialise(settings.towerEtaMin,settings.towerEtaMax,settings.towerDeta,settings.towerDphi,settings.towerThresh);
+    if (nPU!=0) puTree->SetBranchAddress("HGCSSSimHitVec",&ws.puhitvec);
+    if (premixTree) {
+      ws.premix = new PremixEvent();
+      ws.premix->setBranchAddress(premixTree);
+    }
+    DigiEvent evt;
+    for (unsigned ievt(evtmin); ievt<evtmin+nEvts; ++ievt){//loop on entries
+      readEvent(ievt,evt);
+      digitiseEvent(evt,ws,settings,*lRndm);
+      writeEvent(evt);
+    }//loop on entries
+    if (premixTree) premixTree->ResetBranchAddresses();
+    delete ws.premix;
+  }
+  else {
+    //one workspace per thread, RNG streams derived from (pSeed,ievt):
+    //output does not depend on the number of threads.
+    std::vector<DigiWorkspace*> workers;
+    for (unsigned iT(0); iT<nThreads; ++iT){
+      std::vector<TH1F*> hNoise;
+      for (unsigned iC(0); iC<outputs.size(); ++iC){
+	std::ostringstream lName;
+	lName << "noiseCheck_" << iT << "_" << iC;
+	hNoise.push_back(new TH1F(lName.str().c_str(),";noise (MIPs)",100,-5,5));
+	hNoise.back()->SetDirectory(0);
       }
-
-      //std::pair<double,double> xy = geom[iB];
-      //if (isScint) HGCSSGeometryConversion::convertFromEtaPhi(xy,meanZpos);
-      std::pair<double,double> xy = lHit.get_xy(subdet,geomConv,shape);
-      double posx = xy.first;//lHit.get_x(cellSize);
-      double posy = xy.second;//lHit.get_y(cellSize);
-      double posz = lHit.get_z();
-      double radius = sqrt(pow(posx,2)+pow(posy,2));
-      double energy = lHit.energy()*mycalib.MeVToMip(layer,radius); // if (energy > 0) std::cout << "sim energy = "<<lHit.energy()<<", reco energy = "<<energy<<std::endl;
-      double realtime = mycalib.correctTime(lHit.time(),posx,posy,posz);
-      bool passTime = myDigitiser.passTimeCut(type,realtime);
-      if (!passTime) continue;
-      if (energy>0 && siLayerNumberLessThan(lHit.silayer(), type, radius, posz)){
-	if (debug > 1) std::cout << " hit " << iH 
-				 << " lay " << layer  
-				 << " x " << posx 
-				 << " y " << posy
-				 << " z " << posz
-				 << " t " << lHit.time() << " " << realtime
-				 << std::endl;
-	//geomConv.fill(type,subdetLayer,energy,realtime,posx,posy,posz);
-	geomConv.fill(layer,energy,realtime,lHit.cellid(),posz);
+      TChain *lPuTree = 0;
+      if (nPU!=0){
+	lPuTree = new TChain("HGCSSTree");
+	for (unsigned iF(0); iF<puFiles.size(); ++iF) lPuTree->AddFile(puFiles[iF],puEntries[iF]);
       }
-
-    }//loop on input simhits
-
-    if(nPU!=0){
-      //get PU events
-      //std::vector<unsigned> ipuevt;
-
-      //get poisson <140>
-      nPuVtx = lRndm->Poisson(nPU);
-      //ipuevt.resize(nPuVtx,1);
-      if (signalIsPu) nPuVtx -= 1;
-      std::cout << " -- Adding " << nPuVtx << " events to signal event: " << ievt << std::endl;
-      std::set<unsigned> lidxSet;
-      for (unsigned iV(0); iV<nPuVtx; ++iV){//loop on interactions
-        unsigned ipuevt = 0;
-	while (1){
-	  ipuevt = lRndm->Integer(nPuEvts);
-	  if (lidxSet.find(ipuevt)==lidxSet.end()){
-	    lidxSet.insert(ipuevt);
-	    break;
-	  }
-	  else {
-	    std::cout << " -- Found duplicate ! Taking another shot." << std::endl;
-	  }
-	}
-	//std::cout << " ---- adding evt " << ipuevt << std::endl;
-	
-        puTree->GetEntry(ipuevt);
-        for (unsigned iH(0); iH<(*puhitvec).size(); ++iH){//loop on hits
-          HGCSSSimHit lHit = (*puhitvec)[iH];
-	  if (lHit.energy()<=0) continue;
-	  if(lHit.cellid()>4000000000) continue;
-
-	  unsigned layer = lHit.layer();
-	  const HGCSSSubDetector & subdet = myDetector.subDetectorByLayer(layer);
-	  DetectorEnum type = subdet.type;
-
-	  if (doEtaSel){
-	    bool passeta = fabs(lHit.eta(subdet,geomConv,shape)-etamean)<deta;
-	    if (!passeta) continue;
-	  }
-	  
-	  std::pair<double,double> xy = lHit.get_xy(subdet,geomConv,shape);
-	  double posx = xy.first;//lHit.get_x(cellSize);
-	  double posy = xy.second;//lHit.get_y(cellSize);
-	  double posz = lHit.get_z();
-	  double radius = sqrt(pow(posx,2)+pow(posy,2));
-	  if (siLayerNumberLessThan(lHit.silayer(), type, radius, posz)){
-	    double energy = lHit.energy()*mycalib.MeVToMip(layer,radius);
-	    double realtime = mycalib.correctTime(lHit.time(),posx,posy,posz);
-	    bool passTime = myDigitiser.passTimeCut(type,realtime);
-	    if (!passTime) continue;
-	    
-	    if (debug > 1) std::cout << " hit " << iH
-				     << " lay " << layer
-				     << " x " << posx
-				     << " y " << posy
-				     << " z " << posz
-				     << " t " << lHit.time() << " " << realtime
-				     << std::endl;
-	    //geomConv.fill(type,subdetLayer,energy,realtime,posx,posy,posz);
-	    geomConv.fill(layer,energy,realtime,lHit.cellid(),posz);
-	  }
-	  
-        }//loop on hits
-      }//loop on interactions
-    }//add PU
-
-    if (debug>0) {
-      std::cout << " **DEBUG** simhits = " << (*hitvec).size() << " " << lSimHits.size() << std::endl;
-    }
-
-    //create hits, everywhere to have also pure noise
-    //digitise
-    //apply threshold
-    //save
-    unsigned nTotBins = 0;
-    for (unsigned iL(0); iL<nLayers; ++iL){//loop on layers
-      //TH2Poly *histE = geomConv.get2DHist(iL,"E");
-      std::map<unsigned,MergeCells> & histE = geomConv.get2DHist(iL);
-      //TH2Poly *histTime = geomConv.get2DHist(iL,"Time");
-      //TH2Poly *histZ = geomConv.get2DHist(iL,"Z");
-      const HGCSSSubDetector & subdet = myDetector.subDetectorByLayer(iL);
-      bool isScint = subdet.isScint;
-      //nTotBins += histE->GetNumberOfBins();
-
-      std::map<int,std::pair<double,double> > & geom = isScint?(subdet.type==DetectorEnum::BHCAL1?geomConv.squareGeom1:geomConv.squareGeom2): shape==4?geomConv.squareGeom:shape==2?geomConv.diamGeom:shape==3?geomConv.triangleGeom:geomConv.hexaGeom;
-
-      unsigned nBins = geom.size();//isScint||shape==4?geomConv.squareMap()->GetNumberOfBins() : shape==2?geomConv.diamondMap()->GetNumberOfBins() : shape==3? geomConv.triangleMap()->GetNumberOfBins() : geomConv.hexagonMap()->GetNumberOfBins();
-      nTotBins += nBins;
-      if (pSaveDigis) lDigiHits.reserve(nTotBins);
-      
-      //double meanZpos = geomConv.getAverageZ(iL);
-      double meanZpos = myDetector.sensitiveZ(iL);
-      double etaBoundary = myDetector.etaBoundary(iL);
-      //extend map to include all cells in eta=1.4-3 region
-      //in eta ring if saving only one eta ring....
-      if (addNoiseHits) {
-	for (unsigned iB(1); iB<nBins+1;++iB){
-	  std::pair<double,double> xy = geom[iB];
-	  if (isScint) {
-	    HGCSSGeometryConversion::convertFromEtaPhi(xy,meanZpos);
-	  }
-	  ROOT::Math::XYZPoint lpos = ROOT::Math::XYZPoint(xy.first,xy.second,meanZpos);
-	  double eta = lpos.eta();
-	  bool passeta = eta>1.3 && eta<3.0;
-	  if (doEtaSel) passeta = fabs(eta-etamean)<deta;
-	  else {
-	    if (isScint) passeta = eta>outerScintBoundary[iL] && eta<=etaBoundary; // only simulate noise within the physical bounds of the detector
-	    else passeta = eta>etaBoundary && eta<3.0;
-	  }
-	  if (!passeta) continue;
-	  MergeCells tmpCell;
-	  tmpCell.energy = 0;
-	  tmpCell.time = 0;
-	  histE.insert(std::pair<unsigned,MergeCells>(iB,tmpCell));
-	}
+      TChain *lPremixTree = 0;
+      if (premixTree){
+	lPremixTree = new TChain("PremixTree");
+	lPremixTree->Add(premixPath.c_str());
       }
-
-      //std::cout << iL << " " << meanZpos << " map size " << histE.size() << std::endl;
-
-      if (debug>0){
-	std::cout << " -- Layer " << iL << " " << subdet.name << " z=" << meanZpos
-		  << " bins = " << nBins << " histE entries = " << histE.size() << std::endl;
+      DigiWorkspace *ws = new DigiWorkspace{geomConv,mycalib,myDigitiser,digitisers,lPuTree,0,hNoise,std::vector<PseudoJet>(),SimHitBatch(),JetTowers(),lPremixTree,0};
+      if (lPuTree) lPuTree->SetBranchAddress("HGCSSSimHitVec",&ws->puhitvec);
+      if (lPremixTree) {
+	ws->premix = new PremixEvent();
+	ws->premix->setBranchAddress(lPremixTree);
       }
+      ws->towers.initialise(settings.towerEtaMin,settings.towerEtaMax,settings.towerDeta,settings.towerDphi,settings.towerThresh);
+      workers.push_back(ws);
+    }
 
-      //cell-to-cell cross-talk for scintillator
-      if (isScint){
-	//2.5% per 30-mm edge
-	//myDigitiser.setIPCrossTalk(0.025*geomConv.cellSize(iL,0)/30.);
+    const unsigned batchSize = 4*nThreads;
+    std::vector<DigiEvent> batch(batchSize);
+    for (unsigned first(evtmin); first<evtmin+nEvts; first+=batchSize){//loop on batches
+      const unsigned nBatch = std::min(batchSize,evtmin+nEvts-first);
+      for (unsigned iE(0); iE<nBatch; ++iE){
+	readEvent(first+iE,batch[iE]);
       }
-      else {
-	myDigitiser.setIPCrossTalk(0);
+      std::atomic<unsigned> next(0);
+      std::vector<std::thread> threads;
+      for (unsigned iT(0); iT<nThreads; ++iT){
+	threads.push_back(std::thread([&,iT](){
+	      DigiWorkspace & ws = *workers[iT];
+	      TRandom3 puRndm;
+	      for (unsigned iE=next++; iE<nBatch; iE=next++){
+		DigiEvent & evt = batch[iE];
+		puRndm.SetSeed(eventSeed(pSeed,evt.ievt,0));
+		for (unsigned iC(0); iC<ws.digitisers.size(); ++iC) ws.digitisers[iC].setRandomSeed(eventSeed(pSeed,evt.ievt,1));
+		digitiseEvent(evt,ws,settings,puRndm);
+	      }
+	    }));
       }
+      for (unsigned iT(0); iT<nThreads; ++iT) threads[iT].join();
+      for (unsigned iE(0); iE<nBatch; ++iE){
+	writeEvent(batch[iE]);
+      }
+    }//loop on batches
 
-      //processHist(iL,histE,myDigitiser,p_noise,histZ,meanZpos,isTBsetup,subdet,pThreshInADC,pSaveDigis,lDigiHits,lRecoHits,pMakeJets,lParticles);
-
-      processHist(iL,histE,geom,myDigitiser,p_noise,meanZpos,isTBsetup,subdet,pThreshInADC,pSaveDigis,lDigiHits,lRecoHits,pMakeJets,lParticles);
- 
-    }//loop on layers
-
-    if (debug) {
-      std::cout << " **DEBUG** sim-digi-reco hits = " << (*hitvec).size() << "-" << lDigiHits.size() << "-" << lRecoHits.size() << std::endl;
-    }
-    
-    
-    if (pMakeJets){//pMakeJets
-      
-      // run the clustering, extract the jets
-      ClusterSequence cs(lParticles, jet_def);
-      std::vector<PseudoJet> jets = sorted_by_pt(cs.inclusive_jets());
-      
-      // print the jets
-      std::cout <<   "-- evt " << ievt << ": found " << jets.size() << " Jets." << std::endl;
-      for (unsigned i = 0; i < jets.size(); i++) {
-	const PseudoJet & lFastJet = jets[i];
-	//TOFIX // inverted y and z...
-	HGCSSRecoJet ljet(lFastJet.px(),
-			  lFastJet.py(),
-			  lFastJet.pz(),
-			  lFastJet.E());
-	if (lFastJet.has_constituents()) ljet.nConstituents(lFastJet.constituents().size());
-	if (lFastJet.has_area()){
-	  ljet.area(lFastJet.area());
-	  ljet.area_error(lFastJet.area_error());
-	}
-	
-	lCaloJets.push_back(ljet);
-	std::cout << " -------- jet " << i << ": "
-		  << lFastJet.E() << " " 
-		  << lFastJet.perp() << " " 
-		  << lFastJet.rap() << " " << lFastJet.phi() << " "
-		  << lFastJet.constituents().size() << std::endl;
-	// std::vector<PseudoJet> constituents = lFastJet.constituents();
-	// for (unsigned j = 0; j < constituents.size(); j++) {
-	//   std::cout << "    constituent " << j << "'s pt: " << constituents[j].perp()
-	// 	      << std::endl;
-	// }
+    for (unsigned iT(0); iT<nThreads; ++iT){
+      for (unsigned iC(0); iC<outputs.size(); ++iC){
+	outputs[iC]->p_noise->Add(workers[iT]->p_noise[iC]);
+	delete workers[iT]->p_noise[iC];
       }
-      
-    }//pMakeJets
-    
-    outputTree->Fill();
-    //reserve necessary space and clear vectors.
-    if (lSimHits.size() > maxSimHits) {
-      maxSimHits = 2*lSimHits.size();
-      std::cout << " -- INFO: event " << ievt << " maxSimHits updated to " << maxSimHits << std::endl;
-    }
-    if (lRecoHits.size() > maxRecHits) {
-      maxRecHits = 2*lRecoHits.size();
-      std::cout << " -- INFO: event " << ievt << " maxRecHits updated to " << maxRecHits << std::endl;
-    }
-    if (lCaloJets.size() > maxRecJets) {
-      maxRecJets = 2*lCaloJets.size();
-      std::cout << " -- INFO: event " << ievt << " maxRecJets updated to " << maxRecJets << std::endl;
-    }
-    lSimHits.clear();
-    lDigiHits.clear();
-    lRecoHits.clear();
-    lCaloJets.clear();
-    geomConv.initialiseHistos();
-    lParticles.clear();
-    if (pSaveSims) lSimHits.reserve(maxSimHits);
-    lRecoHits.reserve(maxRecHits);
-    lParticles.reserve(maxRecHits);
-    lCaloJets.reserve(maxRecJets);
-    
-  }//loop on entries
+      delete workers[iT]->puTree;
+      delete workers[iT]->premixTree;
+      delete workers[iT]->premix;
+      delete workers[iT];
+    }
+  }
 
-  outputFile->cd();
-  outputFile->WriteObjectAny(lInfo,"HGCSSInfo","Info");
-  outputTree->Write();
-  p_noise->Write();
-  outputFile->Close();
+  const double loopSeconds = secondsSince(tLoop);
+  printThroughput(jobStats,nEvts,nThreads,loopSeconds);
+
+  for (unsigned iC(0); iC<outputs.size(); ++iC){
+    DigiOutputFile *out = outputs[iC];
+    out->file->cd();
+    //job totals, the same in all the files
+    writeTimingTree(jobStats,nEvts,nThreads,loopSeconds);
+    out->file->WriteObjectAny(lInfo,"HGCSSInfo","Info");
+    out->tree->Write();
+    out->p_noise->Write();
+    out->file->Close();
+    delete out;
+  }
 
   return 0;
 